@@ -0,0 +1,179 @@
+// CPU cost of the send path: Crc8 throughput and float array block encoding, without bus time.
+// The transport copies the written fragments into one buffer, as the Linux driver does.
+// Build a second time with -DCRC8_SLICES=1 to compare with the bytewise CRC.
+//
+// build: cc -O2 -I. benchmarks/encoder_bench.c grc/i2c/grc_ll_protocol_commands.c grc/i2c/crc_calculation.c
+// usage: encoder_bench [seconds per row]
+
+#include "grc/drivers/grc_ll_driver.h"
+#include "grc/grc_error_codes.h"
+#include "grc/i2c/crc_calculation.h"
+#include "grc/i2c/grc_ll_protocol_commands.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_WINDOW_LEN 15000
+
+static uint8_t bus[8192];
+static uint64_t bus_bytes;
+
+// ================ DISCARDING TRANSPORT ====================
+static void discard_sleep_us(void* dev, uint32_t us)
+{
+}
+
+static uint64_t discard_time_us(void* dev)
+{
+    return 0;
+}
+
+static int discard_init(void* dev)
+{
+    return GRC_OK;
+}
+
+static int discard_mtu(void* dev)
+{
+    return sizeof(bus);
+}
+
+static int discard_write(void* dev, const void* data, int len)
+{
+    memcpy(bus, data, len);
+    bus_bytes += len;
+    return len;
+}
+
+static int discard_writev(void* dev, const struct grc_ll_iovec* iov, int cnt)
+{
+    int len = 0;
+    for (int i = 0; i < cnt; i++) {
+        memcpy(&bus[len], iov[i].data, iov[i].len);
+        len += iov[i].len;
+    }
+    bus_bytes += len;
+    return len;
+}
+
+static int discard_read(void* dev, void* data, int len)
+{
+    return len;
+}
+
+static const struct grc_transport_ops discard_transport = {
+    .init = discard_init,
+    .write = discard_write,
+    .writev = discard_writev,
+    .read = discard_read,
+    .mtu = discard_mtu,
+    .sleep_us = discard_sleep_us,
+    .time_us = discard_time_us,
+};
+
+// ===========================================================
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// bit by bit CRC-8, reference for the table driven one
+static uint8_t crc8_reference(const uint8_t* data, int len)
+{
+    uint8_t crc = CRC8_INIT;
+    while (len--) {
+        crc ^= *data++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static double bench_crc(double seconds, uint8_t block_len)
+{
+    static uint8_t block[255];
+    volatile uint8_t sink = 0;
+    uint64_t bytes = 0;
+    double start = now_seconds();
+    double elapsed;
+    do {
+        for (int i = 0; i < 1000; i++) {
+            block[0] = (uint8_t)i;
+            sink ^= Crc8(block, block_len);
+        }
+        bytes += 1000 * block_len;
+        elapsed = now_seconds() - start;
+    } while (elapsed < seconds);
+    return bytes / elapsed / 1e6;
+}
+
+static double bench_encode(double seconds, struct ProtocolContext* ctx, const float* window, unsigned len)
+{
+    uint64_t bytes = 0;
+    double start = now_seconds();
+    double elapsed;
+    do {
+        for (int i = 0; i < 100; i++) {
+            uint8_t block_cnt;
+            if (sendFloatArrayArguments(ctx, len, window, &block_cnt) < 0) {
+                return -1;
+            }
+        }
+        bytes += 100 * len * sizeof(float);
+        elapsed = now_seconds() - start;
+    } while (elapsed < seconds);
+    return bytes / elapsed / 1e6;
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = argc > 1 ? atof(argv[1]) : 0.5;
+    if (seconds <= 0) {
+        printf("usage: encoder_bench [seconds per row]\n");
+        return 1;
+    }
+
+    static uint8_t data[255];
+    for (int i = 0; i < 255; i++) {
+        data[i] = (uint8_t)(i * 37 + 11);
+    }
+    for (int len = 0; len <= 255; len++) {
+        for (int start = 0; start < 8 && start <= len; start++) {
+            if (Crc8Update(Crc8(data, start), data + start, len - start) != crc8_reference(data, len)) {
+                printf("Crc8 mismatch at length %d\n", len);
+                return 1;
+            }
+        }
+    }
+
+    static float window[MAX_WINDOW_LEN];
+    for (int i = 0; i < MAX_WINDOW_LEN; i++) {
+        window[i] = 0.001f * i;
+    }
+    static struct ProtocolContext ctx;
+    ctx.transport = &discard_transport;
+    if (initProtocolCommands(&ctx) < 0) {
+        return 1;
+    }
+
+    printf("%24s %10s\n", "row", "MB/s");
+    const uint8_t crc_lens[] = { 9, 63, 251 };
+    for (unsigned i = 0; i < sizeof(crc_lens); i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "crc8 %u bytes", crc_lens[i]);
+        printf("%24s %10.1f\n", name, bench_crc(seconds, crc_lens[i]));
+    }
+    const unsigned window_lens[] = { 16, 128, 1024, MAX_WINDOW_LEN };
+    for (unsigned i = 0; i < sizeof(window_lens) / sizeof(window_lens[0]); i++) {
+        char name[32];
+        snprintf(name, sizeof(name), "encode %u floats", window_lens[i]);
+        printf("%24s %10.1f\n", name, bench_encode(seconds, &ctx, window, window_lens[i]));
+    }
+    return 0;
+}
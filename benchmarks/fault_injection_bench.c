@@ -0,0 +1,228 @@
+// grc_inference and pipelined grc_inference_batch on a faulty bus. The simulated module is initialised and trained
+// on a clean bus, then every Nth transaction is not acknowledged, every Nth read returns the idle bus or a flipped
+// bit, or every Nth stream block fails its CRC. Reports how the inferences end: right class, wrong class or the
+// error code the SDK returns, with the injected faults, bus transactions and time per inference.
+// The SDK resends the blocks failing CRC, so the bench fails if any inference of the block CRC runs does not end
+// with the right class. A training whose series is not acknowledged part way has to leave GRC out of training
+// mode, the bench fails if the classes trained before are not inferred afterwards. Cancelling a training has to
+// report the class GRC kept from the floats it got, or NOT_CLASSIFIED if it got none.
+//
+// build: cc -O2 -I. benchmarks/fault_injection_bench.c grc/i2c/*.c grc/drivers/sim/grc_sim_module.c -lpthread -lm
+// usage: fault_injection_bench [inferences] [fault period] [transaction latency us]
+
+#include "grc/drivers/sim/grc_sim_impl.h"
+#include "grc/grc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define WINDOW_LEN 128
+#define MAX_ERROR_KINDS 4
+// windows of one grc_inference_batch call of the pipelined runs
+#define BATCH_LEN 8
+// series of the failing training, streamed in several blocks
+#define SERIES_LEN 4096
+// the not acknowledged transaction lands in the stream of the series, after GRC started training
+#define TRAIN_FAULT_PERIOD 50
+
+struct bench_result {
+    struct grc_sim_stats bus;
+    double seconds;
+    int right;
+    int wrong;
+    int error_codes[MAX_ERROR_KINDS];
+    int error_cnt[MAX_ERROR_KINDS];
+    int setup_error;
+};
+
+static void fill_window(float* window, float level)
+{
+    for (int i = 0; i < WINDOW_LEN; i++) {
+        window[i] = level + 0.01f * (float)(i % 7);
+    }
+}
+
+static void count_error(struct bench_result* r, int code)
+{
+    for (int i = 0; i < MAX_ERROR_KINDS; i++) {
+        if (r->error_cnt[i] == 0 || r->error_codes[i] == code) {
+            r->error_codes[i] = code;
+            r->error_cnt[i]++;
+            return;
+        }
+    }
+}
+
+static struct bench_result bench_faults(
+    const struct grc_sim_config* faults, uint32_t sdk_version, int inferences, uint32_t transaction_us)
+{
+    struct bench_result result = { 0 };
+    struct grc_ll_sim_dev ll_dev = { .type = PROTOCOL_INTERFACE_SIM, .config = GRC_SIM_DEFAULT_CONFIG };
+    ll_dev.config.sdk_version = sdk_version;
+    ll_dev.config.transaction_us = transaction_us;
+    struct grc_device dev = { .ll_dev = &ll_dev };
+    struct grc_config conf = { .arch = I3_N10 };
+    float windows[2][WINDOW_LEN];
+
+    result.setup_error = grc_init(&dev, &conf);
+    for (int cls = 0; cls < 2 && result.setup_error >= 0; cls++) {
+        struct grc_training_params t_params = { .flags = GRC_PARAMS_ADD_NEW_TAG };
+        fill_window(windows[cls], (float)cls);
+        result.setup_error = grc_train(&dev, &t_params, windows[cls], WINDOW_LEN);
+    }
+    if (result.setup_error >= 0) {
+        grc_sim_module_set_faults(ll_dev.module, faults);
+        grc_sim_module_get_stats(ll_dev.module, &result.bus, 1);
+        struct grc_inference_params i_params = { 0 };
+        uint64_t start = grc_sim_time_us();
+        for (int i = 0; i < inferences;) {
+            // firmware with a queue gets the windows in batches, the others one by one
+            int cnt = (sdk_version >= 3) ? inferences - i : 1;
+            cnt = cnt < BATCH_LEN ? cnt : BATCH_LEN;
+            const float* batch[BATCH_LEN];
+            int classes[BATCH_LEN];
+            for (int j = 0; j < cnt; j++) {
+                batch[j] = windows[(i + j) % 2];
+            }
+            int res = (sdk_version >= 3) ? grc_inference_batch(&dev, &i_params, batch, WINDOW_LEN, cnt, classes)
+                                         : grc_inference(&dev, &i_params, batch[0], WINDOW_LEN);
+            for (int j = 0; j < cnt; j++, i++) {
+                int class_tag = (sdk_version >= 3) ? classes[j] : res;
+                if (res < 0 && res != NOT_CLASSIFIED) {
+                    count_error(&result, res);
+                } else if (class_tag == i % 2) {
+                    result.right++;
+                } else {
+                    result.wrong++;
+                }
+            }
+        }
+        result.seconds = (grc_sim_time_us() - start) / 1e6;
+        grc_sim_module_get_stats(ll_dev.module, &result.bus, 0);
+    }
+    grc_release(&dev);
+    grc_sim_module_destroy(ll_dev.module);
+    return result;
+}
+
+// trains two classes, fails a third one part way and cancels a fourth one, then infers the first two
+static int check_failed_training(uint32_t sdk_version)
+{
+    struct grc_ll_sim_dev ll_dev = { .type = PROTOCOL_INTERFACE_SIM, .config = GRC_SIM_DEFAULT_CONFIG };
+    ll_dev.config.sdk_version = sdk_version;
+    struct grc_device dev = { .ll_dev = &ll_dev };
+    struct grc_config conf = { .arch = I3_N10 };
+    float windows[2][WINDOW_LEN];
+    static float series[SERIES_LEN];
+    int failed = 0;
+    int res = grc_init(&dev, &conf);
+    for (int cls = 0; cls < 2 && res >= 0; cls++) {
+        struct grc_training_params t_params = { .flags = GRC_PARAMS_ADD_NEW_TAG };
+        fill_window(windows[cls], (float)cls);
+        res = grc_train(&dev, &t_params, windows[cls], WINDOW_LEN);
+    }
+    if (res < 0) {
+        printf("failed training: setup failed with %d\n", res);
+        failed = 1;
+    } else {
+        struct grc_sim_config faults = { .nak_period = TRAIN_FAULT_PERIOD };
+        struct grc_sim_config no_faults = { 0 };
+        struct grc_training_params t_params = { .flags = GRC_PARAMS_ADD_NEW_TAG };
+        for (int i = 0; i < SERIES_LEN; i++) {
+            series[i] = 5.0f + 0.01f * (float)(i % 7);
+        }
+        grc_sim_module_set_faults(ll_dev.module, &faults);
+        res = grc_train(&dev, &t_params, series, SERIES_LEN);
+        grc_sim_module_set_faults(ll_dev.module, &no_faults);
+        if (res >= 0) {
+            printf("failed training: training with not acknowledged transactions returned %d\n", res);
+            failed = 1;
+        }
+        struct grc_inference_params i_params = { 0 };
+        for (int cls = 0; cls < 2; cls++) {
+            res = grc_inference(&dev, &i_params, windows[cls], WINDOW_LEN);
+            if (res != cls) {
+                printf("failed training: class %d inferred as %d afterwards\n", cls, res);
+                failed = 1;
+            }
+        }
+        // no floats: nothing is kept
+        res = grc_train_begin(&dev, &t_params);
+        res = res < 0 ? res : grc_train_cancel(&dev);
+        if (res != NOT_CLASSIFIED) {
+            printf("failed training: cancel before any float returned %d\n", res);
+            failed = 1;
+        }
+        // the series is sent to GRC, the class trained on it is kept
+        int classes = grc_get_classes_number(&dev);
+        res = grc_train_begin(&dev, &t_params);
+        res = res < 0 ? res : grc_train_feed(&dev, series, SERIES_LEN);
+        res = res < 0 ? res : grc_train_cancel(&dev);
+        if (res != classes) {
+            printf("failed training: cancel after %d floats returned %d, class %d expected\n", SERIES_LEN, res,
+                classes);
+            failed = 1;
+        }
+    }
+    grc_release(&dev);
+    grc_sim_module_destroy(ll_dev.module);
+    return failed;
+}
+
+int main(int argc, char** argv)
+{
+    int inferences = argc > 1 ? atoi(argv[1]) : 200;
+    uint32_t period = argc > 2 ? atoi(argv[2]) : 7;
+    uint32_t transaction_us = argc > 3 ? atoi(argv[3]) : 0;
+    if (inferences < 1 || period < 1) {
+        printf("usage: fault_injection_bench [inferences] [fault period >= 1] [transaction latency us]\n");
+        return 1;
+    }
+
+    struct {
+        const char* name;
+        struct grc_sim_config faults;
+    } runs[] = {
+        { "none", { 0 } },
+        { "nak", { .nak_period = period } },
+        { "not ready", { .not_ready_period = period } },
+        { "bit flip", { .bit_flip_period = period } },
+        { "block crc", { .block_error_period = period } },
+    };
+
+    printf("per inference, window of %d floats, fault every %u, transaction latency %u us\n", WINDOW_LEN, period,
+        transaction_us);
+    const char* modes[] = { "sequence", "fused", "pipelined batch" };
+    int failed = 0;
+    for (uint32_t sdk_version = 1; sdk_version <= 3; sdk_version++) {
+        printf("%s inference\n", modes[sdk_version - 1]);
+        printf("%12s %8s %8s %8s %8s %12s %10s  %s\n", "faults", "right", "wrong", "injected", "total", "bytes",
+            "ms", "errors");
+        for (unsigned i = 0; i < sizeof(runs) / sizeof(runs[0]); i++) {
+            struct bench_result r = bench_faults(&runs[i].faults, sdk_version, inferences, transaction_us);
+            if (r.setup_error < 0) {
+                printf("%12s setup failed with %d\n", runs[i].name, r.setup_error);
+                failed = 1;
+                continue;
+            }
+            if ((runs[i].faults.block_error_period != 0) && (r.right != inferences)) {
+                failed = 1;
+            }
+            printf("%12s %8d %8d %8.2f %8.1f %12.1f %10.3f ", runs[i].name, r.right, r.wrong,
+                (double)r.bus.faults / inferences,
+                (double)(r.bus.writes + r.bus.reads + r.bus.combined) / inferences,
+                (double)(r.bus.bytes_written + r.bus.bytes_read) / inferences, r.seconds * 1000 / inferences);
+            for (int j = 0; j < MAX_ERROR_KINDS && r.error_cnt[j] > 0; j++) {
+                printf(" %d x%d", r.error_codes[j], r.error_cnt[j]);
+            }
+            printf("\n");
+        }
+    }
+    if (failed) {
+        printf("inferences with block CRC faults did not all end with the right class\n");
+    }
+    for (uint32_t sdk_version = 1; sdk_version <= 3; sdk_version++) {
+        failed |= check_failed_training(sdk_version);
+    }
+    return failed;
+}
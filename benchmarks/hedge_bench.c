@@ -0,0 +1,156 @@
+// Latency percentiles of a grc_pool with and without hedging, while simulated devices stall now and then.
+// Windows are submitted at a fixed rate below the pool capacity, the latency of a window is the time from
+// grc_pool_inference to its callback.
+//
+// build: cc -O2 -I. benchmarks/hedge_bench.c grc/i2c/*.c grc/drivers/sim/grc_sim_module.c -lpthread -lm
+// usage: hedge_bench [devices] [windows] [windows per second] [stall period] [stall ms]
+
+#include "grc/drivers/sim/grc_sim_impl.h"
+#include "grc/grc.h"
+#include "grc/grc_pool.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define WINDOW_LEN 128
+#define MAX_DEVICES 16
+
+static pthread_mutex_t done_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t* submitted_us;
+static uint64_t* latencies_us;
+static uint32_t misclassified;
+static int failure;
+
+static void fill_window(float* window, float level)
+{
+    for (int i = 0; i < WINDOW_LEN; i++) {
+        window[i] = level + 0.01f * (float)(i % 7);
+    }
+}
+
+// user_data carries the window index, the expected class is its parity
+static void inference_done(int status, void* user_data)
+{
+    uint32_t idx = (uint32_t)(uintptr_t)user_data;
+    uint64_t now = grc_sim_time_us();
+    pthread_mutex_lock(&done_lock);
+    if (status < 0) {
+        failure = status;
+    }
+    misclassified += (status != (int)(idx % 2));
+    latencies_us[idx] = now - submitted_us[idx];
+    pthread_mutex_unlock(&done_lock);
+}
+
+static int compare_latencies(const void* a, const void* b)
+{
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static int bench(int n, uint32_t windows, uint32_t rate, uint32_t stall_period, uint32_t stall_ms, int hedging)
+{
+    static struct grc_ll_sim_dev ll_devs[MAX_DEVICES];
+    static struct grc_device devs[MAX_DEVICES];
+    struct grc_device* dev_ptrs[MAX_DEVICES];
+    float samples[2][WINDOW_LEN];
+    int res = GRC_OK;
+    for (int i = 0; (i < n) && (res >= 0); i++) {
+        ll_devs[i] = (struct grc_ll_sim_dev) { .type = PROTOCOL_INTERFACE_SIM, .config = GRC_SIM_DEFAULT_CONFIG };
+        ll_devs[i].config.sdk_version = 2;
+        ll_devs[i].config.stall_period = stall_period;
+        ll_devs[i].config.stall_us = stall_ms * 1000;
+        devs[i] = (struct grc_device) { .ll_dev = &ll_devs[i] };
+        dev_ptrs[i] = &devs[i];
+        struct grc_config conf = { .arch = I3_N10 };
+        res = grc_init(&devs[i], &conf);
+    }
+    for (int cls = 0; (cls < 2) && (res >= 0); cls++) {
+        struct grc_training_params t_params = { .flags = GRC_PARAMS_ADD_NEW_TAG };
+        fill_window(samples[cls], (float)cls);
+        res = grc_train(&devs[0], &t_params, samples[cls], WINDOW_LEN);
+    }
+    struct grc_pool* pool = res >= 0 ? grc_pool_create(dev_ptrs, n) : NULL;
+    if (pool != NULL) {
+        res = grc_pool_replicate(pool, 0);
+        grc_pool_set_hedging(pool, hedging);
+    } else if (res >= 0) {
+        res = GRC_NO_MEMORY;
+    }
+    misclassified = 0;
+    failure = 0;
+    uint64_t next_us = grc_sim_time_us();
+    for (uint32_t i = 0; (i < windows) && (res >= 0); i++) {
+        uint64_t now = grc_sim_time_us();
+        if (next_us > now) {
+            grc_sim_sleep_us(next_us - now);
+        }
+        next_us += 1000000 / rate;
+        pthread_mutex_lock(&done_lock);
+        submitted_us[i] = grc_sim_time_us();
+        pthread_mutex_unlock(&done_lock);
+        res = grc_pool_inference(pool, samples[i % 2], WINDOW_LEN, inference_done, (void*)(uintptr_t)i);
+    }
+
+    if (pool != NULL) {
+        grc_pool_wait(pool);
+        uint32_t delay_us = grc_pool_hedge_delay_us(pool);
+        uint64_t hedged = 0;
+        uint64_t won = 0;
+        for (int i = 0; i < n; i++) {
+            struct grc_pool_stats stats;
+            grc_pool_get_stats(pool, i, &stats, 0);
+            hedged += stats.hedged;
+            won += stats.hedges_won;
+        }
+        grc_pool_destroy(pool);
+        if (res >= 0) {
+            qsort(latencies_us, windows, sizeof(uint64_t), compare_latencies);
+            printf("hedging %-3s  p50 %6.1f ms  p95 %6.1f ms  p99 %6.1f ms  max %6.1f ms  hedged %llu, won %llu, delay %.1f ms\n",
+                hedging ? "on" : "off", latencies_us[windows / 2] / 1e3, latencies_us[windows * 95 / 100] / 1e3,
+                latencies_us[windows * 99 / 100] / 1e3, latencies_us[windows - 1] / 1e3, (unsigned long long)hedged,
+                (unsigned long long)won, delay_us / 1e3);
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        grc_release(&devs[i]);
+        grc_sim_module_destroy(ll_devs[i].module);
+    }
+    if (misclassified > 0) {
+        printf("%u inferences returned a wrong class\n", misclassified);
+    }
+    return res < 0 ? res : failure;
+}
+
+int main(int argc, char** argv)
+{
+    int devices = argc > 1 ? atoi(argv[1]) : 4;
+    uint32_t windows = argc > 2 ? (uint32_t)atoi(argv[2]) : 1000;
+    uint32_t rate = argc > 3 ? (uint32_t)atoi(argv[3]) : 100;
+    uint32_t stall_period = argc > 4 ? (uint32_t)atoi(argv[4]) : 50;
+    uint32_t stall_ms = argc > 5 ? (uint32_t)atoi(argv[5]) : 50;
+    if ((devices < 2) || (devices > MAX_DEVICES) || (windows < 100) || (rate < 1)) {
+        printf("usage: hedge_bench [devices 2..%d] [windows >= 100] [windows per second] [stall period] [stall ms]\n",
+            MAX_DEVICES);
+        return 1;
+    }
+    submitted_us = (uint64_t*)calloc(windows, sizeof(uint64_t));
+    latencies_us = (uint64_t*)calloc(windows, sizeof(uint64_t));
+    if ((submitted_us == NULL) || (latencies_us == NULL)) {
+        return 1;
+    }
+    printf("%d devices, %u windows/s, every %u. function stalls for %u ms\n", devices, rate, stall_period, stall_ms);
+    for (int hedging = 0; hedging <= 1; hedging++) {
+        int res = bench(devices, windows, rate, stall_period, stall_ms, hedging);
+        if (res < 0) {
+            printf("failed with %d\n", res);
+            return 1;
+        }
+    }
+    free(submitted_us);
+    free(latencies_us);
+    return 0;
+}
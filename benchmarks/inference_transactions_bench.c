@@ -0,0 +1,124 @@
+// Bus transactions of one grc_inference call.
+// Firmware of SDK version 1 classifies a window with start inference, feed data, stop inference and get status
+// remote calls, version 2 does it with one fused remote call. Version 3 queues windows given to grc_inference_batch,
+// so the next windows are sent while the module computes.
+//
+// build: cc -O2 -I. benchmarks/inference_transactions_bench.c grc/i2c/*.c grc/drivers/sim/grc_sim_module.c -lpthread -lm
+// usage: inference_transactions_bench [inferences] [window length] [module compute time, us]
+
+#include "grc/drivers/sim/grc_sim_impl.h"
+#include "grc/grc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX_WINDOW_LEN 4096
+#define BATCH_LEN 16
+
+struct bench_result {
+    struct grc_sim_stats bus;
+    double seconds;
+    int error;
+};
+
+static void fill_window(float* window, int len, float level)
+{
+    for (int i = 0; i < len; i++) {
+        window[i] = level + 0.01f * (float)(i % 7);
+    }
+}
+
+static struct bench_result bench_inference(
+    uint32_t sdk_version, uint32_t ready_line, int batch, int inferences, int window_len, uint32_t function_us)
+{
+    struct bench_result result = { 0 };
+    struct grc_ll_sim_dev ll_dev = { .type = PROTOCOL_INTERFACE_SIM, .config = GRC_SIM_DEFAULT_CONFIG };
+    ll_dev.config.sdk_version = sdk_version;
+    ll_dev.config.ready_line = ready_line;
+    ll_dev.config.function_us = function_us;
+    struct grc_device dev = { .ll_dev = &ll_dev };
+    struct grc_config conf = { .arch = I3_N10 };
+    static float window[MAX_WINDOW_LEN];
+    static float batch_windows[BATCH_LEN][MAX_WINDOW_LEN];
+    const float* batch_ptrs[BATCH_LEN];
+    int batch_results[BATCH_LEN];
+
+    result.error = grc_init(&dev, &conf);
+    for (int cls = 0; cls < 2 && result.error >= 0; cls++) {
+        struct grc_training_params t_params = { .flags = GRC_PARAMS_ADD_NEW_TAG };
+        fill_window(window, window_len, (float)cls);
+        result.error = grc_train(&dev, &t_params, window, window_len);
+    }
+    if (result.error >= 0) {
+        grc_sim_module_get_stats(ll_dev.module, &result.bus, 1);
+        struct grc_inference_params i_params = { 0 };
+        for (int i = 0; i < BATCH_LEN; i++) {
+            fill_window(batch_windows[i], window_len, (float)(i % 2));
+            batch_ptrs[i] = batch_windows[i];
+        }
+        uint64_t start = grc_sim_time_us();
+        for (int i = 0; i < inferences && result.error >= 0; i++) {
+            if (batch) {
+                int cnt = (inferences - i < BATCH_LEN) ? inferences - i : BATCH_LEN;
+                result.error = grc_inference_batch(&dev, &i_params, batch_ptrs, window_len, cnt, batch_results);
+                for (int j = 0; j < cnt && result.error >= 0; j++) {
+                    result.error = (batch_results[j] == j % 2) ? GRC_OK : WRONG_GRC_ANSWER;
+                }
+                i += cnt - 1;
+                continue;
+            }
+            fill_window(window, window_len, (float)(i % 2));
+            result.error = grc_inference(&dev, &i_params, window, window_len);
+            if (result.error >= 0 && result.error != i % 2) {
+                result.error = WRONG_GRC_ANSWER;
+            }
+        }
+        result.seconds = (grc_sim_time_us() - start) / 1e6;
+        grc_sim_module_get_stats(ll_dev.module, &result.bus, 0);
+    }
+    grc_release(&dev);
+    grc_sim_module_destroy(ll_dev.module);
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int inferences = argc > 1 ? atoi(argv[1]) : 200;
+    int window_len = argc > 2 ? atoi(argv[2]) : 128;
+    uint32_t function_us = argc > 3 ? atoi(argv[3]) : 200;
+    if (inferences < 1 || window_len < 1 || window_len > MAX_WINDOW_LEN) {
+        printf("usage: inference_transactions_bench [inferences] [window length <= %d] [compute us]\n", MAX_WINDOW_LEN);
+        return 1;
+    }
+
+    struct {
+        const char* name;
+        uint32_t sdk_version;
+        uint32_t ready_line;
+        int batch;
+    } runs[] = {
+        { "sequence", 1, 0, 0 },
+        { "sequence+ready", 1, 1, 0 },
+        { "fused", 2, 0, 0 },
+        { "fused+ready", 2, 1, 0 },
+        { "pipelined", 3, 0, 1 },
+    };
+
+    printf("per inference, window of %d floats, module computes %u us\n", window_len, function_us);
+    printf("%16s %8s %8s %8s %8s %12s %12s %10s\n", "path", "writes", "reads", "combined", "total", "bytes out", "bytes in",
+        "ms");
+    for (unsigned i = 0; i < sizeof(runs) / sizeof(runs[0]); i++) {
+        struct bench_result r = bench_inference(
+            runs[i].sdk_version, runs[i].ready_line, runs[i].batch, inferences, window_len, function_us);
+        if (r.error < 0) {
+            printf("%16s failed with %d\n", runs[i].name, r.error);
+            continue;
+        }
+        printf("%16s %8.1f %8.1f %8.1f %8.1f %12.1f %12.1f %10.3f\n", runs[i].name,
+            (double)r.bus.writes / inferences, (double)r.bus.reads / inferences, (double)r.bus.combined / inferences,
+            (double)(r.bus.writes + r.bus.reads + r.bus.combined) / inferences,
+            (double)r.bus.bytes_written / inferences, (double)r.bus.bytes_read / inferences,
+            r.seconds * 1000 / inferences);
+    }
+    return 0;
+}
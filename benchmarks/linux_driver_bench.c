@@ -0,0 +1,443 @@
+// The Linux i2c-dev driver against a userspace stand-in of the kernel: open, read, write and ioctl of the driver
+// are routed to a stand-in adapter in front of the simulated module, and to a stand-in GPIO chip whose data ready
+// line is an eventfd raised at each function completion of the module. The driver itself runs unchanged.
+// First the transport calls are checked one by one: writev gathers its segments into one I2C message of at most
+// 8 KB, write_read is one I2C_RDWR transfer or NOT_IMPLEMENTED on SMBus-only adapters (as i2c-stub), an address
+// without a device gives I2C_NACK, and wait_ready takes the edges of a data_ready_event_fd and of a GPIO v2 line.
+// Then the SDK trains and infers through the driver with polled status, without combined transfers, and with the
+// data ready line as an eventfd and as a GPIO line, reporting I2C messages and time per inference.
+// Fails if a transport call does not behave as above, an inference does not end with the right class or a run with
+// data ready takes no edge.
+//
+// build: cc -O2 -I. benchmarks/linux_driver_bench.c grc/i2c/*.c grc/drivers/sim/grc_sim_module.c -lpthread -lm
+// usage: linux_driver_bench [inferences]
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/gpio.h>
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "grc/drivers/sim/grc_sim.h"
+#include "grc/grc.h"
+#include "grc/grc_error_codes.h"
+
+#define WINDOW_LEN 128
+#define I2C_PATH "/dev/i2c-stand-in"
+#define GPIO_PATH "/dev/gpiochip-stand-in"
+#define MODULE_ADDR 0x30
+#define DATA_READY_LINE 5
+#define RESET_LINE 6
+#define MAX_MESSAGE 8192
+
+// kernel side of the driver: the adapter, the GPIO chip and the module behind them
+static struct {
+    struct grc_sim_module* module; // NULL - messages to MODULE_ADDR are acknowledged and recorded only
+    int rdwr; // 1 - adapter takes I2C_RDWR, 0 - SMBus only
+    int i2c_fd;
+    uint16_t addr;
+    pthread_mutex_t lock;
+    int edge_fd; // where the data ready edges of the module go, -1 - dropped
+    int line_fd; // eventfd behind the requested data ready line
+    int reset_fd;
+    int reset_value;
+    uint32_t resets;
+    uint32_t messages;
+    uint32_t combined;
+    uint32_t max_message;
+    uint32_t edges_read;
+    uint8_t last[MAX_MESSAGE];
+    int last_len;
+} kernel = { .i2c_fd = -1, .lock = PTHREAD_MUTEX_INITIALIZER, .edge_fd = -1, .line_fd = -1, .reset_fd = -1 };
+
+static int kernel_error(int res)
+{
+    errno = res == I2C_NACK ? EREMOTEIO : EIO;
+    return -1;
+}
+
+// one I2C message to the current address, write or read
+static int kernel_transfer(uint16_t addr, uint8_t* data, int len, int is_read)
+{
+    kernel.messages++;
+    if ((len < 1) || (len > MAX_MESSAGE)) {
+        errno = EINVAL;
+        return -1;
+    }
+    kernel.max_message = (uint32_t)len > kernel.max_message ? (uint32_t)len : kernel.max_message;
+    if (addr != MODULE_ADDR) {
+        errno = ENXIO;
+        return -1;
+    }
+    if (kernel.module == NULL) {
+        if (is_read) {
+            memset(data, 0xa5, len);
+        } else {
+            memcpy(kernel.last, data, len);
+            kernel.last_len = len;
+        }
+        return len;
+    }
+    int res = is_read ? grc_sim_module_read(kernel.module, data, len) : grc_sim_module_write(kernel.module, data, len);
+    return res < 0 ? kernel_error(res) : len;
+}
+
+static int kernel_open(const char* path, int flags)
+{
+    if ((strcmp(path, I2C_PATH) != 0) && (strcmp(path, GPIO_PATH) != 0)) {
+        errno = ENOENT;
+        return -1;
+    }
+    // an eventfd stands in for the character device
+    int fd = eventfd(0, EFD_CLOEXEC);
+    if (strcmp(path, I2C_PATH) == 0) {
+        kernel.i2c_fd = fd;
+    }
+    return fd;
+}
+
+static int kernel_gpio_line(struct gpio_v2_line_request* req)
+{
+    int fd = eventfd(0, EFD_CLOEXEC);
+    if ((req->num_lines != 1) || (fd < 0)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if ((req->offsets[0] == DATA_READY_LINE) && (req->config.flags & GPIO_V2_LINE_FLAG_EDGE_RISING)) {
+        pthread_mutex_lock(&kernel.lock);
+        kernel.line_fd = fd;
+        kernel.edge_fd = fd;
+        pthread_mutex_unlock(&kernel.lock);
+    } else if ((req->offsets[0] == RESET_LINE) && (req->config.flags & GPIO_V2_LINE_FLAG_OUTPUT)) {
+        kernel.reset_fd = fd;
+    } else {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+    req->fd = fd;
+    return 0;
+}
+
+static int kernel_ioctl(int fd, unsigned long request, void* arg)
+{
+    if ((fd == kernel.i2c_fd) && (request == I2C_SLAVE)) {
+        kernel.addr = (uint16_t)(uintptr_t)arg;
+        return 0;
+    }
+    if ((fd == kernel.i2c_fd) && (request == I2C_RDWR)) {
+        struct i2c_rdwr_ioctl_data* xfer = (struct i2c_rdwr_ioctl_data*)arg;
+        if (!kernel.rdwr) {
+            errno = EOPNOTSUPP;
+            return -1;
+        }
+        if ((xfer->nmsgs != 2) || (xfer->msgs[0].flags != 0) || (xfer->msgs[1].flags != I2C_M_RD)
+            || (xfer->msgs[0].addr != kernel.addr) || (xfer->msgs[1].addr != kernel.addr)) {
+            errno = EINVAL;
+            return -1;
+        }
+        kernel.combined++;
+        kernel.messages += 2;
+        if (kernel.addr != MODULE_ADDR) {
+            errno = ENXIO;
+            return -1;
+        }
+        if (kernel.module == NULL) {
+            memset(xfer->msgs[1].buf, 0xa5, xfer->msgs[1].len);
+            return 2;
+        }
+        int res = grc_sim_module_write_read(
+            kernel.module, xfer->msgs[0].buf, xfer->msgs[0].len, xfer->msgs[1].buf, xfer->msgs[1].len);
+        return res < 0 ? kernel_error(res) : 2;
+    }
+    if (request == GPIO_V2_GET_LINE_IOCTL) {
+        return kernel_gpio_line((struct gpio_v2_line_request*)arg);
+    }
+    if ((fd == kernel.reset_fd) && (request == GPIO_V2_LINE_SET_VALUES_IOCTL)) {
+        struct gpio_v2_line_values* values = (struct gpio_v2_line_values*)arg;
+        kernel.resets += (kernel.reset_value == 0) && (values->bits & 1);
+        kernel.reset_value = values->bits & 1;
+        return 0;
+    }
+    errno = ENOTTY;
+    return -1;
+}
+
+static ssize_t kernel_write(int fd, const void* data, size_t len)
+{
+    if (fd == kernel.i2c_fd) {
+        return kernel_transfer(kernel.addr, (uint8_t*)data, (int)len, 0);
+    }
+    return write(fd, data, len);
+}
+
+static ssize_t kernel_read(int fd, void* data, size_t len)
+{
+    if (fd == kernel.i2c_fd) {
+        return kernel_transfer(kernel.addr, (uint8_t*)data, (int)len, 1);
+    }
+    uint64_t counter;
+    if (read(fd, &counter, sizeof(counter)) != sizeof(counter)) {
+        return -1;
+    }
+    kernel.edges_read++;
+    if (fd != kernel.line_fd) {
+        memcpy(data, &counter, sizeof(counter));
+        return sizeof(counter);
+    }
+    // the GPIO chip reports the edge as a line event
+    struct gpio_v2_line_event event;
+    memset(&event, 0, sizeof(event));
+    event.id = GPIO_V2_LINE_EVENT_RISING_EDGE;
+    event.offset = DATA_READY_LINE;
+    if (len < sizeof(event)) {
+        errno = EINVAL;
+        return -1;
+    }
+    memcpy(data, &event, sizeof(event));
+    return sizeof(event);
+}
+
+// the driver is built against the stand-in
+#define open(path, flags) kernel_open(path, flags)
+#define ioctl(fd, request, arg) kernel_ioctl(fd, request, (void*)(arg))
+#define write(fd, data, len) kernel_write(fd, data, len)
+#define read(fd, data, len) kernel_read(fd, data, len)
+#include "grc/drivers/linux/grc_linux_impl.h"
+#undef open
+#undef ioctl
+#undef write
+#undef read
+
+static int stop_fd = -1;
+
+// raises the data ready line at each function completion of the module
+static void* edge_thread(void* arg)
+{
+    struct pollfd pfds[2] = { { .fd = grc_sim_module_ready_fd(kernel.module), .events = POLLIN },
+        { .fd = stop_fd, .events = POLLIN } };
+    while ((poll(pfds, 2, -1) >= 0) && !(pfds[1].revents & POLLIN)) {
+        uint64_t expirations;
+        if ((pfds[0].revents & POLLIN) && (read(pfds[0].fd, &expirations, sizeof(expirations)) > 0)) {
+            uint64_t edge = 1;
+            pthread_mutex_lock(&kernel.lock);
+            if (kernel.edge_fd >= 0) {
+                write(kernel.edge_fd, &edge, sizeof(edge));
+            }
+            pthread_mutex_unlock(&kernel.lock);
+        }
+    }
+    return NULL;
+}
+
+static struct grc_ll_i2c_dev_linux linux_device(void)
+{
+    return (struct grc_ll_i2c_dev_linux) { .type = PROTOCOL_INTERFACE_I2C_LINUX, .i2c_dev_path = I2C_PATH,
+        .slave_addr = MODULE_ADDR, .data_ready_line = -1, .reset_line = -1, .data_ready_event_fd = -1 };
+}
+
+static int check(int ok, const char* what)
+{
+    if (!ok) {
+        printf("    %s: failed\n", what);
+    }
+    return !ok;
+}
+
+// transport calls one by one, the adapter records the messages
+static int check_transport(void)
+{
+    const struct grc_transport_ops* t = &grc_linux_transport;
+    struct grc_ll_i2c_dev_linux ll_dev = linux_device();
+    int failed = 0;
+    kernel.module = NULL;
+    kernel.rdwr = 1;
+    if (t->init(&ll_dev) != GRC_OK) {
+        printf("    transport init: failed\n");
+        return 1;
+    }
+
+    static uint8_t data[MAX_MESSAGE + 1];
+    for (int i = 0; i < MAX_MESSAGE + 1; i++) {
+        data[i] = (uint8_t)(i * 7);
+    }
+    struct grc_ll_iovec iov[3] = { { data, 1 }, { data + 1, 4000 }, { data + 4001, MAX_MESSAGE - 4001 } };
+    uint32_t messages = kernel.messages;
+    failed |= check(t->writev(&ll_dev, iov, 3) == MAX_MESSAGE, "writev of 8 KB");
+    failed |= check((kernel.messages == messages + 1) && (kernel.last_len == MAX_MESSAGE)
+            && (memcmp(kernel.last, data, MAX_MESSAGE) == 0),
+        "writev gathered into one message");
+    iov[2].len++;
+    messages = kernel.messages;
+    failed |= check(t->writev(&ll_dev, iov, 3) == ARGUMENT_ERROR, "writev above 8 KB refused");
+    failed |= check(kernel.messages == messages, "writev above 8 KB sends nothing");
+
+    uint8_t reply[4];
+    uint32_t combined = kernel.combined;
+    failed |= check(t->write_read(&ll_dev, data, 2, reply, sizeof(reply)) == sizeof(reply), "write_read");
+    failed |= check(kernel.combined == combined + 1, "write_read is one I2C_RDWR transfer");
+    kernel.rdwr = 0;
+    failed |= check(t->write_read(&ll_dev, data, 2, reply, sizeof(reply)) == NOT_IMPLEMENTED,
+        "write_read on SMBus-only adapter");
+    kernel.rdwr = 1;
+
+    failed |= check(t->set_address(&ll_dev, MODULE_ADDR + 1) == GRC_OK, "set_address");
+    failed |= check(t->get_address(&ll_dev) == MODULE_ADDR + 1, "get_address");
+    failed |= check(t->write(&ll_dev, data, 2) == I2C_NACK, "write without a device");
+    failed |= check(t->read(&ll_dev, reply, sizeof(reply)) == I2C_NACK, "read without a device");
+    failed |= check(t->write_read(&ll_dev, data, 2, reply, sizeof(reply)) == I2C_NACK, "write_read without a device");
+    failed |= check(t->set_address(&ll_dev, MODULE_ADDR) == GRC_OK, "set_address back");
+
+    failed |= check(t->wait_ready(&ll_dev, 0) == NOT_IMPLEMENTED, "wait_ready without data ready");
+    t->release(&ll_dev);
+
+    // data ready as an eventfd
+    ll_dev = linux_device();
+    ll_dev.data_ready_event_fd = eventfd(0, EFD_CLOEXEC);
+    uint64_t edge = 1;
+    uint32_t edges = kernel.edges_read;
+    failed |= check(t->init(&ll_dev) == GRC_OK, "init with data_ready_event_fd");
+    failed |= check(t->ready_fd(&ll_dev) == ll_dev.data_ready_event_fd, "ready_fd is data_ready_event_fd");
+    failed |= check(t->wait_ready(&ll_dev, 0) == GRC_TIMEOUT, "wait_ready without an edge");
+    failed |= check(write(ll_dev.data_ready_event_fd, &edge, sizeof(edge)) == sizeof(edge), "eventfd edge");
+    failed |= check(t->wait_ready(&ll_dev, 100) == GRC_OK, "wait_ready on an eventfd edge");
+    failed |= check(kernel.edges_read == edges + 1, "eventfd edge consumed");
+    failed |= check(t->wait_ready(&ll_dev, 0) == GRC_TIMEOUT, "wait_ready after the edge");
+    t->release(&ll_dev);
+    close(ll_dev.data_ready_event_fd);
+
+    // data ready as a GPIO v2 line
+    ll_dev = linux_device();
+    ll_dev.gpio_chip_path = GPIO_PATH;
+    ll_dev.data_ready_line = DATA_READY_LINE;
+    edges = kernel.edges_read;
+    failed |= check(t->init(&ll_dev) == GRC_OK, "init with GPIO data ready line");
+    failed |= check(t->ready_fd(&ll_dev) == kernel.line_fd, "ready_fd is the GPIO line");
+    failed |= check(t->wait_ready(&ll_dev, 0) == GRC_TIMEOUT, "wait_ready without a GPIO edge");
+    failed |= check(write(kernel.line_fd, &edge, sizeof(edge)) == sizeof(edge), "GPIO edge");
+    failed |= check(t->wait_ready(&ll_dev, 100) == GRC_OK, "wait_ready on a GPIO edge");
+    failed |= check(kernel.edges_read == edges + 1, "GPIO edge consumed as a line event");
+    pthread_mutex_lock(&kernel.lock);
+    kernel.edge_fd = -1;
+    pthread_mutex_unlock(&kernel.lock);
+    t->release(&ll_dev);
+    return failed;
+}
+
+static void fill_window(float* window, float level)
+{
+    for (int i = 0; i < WINDOW_LEN; i++) {
+        window[i] = level + 0.01f * (float)(i % 7);
+    }
+}
+
+enum data_ready { POLLED, EVENT_FD, GPIO_LINE };
+
+// the SDK through the driver, returns 1 on failure
+static int bench(const char* name, enum data_ready ready, int rdwr, int inferences)
+{
+    struct grc_sim_config cfg = GRC_SIM_DEFAULT_CONFIG;
+    cfg.sdk_version = 2;
+    cfg.ready_line = ready != POLLED;
+    kernel.module = grc_sim_module_create(&cfg);
+    kernel.rdwr = rdwr;
+    if (kernel.module == NULL) {
+        printf("%24s out of memory\n", name);
+        return 1;
+    }
+    struct grc_ll_i2c_dev_linux ll_dev = linux_device();
+    if (ready == EVENT_FD) {
+        ll_dev.data_ready_event_fd = eventfd(0, EFD_CLOEXEC);
+        kernel.edge_fd = ll_dev.data_ready_event_fd;
+    } else if (ready == GPIO_LINE) {
+        ll_dev.gpio_chip_path = GPIO_PATH;
+        ll_dev.data_ready_line = DATA_READY_LINE;
+        ll_dev.reset_line = RESET_LINE;
+    }
+    pthread_t thread;
+    stop_fd = eventfd(0, EFD_CLOEXEC);
+    int threaded = (ready != POLLED) && (pthread_create(&thread, NULL, edge_thread, NULL) == 0);
+
+    struct grc_device dev = { .ll_dev = &ll_dev };
+    struct grc_config conf = { .arch = I3_N10 };
+    float windows[2][WINDOW_LEN];
+    uint32_t resets = kernel.resets;
+    int res = ready == GPIO_LINE ? grc_device_reset(&dev) : GRC_OK;
+    int failed = (ready == GPIO_LINE) && (kernel.resets != resets + 1);
+    res = res < 0 ? res : grc_init(&dev, &conf);
+    for (int cls = 0; cls < 2 && res >= 0; cls++) {
+        struct grc_training_params t_params = { .flags = GRC_PARAMS_ADD_NEW_TAG };
+        fill_window(windows[cls], (float)cls);
+        res = grc_train(&dev, &t_params, windows[cls], WINDOW_LEN);
+    }
+    int right = 0;
+    uint32_t messages = kernel.messages;
+    uint32_t combined = kernel.combined;
+    uint32_t edges = kernel.edges_read;
+    uint64_t start = linux_ll_time_us(&ll_dev);
+    struct grc_inference_params i_params = { 0 };
+    for (int i = 0; i < inferences && res >= 0; i++) {
+        res = grc_inference(&dev, &i_params, windows[i % 2], WINDOW_LEN);
+        right += res == i % 2;
+    }
+    double ms = (linux_ll_time_us(&ll_dev) - start) / 1000.0 / inferences;
+    messages = kernel.messages - messages;
+    combined = kernel.combined - combined;
+    edges = kernel.edges_read - edges;
+    if (dev.ctx != NULL) {
+        grc_release(&dev);
+    }
+
+    if (threaded) {
+        uint64_t stop = 1;
+        write(stop_fd, &stop, sizeof(stop));
+        pthread_join(thread, NULL);
+    }
+    close(stop_fd);
+    if (ll_dev.data_ready_event_fd >= 0) {
+        close(ll_dev.data_ready_event_fd);
+    }
+    kernel.edge_fd = -1;
+    grc_sim_module_destroy(kernel.module);
+    kernel.module = NULL;
+
+    printf("%24s %8d %10.1f %10.1f %8.1f %10.3f", name, right, (double)messages / inferences,
+        (double)combined / inferences, (double)edges / inferences, ms);
+    if (res < 0 && res != NOT_CLASSIFIED) {
+        printf("  failed with %d", res);
+    }
+    printf("\n");
+    failed |= right != inferences;
+    failed |= (ready != POLLED) && (edges == 0);
+    failed |= rdwr ? (combined == 0) : (combined != 0);
+    return failed;
+}
+
+int main(int argc, char** argv)
+{
+    int inferences = argc > 1 ? atoi(argv[1]) : 100;
+    if (inferences < 1) {
+        printf("usage: linux_driver_bench [inferences >= 1]\n");
+        return 1;
+    }
+    printf("transport calls\n");
+    int failed = check_transport();
+    printf("    %s\n", failed ? "failed" : "ok");
+
+    printf("per inference, window of %d floats\n", WINDOW_LEN);
+    printf("%24s %8s %10s %10s %8s %10s\n", "data ready", "right", "messages", "I2C_RDWR", "edges", "ms");
+    failed |= bench("polled", POLLED, 1, inferences);
+    failed |= bench("polled, SMBus only", POLLED, 0, inferences);
+    failed |= bench("eventfd", EVENT_FD, 1, inferences);
+    failed |= bench("GPIO line", GPIO_LINE, 1, inferences);
+    return failed;
+}
@@ -0,0 +1,111 @@
+// Throughput of independent GRC devices driven from separate threads.
+// Every thread owns a simulated module and its own grc_device, the SDK keeps no shared state.
+//
+// build: cc -O2 -I. benchmarks/multi_device_bench.c grc/i2c/*.c grc/drivers/sim/grc_sim_module.c -lpthread -lm
+// usage: multi_device_bench [max devices] [seconds per run]
+
+#include "grc/drivers/sim/grc_sim_impl.h"
+#include "grc/grc.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define WINDOW_LEN 128
+
+struct bench_worker {
+    pthread_t thread;
+    struct grc_ll_sim_dev ll_dev;
+    struct grc_device dev;
+    uint64_t deadline_us;
+    uint32_t inferences;
+    uint32_t misclassified;
+    int error;
+};
+
+static void fill_window(float* window, float level)
+{
+    for (int i = 0; i < WINDOW_LEN; i++) {
+        window[i] = level + 0.01f * (float)(i % 7);
+    }
+}
+
+static void* bench_worker_run(void* arg)
+{
+    struct bench_worker* w = (struct bench_worker*)arg;
+    struct grc_config conf = { .arch = I3_N10 };
+    float window[WINDOW_LEN];
+
+    int res = grc_init(&w->dev, &conf);
+    if (res < 0) {
+        w->error = res;
+        return NULL;
+    }
+    for (int cls = 0; cls < 2; cls++) {
+        struct grc_training_params t_params = { .flags = GRC_PARAMS_ADD_NEW_TAG };
+        fill_window(window, (float)cls);
+        res = grc_train(&w->dev, &t_params, window, WINDOW_LEN);
+        if (res < 0) {
+            w->error = res;
+            return NULL;
+        }
+    }
+
+    struct grc_inference_params i_params = { 0 };
+    while (grc_sim_time_us() < w->deadline_us) {
+        int expected = w->inferences % 2;
+        fill_window(window, (float)expected);
+        res = grc_inference(&w->dev, &i_params, window, WINDOW_LEN);
+        if (res < 0) {
+            w->error = res;
+            return NULL;
+        }
+        w->misclassified += (res != expected);
+        w->inferences++;
+    }
+    return NULL;
+}
+
+int main(int argc, char** argv)
+{
+    int max_devices = argc > 1 ? atoi(argv[1]) : 8;
+    int seconds = argc > 2 ? atoi(argv[2]) : 2;
+    double base_rate = 0;
+
+    printf("%8s %12s %14s %8s\n", "devices", "inferences", "inferences/s", "scaling");
+    for (int n = 1; n <= max_devices; n *= 2) {
+        struct bench_worker* workers = (struct bench_worker*)calloc(n, sizeof(struct bench_worker));
+        uint64_t start = grc_sim_time_us();
+        for (int i = 0; i < n; i++) {
+            struct bench_worker* w = &workers[i];
+            w->ll_dev = (struct grc_ll_sim_dev) { .type = PROTOCOL_INTERFACE_SIM, .config = GRC_SIM_DEFAULT_CONFIG };
+            w->dev = (struct grc_device) { .ll_dev = &w->ll_dev };
+            w->deadline_us = start + (uint64_t)seconds * 1000000u;
+            pthread_create(&w->thread, NULL, bench_worker_run, w);
+        }
+        uint32_t total = 0;
+        uint32_t misclassified = 0;
+        for (int i = 0; i < n; i++) {
+            struct bench_worker* w = &workers[i];
+            pthread_join(w->thread, NULL);
+            if (w->error < 0) {
+                printf("device %d failed with %d\n", i, w->error);
+            }
+            total += w->inferences;
+            misclassified += w->misclassified;
+            grc_release(&w->dev);
+            grc_sim_module_destroy(w->ll_dev.module);
+        }
+        double elapsed = (grc_sim_time_us() - start) / 1e6;
+        double rate = total / elapsed;
+        if (n == 1) {
+            base_rate = rate;
+        }
+        printf("%8d %12u %14.1f %7.2fx\n", n, total, rate, base_rate > 0 ? rate / base_rate : 0);
+        if (misclassified > 0) {
+            printf("%u inferences returned a wrong class\n", misclassified);
+        }
+        free(workers);
+    }
+    return 0;
+}
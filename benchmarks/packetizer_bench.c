@@ -0,0 +1,197 @@
+// Bytes and write transactions on the bus for one float array stream, by window length and link MTU.
+// "fixed" is the previous layout: blocks of up to 62 floats, 256 byte writes, MTU ignored. On a 256 byte link the
+// layout must never need more writes or bytes than the fixed one, which is checked for every window length first.
+// It comes out the same there: a block is not split across writes and hardly two fit in one, so a block more to
+// save padding costs a write. The MTU layout pays off on shorter links, where blocks of 62 floats do not fit.
+//
+// build: cc -O2 -I. benchmarks/packetizer_bench.c grc/i2c/grc_ll_protocol_commands.c grc/i2c/crc_calculation.c
+// usage: packetizer_bench [window length]...
+
+#include "grc/drivers/grc_ll_driver.h"
+#include "grc/grc_error_codes.h"
+#include "grc/i2c/grc_ll_protocol_commands.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX_WINDOW_LEN 15809
+// start, address byte and stop of an I2C write
+#define WRITE_OVERHEAD_BYTES 2
+
+struct wire_cost {
+    unsigned bytes;
+    unsigned writes;
+};
+
+static int link_mtu;
+static struct wire_cost wire;
+
+// ================ COUNTING TRANSPORT ====================
+static void counting_sleep_us(void* dev, uint32_t us)
+{
+}
+
+static uint64_t counting_time_us(void* dev)
+{
+    return 0;
+}
+
+static int counting_init(void* dev)
+{
+    return GRC_OK;
+}
+
+static int counting_mtu(void* dev)
+{
+    return link_mtu;
+}
+
+static int counting_write(void* dev, const void* data, int len)
+{
+    if (len > link_mtu) {
+        return I2C_ERROR;
+    }
+    wire.bytes += len;
+    wire.writes++;
+    return len;
+}
+
+static int counting_writev(void* dev, const struct grc_ll_iovec* iov, int cnt)
+{
+    int len = 0;
+    for (int i = 0; i < cnt; i++) {
+        len += iov[i].len;
+    }
+    if (len > link_mtu) {
+        return I2C_ERROR;
+    }
+    wire.bytes += len;
+    wire.writes++;
+    return len;
+}
+
+static int counting_read(void* dev, void* data, int len)
+{
+    return len;
+}
+
+static const struct grc_transport_ops counting_transport = {
+    .init = counting_init,
+    .write = counting_write,
+    .writev = counting_writev,
+    .read = counting_read,
+    .mtu = counting_mtu,
+    .sleep_us = counting_sleep_us,
+    .time_us = counting_time_us,
+};
+
+// ===========================================================
+
+// previous layout: fewest blocks of up to 62 floats, a write is sent when the next block does not fit into 256 bytes
+static struct wire_cost fixed_layout_cost(unsigned len)
+{
+    struct wire_cost cost = { 0 };
+    unsigned values = len + 1;
+    unsigned block_cnt = (values + 61) / 62;
+    unsigned block_size = (values + block_cnt - 1) / block_cnt * 4 + 4;
+    unsigned pending = 3;
+    for (unsigned i = 0; i < block_cnt; i++) {
+        if (256 - pending < block_size) {
+            cost.bytes += pending;
+            cost.writes++;
+            pending = 0;
+        }
+        pending += block_size;
+    }
+    cost.bytes += pending;
+    cost.writes++;
+    return cost;
+}
+
+static int stream_cost(int mtu, unsigned len, const float* window, struct wire_cost* cost)
+{
+    static struct ProtocolContext ctx;
+    ctx.transport = &counting_transport;
+    link_mtu = mtu;
+    int res = initProtocolCommands(&ctx);
+    if (res < 0) {
+        return res;
+    }
+    uint8_t block_cnt;
+    wire.bytes = 0;
+    wire.writes = 0;
+    res = sendFloatArrayArguments(&ctx, len, window, &block_cnt);
+    *cost = wire;
+    return res;
+}
+
+// every window length the link carries, 1 - the layout of some length needs more writes or bytes than the fixed one
+static int check_writes(const float* window)
+{
+    unsigned fewer_bytes = 0;
+    for (unsigned len = 1; len <= MAX_WINDOW_LEN; len++) {
+        struct wire_cost fixed = fixed_layout_cost(len);
+        struct wire_cost cost;
+        if (stream_cost(256, len, window, &cost) < 0) {
+            printf("%u floats do not fit the 256 byte link\n", len);
+            return 1;
+        }
+        if ((cost.writes > fixed.writes) || (cost.bytes > fixed.bytes)) {
+            printf("%u floats take %u writes and %u bytes, the fixed layout %u and %u\n", len, cost.writes,
+                cost.bytes, fixed.writes, fixed.bytes);
+            return 1;
+        }
+        fewer_bytes += cost.bytes < fixed.bytes;
+    }
+    printf("256 byte link: %u of %d window lengths take fewer bytes than the fixed layout, none more writes\n",
+        fewer_bytes, MAX_WINDOW_LEN);
+    return 0;
+}
+
+static void print_cost(const struct wire_cost* cost, unsigned len)
+{
+    unsigned total = cost->bytes + cost->writes * WRITE_OVERHEAD_BYTES;
+    printf(" %7u %6u %6.1f%%", cost->bytes, cost->writes, 100.0 * (total - len * 4) / (len * 4));
+}
+
+int main(int argc, char** argv)
+{
+    static const unsigned default_lens[] = { 1, 16, 61, 62, 100, 128, 250, 256, 500, 1000, 1024, 4096, 15000 };
+    static float window[MAX_WINDOW_LEN];
+    const int mtus[] = { 256, 128, 32 };
+    if (check_writes(window)) {
+        return 1;
+    }
+
+    printf("%6s %24s", "floats", "fixed");
+    for (unsigned m = 0; m < sizeof(mtus) / sizeof(mtus[0]); m++) {
+        printf(" %17s %3d", "mtu", mtus[m]);
+    }
+    printf("\n%6s", "");
+    for (unsigned m = 0; m <= sizeof(mtus) / sizeof(mtus[0]); m++) {
+        printf(" %7s %6s %7s", "bytes", "writes", "extra");
+    }
+    printf("\n");
+
+    unsigned cnt = argc > 1 ? (unsigned)argc - 1 : sizeof(default_lens) / sizeof(default_lens[0]);
+    for (unsigned i = 0; i < cnt; i++) {
+        unsigned len = argc > 1 ? (unsigned)atoi(argv[i + 1]) : default_lens[i];
+        if (len < 1 || len > MAX_WINDOW_LEN) {
+            printf("window length must be 1..%d\n", MAX_WINDOW_LEN);
+            return 1;
+        }
+        printf("%6u", len);
+        struct wire_cost fixed = fixed_layout_cost(len);
+        print_cost(&fixed, len);
+        for (unsigned m = 0; m < sizeof(mtus) / sizeof(mtus[0]); m++) {
+            struct wire_cost cost;
+            if (stream_cost(mtus[m], len, window, &cost) < 0) {
+                printf(" %22s", "too long");
+                continue;
+            }
+            print_cost(&cost, len);
+        }
+        printf("\n");
+    }
+    return 0;
+}
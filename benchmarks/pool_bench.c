@@ -0,0 +1,191 @@
+// Inference throughput of a grc_pool of N simulated devices, fed from one thread that keeps the queues full.
+// Only device 0 is trained, the pool copies its model to the others. Every run gives each device the same number
+// of windows and is timed until the pool has finished them, so the speedup compares the same work per device.
+// The skewed run makes the last device slow factor times slower: the others run out of windows first and steal
+// the ones queued on it. Its rate is compared with the sum of the rates of its devices alone.
+// Fails if a skewed run steals no window or a uniform run scales above the number of devices.
+//
+// build: cc -O2 -I. benchmarks/pool_bench.c grc/i2c/*.c grc/drivers/sim/grc_sim_module.c -lpthread -lm
+// usage: pool_bench [max devices] [windows per device] [slow factor]
+
+#include "grc/drivers/sim/grc_sim_impl.h"
+#include "grc/grc.h"
+#include "grc/grc_pool.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define WINDOW_LEN 128
+#define MAX_DEVICES 16
+// timing noise allowed above linear scaling
+#define SCALING_TOLERANCE 1.05
+
+static pthread_mutex_t done_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t done_cond = PTHREAD_COND_INITIALIZER;
+static uint32_t finished;
+static uint32_t misclassified;
+static int failure;
+
+struct run_result {
+    double rate;
+    uint64_t stolen;
+};
+
+static void fill_window(float* window, float level)
+{
+    for (int i = 0; i < WINDOW_LEN; i++) {
+        window[i] = level + 0.01f * (float)(i % 7);
+    }
+}
+
+// user_data carries the expected class
+static void inference_done(int status, void* user_data)
+{
+    pthread_mutex_lock(&done_lock);
+    if (status < 0) {
+        failure = status;
+    }
+    misclassified += (status != (int)(intptr_t)user_data);
+    finished++;
+    pthread_cond_signal(&done_cond);
+    pthread_mutex_unlock(&done_lock);
+}
+
+// n devices, the last one slow_factor times slower, each given per_device windows
+static int bench(int n, uint32_t per_device, uint32_t slow_factor, int verbose, struct run_result* result)
+{
+    static struct grc_ll_sim_dev ll_devs[MAX_DEVICES];
+    static struct grc_device devs[MAX_DEVICES];
+    struct grc_device* dev_ptrs[MAX_DEVICES];
+    float windows[2][WINDOW_LEN];
+    int res = GRC_OK;
+    for (int i = 0; (i < n) && (res >= 0); i++) {
+        ll_devs[i] = (struct grc_ll_sim_dev) { .type = PROTOCOL_INTERFACE_SIM, .config = GRC_SIM_DEFAULT_CONFIG };
+        ll_devs[i].config.sdk_version = 2;
+        if (i == n - 1) {
+            ll_devs[i].config.function_us *= slow_factor;
+            ll_devs[i].config.bus_hz /= slow_factor;
+        }
+        devs[i] = (struct grc_device) { .ll_dev = &ll_devs[i] };
+        dev_ptrs[i] = &devs[i];
+        struct grc_config conf = { .arch = I3_N10 };
+        res = grc_init(&devs[i], &conf);
+    }
+    for (int cls = 0; (cls < 2) && (res >= 0); cls++) {
+        struct grc_training_params t_params = { .flags = GRC_PARAMS_ADD_NEW_TAG };
+        fill_window(windows[cls], (float)cls);
+        res = grc_train(&devs[0], &t_params, windows[cls], WINDOW_LEN);
+    }
+    struct grc_pool* pool = res >= 0 ? grc_pool_create(dev_ptrs, n) : NULL;
+    if (pool != NULL) {
+        res = grc_pool_replicate(pool, 0);
+        for (int i = 0; i < n; i++) {
+            struct grc_pool_stats stats;
+            grc_pool_get_stats(pool, i, &stats, 1);
+        }
+    } else if (res >= 0) {
+        res = GRC_NO_MEMORY;
+    }
+
+    finished = 0;
+    misclassified = 0;
+    failure = 0;
+    uint32_t total = (uint32_t)n * per_device;
+    uint32_t submitted = 0;
+    uint64_t start = grc_sim_time_us();
+    while ((res >= 0) && (submitted < total)) {
+        int expected = submitted % 2;
+        res = grc_pool_inference(pool, windows[expected], WINDOW_LEN, inference_done, (void*)(intptr_t)expected);
+        if (res == GRC_IS_BUSY) {
+            // the queues are full, wait for a finished window
+            pthread_mutex_lock(&done_lock);
+            uint32_t seen = finished;
+            while (finished == seen) {
+                pthread_cond_wait(&done_cond, &done_lock);
+            }
+            pthread_mutex_unlock(&done_lock);
+            res = GRC_OK;
+            continue;
+        }
+        submitted++;
+    }
+
+    result->stolen = 0;
+    if (pool != NULL) {
+        grc_pool_wait(pool);
+        result->rate = finished / ((grc_sim_time_us() - start) / 1e6);
+        for (int i = 0; i < n; i++) {
+            struct grc_pool_stats stats;
+            grc_pool_get_stats(pool, i, &stats, 0);
+            result->stolen += stats.stolen;
+            if (verbose) {
+                printf("    device %2d: %6llu inferences, %5llu stolen, %5.1f%% busy\n", i,
+                    (unsigned long long)stats.inferences, (unsigned long long)stats.stolen, 100.0 * stats.utilisation);
+            }
+        }
+        grc_pool_destroy(pool);
+    }
+    for (int i = 0; i < n; i++) {
+        grc_release(&devs[i]);
+        grc_sim_module_destroy(ll_devs[i].module);
+    }
+    if (misclassified > 0) {
+        printf("%u inferences returned a wrong class\n", misclassified);
+    }
+    return res < 0 ? res : failure;
+}
+
+int main(int argc, char** argv)
+{
+    int max_devices = argc > 1 ? atoi(argv[1]) : 8;
+    int per_device = argc > 2 ? atoi(argv[2]) : 64;
+    uint32_t slow_factor = argc > 3 ? (uint32_t)atoi(argv[3]) : 4;
+    if ((max_devices < 1) || (max_devices > MAX_DEVICES) || (per_device < 1) || (slow_factor < 2)) {
+        printf("usage: pool_bench [max devices 1..%d] [windows per device] [slow factor >= 2]\n", MAX_DEVICES);
+        return 1;
+    }
+
+    // rates of one device alone, the slow one runs its share of the windows
+    struct run_result fast;
+    struct run_result slow;
+    int res = bench(1, per_device, 1, 0, &fast);
+    res = res < 0 ? res : bench(1, (per_device + slow_factor - 1) / slow_factor, slow_factor, 0, &slow);
+    if (res < 0) {
+        printf("failed with %d\n", res);
+        return 1;
+    }
+    printf("one device alone: %.1f inferences/s, %u times slower: %.1f inferences/s\n", fast.rate, slow_factor,
+        slow.rate);
+
+    int violations = 0;
+    for (int n = 2; n <= max_devices; n *= 2) {
+        struct run_result uniform;
+        struct run_result skewed;
+        printf("%d devices, uniform\n", n);
+        res = bench(n, per_device, 1, 1, &uniform);
+        if (res >= 0) {
+            double speedup = uniform.rate / fast.rate;
+            printf("    %.1f inferences/s, %.2fx of one device\n", uniform.rate, speedup);
+            if (speedup > n * SCALING_TOLERANCE) {
+                printf("    speedup above %d devices, the baseline is off\n", n);
+                violations++;
+            }
+            printf("%d devices, last one %u times slower\n", n, slow_factor);
+            res = bench(n, per_device, slow_factor, 1, &skewed);
+        }
+        if (res < 0) {
+            printf("failed with %d\n", res);
+            return 1;
+        }
+        double capacity = (n - 1) * fast.rate + slow.rate;
+        printf("    %.1f inferences/s, %.0f%% of its devices alone, %llu stolen\n", skewed.rate,
+            100.0 * skewed.rate / capacity, (unsigned long long)skewed.stolen);
+        if (skewed.stolen == 0) {
+            printf("    no window was stolen from the slow device\n");
+            violations++;
+        }
+    }
+    return violations > 0 ? 1 : 0;
+}
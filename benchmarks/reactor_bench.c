@@ -0,0 +1,206 @@
+// Many GRC devices from one thread: a thread per device with the blocking API against one grc_reactor thread.
+// CPU time and context switches are those of the whole process, including the simulated modules.
+// The simulated bus transfers sleep in the calling thread and are not overlapped by the reactor: at the default
+// 400 kHz they dominate, run with bus hz 0 to compare how the waits for GRC are overlapped.
+//
+// build: cc -O2 -I. benchmarks/reactor_bench.c grc/i2c/*.c grc/drivers/sim/grc_sim_module.c -lpthread -lm
+// usage: reactor_bench [max devices] [seconds per run] [sdk version] [ready line 0/1] [bus hz, 0 - no transfer time]
+
+#include "grc/drivers/sim/grc_sim_impl.h"
+#include "grc/grc.h"
+#include "grc/grc_reactor.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+
+#define WINDOW_LEN 128
+
+struct bench_device {
+    pthread_t thread;
+    struct grc_ll_sim_dev ll_dev;
+    struct grc_device dev;
+    float windows[2][WINDOW_LEN];
+    uint64_t deadline_us;
+    uint32_t inferences;
+    uint32_t misclassified;
+    int error;
+    struct grc_reactor* reactor;
+};
+
+struct bench_result {
+    double rate;
+    double cpu_us_per_inference;
+    double switches_per_inference;
+};
+
+static void fill_window(float* window, float level)
+{
+    for (int i = 0; i < WINDOW_LEN; i++) {
+        window[i] = level + 0.01f * (float)(i % 7);
+    }
+}
+
+static int setup_device(struct bench_device* d, const struct grc_sim_config* config)
+{
+    d->ll_dev = (struct grc_ll_sim_dev) { .type = PROTOCOL_INTERFACE_SIM, .config = *config };
+    d->dev = (struct grc_device) { .ll_dev = &d->ll_dev };
+    struct grc_config conf = { .arch = I3_N10 };
+    int res = grc_init(&d->dev, &conf);
+    for (int cls = 0; (cls < 2) && (res >= 0); cls++) {
+        struct grc_training_params t_params = { .flags = GRC_PARAMS_ADD_NEW_TAG };
+        fill_window(d->windows[cls], (float)cls);
+        res = grc_train(&d->dev, &t_params, d->windows[cls], WINDOW_LEN);
+    }
+    return res;
+}
+
+static void* blocking_run(void* arg)
+{
+    struct bench_device* d = (struct bench_device*)arg;
+    struct grc_inference_params i_params = { 0 };
+    while (grc_sim_time_us() < d->deadline_us) {
+        int expected = d->inferences % 2;
+        int res = grc_inference(&d->dev, &i_params, d->windows[expected], WINDOW_LEN);
+        if (res < 0) {
+            d->error = res;
+            return NULL;
+        }
+        d->misclassified += (res != expected);
+        d->inferences++;
+    }
+    return NULL;
+}
+
+// the next window of the device is queued from the callback of the previous one
+static void reactor_done(int status, void* user_data)
+{
+    struct bench_device* d = (struct bench_device*)user_data;
+    if (status < 0) {
+        d->error = status;
+        return;
+    }
+    d->misclassified += (status != (int)(d->inferences % 2));
+    d->inferences++;
+    if (grc_sim_time_us() < d->deadline_us) {
+        int res = grc_reactor_inference(d->reactor, &d->dev, d->windows[d->inferences % 2], WINDOW_LEN, reactor_done, d);
+        if (res < 0) {
+            d->error = res;
+        }
+    }
+}
+
+static int reactor_run(struct bench_device* devices, int n)
+{
+    struct grc_reactor* reactor = grc_reactor_create();
+    if (reactor == NULL) {
+        return GRC_NO_MEMORY;
+    }
+    int res = GRC_OK;
+    for (int i = 0; (i < n) && (res >= 0); i++) {
+        devices[i].reactor = reactor;
+        res = grc_reactor_add(reactor, &devices[i].dev);
+        if (res >= 0) {
+            res = grc_reactor_inference(reactor, &devices[i].dev, devices[i].windows[0], WINDOW_LEN, reactor_done, &devices[i]);
+        }
+    }
+    while ((res >= 0) && (grc_reactor_pending(reactor) > 0)) {
+        res = grc_reactor_run(reactor, -1);
+    }
+    grc_reactor_destroy(reactor);
+    return res;
+}
+
+static double cpu_us(const struct rusage* usage)
+{
+    return usage->ru_utime.tv_sec * 1e6 + usage->ru_utime.tv_usec + usage->ru_stime.tv_sec * 1e6 + usage->ru_stime.tv_usec;
+}
+
+static int bench(int n, int seconds, const struct grc_sim_config* config, int use_reactor, struct bench_result* result)
+{
+    struct bench_device* devices = (struct bench_device*)calloc(n, sizeof(struct bench_device));
+    int res = GRC_OK;
+    for (int i = 0; (i < n) && (res >= 0); i++) {
+        res = setup_device(&devices[i], config);
+    }
+
+    struct rusage before, after;
+    getrusage(RUSAGE_SELF, &before);
+    uint64_t start = grc_sim_time_us();
+    for (int i = 0; i < n; i++) {
+        devices[i].deadline_us = start + (uint64_t)seconds * 1000000u;
+    }
+    if (res >= 0) {
+        if (use_reactor) {
+            res = reactor_run(devices, n);
+        } else {
+            for (int i = 0; i < n; i++) {
+                pthread_create(&devices[i].thread, NULL, blocking_run, &devices[i]);
+            }
+            for (int i = 0; i < n; i++) {
+                pthread_join(devices[i].thread, NULL);
+            }
+        }
+    }
+    double elapsed = (grc_sim_time_us() - start) / 1e6;
+    getrusage(RUSAGE_SELF, &after);
+
+    uint32_t total = 0;
+    uint32_t misclassified = 0;
+    for (int i = 0; i < n; i++) {
+        if ((res >= 0) && (devices[i].error < 0)) {
+            res = devices[i].error;
+        }
+        total += devices[i].inferences;
+        misclassified += devices[i].misclassified;
+        grc_release(&devices[i].dev);
+        grc_sim_module_destroy(devices[i].ll_dev.module);
+    }
+    free(devices);
+    if (misclassified > 0) {
+        printf("%u inferences returned a wrong class\n", misclassified);
+    }
+    long switches = (after.ru_nvcsw + after.ru_nivcsw) - (before.ru_nvcsw + before.ru_nivcsw);
+    result->rate = total / elapsed;
+    result->cpu_us_per_inference = total ? (cpu_us(&after) - cpu_us(&before)) / total : 0;
+    result->switches_per_inference = total ? (double)switches / total : 0;
+    return res;
+}
+
+int main(int argc, char** argv)
+{
+    int max_devices = argc > 1 ? atoi(argv[1]) : 12;
+    int seconds = argc > 2 ? atoi(argv[2]) : 2;
+    struct grc_sim_config config = GRC_SIM_DEFAULT_CONFIG;
+    config.sdk_version = argc > 3 ? (uint32_t)atoi(argv[3]) : 2;
+    config.ready_line = argc > 4 ? (uint32_t)atoi(argv[4]) : 0;
+    config.bus_hz = argc > 5 ? (uint32_t)atoi(argv[5]) : config.bus_hz;
+    if ((max_devices < 1) || (seconds < 1)) {
+        printf("usage: reactor_bench [max devices] [seconds per run] [sdk version] [ready line 0/1] [bus hz]\n");
+        return 1;
+    }
+
+    printf("%8s %30s %30s\n", "", "thread per device", "one reactor thread");
+    printf("%8s", "devices");
+    for (int m = 0; m < 2; m++) {
+        printf(" %12s %8s %8s", "inferences/s", "cpu us", "ctx sw");
+    }
+    printf("\n");
+    const int counts[] = { 1, 2, 4, 8, 12, 16, 32 };
+    for (unsigned c = 0; (c < sizeof(counts) / sizeof(counts[0])) && (counts[c] <= max_devices); c++) {
+        printf("%8d", counts[c]);
+        for (int use_reactor = 0; use_reactor < 2; use_reactor++) {
+            struct bench_result result;
+            int res = bench(counts[c], seconds, &config, use_reactor, &result);
+            if (res < 0) {
+                printf(" %30s", "failed");
+                printf("\nerror %d\n", res);
+                return 1;
+            }
+            printf(" %12.1f %8.1f %8.2f", result.rate, result.cpu_us_per_inference, result.switches_per_inference);
+        }
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,426 @@
+// SDK overhead in one run, as CSV for tracking regressions across SDK releases:
+// - host: Crc8 throughput and float array block encoding by sendFloatArrayArguments, with its writes and bytes,
+//   against a transport discarding the writes
+// - remote: grc_train, grc_inference, grc_download and grc_upload round trips against the simulated module with
+//   modelled bus timing
+// Every row is per operation: bus transactions, bytes written and read, sleeps of the SDK and their total time, and
+// wall time. A metering transport in front of the driver counts them, so the SDK runs unchanged.
+//
+// build: cc -O2 -I. benchmarks/sdk_bench.c grc/i2c/*.c grc/drivers/sim/grc_sim_module.c -lpthread -lm
+// usage: sdk_bench [runs] [window length] [sdk version] [bus hz] > sdk_bench.csv
+
+#include "grc/drivers/grc_transport.h"
+#include "grc/drivers/sim/grc_sim_impl.h"
+#include "grc/grc.h"
+#include "grc/i2c/crc_calculation.h"
+#include "grc/i2c/grc_ll_protocol_commands.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define MAX_WINDOW_LEN 4096
+#define CLASSES 4
+#define DISCARD_MTU 4096
+
+struct meter {
+    uint64_t transactions;
+    uint64_t bytes_out;
+    uint64_t bytes_in;
+    uint64_t sleeps;
+    uint64_t sleep_us;
+};
+
+// device of the metering transport: the metered driver and its device
+struct metered_dev {
+    const struct grc_transport_ops* ops;
+    void* dev;
+    struct meter meter;
+};
+
+// ================ METERING TRANSPORT ====================
+static int meter_init(void* dev)
+{
+    struct metered_dev* m = (struct metered_dev*)dev;
+    return grc_transport_init(m->ops, m->dev);
+}
+
+static int meter_release(void* dev)
+{
+    struct metered_dev* m = (struct metered_dev*)dev;
+    return grc_transport_release(m->ops, m->dev);
+}
+
+static int meter_write(void* dev, const void* data, int len)
+{
+    struct metered_dev* m = (struct metered_dev*)dev;
+    m->meter.transactions++;
+    m->meter.bytes_out += len;
+    return grc_transport_write(m->ops, m->dev, data, len);
+}
+
+static int meter_writev(void* dev, const struct grc_ll_iovec* iov, int cnt)
+{
+    struct metered_dev* m = (struct metered_dev*)dev;
+    m->meter.transactions++;
+    for (int i = 0; i < cnt; i++) {
+        m->meter.bytes_out += iov[i].len;
+    }
+    return grc_transport_writev(m->ops, m->dev, iov, cnt);
+}
+
+static int meter_read(void* dev, void* data, int len)
+{
+    struct metered_dev* m = (struct metered_dev*)dev;
+    m->meter.transactions++;
+    m->meter.bytes_in += len;
+    return grc_transport_read(m->ops, m->dev, data, len);
+}
+
+static int meter_write_read(void* dev, const void* wdata, int wlen, void* rdata, int rlen)
+{
+    struct metered_dev* m = (struct metered_dev*)dev;
+    int res = grc_transport_write_read(m->ops, m->dev, wdata, wlen, rdata, rlen);
+    // the SDK writes and reads separately after NOT_IMPLEMENTED, nothing was sent
+    if (res != NOT_IMPLEMENTED) {
+        m->meter.transactions++;
+        m->meter.bytes_out += wlen;
+        m->meter.bytes_in += rlen;
+    }
+    return res;
+}
+
+static int meter_set_address(void* dev, uint16_t addr)
+{
+    struct metered_dev* m = (struct metered_dev*)dev;
+    return grc_transport_set_address(m->ops, m->dev, addr);
+}
+
+static int meter_get_address(void* dev)
+{
+    struct metered_dev* m = (struct metered_dev*)dev;
+    return grc_transport_get_address(m->ops, m->dev);
+}
+
+static int meter_mtu(void* dev)
+{
+    struct metered_dev* m = (struct metered_dev*)dev;
+    return grc_transport_mtu(m->ops, m->dev);
+}
+
+static int meter_wait_ready(void* dev, int timeout_ms)
+{
+    struct metered_dev* m = (struct metered_dev*)dev;
+    return grc_transport_wait_ready(m->ops, m->dev, timeout_ms);
+}
+
+static int meter_ready_fd(void* dev)
+{
+    struct metered_dev* m = (struct metered_dev*)dev;
+    return grc_transport_ready_fd(m->ops, m->dev);
+}
+
+static int meter_gpio_init(void* dev)
+{
+    struct metered_dev* m = (struct metered_dev*)dev;
+    return grc_transport_gpio_init(m->ops, m->dev);
+}
+
+static int meter_gpio_reset_high(void* dev)
+{
+    struct metered_dev* m = (struct metered_dev*)dev;
+    return grc_transport_gpio_reset_high(m->ops, m->dev);
+}
+
+static int meter_gpio_reset_low(void* dev)
+{
+    struct metered_dev* m = (struct metered_dev*)dev;
+    return grc_transport_gpio_reset_low(m->ops, m->dev);
+}
+
+static void meter_sleep_us(void* dev, uint32_t us)
+{
+    struct metered_dev* m = (struct metered_dev*)dev;
+    m->meter.sleeps++;
+    m->meter.sleep_us += us;
+    grc_transport_sleep_us(m->ops, m->dev, us);
+}
+
+static uint64_t meter_time_us(void* dev)
+{
+    struct metered_dev* m = (struct metered_dev*)dev;
+    return grc_transport_time_us(m->ops, m->dev);
+}
+
+static int meter_flush(void* dev)
+{
+    struct metered_dev* m = (struct metered_dev*)dev;
+    return grc_transport_flush(m->ops, m->dev);
+}
+
+static const struct grc_transport_ops meter_transport = {
+    .init = meter_init,
+    .release = meter_release,
+    .write = meter_write,
+    .writev = meter_writev,
+    .read = meter_read,
+    .write_read = meter_write_read,
+    .set_address = meter_set_address,
+    .get_address = meter_get_address,
+    .mtu = meter_mtu,
+    .wait_ready = meter_wait_ready,
+    .ready_fd = meter_ready_fd,
+    .gpio_init = meter_gpio_init,
+    .gpio_reset_high = meter_gpio_reset_high,
+    .gpio_reset_low = meter_gpio_reset_low,
+    .sleep_us = meter_sleep_us,
+    .time_us = meter_time_us,
+    .flush = meter_flush,
+};
+
+// ================ DISCARDING TRANSPORT ====================
+static void discard_sleep_us(void* dev, uint32_t us)
+{
+}
+
+static uint64_t discard_time_us(void* dev)
+{
+    return 0;
+}
+
+static int discard_init(void* dev)
+{
+    return GRC_OK;
+}
+
+static int discard_mtu(void* dev)
+{
+    return DISCARD_MTU;
+}
+
+static int discard_write(void* dev, const void* data, int len)
+{
+    return len;
+}
+
+static int discard_writev(void* dev, const struct grc_ll_iovec* iov, int cnt)
+{
+    int len = 0;
+    for (int i = 0; i < cnt; i++) {
+        len += iov[i].len;
+    }
+    return len;
+}
+
+static int discard_read(void* dev, void* data, int len)
+{
+    return len;
+}
+
+static const struct grc_transport_ops discard_transport = {
+    .init = discard_init,
+    .write = discard_write,
+    .writev = discard_writev,
+    .read = discard_read,
+    .mtu = discard_mtu,
+    .sleep_us = discard_sleep_us,
+    .time_us = discard_time_us,
+};
+
+// ===========================================================
+
+struct row {
+    const char* suite;
+    const char* operation;
+    unsigned size;
+    int runs;
+    struct meter meter;
+    double wall_us;
+    double bytes_processed;
+    int error;
+};
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void print_header(void)
+{
+    printf("suite,operation,size,sdk_version,bus_hz,runs,transactions,bytes_out,bytes_in,sleeps,sleep_us,wall_us,"
+           "mb_per_s,error\n");
+}
+
+// averages of the runs, mb_per_s is left empty for the round trips
+static void print_row(const struct row* r, uint32_t sdk_version, uint32_t bus_hz)
+{
+    double runs = r->runs > 0 ? r->runs : 1;
+    printf("%s,%s,%u,%u,%u,%d,%.2f,%.2f,%.2f,%.2f,%.1f,%.3f,", r->suite, r->operation, r->size, sdk_version, bus_hz,
+        r->runs, r->meter.transactions / runs, r->meter.bytes_out / runs, r->meter.bytes_in / runs,
+        r->meter.sleeps / runs, r->meter.sleep_us / runs, r->wall_us / runs);
+    if (r->bytes_processed > 0 && r->wall_us > 0) {
+        printf("%.2f", r->bytes_processed / r->wall_us);
+    }
+    printf(",%d\n", r->error);
+}
+
+static void fill_window(float* window, unsigned len, float level)
+{
+    for (unsigned i = 0; i < len; i++) {
+        window[i] = level + 0.01f * (float)(i % 7);
+    }
+}
+
+// ================ HOST PATHS ====================
+
+static struct row bench_crc(int runs, uint8_t block_len)
+{
+    struct row r = { .suite = "host", .operation = "crc8", .size = block_len, .runs = runs * 1000 };
+    static uint8_t block[255];
+    volatile uint8_t sink = 0;
+    double start = now_us();
+    for (int i = 0; i < r.runs; i++) {
+        block[0] = (uint8_t)i;
+        sink ^= Crc8(block, block_len);
+    }
+    r.wall_us = now_us() - start;
+    r.bytes_processed = (double)r.runs * block_len;
+    return r;
+}
+
+static struct row bench_encode(int runs, unsigned window_len)
+{
+    struct row r = { .suite = "host", .operation = "send_float_array", .size = window_len, .runs = runs * 10 };
+    static float window[MAX_WINDOW_LEN];
+    fill_window(window, window_len, 0.5f);
+    struct metered_dev dev = { .ops = &discard_transport };
+    static struct ProtocolContext ctx;
+    ctx.transport = &meter_transport;
+    ctx.ll_dev = &dev;
+    r.error = initProtocolCommands(&ctx);
+    if (r.error < 0) {
+        return r;
+    }
+    if (window_len > getMaxFloatArrayLen(&ctx)) {
+        r.error = ARGUMENT_ERROR;
+        return r;
+    }
+    dev.meter = (struct meter) { 0 };
+    double start = now_us();
+    for (int i = 0; i < r.runs && r.error >= 0; i++) {
+        uint8_t block_cnt;
+        r.error = sendFloatArrayArguments(&ctx, window_len, window, &block_cnt);
+    }
+    r.wall_us = now_us() - start;
+    r.meter = dev.meter;
+    r.bytes_processed = (double)r.runs * window_len * sizeof(float);
+    r.error = r.error < 0 ? r.error : GRC_OK;
+    return r;
+}
+
+// ================ ROUND TRIPS ====================
+
+static int bench_remote(int runs, unsigned window_len, uint32_t sdk_version, uint32_t bus_hz)
+{
+    struct row rows[] = {
+        { .suite = "remote", .operation = "grc_train", .size = window_len },
+        { .suite = "remote", .operation = "grc_inference", .size = window_len },
+        { .suite = "remote", .operation = "grc_download", .size = CLASSES },
+        { .suite = "remote", .operation = "grc_upload", .size = CLASSES },
+    };
+    struct row* train = &rows[0];
+    struct row* inference = &rows[1];
+    struct row* download = &rows[2];
+    struct row* upload = &rows[3];
+
+    struct grc_ll_sim_dev sim = { .type = PROTOCOL_INTERFACE_SIM, .config = GRC_SIM_DEFAULT_CONFIG };
+    sim.config.sdk_version = sdk_version;
+    sim.config.bus_hz = bus_hz;
+    struct metered_dev ll_dev = { .ops = &grc_sim_transport, .dev = &sim };
+    struct grc_device dev = { .ll_dev = &ll_dev, .transport = &meter_transport };
+    struct grc_config conf = { .arch = I3_N10 };
+    static float windows[CLASSES][MAX_WINDOW_LEN];
+    int res = grc_init(&dev, &conf);
+
+    // one operation at a time, the meter and the clock are read around each call
+#define MEASURE(r, call)                                      \
+    do {                                                      \
+        ll_dev.meter = (struct meter) { 0 };                  \
+        double start = now_us();                              \
+        res = (call);                                         \
+        (r)->wall_us += now_us() - start;                     \
+        (r)->meter.transactions += ll_dev.meter.transactions; \
+        (r)->meter.bytes_out += ll_dev.meter.bytes_out;       \
+        (r)->meter.bytes_in += ll_dev.meter.bytes_in;         \
+        (r)->meter.sleeps += ll_dev.meter.sleeps;             \
+        (r)->meter.sleep_us += ll_dev.meter.sleep_us;         \
+        (r)->runs++;                                          \
+        (r)->error = res < 0 ? res : (r)->error;              \
+    } while (0)
+
+    for (int cls = 0; cls < CLASSES && res >= 0; cls++) {
+        struct grc_training_params t_params = { .flags = GRC_PARAMS_ADD_NEW_TAG };
+        fill_window(windows[cls], window_len, (float)cls);
+        MEASURE(train, grc_train(&dev, &t_params, windows[cls], window_len));
+    }
+    struct grc_inference_params i_params = { 0 };
+    for (int i = 0; i < runs && res >= 0; i++) {
+        MEASURE(inference, grc_inference(&dev, &i_params, windows[i % CLASSES], window_len));
+        if (res >= 0 && res != i % CLASSES) {
+            inference->error = res = WRONG_GRC_ANSWER;
+        }
+    }
+    struct grc_internal_state state = { 0 };
+    uint32_t len = 0;
+    // the state of the last download is uploaded
+    for (int i = 0; i < runs && res >= 0; i++) {
+        free(state.values);
+        state = (struct grc_internal_state) { 0 };
+        MEASURE(download, grc_download(&dev, &state, &len));
+    }
+    for (int i = 0; i < runs && res >= 0; i++) {
+        res = grc_clear_state(&dev);
+        if (res >= 0) {
+            MEASURE(upload, grc_upload(&dev, &state, CLASSES));
+        }
+    }
+    if (res >= 0 && grc_get_classes_number(&dev) != CLASSES) {
+        upload->error = res = WRONG_GRC_ANSWER;
+    }
+#undef MEASURE
+    free(state.values);
+    grc_release(&dev);
+    grc_sim_module_destroy(sim.module);
+
+    for (unsigned i = 0; i < sizeof(rows) / sizeof(rows[0]); i++) {
+        print_row(&rows[i], sdk_version, bus_hz);
+    }
+    return res < 0 ? res : GRC_OK;
+}
+
+int main(int argc, char** argv)
+{
+    int runs = argc > 1 ? atoi(argv[1]) : 20;
+    int window_len = argc > 2 ? atoi(argv[2]) : 128;
+    uint32_t sdk_version = argc > 3 ? atoi(argv[3]) : 2;
+    uint32_t bus_hz = argc > 4 ? atoi(argv[4]) : 400000;
+    if (runs < 1 || window_len < 1 || window_len > MAX_WINDOW_LEN) {
+        fprintf(stderr, "usage: sdk_bench [runs] [window length <= %d] [sdk version] [bus hz]\n", MAX_WINDOW_LEN);
+        return 1;
+    }
+
+    print_header();
+    const uint8_t crc_lens[] = { 9, 63, 251 };
+    for (unsigned i = 0; i < sizeof(crc_lens); i++) {
+        struct row r = bench_crc(runs * 100, crc_lens[i]);
+        print_row(&r, sdk_version, 0);
+    }
+    const unsigned window_lens[] = { 16, 128, 1024, MAX_WINDOW_LEN };
+    for (unsigned i = 0; i < sizeof(window_lens) / sizeof(window_lens[0]); i++) {
+        struct row r = bench_encode(runs, window_lens[i]);
+        print_row(&r, sdk_version, 0);
+    }
+    return bench_remote(runs, (unsigned)window_len, sdk_version, bus_hz) < 0 ? 1 : 0;
+}
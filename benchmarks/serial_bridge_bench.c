@@ -0,0 +1,136 @@
+// GRC behind a serial bridge, end to end over a pty pair: a bridge thread answers the frames on the pty master
+// with a simulated module, the SDK talks to the pty slave with the serial transport. Reports serial exchanges,
+// tunnelled I2C transactions and time per inference with the transactions batched into one exchange per reply
+// and sent one by one. The reply delay models the latency of a USB CDC link.
+//
+// build: cc -O2 -I. benchmarks/serial_bridge_bench.c grc/i2c/*.c grc/drivers/sim/grc_sim_module.c grc/drivers/serial/grc_serial_link.c -lpthread -lm
+// usage: serial_bridge_bench [inferences] [reply delay us] [function us]
+
+// posix_openpt and ptsname
+#define _XOPEN_SOURCE 600
+#define _DEFAULT_SOURCE
+
+#include "grc/drivers/serial/grc_serial_impl.h"
+#include "grc/grc.h"
+#define GRC_TRANSPORT_NO_DEFAULT
+#include "grc/drivers/sim/grc_sim_impl.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define WINDOW_LEN 128
+
+struct bridge {
+    int master_fd;
+    struct grc_ll_sim_dev sim;
+    uint32_t reply_delay_us;
+    int result;
+};
+
+static void* bridge_thread(void* arg)
+{
+    struct bridge* b = (struct bridge*)arg;
+    b->result = grc_serial_bridge_serve(b->master_fd, &grc_sim_transport, &b->sim, b->reply_delay_us);
+    return NULL;
+}
+
+static void fill_window(float* window, float level)
+{
+    for (int i = 0; i < WINDOW_LEN; i++) {
+        window[i] = level + 0.01f * (float)(i % 7);
+    }
+}
+
+static int bench(int unbatched, int inferences, uint32_t reply_delay_us, uint32_t function_us)
+{
+    struct bridge b = { .reply_delay_us = reply_delay_us };
+    b.sim = (struct grc_ll_sim_dev) { .type = PROTOCOL_INTERFACE_SIM, .config = GRC_SIM_DEFAULT_CONFIG };
+    b.sim.config.sdk_version = 2;
+    b.sim.config.function_us = function_us;
+    int res = grc_sim_transport.init(&b.sim);
+    if (res < 0) {
+        return res;
+    }
+    b.master_fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if ((b.master_fd < 0) || (grantpt(b.master_fd) < 0) || (unlockpt(b.master_fd) < 0)) {
+        return I2C_ERROR;
+    }
+    // the master reads fail while no slave is open, this one keeps the link up until the end
+    int keep_fd = open(ptsname(b.master_fd), O_RDWR | O_NOCTTY);
+    pthread_t thread;
+    if ((keep_fd < 0) || (pthread_create(&thread, NULL, bridge_thread, &b) != 0)) {
+        return I2C_ERROR;
+    }
+
+    struct grc_ll_serial_dev ll_dev = {
+        .type = PROTOCOL_INTERFACE_SERIAL,
+        .tty_path = ptsname(b.master_fd),
+        .slave_addr = 0x36,
+        .unbatched = (uint8_t)unbatched,
+    };
+    struct grc_device dev = { .ll_dev = &ll_dev, .transport = &grc_serial_transport };
+    struct grc_config conf = { .arch = I3_N10 };
+    float windows[2][WINDOW_LEN];
+    res = grc_init(&dev, &conf);
+    for (int cls = 0; (cls < 2) && (res >= 0); cls++) {
+        struct grc_training_params t_params = { .flags = GRC_PARAMS_ADD_NEW_TAG };
+        fill_window(windows[cls], (float)cls);
+        res = grc_train(&dev, &t_params, windows[cls], WINDOW_LEN);
+    }
+
+    memset(&ll_dev.stats, 0, sizeof(ll_dev.stats));
+    struct grc_sim_stats i2c;
+    grc_sim_module_get_stats(b.sim.module, &i2c, 1);
+    uint64_t start = grc_sim_time_us();
+    int wrong = 0;
+    struct grc_inference_params params = { 0 };
+    for (int i = 0; (i < inferences) && (res >= 0); i++) {
+        res = grc_inference(&dev, &params, windows[i % 2], WINDOW_LEN);
+        wrong += (res >= 0) && (res != i % 2);
+    }
+    double ms = (grc_sim_time_us() - start) / 1e3 / inferences;
+    grc_sim_module_get_stats(b.sim.module, &i2c, 0);
+    if (res >= 0) {
+        struct grc_serial_stats* s = &ll_dev.stats;
+        printf("%10s %10.1f %10.1f %10.1f %12.1f %12.1f %10.3f\n", unbatched ? "unbatched" : "batched",
+            (double)s->exchanges / inferences, (double)s->transactions / inferences,
+            (double)(i2c.writes + i2c.reads + i2c.combined) / inferences, (double)s->bytes_sent / inferences,
+            (double)s->bytes_received / inferences, ms);
+    }
+    if (wrong > 0) {
+        printf("%d inferences returned a wrong class\n", wrong);
+        res = res < 0 ? res : WRONG_GRC_ANSWER;
+    }
+
+    int released = grc_release(&dev);
+    close(keep_fd);
+    pthread_join(thread, NULL);
+    close(b.master_fd);
+    grc_sim_module_destroy(b.sim.module);
+    res = res < 0 ? res : released;
+    return res < 0 ? res : b.result;
+}
+
+int main(int argc, char** argv)
+{
+    int inferences = argc > 1 ? atoi(argv[1]) : 50;
+    uint32_t reply_delay_us = argc > 2 ? (uint32_t)atoi(argv[2]) : 1000;
+    uint32_t function_us = argc > 3 ? (uint32_t)atoi(argv[3]) : 200;
+    if (inferences < 1) {
+        printf("usage: serial_bridge_bench [inferences] [reply delay us] [function us]\n");
+        return 1;
+    }
+    printf("per inference, window of %d floats, reply delay %u us, module computes %u us\n", WINDOW_LEN,
+        reply_delay_us, function_us);
+    printf("%10s %10s %10s %10s %12s %12s %10s\n", "link", "exchanges", "tunnelled", "i2c", "bytes out", "bytes in",
+        "ms");
+    for (int unbatched = 0; unbatched < 2; unbatched++) {
+        int res = bench(unbatched, inferences, reply_delay_us, function_us);
+        if (res < 0) {
+            printf("failed with %d\n", res);
+            return 1;
+        }
+    }
+    return 0;
+}
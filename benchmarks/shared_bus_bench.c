@@ -0,0 +1,190 @@
+// Several GRC modules on one simulated I2C bus: the modules are found with grc_scan, then classify windows
+// one device at a time with the blocking API and interleaved by one grc_reactor, which moves the windows
+// of the other modules while one computes. Reports inference rate and the time share the bus carries data.
+//
+// build: cc -O2 -I. benchmarks/shared_bus_bench.c grc/i2c/*.c grc/drivers/sim/grc_sim_module.c -lpthread -lm
+// usage: shared_bus_bench [max modules] [inferences per module] [function us] [bus hz]
+
+#include "grc/drivers/sim/grc_sim_impl.h"
+#include "grc/grc.h"
+#include "grc/grc_reactor.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define WINDOW_LEN 128
+#define MAX_MODULES 8
+#define FIRST_ADDR 0x30
+
+struct bench_device {
+    struct grc_ll_sim_dev ll_dev;
+    struct grc_device dev;
+    struct grc_reactor* reactor;
+    float windows[2][WINDOW_LEN];
+    int inferences;
+    int target;
+    int wrong;
+    int failure;
+};
+
+static void fill_window(float* window, float level)
+{
+    for (int i = 0; i < WINDOW_LEN; i++) {
+        window[i] = level + 0.01f * (float)(i % 7);
+    }
+}
+
+static void reactor_done(int status, void* user_data)
+{
+    struct bench_device* d = (struct bench_device*)user_data;
+    if (status < 0) {
+        d->failure = status;
+        return;
+    }
+    d->wrong += (status != d->inferences % 2);
+    if (++d->inferences < d->target) {
+        int res = grc_reactor_inference(d->reactor, &d->dev, d->windows[d->inferences % 2], WINDOW_LEN, reactor_done, d);
+        if (res < 0) {
+            d->failure = res;
+        }
+    }
+}
+
+static int run_interleaved(struct bench_device* devices, int n)
+{
+    struct grc_reactor* reactor = grc_reactor_create();
+    if (reactor == NULL) {
+        return GRC_NO_MEMORY;
+    }
+    int res = GRC_OK;
+    for (int i = 0; (i < n) && (res >= 0); i++) {
+        devices[i].reactor = reactor;
+        res = grc_reactor_add(reactor, &devices[i].dev);
+        if (res >= 0) {
+            res = grc_reactor_inference(reactor, &devices[i].dev, devices[i].windows[0], WINDOW_LEN, reactor_done, &devices[i]);
+        }
+    }
+    while ((res >= 0) && (grc_reactor_pending(reactor) > 0)) {
+        res = grc_reactor_run(reactor, -1);
+    }
+    grc_reactor_destroy(reactor);
+    return res;
+}
+
+static int run_serial(struct bench_device* devices, int n, int inferences)
+{
+    struct grc_inference_params params = { 0 };
+    for (int k = 0; k < inferences; k++) {
+        for (int i = 0; i < n; i++) {
+            int res = grc_inference(&devices[i].dev, &params, devices[i].windows[k % 2], WINDOW_LEN);
+            if (res < 0) {
+                return res;
+            }
+            devices[i].wrong += (res != k % 2);
+            devices[i].inferences++;
+        }
+    }
+    return GRC_OK;
+}
+
+static int bench(int n, int inferences, uint32_t function_us, uint32_t bus_hz)
+{
+    struct grc_sim_bus* bus = grc_sim_bus_create(bus_hz);
+    if (bus == NULL) {
+        return GRC_NO_MEMORY;
+    }
+    struct grc_sim_config config = GRC_SIM_DEFAULT_CONFIG;
+    config.sdk_version = 2;
+    config.ready_line = 1;
+    config.function_us = function_us;
+    int res = GRC_OK;
+    for (int i = 0; (i < n) && (res >= 0); i++) {
+        struct grc_sim_module* module = grc_sim_module_create(&config);
+        res = module ? grc_sim_bus_attach(bus, FIRST_ADDR + 2 * i, module) : GRC_NO_MEMORY;
+    }
+
+    struct grc_ll_sim_dev scan_ll_dev = { .type = PROTOCOL_INTERFACE_SIM, .bus = bus };
+    struct grc_device scan_dev = { .ll_dev = &scan_ll_dev };
+    uint16_t addrs[MAX_MODULES];
+    uint64_t start = grc_sim_time_us();
+    res = res >= 0 ? grc_sim_transport.init(&scan_ll_dev) : res;
+    int found = res >= 0 ? grc_scan(&scan_dev, 0x08, 0x77, addrs, MAX_MODULES) : res;
+    grc_sim_transport.release(&scan_ll_dev);
+    if (found >= 0) {
+        printf("%d modules, scan found %d in %.1f ms:", n, found, (grc_sim_time_us() - start) / 1e3);
+        for (int i = 0; i < found; i++) {
+            printf(" 0x%02x", addrs[i]);
+        }
+        printf("\n");
+    }
+    res = found;
+
+    struct bench_device* devices = (struct bench_device*)calloc(MAX_MODULES, sizeof(struct bench_device));
+    if (devices == NULL) {
+        res = GRC_NO_MEMORY;
+    }
+    for (int i = 0; (i < found) && (res >= 0); i++) {
+        struct bench_device* d = &devices[i];
+        d->ll_dev = (struct grc_ll_sim_dev) { .type = PROTOCOL_INTERFACE_SIM, .bus = bus, .addr = addrs[i] };
+        d->dev = (struct grc_device) { .ll_dev = &d->ll_dev };
+        struct grc_config conf = { .arch = I3_N10 };
+        res = grc_init(&d->dev, &conf);
+        for (int cls = 0; (cls < 2) && (res >= 0); cls++) {
+            struct grc_training_params t_params = { .flags = GRC_PARAMS_ADD_NEW_TAG };
+            fill_window(d->windows[cls], (float)cls);
+            res = grc_train(&d->dev, &t_params, d->windows[cls], WINDOW_LEN);
+        }
+    }
+
+    for (int interleaved = 0; (interleaved < 2) && (res >= 0); interleaved++) {
+        for (int i = 0; i < found; i++) {
+            devices[i].inferences = 0;
+            devices[i].target = inferences;
+        }
+        struct grc_sim_bus_stats stats;
+        grc_sim_bus_get_stats(bus, &stats, 1);
+        start = grc_sim_time_us();
+        res = interleaved ? run_interleaved(devices, found) : run_serial(devices, found, inferences);
+        double elapsed = (grc_sim_time_us() - start) / 1e6;
+        grc_sim_bus_get_stats(bus, &stats, 1);
+        for (int i = 0; (i < found) && (res >= 0); i++) {
+            res = devices[i].failure;
+        }
+        if (res >= 0) {
+            printf("    %-12s %8.1f inferences/s, bus busy %5.1f%%\n", interleaved ? "interleaved" : "serial",
+                found * inferences / elapsed, 100.0 * stats.utilisation);
+        }
+    }
+
+    int wrong = 0;
+    for (int i = 0; (devices != NULL) && (i < found); i++) {
+        wrong += devices[i].wrong;
+        grc_release(&devices[i].dev);
+    }
+    if (wrong > 0) {
+        printf("%d inferences returned a wrong class\n", wrong);
+    }
+    free(devices);
+    grc_sim_bus_destroy(bus);
+    return res;
+}
+
+int main(int argc, char** argv)
+{
+    int max_modules = argc > 1 ? atoi(argv[1]) : 4;
+    int inferences = argc > 2 ? atoi(argv[2]) : 50;
+    uint32_t function_us = argc > 3 ? (uint32_t)atoi(argv[3]) : 10000;
+    uint32_t bus_hz = argc > 4 ? (uint32_t)atoi(argv[4]) : 400000;
+    if ((max_modules < 1) || (max_modules > MAX_MODULES) || (inferences < 1)) {
+        printf("usage: shared_bus_bench [max modules 1..%d] [inferences per module] [function us] [bus hz]\n", MAX_MODULES);
+        return 1;
+    }
+    for (int n = 1; n <= max_modules; n *= 2) {
+        int res = bench(n, inferences, function_us, bus_hz);
+        if (res < 0) {
+            printf("failed with %d\n", res);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+// Time to back up the AI SW state with grc_download and to provision a module with grc_upload.
+// Firmware of SDK version 1 transfers the state one float per remote call, version 2 streams it in CRC protected blocks.
+//
+// build: cc -O2 -I. benchmarks/state_transfer_bench.c grc/i2c/*.c grc/drivers/sim/grc_sim_module.c -lpthread -lm
+// usage: state_transfer_bench [classes] [floats per class]
+
+#include "grc/drivers/sim/grc_sim_impl.h"
+#include "grc/grc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define WINDOW_LEN 64
+
+struct bench_result {
+    uint32_t state_len;
+    double download_seconds;
+    double upload_seconds;
+    int error;
+};
+
+static struct bench_result bench_transfer(uint32_t sdk_version, uint32_t block_size, int classes, uint32_t floats_per_class)
+{
+    struct bench_result result = { 0 };
+    struct grc_ll_sim_dev ll_dev = { .type = PROTOCOL_INTERFACE_SIM, .config = GRC_SIM_DEFAULT_CONFIG };
+    ll_dev.config.sdk_version = sdk_version;
+    ll_dev.config.max_block_size = block_size;
+    ll_dev.config.state_floats_per_class = floats_per_class;
+    struct grc_device dev = { .ll_dev = &ll_dev };
+    struct grc_config conf = { .arch = I3_N10 };
+    float window[WINDOW_LEN];
+
+    result.error = grc_init(&dev, &conf);
+    for (int cls = 0; cls < classes && result.error >= 0; cls++) {
+        struct grc_training_params t_params = { .flags = GRC_PARAMS_ADD_NEW_TAG };
+        for (int i = 0; i < WINDOW_LEN; i++) {
+            window[i] = (float)cls;
+        }
+        result.error = grc_train(&dev, &t_params, window, WINDOW_LEN);
+    }
+    struct grc_internal_state state = { 0 };
+    if (result.error >= 0) {
+        uint32_t len = 0;
+        uint64_t start = grc_sim_time_us();
+        result.error = grc_download(&dev, &state, &len);
+        result.download_seconds = (grc_sim_time_us() - start) / 1e6;
+        result.state_len = state.len;
+    }
+    if (result.error >= 0) {
+        result.error = grc_clear_state(&dev);
+    }
+    if (result.error >= 0) {
+        uint64_t start = grc_sim_time_us();
+        result.error = grc_upload(&dev, &state, classes);
+        result.upload_seconds = (grc_sim_time_us() - start) / 1e6;
+    }
+    if (result.error >= 0 && grc_get_classes_number(&dev) != classes) {
+        result.error = WRONG_GRC_ANSWER;
+    }
+    free(state.values);
+    grc_release(&dev);
+    grc_sim_module_destroy(ll_dev.module);
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int classes = argc > 1 ? atoi(argv[1]) : 4;
+    uint32_t floats_per_class = argc > 2 ? atoi(argv[2]) : 500;
+
+    struct {
+        const char* name;
+        uint32_t sdk_version;
+        uint32_t block_size;
+    } runs[] = {
+        { "per float", 1, 0 },
+        { "block 32", 2, 32 },
+        { "block 128", 2, 128 },
+        { "block 255", 2, 255 },
+    };
+
+    struct bench_result base = { 0 };
+    printf("%10s %8s %12s %8s %12s %8s\n", "transfer", "floats", "download s", "speedup", "upload s", "speedup");
+    for (unsigned i = 0; i < sizeof(runs) / sizeof(runs[0]); i++) {
+        struct bench_result r = bench_transfer(runs[i].sdk_version, runs[i].block_size, classes, floats_per_class);
+        if (r.error < 0) {
+            printf("%10s failed with %d\n", runs[i].name, r.error);
+            continue;
+        }
+        if (i == 0) {
+            base = r;
+        }
+        printf("%10s %8u %12.3f %7.1fx %12.3f %7.1fx\n", runs[i].name, r.state_len,
+            r.download_seconds, base.download_seconds > 0 ? base.download_seconds / r.download_seconds : 0,
+            r.upload_seconds, base.upload_seconds > 0 ? base.upload_seconds / r.upload_seconds : 0);
+    }
+    return 0;
+}
@@ -0,0 +1,123 @@
+// Classification rate of a continuous stream classified on overlapping windows, on the simulated 400 kHz bus.
+// "resend" classifies each window with grc_inference, so every hop sends the whole window. "stream" uses
+// grc_stream_push: GRC firmware of SDK version 4 keeps the window and only the new samples of each hop are sent,
+// older firmware gets the whole window as with grc_inference.
+//
+// build: cc -O2 -I. benchmarks/stream_inference_bench.c grc/i2c/*.c grc/drivers/sim/grc_sim_module.c -lpthread -lm
+// usage: stream_inference_bench [window length] [hop length] [windows]
+
+#include "grc/drivers/sim/grc_sim_impl.h"
+#include "grc/grc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_WINDOW_LEN 4096
+
+struct bench_result {
+    struct grc_sim_stats bus;
+    double seconds;
+    int windows;
+    int error;
+};
+
+static float sample_at(uint64_t i)
+{
+    // classes 0 and 1 alternate every 4096 samples
+    return (float)((i / MAX_WINDOW_LEN) % 2) + 0.01f * (float)(i % 7);
+}
+
+static struct bench_result bench_stream(uint32_t sdk_version, int stream, int window_len, int hop_len, int windows)
+{
+    struct bench_result result = { 0 };
+    struct grc_ll_sim_dev ll_dev = { .type = PROTOCOL_INTERFACE_SIM, .config = GRC_SIM_DEFAULT_CONFIG };
+    ll_dev.config.sdk_version = sdk_version;
+    struct grc_device dev = { .ll_dev = &ll_dev };
+    struct grc_config conf = { .arch = I3_N10 };
+    static float window[MAX_WINDOW_LEN];
+    static float hop[MAX_WINDOW_LEN];
+
+    result.error = grc_init(&dev, &conf);
+    for (int cls = 0; cls < 2 && result.error >= 0; cls++) {
+        struct grc_training_params t_params = { .flags = GRC_PARAMS_ADD_NEW_TAG };
+        for (int i = 0; i < window_len; i++) {
+            window[i] = sample_at((uint64_t)cls * MAX_WINDOW_LEN + i);
+        }
+        result.error = grc_train(&dev, &t_params, window, window_len);
+    }
+    struct grc_stream_params s_params = { .window_len = window_len, .hop_len = hop_len };
+    if (result.error >= 0 && stream) {
+        result.error = grc_stream_begin(&dev, &s_params);
+    }
+    if (result.error >= 0) {
+        grc_sim_module_get_stats(ll_dev.module, &result.bus, 1);
+        struct grc_inference_params i_params = { 0 };
+        uint64_t pushed = 0;
+        uint64_t start = grc_sim_time_us();
+        int len = window_len;
+        while (result.windows < windows && result.error >= 0) {
+            float* dst = stream ? hop : window;
+            if (!stream) {
+                // host keeps the window itself and sends it whole
+                memmove(window, window + len, (window_len - len) * sizeof(float));
+                dst = window + window_len - len;
+            }
+            for (int i = 0; i < len; i++) {
+                dst[i] = sample_at(pushed++);
+            }
+            if (stream) {
+                result.error = grc_stream_push(&dev, hop, len);
+                result.windows += result.error > 0 ? result.error : 0;
+            } else {
+                result.error = grc_inference(&dev, &i_params, window, window_len);
+                result.error = result.error == NOT_CLASSIFIED ? GRC_OK : result.error;
+                result.windows++;
+            }
+            len = hop_len;
+        }
+        result.seconds = (grc_sim_time_us() - start) / 1e6;
+        grc_sim_module_get_stats(ll_dev.module, &result.bus, 0);
+    }
+    if (stream) {
+        grc_stream_end(&dev);
+    }
+    grc_release(&dev);
+    grc_sim_module_destroy(ll_dev.module);
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int window_len = argc > 1 ? atoi(argv[1]) : 512;
+    int hop_len = argc > 2 ? atoi(argv[2]) : 64;
+    int windows = argc > 3 ? atoi(argv[3]) : 100;
+    if (window_len < 1 || window_len > MAX_WINDOW_LEN || hop_len < 1 || hop_len > window_len || windows < 1) {
+        printf("usage: stream_inference_bench [window length <= %d] [hop length <= window length] [windows]\n",
+            MAX_WINDOW_LEN);
+        return 1;
+    }
+
+    struct {
+        const char* name;
+        uint32_t sdk_version;
+        int stream;
+    } runs[] = {
+        { "resend v2", 2, 0 },
+        { "stream v2", 2, 1 },
+        { "stream v4", 4, 1 },
+    };
+
+    printf("window of %d floats, hop of %d floats\n", window_len, hop_len);
+    printf("%12s %12s %10s %14s\n", "path", "bytes out", "ms", "windows/s");
+    for (unsigned i = 0; i < sizeof(runs) / sizeof(runs[0]); i++) {
+        struct bench_result r = bench_stream(runs[i].sdk_version, runs[i].stream, window_len, hop_len, windows);
+        if (r.error < 0) {
+            printf("%12s failed with %d\n", runs[i].name, r.error);
+            continue;
+        }
+        printf("%12s %12.1f %10.3f %14.1f\n", runs[i].name, (double)r.bus.bytes_written / r.windows,
+            r.seconds * 1000 / r.windows, r.windows / r.seconds);
+    }
+    return 0;
+}
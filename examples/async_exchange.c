@@ -53,7 +53,12 @@ void async_inference_example(float* data, int len)
     }
 
     // wait for the event from the callback
-    // or call grc_wait(&dev) instead
+    // or for the result with grc_wait(&dev) instead
+    res = grc_wait_timeout(&dev, 1000);
+    if (res < 0) {
+        // report error or GRC_TIMEOUT
+        goto out;
+    }
 
     struct grc_class_info info;
     for (int class_index = 0; class_index < res; class_index++) {
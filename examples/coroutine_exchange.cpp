@@ -0,0 +1,134 @@
+// Awaitable Grc methods on a GrcEventLoop: two simulated devices classify windows of a timer driven "sensor"
+// from one thread. Exits with 1 if a window gets a wrong class or a function fails.
+//
+// build: cc -O2 -I. -c grc/i2c/*.c grc/drivers/sim/grc_sim_module.c
+//        c++ -std=c++20 -O2 -I. examples/coroutine_exchange.cpp grc/Grc.cpp grc/GrcEventLoop.cpp *.o -lpthread -lm
+
+#include "grc/Grc.hpp"
+#include "grc/GrcEventLoop.hpp"
+#include "grc/drivers/sim/grc_sim_impl.h"
+
+#include <cstdio>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <vector>
+
+#define WINDOW_LEN 128
+#define WINDOW_CNT 20
+// period of the simulated sensor
+#define SENSOR_PERIOD_US 5000
+
+static const HP hp = {
+    .PredictSignal = 0,
+    .SeparateInaccuracies = 0,
+    .InputComponents = 3,
+    .OutputComponents = 0,
+    .Neurons = 10,
+    .SpectralRadius = 0.0f,
+    .Sparsity = 0.0f,
+    .Noise = 0.0f,
+    .InputScaling = 1.0f,
+    .InputSparsity = 0.0f,
+    .FeedbackScaling = 1.0f,
+    .FeedbackSparsity = 0.0f,
+    .ThresholdFactor = 1.0f
+};
+
+static void fill_window(std::vector<float>& window, int level)
+{
+    for (int i = 0; i < WINDOW_LEN; i++) {
+        window[i] = level + 0.01f * (float)(i % 7);
+    }
+}
+
+// sensor samples are ready when the timer expires
+static int open_sensor()
+{
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    struct itimerspec spec = {};
+    spec.it_interval.tv_nsec = SENSOR_PERIOD_US * 1000;
+    spec.it_value.tv_nsec = SENSOR_PERIOD_US * 1000;
+    timerfd_settime(fd, 0, &spec, nullptr);
+    return fd;
+}
+
+// returns the number of wrongly classified windows or error code (<0)
+static GrcTask<int> classify_sensor(GrcEventLoop& loop, const Grc& grc, const char* name)
+{
+    std::vector<float> window(WINDOW_LEN);
+    for (int cls = 0; cls < 2; cls++) {
+        fill_window(window, cls);
+        int res = co_await grc.trainAsync(window);
+        if (res < 0) {
+            co_return res;
+        }
+    }
+
+    int sensor = open_sensor();
+    int wrong = 0;
+    for (int i = 0; i < WINDOW_CNT; i++) {
+        int res = co_await loop.readable(sensor);
+        uint64_t expirations;
+        if ((res < 0) || (read(sensor, &expirations, sizeof(expirations)) != sizeof(expirations))) {
+            close(sensor);
+            co_return res < 0 ? res : I2C_ERROR;
+        }
+        fill_window(window, i % 2);
+        res = co_await grc.inferenceAsync(window);
+        if (res < 0) {
+            close(sensor);
+            co_return res;
+        }
+        wrong += (res != i % 2);
+    }
+    close(sensor);
+
+    std::vector<float> state;
+    int classes = co_await grc.saveAsync(state);
+    printf("%s: %d windows, %d wrong, saved %d classes in %zu floats\n", name, WINDOW_CNT, wrong, classes, state.size());
+    co_return classes < 0 ? classes : wrong;
+}
+
+int main()
+{
+    // the fused inference device is driven by the loop's reactor on its data ready line,
+    // the SDK version 1 device with status polling
+    grc_ll_sim_dev fused = {
+        .type = PROTOCOL_INTERFACE_SIM, .config = GRC_SIM_DEFAULT_CONFIG, .module = nullptr, .bus = nullptr, .addr = 0
+    };
+    fused.config.sdk_version = 2;
+    fused.config.ready_line = 1;
+    grc_ll_sim_dev legacy = {
+        .type = PROTOCOL_INTERFACE_SIM, .config = GRC_SIM_DEFAULT_CONFIG, .module = nullptr, .bus = nullptr, .addr = 0
+    };
+
+    GrcEventLoop loop;
+    int failed = 0;
+    {
+        Grc first(&fused);
+        Grc second(&legacy);
+        if ((first.init(hp) < 0) || (second.init(hp) < 0)) {
+            printf("init failed\n");
+            return 1;
+        }
+        first.setExecutor(&loop);
+        second.setExecutor(&loop);
+
+        GrcTask<int> first_task = classify_sensor(loop, first, "sdk 2, ready line");
+        GrcTask<int> second_task = classify_sensor(loop, second, "sdk 1, polling");
+        int res = loop.run(first_task, second_task);
+        if (res < 0) {
+            printf("event loop failed with %d\n", res);
+            return 1;
+        }
+        for (int result : { first_task.result(), second_task.result() }) {
+            if (result != 0) {
+                printf("result %d\n", result);
+                failed = 1;
+            }
+        }
+    }
+    grc_sim_module_destroy(fused.module);
+    grc_sim_module_destroy(legacy.module);
+    return failed;
+}
@@ -1,24 +1,23 @@
 #include "grc/Grc.hpp"
+#include "grc/grc_reactor.h"
 #include <cstdlib>
 
-Grc::Grc(void* ll_dev)
+Grc::Grc(void* ll_dev, const grc_transport_ops* transport)
 {
-    dev_ = grc_device { .ll_dev = ll_dev, .version = 1 };
+    dev_ = grc_device { .ll_dev = ll_dev, .version = 1, .ctx = nullptr, .transport = transport };
 }
 
 Grc::~Grc()
 {
+#if GRC_COROUTINES
+    setExecutor(nullptr);
+#endif
     grc_release(&dev_);
 }
 
 int Grc::init(const HP& hp) const
 {
     struct grc_config conf = { .arch = uint32_t(ARCH_CONSTRUCTOR(0, hp.InputComponents, hp.Neurons, 0)) };
-    int res = grc_init(&dev_, &conf);
-    if (res < 0) {
-        return res;
-    }
-
     int config_len = 6;
     struct hp_setup config[config_len] = {
         hp_setup { .type = PREDICT_SIGNAL,
@@ -30,8 +29,7 @@ int Grc::init(const HP& hp) const
         hp_setup { .type = FEEDBACK_SCALING, .value = (float)hp.FeedbackScaling },
         hp_setup { .type = THRESHOLD_FACTOR, .value = (float)hp.ThresholdFactor }
     };
-    res = grc_set_config(&dev_, config, config_len);
-    return res;
+    return grc_init_config(&dev_, &conf, config, config_len, nullptr);
 }
 
 int Grc::clearState() const
@@ -52,6 +50,41 @@ int Grc::train(uint32_t len, const float* vals, int category) const
     return train_category;
 }
 
+int Grc::train(const ChunkSource& source, int category, uint32_t chunk_len) const
+{
+    if (chunk_len == 0) {
+        return ARGUMENT_ERROR;
+    }
+    struct grc_training_params training_params = {};
+    if (category >= 0) {
+        training_params.flags = GRC_PARAMS_OVERWRITE;
+        training_params.tag = category;
+    } else {
+        training_params.flags = GRC_PARAMS_ADD_NEW_TAG;
+    }
+    std::vector<float> chunk(chunk_len);
+    int res = grc_train_begin(&dev_, &training_params);
+    if (res < 0) {
+        return res;
+    }
+    while (true) {
+        int len = source(chunk.data(), chunk_len);
+        if (len == 0) {
+            break;
+        }
+        if (len < 0) {
+            grc_train_cancel(&dev_);
+            return len;
+        }
+        // a failed feed ends the training itself
+        res = grc_train_feed(&dev_, chunk.data(), len < (int)chunk_len ? len : chunk_len);
+        if (res < 0) {
+            return res;
+        }
+    }
+    return grc_train_end(&dev_);
+}
+
 int Grc::inference(uint32_t len, const float* vals, int category) const
 {
     struct grc_inference_params inf_params = {};
@@ -63,9 +96,9 @@ int Grc::inference(uint32_t len, const float* vals, int category) const
     return inf_category;
 }
 
-int Grc::wait() const
+int Grc::wait(int timeout_ms) const
 {
-    return GRC_OK;
+    return grc_wait_timeout(&dev_, timeout_ms);
 }
 
 int Grc::getQty() const
@@ -134,4 +167,75 @@ int Grc::restore() const
 int Grc::reset() const
 {
     return grc_device_reset(&dev_);
-}
\ No newline at end of file
+}
+
+#if GRC_COROUTINES
+
+void Grc::setExecutor(GrcExecutor* executor)
+{
+    if (executor_) {
+        executor_->detach(&dev_);
+    }
+    executor_ = executor;
+    reactor_ = executor ? executor->attach(&dev_) : nullptr;
+}
+
+GrcOperation Grc::inferenceAsync(std::span<const float> vals, int category) const
+{
+    grc_device* dev = &dev_;
+    grc_reactor* reactor = reactor_;
+    return GrcOperation(executor_, [dev, reactor, vals, category](grc_callback_t callback, void* user_data) {
+        // the reactor considers all classes
+        if (reactor && (category < 0)) {
+            return grc_reactor_inference(reactor, dev, vals.data(), vals.size(), callback, user_data);
+        }
+        struct grc_inference_params inf_params = {};
+        inf_params.flags = GRC_PARAMS_ASYNC;
+        if (category >= 0) {
+            inf_params.flags |= GRC_PARAMS_SINGLE_CLASS;
+            inf_params.tag = category;
+        }
+        inf_params.callback = callback;
+        inf_params.user_data = user_data;
+        return grc_inference(dev, &inf_params, vals.data(), vals.size());
+    });
+}
+
+GrcOperation Grc::trainAsync(std::span<const float> vals, int category) const
+{
+    grc_device* dev = &dev_;
+    return GrcOperation(executor_, [dev, vals, category](grc_callback_t callback, void* user_data) {
+        struct grc_training_params training_params = {};
+        if (category >= 0) {
+            training_params.flags = GRC_PARAMS_ASYNC | GRC_PARAMS_OVERWRITE;
+            training_params.tag = category;
+        } else {
+            training_params.flags = GRC_PARAMS_ASYNC | GRC_PARAMS_ADD_NEW_TAG;
+        }
+        training_params.callback = callback;
+        training_params.user_data = user_data;
+        return grc_train(dev, &training_params, vals.data(), vals.size());
+    });
+}
+
+struct SaveCall {
+    const Grc* grc;
+    std::vector<float>* data;
+};
+
+static int runSave(grc_device* dev, void* arg)
+{
+    SaveCall* call = static_cast<SaveCall*>(arg);
+    return call->grc->save(*call->data);
+}
+
+GrcOperation Grc::saveAsync(std::vector<float>& data) const
+{
+    grc_device* dev = &dev_;
+    // the call is kept in the operation until the callback
+    return GrcOperation(executor_, [dev, call = SaveCall { this, &data }](grc_callback_t callback, void* user_data) mutable {
+        return grc_submit(dev, runSave, &call, callback, user_data);
+    });
+}
+
+#endif // GRC_COROUTINES
@@ -1,10 +1,19 @@
 #ifndef _GRC_HPP_
 #define _GRC_HPP_
 
+#include "grc/GrcAsync.hpp"
 #include "grc/grc.h"
 
+#include <functional>
 #include <vector>
 
+#if GRC_COROUTINES
+#include <span>
+#endif
+
+class GrcExecutor;
+struct grc_reactor;
+
 /*!
  * \brief Hyper parameters to GRC AI SW.
  */
@@ -32,8 +41,9 @@ public:
     /*!
     * \brief Constructor.
     * \param ll_dev Pointer to grc ll device
+    * \param transport Driver functions for ll_dev, nullptr - grc_default_transport
     */
-    Grc(void* ll_dev);
+    Grc(void* ll_dev, const grc_transport_ops* transport = nullptr);
 
     /*!
     * \brief Destructor.
@@ -62,6 +72,19 @@ public:
     */
     int train(uint32_t len, const float *vals, int category) const;
     /*!
+    * \brief Source of a train series, fills buf with up to cap values.
+    * \return Number of values, 0 at the end of the series or error code (<0).
+    */
+    using ChunkSource = std::function<int(float *buf, uint32_t cap)>;
+    /*!
+    * \brief Train GRC AI SW on a series read in chunks, without holding all of it in memory.
+    * \param source Source of the series.
+    * \param category Overwrite specific category in GRC AI SW.
+    * \param chunk_len Number of values read from the source at once.
+    * \return Trained category or error code (<0).
+    */
+    int train(const ChunkSource &source, int category, uint32_t chunk_len = 1024) const;
+    /*!
     * \brief Inference on raw data.
     * \param len Inference data len.
     * \param vals Pointer to inference data.
@@ -70,10 +93,11 @@ public:
     */
     int inference(uint32_t len, const float *vals, int category = -1) const;
     /*!
-    * \brief (NOT IMPLEMENTED) Wait for train or inference execution end
-    * \return Ok(=0) or error code (<0)
+    * \brief Wait for train or inference execution end
+    * \param timeout_ms Maximum wait time, <0 - no limit.
+    * \return Result of the last finished function or error code (<0), GRC_TIMEOUT on timeout.
     */
-    int wait() const;
+    int wait(int timeout_ms = -1) const;
     /*!
     * \brief Get the number of trained categories.
     * \return Number of trained categories.
@@ -122,9 +146,42 @@ public:
     */
     int reset() const;
 
+#if GRC_COROUTINES
+    /*!
+    * \brief Set the executor resuming coroutines awaiting the device, after init.
+    * \param executor Executor, nullptr - coroutines are resumed on the thread finishing the function.
+    */
+    void setExecutor(GrcExecutor* executor);
+    /*!
+    * \brief Awaitable inference on raw data. The data stays valid until the inference is finished.
+    *        One function of the device is awaited at a time.
+    * \param vals Inference data.
+    * \param category Hint category.
+    * \return Awaitable of the inferenced category or error code (<0).
+    */
+    GrcOperation inferenceAsync(std::span<const float> vals, int category = -1) const;
+    /*!
+    * \brief Awaitable train on raw data, the data is copied.
+    * \param vals Train data.
+    * \param category Overwrite specific category in GRC AI SW.
+    * \return Awaitable of the trained category or error code (<0).
+    */
+    GrcOperation trainAsync(std::span<const float> vals, int category = -1) const;
+    /*!
+    * \brief Awaitable save, run on the device worker thread.
+    * \param data Where to save, valid until the save is finished.
+    * \return Awaitable of the number of trained categories or error code (<0).
+    */
+    GrcOperation saveAsync(std::vector<float> &data) const;
+#endif
+
 protected:
     /*! \brief Device structure. */
     mutable grc_device dev_;
+    /*! \brief Executor of the awaitable methods. */
+    GrcExecutor* executor_ = nullptr;
+    /*! \brief Reactor driving inference of the device, nullptr - the device worker thread. */
+    grc_reactor* reactor_ = nullptr;
 };
 
 #endif //_GRC_HPP_
\ No newline at end of file
@@ -0,0 +1,195 @@
+#ifndef _GRC_ASYNC_HPP_
+#define _GRC_ASYNC_HPP_
+
+#include "grc/grc.h"
+
+// awaitable Grc methods need C++20 coroutines
+#ifndef GRC_COROUTINES
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define GRC_COROUTINES 1
+#else
+#define GRC_COROUTINES 0
+#endif
+#endif
+
+#if GRC_COROUTINES
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <utility>
+
+struct grc_reactor;
+
+/*!
+ * \brief Resumes coroutines waiting for GRC devices.
+ */
+class GrcExecutor {
+public:
+    virtual ~GrcExecutor() = default;
+    /*!
+    * \brief Resume the coroutine on the executor. Called from any thread, also from device worker threads.
+    * \param handle Coroutine to resume.
+    */
+    virtual void post(std::coroutine_handle<> handle) = 0;
+    /*!
+    * \brief Device is used with the executor, called after the device is initialised.
+    * \param dev Device structure.
+    * \return Reactor driving inference of the device, nullptr - inference runs on the device worker thread.
+    */
+    virtual grc_reactor* attach(grc_device* dev) { return nullptr; }
+    /*!
+    * \brief Device is not used with the executor any more.
+    * \param dev Device structure.
+    */
+    virtual void detach(grc_device* dev) { }
+};
+
+struct GrcTaskPromiseBase {
+    /*! \brief Coroutine awaiting the task. */
+    std::coroutine_handle<> continuation_;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+        {
+            std::coroutine_handle<> continuation = handle.promise().continuation_;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() noexcept { }
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    // errors are reported with error codes
+    void unhandled_exception() noexcept { std::terminate(); }
+};
+
+template <typename T>
+struct GrcTaskPromise : GrcTaskPromiseBase {
+    T value_ {};
+    void return_value(T value) { value_ = std::move(value); }
+    T result() { return std::move(value_); }
+};
+
+template <>
+struct GrcTaskPromise<void> : GrcTaskPromiseBase {
+    void return_void() { }
+    void result() { }
+};
+
+/*!
+ * \brief Lazily started coroutine, runs when awaited or started by an event loop.
+ */
+template <typename T = void>
+class [[nodiscard]] GrcTask {
+public:
+    struct promise_type : GrcTaskPromise<T> {
+        GrcTask get_return_object() { return GrcTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+    };
+
+    GrcTask(GrcTask&& other) noexcept
+        : handle_(std::exchange(other.handle_, {}))
+    {
+    }
+    GrcTask(const GrcTask&) = delete;
+    GrcTask& operator=(const GrcTask&) = delete;
+    ~GrcTask()
+    {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        handle_.promise().continuation_ = awaiting;
+        return handle_;
+    }
+    T await_resume() { return handle_.promise().result(); }
+
+    /*!
+    * \brief Run the task until its first suspension, without awaiting it.
+    */
+    void start() { handle_.resume(); }
+    /*!
+    * \brief Whether the task has returned.
+    */
+    bool done() const { return handle_.done(); }
+    /*!
+    * \brief Value returned by the finished task.
+    */
+    T result() { return handle_.promise().result(); }
+
+private:
+    explicit GrcTask(std::coroutine_handle<promise_type> handle)
+        : handle_(handle)
+    {
+    }
+    std::coroutine_handle<promise_type> handle_;
+};
+
+/*!
+ * \brief Awaitable device function finished with grc_callback_t.
+ *        The coroutine is resumed on the executor, or on the thread finishing the function without one.
+ */
+class GrcOperation {
+public:
+    /*!
+    * \brief Starts the function.
+    * \return Ok(=0) if the callback will be called, otherwise the result of the operation.
+    */
+    using Start = std::function<int(grc_callback_t callback, void* user_data)>;
+
+    GrcOperation(GrcExecutor* executor, Start start)
+        : executor_(executor)
+        , start_(std::move(start))
+    {
+    }
+
+    bool await_ready() const noexcept { return false; }
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        handle_ = handle;
+        int res = start_(&GrcOperation::finished, this);
+        if (res < 0) {
+            result_ = res;
+            return false;
+        }
+        // the callback may come before the coroutine is suspended, then it is not suspended
+        return !done_.exchange(true);
+    }
+    /*!
+    * \return Result of the function: class id, number of classes or error code (<0).
+    */
+    int await_resume() const noexcept { return result_; }
+
+private:
+    static void finished(int status, void* user_data)
+    {
+        GrcOperation* op = static_cast<GrcOperation*>(user_data);
+        op->result_ = status;
+        if (!op->done_.exchange(true)) {
+            return;
+        }
+        if (op->executor_) {
+            op->executor_->post(op->handle_);
+        } else {
+            op->handle_.resume();
+        }
+    }
+
+    GrcExecutor* executor_;
+    Start start_;
+    std::coroutine_handle<> handle_;
+    std::atomic<bool> done_ { false };
+    int result_ = GRC_OK;
+};
+
+#endif // GRC_COROUTINES
+
+#endif //_GRC_ASYNC_HPP_
@@ -0,0 +1,131 @@
+#include "grc/GrcEventLoop.hpp"
+
+#if GRC_COROUTINES && defined(__linux__)
+
+#include "grc/grc_reactor.h"
+
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+// epoll data of the loop's own file descriptors, awaited fds carry their FdAwaiter
+static char wake_tag;
+static char reactor_tag;
+
+GrcEventLoop::GrcEventLoop()
+{
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.ptr = &wake_tag;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+    reactor_ = grc_reactor_create();
+    if (reactor_) {
+        event.data.ptr = &reactor_tag;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, grc_reactor_fd(reactor_), &event);
+    }
+}
+
+GrcEventLoop::~GrcEventLoop()
+{
+    if (reactor_) {
+        grc_reactor_destroy(reactor_);
+    }
+    close(wake_fd_);
+    close(epoll_fd_);
+}
+
+void GrcEventLoop::post(std::coroutine_handle<> handle)
+{
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        posted_.push_back(handle);
+    }
+    uint64_t one = 1;
+    // the counter only wakes the loop, a full counter wakes it as well
+    (void)!write(wake_fd_, &one, sizeof(one));
+}
+
+grc_reactor* GrcEventLoop::attach(grc_device* dev)
+{
+    if (!reactor_ || (grc_reactor_add(reactor_, dev) < 0)) {
+        return nullptr;
+    }
+    return reactor_;
+}
+
+void GrcEventLoop::detach(grc_device* dev)
+{
+    if (reactor_) {
+        grc_reactor_remove(reactor_, dev);
+    }
+}
+
+bool GrcEventLoop::FdAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    handle_ = handle;
+    epoll_event event = {};
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.ptr = this;
+    if (epoll_ctl(loop_->epoll_fd_, EPOLL_CTL_ADD, fd_, &event) < 0) {
+        result_ = ARGUMENT_ERROR;
+        return false;
+    }
+    return true;
+}
+
+void GrcEventLoop::resumePosted()
+{
+    std::vector<std::coroutine_handle<>> posted;
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        posted.swap(posted_);
+    }
+    for (std::coroutine_handle<> handle : posted) {
+        handle.resume();
+    }
+}
+
+int GrcEventLoop::runOnce(int timeout_ms)
+{
+    // handles posted from the loop thread are resumed without waiting
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        if (!posted_.empty()) {
+            timeout_ms = 0;
+        }
+    }
+    epoll_event events[16];
+    int cnt = epoll_wait(epoll_fd_, events, 16, timeout_ms);
+    if (cnt < 0) {
+        return errno == EINTR ? GRC_OK : I2C_ERROR;
+    }
+    std::vector<std::coroutine_handle<>> readable;
+    for (int i = 0; i < cnt; i++) {
+        void* tag = events[i].data.ptr;
+        if (tag == &wake_tag) {
+            uint64_t wakes;
+            (void)!read(wake_fd_, &wakes, sizeof(wakes));
+        } else if (tag == &reactor_tag) {
+            // reactor callbacks post the coroutines of the finished inferences
+            int res = grc_reactor_run(reactor_, 0);
+            if (res < 0) {
+                return res;
+            }
+        } else {
+            FdAwaiter* awaiter = static_cast<FdAwaiter*>(tag);
+            epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, awaiter->fd_, nullptr);
+            readable.push_back(awaiter->handle_);
+        }
+    }
+    // awaited fds are resumed after the events are handled, a resumed coroutine may await another fd
+    for (std::coroutine_handle<> handle : readable) {
+        handle.resume();
+    }
+    resumePosted();
+    return GRC_OK;
+}
+
+#endif // GRC_COROUTINES && __linux__
@@ -0,0 +1,94 @@
+#ifndef _GRC_EVENT_LOOP_HPP_
+#define _GRC_EVENT_LOOP_HPP_
+
+#include "grc/GrcAsync.hpp"
+
+#if GRC_COROUTINES && defined(__linux__)
+
+#include <mutex>
+#include <vector>
+
+/*!
+ * \brief Single-threaded Linux event loop (epoll) resuming coroutines of Grc devices.
+ *        Inference of the attached devices is driven by a grc_reactor on the loop thread,
+ *        train and save run on the device worker threads and resume on the loop thread.
+ */
+class GrcEventLoop : public GrcExecutor {
+public:
+    /*!
+    * \brief Awaitable readiness of a file descriptor, see readable().
+    */
+    class FdAwaiter {
+    public:
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle);
+        /*!
+        * \return Ok(=0) or error code (<0).
+        */
+        int await_resume() const noexcept { return result_; }
+
+    private:
+        friend class GrcEventLoop;
+        FdAwaiter(GrcEventLoop* loop, int fd)
+            : loop_(loop)
+            , fd_(fd)
+        {
+        }
+        GrcEventLoop* loop_;
+        int fd_;
+        std::coroutine_handle<> handle_;
+        int result_ = GRC_OK;
+    };
+
+    GrcEventLoop();
+    ~GrcEventLoop() override;
+    GrcEventLoop(const GrcEventLoop&) = delete;
+    GrcEventLoop& operator=(const GrcEventLoop&) = delete;
+
+    void post(std::coroutine_handle<> handle) override;
+    grc_reactor* attach(grc_device* dev) override;
+    void detach(grc_device* dev) override;
+
+    /*!
+    * \brief Wait until the file descriptor is readable, e.g. a sensor or a timerfd.
+    *        One coroutine waits for a file descriptor at a time.
+    */
+    FdAwaiter readable(int fd) { return FdAwaiter(this, fd); }
+
+    /*!
+    * \brief Wait for events once and resume the coroutines they finish.
+    * \param timeout_ms Maximum wait time, <0 - no limit.
+    * \return Ok(=0) or error code (<0).
+    */
+    int runOnce(int timeout_ms = -1);
+
+    /*!
+    * \brief Start the tasks and run the loop until all of them return.
+    * \return Ok(=0) or error code (<0) of the loop, the value of a task is task.result().
+    */
+    template <typename... Tasks>
+    int run(Tasks&... tasks)
+    {
+        (tasks.start(), ...);
+        while (!(tasks.done() && ...)) {
+            int res = runOnce();
+            if (res < 0) {
+                return res;
+            }
+        }
+        return GRC_OK;
+    }
+
+private:
+    void resumePosted();
+
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+    grc_reactor* reactor_ = nullptr;
+    std::mutex lock_;
+    std::vector<std::coroutine_handle<>> posted_;
+};
+
+#endif // GRC_COROUTINES && __linux__
+
+#endif //_GRC_EVENT_LOOP_HPP_
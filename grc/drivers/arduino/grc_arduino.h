@@ -7,10 +7,15 @@
 
 #define PROTOCOL_INTERFACE_I2C_ARDUINO 0x32220002
 
+/*!
+ * \param i2c_addr GRC device address, 0 - the default address 0x36. modules with different addresses
+ *        may share one TwoWire bus
+ */
 struct grc_ll_i2c_dev_arduino {
     uint32_t type;
     TwoWire* arduino_wire;
     int reset_pin;
+    uint8_t i2c_addr;
 };
 
 
@@ -2,66 +2,152 @@
 #define _GRC_DRIVERS_I2C_ARDUINO_IMPL_H_
 
 #include "grc_arduino.h"
+#include "grc/drivers/grc_ll_driver.h"
 #include "grc/grc_error_codes.h"
 
 
 #define GRC_AI_MODULE_FREQ_HZ 400000
 #define GRC_AI_MODULE_I2C_ADDR 0x36
 
+// Wire transfers are limited by its buffer: 32 bytes on AVR, I2C_BUFFER_LENGTH on ESP32 and RP2040 cores
+#if defined(I2C_BUFFER_LENGTH)
+#define GRC_ARDUINO_I2C_MTU I2C_BUFFER_LENGTH
+#elif defined(BUFFER_LENGTH)
+#define GRC_ARDUINO_I2C_MTU BUFFER_LENGTH
+#else
+#define GRC_ARDUINO_I2C_MTU 32
+#endif
 
-extern "C" void grc_ll_sleep(int ms)
+// devices sharing a TwoWire bus, it is ended with the last one
+#define GRC_ARDUINO_MAX_BUSES 4
+
+static struct {
+    TwoWire* wire;
+    uint8_t users;
+} arduino_buses[GRC_ARDUINO_MAX_BUSES];
+
+static uint8_t arduino_i2c_addr(const grc_ll_i2c_dev_arduino* ll_dev)
+{
+    return ll_dev->i2c_addr ? ll_dev->i2c_addr : GRC_AI_MODULE_I2C_ADDR;
+}
+
+// users of the device's bus, NULL if all GRC_ARDUINO_MAX_BUSES entries are taken by other buses
+static uint8_t* arduino_bus_users(TwoWire* wire)
+{
+    for (int i = 0; i < GRC_ARDUINO_MAX_BUSES; i++) {
+        if (arduino_buses[i].wire == wire) {
+            return &arduino_buses[i].users;
+        }
+    }
+    for (int i = 0; i < GRC_ARDUINO_MAX_BUSES; i++) {
+        if (arduino_buses[i].users == 0) {
+            arduino_buses[i].wire = wire;
+            return &arduino_buses[i].users;
+        }
+    }
+    return NULL;
+}
+
+// result of endTransmission: 2 - the address is not acknowledged, other non-zero values are bus errors
+static int arduino_ll_i2c_status(uint8_t status, int len)
+{
+    if (status == 0) {
+        return len;
+    }
+    return status == 2 ? I2C_NACK : I2C_ERROR;
+}
+
+static void arduino_ll_sleep_us(void* dev, uint32_t us)
+{
+    // delayMicroseconds is accurate only for short delays
+    if (us >= 1000) {
+        delay(us / 1000);
+        us %= 1000;
+    }
+    delayMicroseconds(us);
+}
+
+static uint64_t arduino_ll_time_us(void* dev)
 {
-    delay(ms);
+    // extend 32-bit micros() which wraps every ~71 minutes
+    static uint32_t last = 0;
+    static uint64_t high = 0;
+    uint32_t now = micros();
+    if (now < last) {
+        high += (uint64_t)1 << 32;
+    }
+    last = now;
+    return high | now;
 }
 
-extern "C" int grc_ll_i2c_init(void* dev)
+static int arduino_ll_i2c_init(void* dev)
 {
     grc_ll_i2c_dev_arduino* ll_dev = reinterpret_cast<grc_ll_i2c_dev_arduino*>(dev);
     if (ll_dev->type != PROTOCOL_INTERFACE_I2C_ARDUINO)
         return ARGUMENT_ERROR;
 
-    ll_dev->arduino_wire->begin();
-    ll_dev->arduino_wire->setClock(GRC_AI_MODULE_FREQ_HZ);
-    ll_dev->arduino_wire->setTimeOut(1);
-    ll_dev->arduino_wire->setBufferSize(256);
+    uint8_t* users = arduino_bus_users(ll_dev->arduino_wire);
+    if (users == NULL) {
+        return GRC_NO_MEMORY;
+    }
+    if (*users == 0) {
+        ll_dev->arduino_wire->begin();
+        ll_dev->arduino_wire->setClock(GRC_AI_MODULE_FREQ_HZ);
+        ll_dev->arduino_wire->setTimeOut(1);
+        ll_dev->arduino_wire->setBufferSize(256);
+    }
+    (*users)++;
     return GRC_OK;
 }
 
-extern "C" int grc_ll_i2c_release(void* dev)
+static int arduino_ll_i2c_release(void* dev)
 {
     grc_ll_i2c_dev_arduino* ll_dev = reinterpret_cast<grc_ll_i2c_dev_arduino*>(dev);
-    if (ll_dev->type != PROTOCOL_INTERFACE_I2C_ARDUINO)
-        return ARGUMENT_ERROR;
-
-    ll_dev->arduino_wire->end();
+    uint8_t* users = arduino_bus_users(ll_dev->arduino_wire);
+    if ((users != NULL) && (*users > 0) && (--(*users) == 0)) {
+        ll_dev->arduino_wire->end();
+    }
     return GRC_OK;
 }
 
-extern "C" int grc_ll_i2c_write(void* dev, void* data, int len)
+static int arduino_ll_i2c_write(void* dev, const void* data, int len)
 {
     if (len < 1)
         return ARGUMENT_ERROR;
 
     grc_ll_i2c_dev_arduino* ll_dev = reinterpret_cast<grc_ll_i2c_dev_arduino*>(dev);
-    if (ll_dev->type != PROTOCOL_INTERFACE_I2C_ARDUINO)
-        return ARGUMENT_ERROR;
-
-    ll_dev->arduino_wire->beginTransmission(GRC_AI_MODULE_I2C_ADDR);
+    ll_dev->arduino_wire->beginTransmission(arduino_i2c_addr(ll_dev));
     ll_dev->arduino_wire->write(reinterpret_cast<const uint8_t*>(data), len);
-    ll_dev->arduino_wire->endTransmission(true);
-    return len;
+    return arduino_ll_i2c_status(ll_dev->arduino_wire->endTransmission(true), len);
 }
 
-extern "C" int grc_ll_i2c_read(void* dev, void* data, int len)
+static int arduino_ll_i2c_writev(void* dev, const struct grc_ll_iovec* iov, int cnt)
 {
-    if (len < 1)
+    grc_ll_i2c_dev_arduino* ll_dev = reinterpret_cast<grc_ll_i2c_dev_arduino*>(dev);
+    int len = 0;
+    ll_dev->arduino_wire->beginTransmission(arduino_i2c_addr(ll_dev));
+    for (int i = 0; i < cnt; i++) {
+        if (iov[i].len > 0) {
+            ll_dev->arduino_wire->write(reinterpret_cast<const uint8_t*>(iov[i].data), iov[i].len);
+            len += iov[i].len;
+        }
+    }
+    if (len == 0) {
         return ARGUMENT_ERROR;
+    }
+    return arduino_ll_i2c_status(ll_dev->arduino_wire->endTransmission(true), len);
+}
 
-    grc_ll_i2c_dev_arduino* ll_dev = reinterpret_cast<grc_ll_i2c_dev_arduino*>(dev);
-    if (ll_dev->type != PROTOCOL_INTERFACE_I2C_ARDUINO)
+static int arduino_ll_i2c_read(void* dev, void* data, int len)
+{
+    if (len < 1)
         return ARGUMENT_ERROR;
 
-    ll_dev->arduino_wire->requestFrom((uint8_t)GRC_AI_MODULE_I2C_ADDR, (size_t)len, true);
+    grc_ll_i2c_dev_arduino* ll_dev = reinterpret_cast<grc_ll_i2c_dev_arduino*>(dev);
+    // no byte is read when the address is not acknowledged
+    if (ll_dev->arduino_wire->requestFrom(arduino_i2c_addr(ll_dev), (size_t)len, true) == 0) {
+        return I2C_NACK;
+    }
 
     int readed = 0;
     uint8_t* buf = reinterpret_cast<uint8_t*>(data);
@@ -71,41 +157,96 @@ extern "C" int grc_ll_i2c_read(void* dev, void* data, int len)
     return len;
 }
 
-void grc_ll_i2c_callback(void* dev)
+static int arduino_ll_i2c_write_read(void* dev, const void* wdata, int wlen, void* rdata, int rlen)
 {
+    if (wlen < 1 || rlen < 1)
+        return ARGUMENT_ERROR;
+
+    grc_ll_i2c_dev_arduino* ll_dev = reinterpret_cast<grc_ll_i2c_dev_arduino*>(dev);
+    // no stop after the write: requestFrom continues with a repeated start
+    ll_dev->arduino_wire->beginTransmission(arduino_i2c_addr(ll_dev));
+    ll_dev->arduino_wire->write(reinterpret_cast<const uint8_t*>(wdata), wlen);
+    int res = arduino_ll_i2c_status(ll_dev->arduino_wire->endTransmission(false), rlen);
+    if (res < 0) {
+        return res;
+    }
+    if (ll_dev->arduino_wire->requestFrom(arduino_i2c_addr(ll_dev), (size_t)rlen, true) == 0) {
+        return I2C_NACK;
+    }
+
+    int readed = 0;
+    uint8_t* buf = reinterpret_cast<uint8_t*>(rdata);
+    while (readed < rlen && ll_dev->arduino_wire->available()) {
+        buf[readed++] = ll_dev->arduino_wire->read();
+    }
+    return rlen;
 }
 
-int grc_ll_gpio_init(void* dev)
+static int arduino_ll_i2c_set_address(void* dev, uint16_t addr)
 {
-    grc_ll_i2c_dev_arduino* ll_dev = (grc_ll_i2c_dev_arduino*)dev;
-    if (ll_dev->type != PROTOCOL_INTERFACE_I2C_ARDUINO)
-        return ARGUMENT_ERROR;
+    grc_ll_i2c_dev_arduino* ll_dev = reinterpret_cast<grc_ll_i2c_dev_arduino*>(dev);
+    ll_dev->i2c_addr = (uint8_t)addr;
+    return GRC_OK;
+}
+
+static int arduino_ll_i2c_get_address(void* dev)
+{
+    grc_ll_i2c_dev_arduino* ll_dev = reinterpret_cast<grc_ll_i2c_dev_arduino*>(dev);
+    return arduino_i2c_addr(ll_dev);
+}
 
+static int arduino_ll_i2c_mtu(void* dev)
+{
+    return GRC_ARDUINO_I2C_MTU;
+}
+
+static int arduino_ll_gpio_init(void* dev)
+{
+    grc_ll_i2c_dev_arduino* ll_dev = (grc_ll_i2c_dev_arduino*)dev;
     pinMode(ll_dev->reset_pin, OUTPUT);
 
     return GRC_OK;
 }
 
-int grc_ll_gpio_reset_high(void* dev)
+static int arduino_ll_gpio_reset_high(void* dev)
 {
     grc_ll_i2c_dev_arduino* ll_dev = (grc_ll_i2c_dev_arduino*)dev;
-    if (ll_dev->type != PROTOCOL_INTERFACE_I2C_ARDUINO)
-        return ARGUMENT_ERROR;
-
     digitalWrite(ll_dev->reset_pin, HIGH);
 
     return GRC_OK;
 }
 
-int grc_ll_gpio_reset_low(void* dev)
+static int arduino_ll_gpio_reset_low(void* dev)
 {
     grc_ll_i2c_dev_arduino* ll_dev = (grc_ll_i2c_dev_arduino*)dev;
-    if (ll_dev->type != PROTOCOL_INTERFACE_I2C_ARDUINO)
-        return ARGUMENT_ERROR;
-
     digitalWrite(ll_dev->reset_pin, LOW);
 
     return GRC_OK;
 }
 
+// transport of grc_ll_i2c_dev_arduino devices. data ready line is not wired, status is polled.
+// members are in declaration order, sketches are built before C++20 designated initializers
+static const struct grc_transport_ops grc_arduino_transport = {
+    arduino_ll_i2c_init, // init
+    arduino_ll_i2c_release, // release
+    arduino_ll_i2c_write, // write
+    arduino_ll_i2c_writev, // writev
+    arduino_ll_i2c_read, // read
+    arduino_ll_i2c_write_read, // write_read
+    arduino_ll_i2c_set_address, // set_address
+    arduino_ll_i2c_get_address, // get_address
+    arduino_ll_i2c_mtu, // mtu
+    NULL, // wait_ready
+    NULL, // ready_fd
+    arduino_ll_gpio_init, // gpio_init
+    arduino_ll_gpio_reset_high, // gpio_reset_high
+    arduino_ll_gpio_reset_low, // gpio_reset_low
+    arduino_ll_sleep_us, // sleep_us
+    arduino_ll_time_us, // time_us
+};
+
+#if !defined(GRC_TRANSPORT_NO_DEFAULT) && !defined(GRC_STATIC_TRANSPORT_HEADER)
+extern "C" const struct grc_transport_ops* const grc_default_transport = &grc_arduino_transport;
+#endif
+
 #endif // _GRC_DRIVERS_I2C_ARDUINO_IMPL_H_
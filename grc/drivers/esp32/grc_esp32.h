@@ -20,6 +20,8 @@ struct grc_ll_i2c_dev_esp32 {
     uint32_t clk_speed;
     uint16_t slave_addr;
     uint32_t timeout_us;
+
+    void* data_ready_sem; // given by data ready interrupt, created by the init of the transport
 };
 
 #ifdef __cplusplus
@@ -5,11 +5,16 @@
 extern "C" {
 #endif // __cplusplus
 
+#include "grc/drivers/grc_ll_driver.h"
 #include "grc/grc_error_codes.h"
 #include "grc_esp32.h"
 
 #include "driver/gpio.h"
 #include "driver/i2c.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "sdkconfig.h"
 
 // ===== base esp32-i2c params ===========
@@ -33,6 +38,8 @@ extern "C" {
 #define ESP_SLAVE_ADDR 0x36
 
 #define SLAVE_REQUEST_WAIT_MS (1000 / portTICK_PERIOD_MS)
+// command links queue any transfer length, the protocol layer applies the module limit
+#define I2C_MASTER_MTU 4096
 //==================================================
 
 struct grc_i2c_esp32_config {
@@ -58,6 +65,10 @@ const struct grc_i2c_esp32_config esp32_i2c_config_array[] = {
     }
 };
 
+// devices using each I2C port: modules on one bus share the installed driver, whose port lock
+// serialises their transactions. devices are initialised and released from one task
+static uint8_t esp32_port_users[I2C_NUM_MAX];
+
 #define CHECK_I2C_RESULT(func)    \
     {                             \
         esp_err_t retcode = func; \
@@ -66,48 +77,114 @@ const struct grc_i2c_esp32_config esp32_i2c_config_array[] = {
         }                         \
     }
 
-void grc_ll_sleep(int ms)
+// i2c_master_cmd_begin returns ESP_FAIL when the slave does not acknowledge
+#define CHECK_I2C_TRANSFER(func)                               \
+    {                                                          \
+        esp_err_t retcode = func;                              \
+        if (retcode != ESP_OK) {                               \
+            return retcode == ESP_FAIL ? I2C_NACK : I2C_ERROR; \
+        }                                                      \
+    }
+
+#define CHECK_GPIO_RESULT(func)    \
+    {                              \
+        esp_err_t retcode = func;  \
+        if (retcode != ESP_OK) {   \
+            return GRC_GPIO_ERROR; \
+        }                          \
+    }
+
+static void esp32_ll_sleep_us(void* dev, uint32_t us)
+{
+    // waits shorter than a tick are busy loops, the scheduler can not wake the task earlier
+    uint32_t tick_us = portTICK_PERIOD_MS * 1000;
+    if (us >= tick_us) {
+        vTaskDelay(us / tick_us);
+        us %= tick_us;
+    }
+    if (us > 0) {
+        esp_rom_delay_us(us);
+    }
+}
+
+static uint64_t esp32_ll_time_us(void* dev)
+{
+    return (uint64_t)esp_timer_get_time();
+}
+
+// data ready interrupt handler
+static void esp32_ll_data_ready_isr(void* dev)
 {
-    vTaskDelay((ms) / portTICK_PERIOD_MS);
+    grc_ll_i2c_dev_esp32* ll_dev = (grc_ll_i2c_dev_esp32*)dev;
+    BaseType_t task_woken = pdFALSE;
+    xSemaphoreGiveFromISR((SemaphoreHandle_t)ll_dev->data_ready_sem, &task_woken);
+    if (task_woken) {
+        portYIELD_FROM_ISR();
+    }
 }
 
-int grc_ll_i2c_init(void* dev)
+static int esp32_ll_i2c_init(void* dev)
 {
     grc_ll_i2c_dev_esp32* ll_dev = (grc_ll_i2c_dev_esp32*)dev;
     if (ll_dev->type != PROTOCOL_INTERFACE_I2C_ESP32)
         return ARGUMENT_ERROR;
 
     i2c_port_t i2c_master_port = ll_dev->i2c_num;
-    i2c_config_t conf;
-    conf.mode = I2C_MODE_MASTER;
-    conf.sda_io_num = ll_dev->sda_io_num;
-    conf.sda_pullup_en = GPIO_PULLUP_ENABLE;
-    conf.scl_io_num = ll_dev->scl_io_num;
-    conf.scl_pullup_en = GPIO_PULLUP_ENABLE;
-    conf.master.clk_speed = ll_dev->clk_speed;
-
-    conf.clk_flags = 0;
-    CHECK_I2C_RESULT(i2c_param_config(i2c_master_port, &conf))
-    CHECK_I2C_RESULT(i2c_driver_install(i2c_master_port, conf.mode, I2C_MASTER_RX_BUF_DISABLE, I2C_MASTER_TX_BUF_DISABLE, 0))
+    if (esp32_port_users[i2c_master_port] == 0) {
+        i2c_config_t conf;
+        conf.mode = I2C_MODE_MASTER;
+        conf.sda_io_num = ll_dev->sda_io_num;
+        conf.sda_pullup_en = GPIO_PULLUP_ENABLE;
+        conf.scl_io_num = ll_dev->scl_io_num;
+        conf.scl_pullup_en = GPIO_PULLUP_ENABLE;
+        conf.master.clk_speed = ll_dev->clk_speed;
+
+        conf.clk_flags = 0;
+        CHECK_I2C_RESULT(i2c_param_config(i2c_master_port, &conf))
+        CHECK_I2C_RESULT(i2c_driver_install(i2c_master_port, conf.mode, I2C_MASTER_RX_BUF_DISABLE, I2C_MASTER_TX_BUF_DISABLE, 0))
+    }
+    esp32_port_users[i2c_master_port]++;
+
+    ll_dev->data_ready_sem = NULL;
+    if (ll_dev->data_ready_io_num >= 0) {
+        ll_dev->data_ready_sem = xSemaphoreCreateBinary();
+        if (!ll_dev->data_ready_sem) {
+            return GRC_NO_MEMORY;
+        }
+        gpio_config_t io_conf = {};
+        io_conf.pin_bit_mask = 1ULL << ll_dev->data_ready_io_num;
+        io_conf.mode = GPIO_MODE_INPUT;
+        io_conf.pull_up_en = GPIO_PULLUP_DISABLE;
+        io_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
+        io_conf.intr_type = GPIO_INTR_POSEDGE;
+        CHECK_GPIO_RESULT(gpio_config(&io_conf))
+        // the service may be already installed by the application
+        esp_err_t retcode = gpio_install_isr_service(0);
+        if (retcode != ESP_OK && retcode != ESP_ERR_INVALID_STATE) {
+            return GRC_GPIO_ERROR;
+        }
+        CHECK_GPIO_RESULT(gpio_isr_handler_add((gpio_num_t)ll_dev->data_ready_io_num, esp32_ll_data_ready_isr, ll_dev))
+    }
     return GRC_OK;
 }
 
-int grc_ll_i2c_release(void* dev)
+static int esp32_ll_i2c_release(void* dev)
 {
     grc_ll_i2c_dev_esp32* ll_dev = (grc_ll_i2c_dev_esp32*)dev;
-    if (ll_dev->type != PROTOCOL_INTERFACE_I2C_ESP32)
-        return ARGUMENT_ERROR;
-
-    CHECK_I2C_RESULT(i2c_driver_delete(ll_dev->i2c_num))
+    if (ll_dev->data_ready_sem) {
+        gpio_isr_handler_remove((gpio_num_t)ll_dev->data_ready_io_num);
+        vSemaphoreDelete((SemaphoreHandle_t)ll_dev->data_ready_sem);
+        ll_dev->data_ready_sem = NULL;
+    }
+    if (--esp32_port_users[ll_dev->i2c_num] == 0) {
+        CHECK_I2C_RESULT(i2c_driver_delete(ll_dev->i2c_num))
+    }
     return GRC_OK;
 }
 
-int grc_ll_i2c_write(void* dev, void* data, int len)
+static int esp32_ll_i2c_write(void* dev, const void* data, int len)
 {
     grc_ll_i2c_dev_esp32* ll_dev = (grc_ll_i2c_dev_esp32*)dev;
-    if (ll_dev->type != PROTOCOL_INTERFACE_I2C_ESP32)
-        return ARGUMENT_ERROR;
-
     if (len < 1) {
         return ARGUMENT_ERROR;
     }
@@ -116,23 +193,49 @@ int grc_ll_i2c_write(void* dev, void* data, int len)
         return I2C_ERROR;
     }
 
-    uint8_t *p8 = data;
+    uint8_t *p8 = (uint8_t*)data;
     CHECK_I2C_RESULT(i2c_master_start(cmd))
     CHECK_I2C_RESULT(i2c_master_write_byte(cmd, (ll_dev->slave_addr << 1) | WRITE_BIT, ACK_CHECK_EN))
     CHECK_I2C_RESULT(i2c_master_write(cmd, p8, len, ACK_CHECK_EN))
     CHECK_I2C_RESULT(i2c_master_stop(cmd))
-    CHECK_I2C_RESULT(i2c_master_cmd_begin(ll_dev->i2c_num, cmd, ll_dev->timeout_us))
+    CHECK_I2C_TRANSFER(i2c_master_cmd_begin(ll_dev->i2c_num, cmd, ll_dev->timeout_us))
     // TODO: fix possible absense of link deletion in case of error before
     i2c_cmd_link_delete(cmd);
     return len;
 }
 
-int grc_ll_i2c_read(void* dev, void* data, int len)
+static int esp32_ll_i2c_writev(void* dev, const struct grc_ll_iovec* iov, int cnt)
 {
     grc_ll_i2c_dev_esp32* ll_dev = (grc_ll_i2c_dev_esp32*)dev;
-    if (ll_dev->type != PROTOCOL_INTERFACE_I2C_ESP32)
+    int len = 0;
+    for (int i = 0; i < cnt; i++) {
+        len += iov[i].len > 0 ? iov[i].len : 0;
+    }
+    if (len < 1) {
         return ARGUMENT_ERROR;
+    }
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+    if (!cmd) {
+        return I2C_ERROR;
+    }
 
+    // the fragments are queued in the command link and sent without a stop condition between them
+    CHECK_I2C_RESULT(i2c_master_start(cmd))
+    CHECK_I2C_RESULT(i2c_master_write_byte(cmd, (ll_dev->slave_addr << 1) | WRITE_BIT, ACK_CHECK_EN))
+    for (int i = 0; i < cnt; i++) {
+        if (iov[i].len > 0) {
+            CHECK_I2C_RESULT(i2c_master_write(cmd, (const uint8_t*)iov[i].data, iov[i].len, ACK_CHECK_EN))
+        }
+    }
+    CHECK_I2C_RESULT(i2c_master_stop(cmd))
+    CHECK_I2C_TRANSFER(i2c_master_cmd_begin(ll_dev->i2c_num, cmd, ll_dev->timeout_us))
+    i2c_cmd_link_delete(cmd);
+    return len;
+}
+
+static int esp32_ll_i2c_read(void* dev, void* data, int len)
+{
+    grc_ll_i2c_dev_esp32* ll_dev = (grc_ll_i2c_dev_esp32*)dev;
     if (len < 1) {
         return ARGUMENT_ERROR;
     }
@@ -141,7 +244,7 @@ int grc_ll_i2c_read(void* dev, void* data, int len)
         return I2C_ERROR;
     }
 
-    uint8_t *p8 = data;
+    uint8_t *p8 = (uint8_t*)data;
     CHECK_I2C_RESULT(i2c_master_start(cmd))
     CHECK_I2C_RESULT(i2c_master_write_byte(cmd, (ll_dev->slave_addr << 1) | READ_BIT, ACK_CHECK_EN))
     if (len > 1) {
@@ -150,38 +253,81 @@ int grc_ll_i2c_read(void* dev, void* data, int len)
 
     CHECK_I2C_RESULT(i2c_master_read_byte(cmd, &p8[len - 1], (i2c_ack_type_t)NACK_VAL))
     CHECK_I2C_RESULT(i2c_master_stop(cmd))
-    CHECK_I2C_RESULT(i2c_master_cmd_begin(ll_dev->i2c_num, cmd, ll_dev->timeout_us))
+    CHECK_I2C_TRANSFER(i2c_master_cmd_begin(ll_dev->i2c_num, cmd, ll_dev->timeout_us))
     i2c_cmd_link_delete(cmd);
     return len;
 }
 
-void grc_ll_i2c_callback(void* dev)
+static int esp32_ll_i2c_write_read(void* dev, const void* wdata, int wlen, void* rdata, int rlen)
 {
     grc_ll_i2c_dev_esp32* ll_dev = (grc_ll_i2c_dev_esp32*)dev;
-    if (ll_dev->type != PROTOCOL_INTERFACE_I2C_ESP32)
-        return;
+    if (wlen < 1 || rlen < 1) {
+        return ARGUMENT_ERROR;
+    }
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+    if (!cmd) {
+        return I2C_ERROR;
+    }
 
+    // the read address follows the written command with a repeated start, without a stop between them
+    uint8_t *p8 = rdata;
+    CHECK_I2C_RESULT(i2c_master_start(cmd))
+    CHECK_I2C_RESULT(i2c_master_write_byte(cmd, (ll_dev->slave_addr << 1) | WRITE_BIT, ACK_CHECK_EN))
+    CHECK_I2C_RESULT(i2c_master_write(cmd, (const uint8_t*)wdata, wlen, ACK_CHECK_EN))
+    CHECK_I2C_RESULT(i2c_master_start(cmd))
+    CHECK_I2C_RESULT(i2c_master_write_byte(cmd, (ll_dev->slave_addr << 1) | READ_BIT, ACK_CHECK_EN))
+    if (rlen > 1) {
+        CHECK_I2C_RESULT(i2c_master_read(cmd, p8, rlen - 1, (i2c_ack_type_t)ACK_VAL))
+    }
+    CHECK_I2C_RESULT(i2c_master_read_byte(cmd, &p8[rlen - 1], (i2c_ack_type_t)NACK_VAL))
+    CHECK_I2C_RESULT(i2c_master_stop(cmd))
+    CHECK_I2C_TRANSFER(i2c_master_cmd_begin(ll_dev->i2c_num, cmd, ll_dev->timeout_us))
+    i2c_cmd_link_delete(cmd);
+    return rlen;
+}
 
+static int esp32_ll_i2c_set_address(void* dev, uint16_t addr)
+{
+    grc_ll_i2c_dev_esp32* ll_dev = (grc_ll_i2c_dev_esp32*)dev;
+    ll_dev->slave_addr = addr;
+    return GRC_OK;
 }
 
-int grc_ll_gpio_init(void* dev)
+static int esp32_ll_i2c_get_address(void* dev)
 {
     grc_ll_i2c_dev_esp32* ll_dev = (grc_ll_i2c_dev_esp32*)dev;
-    if (ll_dev->type != PROTOCOL_INTERFACE_I2C_ESP32)
-        return ARGUMENT_ERROR;
+    return ll_dev->slave_addr;
+}
 
+static int esp32_ll_i2c_mtu(void* dev)
+{
+    return I2C_MASTER_MTU;
+}
+
+static int esp32_ll_wait_ready(void* dev, int timeout_ms)
+{
+    grc_ll_i2c_dev_esp32* ll_dev = (grc_ll_i2c_dev_esp32*)dev;
+    if (!ll_dev->data_ready_sem) {
+        return NOT_IMPLEMENTED;
+    }
+    if (xSemaphoreTake((SemaphoreHandle_t)ll_dev->data_ready_sem, timeout_ms / portTICK_PERIOD_MS) != pdTRUE) {
+        return GRC_TIMEOUT;
+    }
+    return GRC_OK;
+}
+
+static int esp32_ll_gpio_init(void* dev)
+{
+    grc_ll_i2c_dev_esp32* ll_dev = (grc_ll_i2c_dev_esp32*)dev;
     gpio_num_t pin = ll_dev->reset_io_num;
     gpio_set_direction(pin, GPIO_MODE_OUTPUT);
 
     return GRC_OK;
 }
 
-int grc_ll_gpio_reset_high(void* dev)
+static int esp32_ll_gpio_reset_high(void* dev)
 {
     grc_ll_i2c_dev_esp32* ll_dev = (grc_ll_i2c_dev_esp32*)dev;
-    if (ll_dev->type != PROTOCOL_INTERFACE_I2C_ESP32)
-        return ARGUMENT_ERROR;
-
     gpio_num_t pin = ll_dev->reset_io_num;
     gpio_set_level(pin, 1);
     gpio_pulldown_dis(pin);
@@ -190,18 +336,40 @@ int grc_ll_gpio_reset_high(void* dev)
     return GRC_OK;
 }
 
-int grc_ll_gpio_reset_low(void* dev)
+static int esp32_ll_gpio_reset_low(void* dev)
 {
     grc_ll_i2c_dev_esp32* ll_dev = (grc_ll_i2c_dev_esp32*)dev;
-    if (ll_dev->type != PROTOCOL_INTERFACE_I2C_ESP32)
-        return ARGUMENT_ERROR;
-
     gpio_num_t pin = ll_dev->reset_io_num;
     gpio_set_level(pin, 0);
 
     return GRC_OK;
 }
 
+// transport of grc_ll_i2c_dev_esp32 devices. the data ready line is signalled with a semaphore, it has no
+// file descriptor
+static const struct grc_transport_ops grc_esp32_transport = {
+    .init = esp32_ll_i2c_init,
+    .release = esp32_ll_i2c_release,
+    .write = esp32_ll_i2c_write,
+    .writev = esp32_ll_i2c_writev,
+    .read = esp32_ll_i2c_read,
+    .write_read = esp32_ll_i2c_write_read,
+    .set_address = esp32_ll_i2c_set_address,
+    .get_address = esp32_ll_i2c_get_address,
+    .mtu = esp32_ll_i2c_mtu,
+    .wait_ready = esp32_ll_wait_ready,
+    .ready_fd = NULL,
+    .gpio_init = esp32_ll_gpio_init,
+    .gpio_reset_high = esp32_ll_gpio_reset_high,
+    .gpio_reset_low = esp32_ll_gpio_reset_low,
+    .sleep_us = esp32_ll_sleep_us,
+    .time_us = esp32_ll_time_us,
+};
+
+#if !defined(GRC_TRANSPORT_NO_DEFAULT) && !defined(GRC_STATIC_TRANSPORT_HEADER)
+const struct grc_transport_ops* const grc_default_transport = &grc_esp32_transport;
+#endif
+
 #ifdef __cplusplus
 }
 #endif // __cplusplus
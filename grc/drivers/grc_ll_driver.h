@@ -1,21 +1,76 @@
 #ifndef _GRC_LL_DRIVER_H_
 #define _GRC_LL_DRIVER_H_
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif // __cplusplus
 
-void grc_ll_sleep(int ms);
+/*!
+ * \brief fragment of a write transaction
+ */
+struct grc_ll_iovec {
+    const void* data;
+    int len;
+};
 
-int grc_ll_i2c_init(void* dev);
-int grc_ll_i2c_release(void* dev);
-int grc_ll_i2c_write(void* dev, void* data, int len);
-int grc_ll_i2c_read(void* dev, void* data, int len);
-void grc_ll_i2c_callback(void* dev);
+/*!
+ * \brief functions of a transport driver. every device carries the table of its driver (grc_device.transport),
+ *        so devices on different transports are used in one program. dev is the transport device of the driver
+ *        (grc_ll_i2c_dev_linux, grc_ll_sim_dev, ...), checked by init only.
+ *        optional functions are NULL when the link does not have them, the SDK handles them as NOT_IMPLEMENTED
+ * \param init open the link, returns Ok(=0) or error code (<0)
+ * \param release close the link
+ * \param write write one I2C transaction, returns len or error code (<0)
+ * \param writev write the fragments as one I2C transaction, as write of their concatenation would.
+ *        empty fragments are skipped, returns total length or error code (<0)
+ * \param read read one I2C transaction, returns len or error code (<0)
+ *        write, writev, read and write_read return I2C_NACK when the address is not acknowledged, if the link tells
+ * \param write_read (optional) write and read in one I2C transaction, the read follows the write with a repeated
+ *        start. returns rlen or error code (<0). without it the protocol layer writes and reads separately
+ * \param set_address (optional) change the 7-bit bus address the transport device talks to, for several GRC
+ *        modules on one bus. returns Ok(=0) or error code (<0)
+ * \param get_address (optional, with set_address) the bus address the transport device talks to,
+ *        returns the address (>=0) or error code (<0)
+ * \param mtu largest write or read transaction the link carries, in bytes
+ * \param wait_ready (optional) block until GRC signals the data ready line. returns GRC_OK if the line was
+ *        signalled, GRC_TIMEOUT or error code (<0). without the line the protocol layer polls the function status
+ * \param ready_fd (optional) file descriptor of the data ready line for event loops (poll, epoll), readable when
+ *        the line was signalled. the edge is consumed with wait_ready(dev, 0)
+ * \param gpio_init, gpio_reset_high, gpio_reset_low (optional) reset line of GRC
+ * \param sleep_us wait, the protocol layer sleeps between the command and its reply
+ * \param time_us monotonic clock in microseconds
+ * \param flush (optional) send the transactions the transport has queued. a transport may queue writes and
+ *        sleeps until the next read, flush or release, and report their errors there. the protocol layer flushes
+ *        before it leaves a wait to its caller (startRemoteCall, stepRemoteCall)
+ */
+struct grc_transport_ops {
+    int (*init)(void* dev);
+    int (*release)(void* dev);
+    int (*write)(void* dev, const void* data, int len);
+    int (*writev)(void* dev, const struct grc_ll_iovec* iov, int cnt);
+    int (*read)(void* dev, void* data, int len);
+    int (*write_read)(void* dev, const void* wdata, int wlen, void* rdata, int rlen);
+    int (*set_address)(void* dev, uint16_t addr);
+    int (*get_address)(void* dev);
+    int (*mtu)(void* dev);
+    int (*wait_ready)(void* dev, int timeout_ms);
+    int (*ready_fd)(void* dev);
+    int (*gpio_init)(void* dev);
+    int (*gpio_reset_high)(void* dev);
+    int (*gpio_reset_low)(void* dev);
+    void (*sleep_us)(void* dev, uint32_t us);
+    uint64_t (*time_us)(void* dev);
+    int (*flush)(void* dev);
+};
 
-int grc_ll_gpio_init(void* dev);
-int grc_ll_gpio_reset_high(void* dev);
-int grc_ll_gpio_reset_low(void* dev);
+/*!
+ * \brief transport of the devices created without one (grc_device.transport is NULL). it is defined by the
+ *        driver header included without GRC_TRANSPORT_NO_DEFAULT, once per program; other drivers of the program
+ *        are included with GRC_TRANSPORT_NO_DEFAULT defined
+ */
+extern const struct grc_transport_ops* const grc_default_transport;
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,155 @@
+#ifndef _GRC_TRANSPORT_H_
+#define _GRC_TRANSPORT_H_
+
+// calls of the SDK into the transport of a device, see grc_transport_ops
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "grc/drivers/grc_ll_driver.h"
+#include "grc/grc_error_codes.h"
+
+#ifdef GRC_STATIC_TRANSPORT_HEADER
+// the SDK is built for one transport: GRC_STATIC_TRANSPORT_HEADER names the driver header and
+// GRC_STATIC_TRANSPORT its table, e.g. -DGRC_STATIC_TRANSPORT_HEADER='"grc/drivers/linux/grc_linux_impl.h"'
+// -DGRC_STATIC_TRANSPORT=grc_linux_transport. the table is known at compile time, so the calls go straight to
+// the driver functions and are inlined; the tables of the devices are not used
+#include GRC_STATIC_TRANSPORT_HEADER
+#define GRC_TRANSPORT(ops) (&GRC_STATIC_TRANSPORT)
+#else
+#define GRC_TRANSPORT(ops) (ops)
+#endif // GRC_STATIC_TRANSPORT_HEADER
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// table of a device, NULL - grc_default_transport
+static inline const struct grc_transport_ops* grc_transport_resolve(const struct grc_transport_ops* ops)
+{
+#ifdef GRC_STATIC_TRANSPORT_HEADER
+    return GRC_TRANSPORT(ops);
+#else
+    return ops != NULL ? ops : grc_default_transport;
+#endif // GRC_STATIC_TRANSPORT_HEADER
+}
+
+static inline int grc_transport_init(const struct grc_transport_ops* ops, void* dev)
+{
+    return GRC_TRANSPORT(ops)->init(dev);
+}
+
+static inline int grc_transport_release(const struct grc_transport_ops* ops, void* dev)
+{
+    return GRC_TRANSPORT(ops)->release(dev);
+}
+
+static inline int grc_transport_write(const struct grc_transport_ops* ops, void* dev, const void* data, int len)
+{
+    return GRC_TRANSPORT(ops)->write(dev, data, len);
+}
+
+static inline int grc_transport_writev(const struct grc_transport_ops* ops, void* dev, const struct grc_ll_iovec* iov, int cnt)
+{
+    return GRC_TRANSPORT(ops)->writev(dev, iov, cnt);
+}
+
+static inline int grc_transport_read(const struct grc_transport_ops* ops, void* dev, void* data, int len)
+{
+    return GRC_TRANSPORT(ops)->read(dev, data, len);
+}
+
+static inline int grc_transport_write_read(
+    const struct grc_transport_ops* ops, void* dev, const void* wdata, int wlen, void* rdata, int rlen)
+{
+    if (GRC_TRANSPORT(ops)->write_read == NULL) {
+        return NOT_IMPLEMENTED;
+    }
+    return GRC_TRANSPORT(ops)->write_read(dev, wdata, wlen, rdata, rlen);
+}
+
+static inline int grc_transport_set_address(const struct grc_transport_ops* ops, void* dev, uint16_t addr)
+{
+    if (GRC_TRANSPORT(ops)->set_address == NULL) {
+        return NOT_IMPLEMENTED;
+    }
+    return GRC_TRANSPORT(ops)->set_address(dev, addr);
+}
+
+static inline int grc_transport_get_address(const struct grc_transport_ops* ops, void* dev)
+{
+    if (GRC_TRANSPORT(ops)->get_address == NULL) {
+        return NOT_IMPLEMENTED;
+    }
+    return GRC_TRANSPORT(ops)->get_address(dev);
+}
+
+static inline int grc_transport_mtu(const struct grc_transport_ops* ops, void* dev)
+{
+    return GRC_TRANSPORT(ops)->mtu(dev);
+}
+
+static inline int grc_transport_wait_ready(const struct grc_transport_ops* ops, void* dev, int timeout_ms)
+{
+    if (GRC_TRANSPORT(ops)->wait_ready == NULL) {
+        return NOT_IMPLEMENTED;
+    }
+    return GRC_TRANSPORT(ops)->wait_ready(dev, timeout_ms);
+}
+
+static inline int grc_transport_ready_fd(const struct grc_transport_ops* ops, void* dev)
+{
+    if (GRC_TRANSPORT(ops)->ready_fd == NULL) {
+        return NOT_IMPLEMENTED;
+    }
+    return GRC_TRANSPORT(ops)->ready_fd(dev);
+}
+
+static inline int grc_transport_gpio_init(const struct grc_transport_ops* ops, void* dev)
+{
+    if (GRC_TRANSPORT(ops)->gpio_init == NULL) {
+        return NOT_IMPLEMENTED;
+    }
+    return GRC_TRANSPORT(ops)->gpio_init(dev);
+}
+
+static inline int grc_transport_gpio_reset_high(const struct grc_transport_ops* ops, void* dev)
+{
+    if (GRC_TRANSPORT(ops)->gpio_reset_high == NULL) {
+        return NOT_IMPLEMENTED;
+    }
+    return GRC_TRANSPORT(ops)->gpio_reset_high(dev);
+}
+
+static inline int grc_transport_gpio_reset_low(const struct grc_transport_ops* ops, void* dev)
+{
+    if (GRC_TRANSPORT(ops)->gpio_reset_low == NULL) {
+        return NOT_IMPLEMENTED;
+    }
+    return GRC_TRANSPORT(ops)->gpio_reset_low(dev);
+}
+
+static inline void grc_transport_sleep_us(const struct grc_transport_ops* ops, void* dev, uint32_t us)
+{
+    GRC_TRANSPORT(ops)->sleep_us(dev, us);
+}
+
+static inline uint64_t grc_transport_time_us(const struct grc_transport_ops* ops, void* dev)
+{
+    return GRC_TRANSPORT(ops)->time_us(dev);
+}
+
+// transports sending every transaction at once have nothing to flush
+static inline int grc_transport_flush(const struct grc_transport_ops* ops, void* dev)
+{
+    if (GRC_TRANSPORT(ops)->flush == NULL) {
+        return GRC_OK;
+    }
+    return GRC_TRANSPORT(ops)->flush(dev);
+}
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _GRC_TRANSPORT_H_
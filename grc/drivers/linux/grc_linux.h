@@ -0,0 +1,45 @@
+#ifndef _GRC_DRIVERS_I2C_LINUX_H_
+#define _GRC_DRIVERS_I2C_LINUX_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#define PROTOCOL_INTERFACE_I2C_LINUX 0x32220004
+
+/*!
+ * \brief GRC connected to a Linux host over i2c-dev
+ * \param i2c_dev_path I2C bus character device, e.g. "/dev/i2c-1"
+ * \param slave_addr GRC device address
+ * \param gpio_chip_path GPIO character device with the data ready and reset lines, e.g. "/dev/gpiochip0". NULL if not wired
+ * \param data_ready_line data ready line offset on gpio_chip_path, -1 if not wired
+ * \param reset_line reset line offset on gpio_chip_path, -1 if not wired
+ * \param data_ready_event_fd eventfd used instead of the data ready line (for tests), -1 if not used.
+ *        a write to it is handled as a rising edge, writes not yet waited for are taken as one edge unless it is
+ *        an EFD_SEMAPHORE eventfd
+ * \param fds file descriptors opened by the driver
+ */
+struct grc_ll_i2c_dev_linux {
+    uint32_t type;
+
+    const char* i2c_dev_path;
+    uint16_t slave_addr;
+    const char* gpio_chip_path;
+    int data_ready_line;
+    int reset_line;
+    int data_ready_event_fd;
+
+    struct {
+        int i2c;
+        int data_ready;
+        int reset;
+    } fds;
+};
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _GRC_DRIVERS_I2C_LINUX_H_
@@ -0,0 +1,317 @@
+#ifndef _GRC_DRIVERS_I2C_LINUX_IMPL_H_
+#define _GRC_DRIVERS_I2C_LINUX_IMPL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "grc/drivers/grc_ll_driver.h"
+#include "grc/grc_error_codes.h"
+#include "grc_linux.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/gpio.h>
+#include <linux/i2c-dev.h>
+#include <linux/i2c.h>
+#include <poll.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+#define GRC_LINUX_GPIO_CONSUMER "grc"
+// largest message accepted by i2c-dev
+#define GRC_LINUX_I2C_MAX_WRITE 8192
+
+#define CHECK_LINUX_DEVICE(ll_dev)                       \
+    if ((ll_dev)->type != PROTOCOL_INTERFACE_I2C_LINUX) \
+        return ARGUMENT_ERROR;
+
+// request a single line of the GPIO character device, returns line fd or -1
+static int grc_linux_request_line(const char* chip_path, int line, uint64_t flags)
+{
+    int chip_fd = open(chip_path, O_RDWR | O_CLOEXEC);
+    if (chip_fd < 0) {
+        return -1;
+    }
+    struct gpio_v2_line_request req;
+    memset(&req, 0, sizeof(req));
+    req.offsets[0] = line;
+    req.num_lines = 1;
+    req.config.flags = flags;
+    strncpy(req.consumer, GRC_LINUX_GPIO_CONSUMER, sizeof(req.consumer) - 1);
+    int res = ioctl(chip_fd, GPIO_V2_GET_LINE_IOCTL, &req);
+    close(chip_fd);
+    return res < 0 ? -1 : req.fd;
+}
+
+static int grc_linux_set_line(int line_fd, int value)
+{
+    struct gpio_v2_line_values values;
+    memset(&values, 0, sizeof(values));
+    values.mask = 1;
+    values.bits = value ? 1 : 0;
+    if (ioctl(line_fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values) < 0) {
+        return GRC_GPIO_ERROR;
+    }
+    return GRC_OK;
+}
+
+static void linux_ll_sleep_us(void* dev, uint32_t us)
+{
+    struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (long)(us % 1000000) * 1000 };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+static uint64_t linux_ll_time_us(void* dev)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// error of a failed i2c-dev transfer: adapters report an address without a device as ENXIO or EREMOTEIO
+static int linux_ll_i2c_error(int res)
+{
+    return (res < 0) && ((errno == ENXIO) || (errno == EREMOTEIO)) ? I2C_NACK : I2C_ERROR;
+}
+
+static int linux_ll_i2c_init(void* dev)
+{
+    struct grc_ll_i2c_dev_linux* ll_dev = (struct grc_ll_i2c_dev_linux*)dev;
+    CHECK_LINUX_DEVICE(ll_dev)
+
+    ll_dev->fds.i2c = open(ll_dev->i2c_dev_path, O_RDWR | O_CLOEXEC);
+    if (ll_dev->fds.i2c < 0) {
+        return I2C_ERROR;
+    }
+    if (ioctl(ll_dev->fds.i2c, I2C_SLAVE, (unsigned long)ll_dev->slave_addr) < 0) {
+        close(ll_dev->fds.i2c);
+        return I2C_ERROR;
+    }
+
+    ll_dev->fds.data_ready = -1;
+    if (ll_dev->gpio_chip_path && ll_dev->data_ready_line >= 0) {
+        ll_dev->fds.data_ready = grc_linux_request_line(ll_dev->gpio_chip_path, ll_dev->data_ready_line,
+            GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_RISING);
+        if (ll_dev->fds.data_ready < 0) {
+            close(ll_dev->fds.i2c);
+            return GRC_GPIO_ERROR;
+        }
+    }
+    return GRC_OK;
+}
+
+static int linux_ll_i2c_release(void* dev)
+{
+    struct grc_ll_i2c_dev_linux* ll_dev = (struct grc_ll_i2c_dev_linux*)dev;
+
+    if (ll_dev->fds.data_ready >= 0) {
+        close(ll_dev->fds.data_ready);
+        ll_dev->fds.data_ready = -1;
+    }
+    if (close(ll_dev->fds.i2c) < 0) {
+        return I2C_ERROR;
+    }
+    return GRC_OK;
+}
+
+static int linux_ll_i2c_write(void* dev, const void* data, int len)
+{
+    struct grc_ll_i2c_dev_linux* ll_dev = (struct grc_ll_i2c_dev_linux*)dev;
+
+    if (len < 1) {
+        return ARGUMENT_ERROR;
+    }
+    int res = write(ll_dev->fds.i2c, data, len);
+    if (res != len) {
+        return linux_ll_i2c_error(res);
+    }
+    return len;
+}
+
+static int linux_ll_i2c_writev(void* dev, const struct grc_ll_iovec* iov, int cnt)
+{
+    struct grc_ll_i2c_dev_linux* ll_dev = (struct grc_ll_i2c_dev_linux*)dev;
+
+    // i2c-dev turns every writev segment into a separate I2C message, gather them into one
+    uint8_t buf[GRC_LINUX_I2C_MAX_WRITE];
+    int len = 0;
+    for (int i = 0; i < cnt; i++) {
+        if (iov[i].len < 0 || len + iov[i].len > GRC_LINUX_I2C_MAX_WRITE) {
+            return ARGUMENT_ERROR;
+        }
+        memcpy(&buf[len], iov[i].data, iov[i].len);
+        len += iov[i].len;
+    }
+    if (len < 1) {
+        return ARGUMENT_ERROR;
+    }
+    int res = write(ll_dev->fds.i2c, buf, len);
+    if (res != len) {
+        return linux_ll_i2c_error(res);
+    }
+    return len;
+}
+
+static int linux_ll_i2c_read(void* dev, void* data, int len)
+{
+    struct grc_ll_i2c_dev_linux* ll_dev = (struct grc_ll_i2c_dev_linux*)dev;
+
+    if (len < 1) {
+        return ARGUMENT_ERROR;
+    }
+    int res = read(ll_dev->fds.i2c, data, len);
+    if (res != len) {
+        return linux_ll_i2c_error(res);
+    }
+    return len;
+}
+
+static int linux_ll_i2c_write_read(void* dev, const void* wdata, int wlen, void* rdata, int rlen)
+{
+    struct grc_ll_i2c_dev_linux* ll_dev = (struct grc_ll_i2c_dev_linux*)dev;
+
+    if (wlen < 1 || rlen < 1 || wlen > GRC_LINUX_I2C_MAX_WRITE || rlen > GRC_LINUX_I2C_MAX_WRITE) {
+        return ARGUMENT_ERROR;
+    }
+    struct i2c_msg msgs[2] = {
+        { .addr = ll_dev->slave_addr, .flags = 0, .len = (uint16_t)wlen, .buf = (uint8_t*)wdata },
+        { .addr = ll_dev->slave_addr, .flags = I2C_M_RD, .len = (uint16_t)rlen, .buf = (uint8_t*)rdata },
+    };
+    struct i2c_rdwr_ioctl_data xfer = { .msgs = msgs, .nmsgs = 2 };
+    int res = ioctl(ll_dev->fds.i2c, I2C_RDWR, &xfer);
+    if (res != 2) {
+        // SMBus-only adapters (i2c-stub among them) have no combined transactions
+        return (res < 0) && (errno == EOPNOTSUPP) ? NOT_IMPLEMENTED : linux_ll_i2c_error(res);
+    }
+    return rlen;
+}
+
+static int linux_ll_i2c_set_address(void* dev, uint16_t addr)
+{
+    struct grc_ll_i2c_dev_linux* ll_dev = (struct grc_ll_i2c_dev_linux*)dev;
+
+    // every device opens the bus on its own, the adapter lock of the kernel serialises their transactions
+    if (ioctl(ll_dev->fds.i2c, I2C_SLAVE, (unsigned long)addr) < 0) {
+        return I2C_ERROR;
+    }
+    ll_dev->slave_addr = addr;
+    return GRC_OK;
+}
+
+static int linux_ll_i2c_get_address(void* dev)
+{
+    struct grc_ll_i2c_dev_linux* ll_dev = (struct grc_ll_i2c_dev_linux*)dev;
+    return ll_dev->slave_addr;
+}
+
+static int linux_ll_i2c_mtu(void* dev)
+{
+    return GRC_LINUX_I2C_MAX_WRITE;
+}
+
+// edges are queued by the kernel, no interrupt handler is needed
+static int linux_ll_wait_ready(void* dev, int timeout_ms)
+{
+    struct grc_ll_i2c_dev_linux* ll_dev = (struct grc_ll_i2c_dev_linux*)dev;
+
+    int fd = ll_dev->fds.data_ready >= 0 ? ll_dev->fds.data_ready : ll_dev->data_ready_event_fd;
+    if (fd < 0) {
+        return NOT_IMPLEMENTED;
+    }
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    int res;
+    do {
+        res = poll(&pfd, 1, timeout_ms);
+    } while (res < 0 && errno == EINTR);
+    if (res < 0) {
+        return GRC_GPIO_ERROR;
+    }
+    if (res == 0) {
+        return GRC_TIMEOUT;
+    }
+
+    // consume the edge
+    if (fd == ll_dev->fds.data_ready) {
+        struct gpio_v2_line_event event;
+        res = read(fd, &event, sizeof(event)) == sizeof(event);
+    } else {
+        uint64_t counter;
+        res = read(fd, &counter, sizeof(counter)) == sizeof(counter);
+    }
+    return res ? GRC_OK : GRC_GPIO_ERROR;
+}
+
+static int linux_ll_ready_fd(void* dev)
+{
+    struct grc_ll_i2c_dev_linux* ll_dev = (struct grc_ll_i2c_dev_linux*)dev;
+
+    int fd = ll_dev->fds.data_ready >= 0 ? ll_dev->fds.data_ready : ll_dev->data_ready_event_fd;
+    return fd >= 0 ? fd : NOT_IMPLEMENTED;
+}
+
+static int linux_ll_gpio_init(void* dev)
+{
+    struct grc_ll_i2c_dev_linux* ll_dev = (struct grc_ll_i2c_dev_linux*)dev;
+
+    if (!ll_dev->gpio_chip_path || ll_dev->reset_line < 0) {
+        return GRC_GPIO_ERROR;
+    }
+    ll_dev->fds.reset = grc_linux_request_line(ll_dev->gpio_chip_path, ll_dev->reset_line, GPIO_V2_LINE_FLAG_OUTPUT);
+    if (ll_dev->fds.reset < 0) {
+        return GRC_GPIO_ERROR;
+    }
+    return GRC_OK;
+}
+
+static int linux_ll_gpio_reset_high(void* dev)
+{
+    struct grc_ll_i2c_dev_linux* ll_dev = (struct grc_ll_i2c_dev_linux*)dev;
+
+    int res = grc_linux_set_line(ll_dev->fds.reset, 1);
+    // reset is the last use of the line, release it for other consumers
+    close(ll_dev->fds.reset);
+    ll_dev->fds.reset = -1;
+    return res;
+}
+
+static int linux_ll_gpio_reset_low(void* dev)
+{
+    struct grc_ll_i2c_dev_linux* ll_dev = (struct grc_ll_i2c_dev_linux*)dev;
+
+    return grc_linux_set_line(ll_dev->fds.reset, 0);
+}
+
+// transport of grc_ll_i2c_dev_linux devices
+static const struct grc_transport_ops grc_linux_transport = {
+    .init = linux_ll_i2c_init,
+    .release = linux_ll_i2c_release,
+    .write = linux_ll_i2c_write,
+    .writev = linux_ll_i2c_writev,
+    .read = linux_ll_i2c_read,
+    .write_read = linux_ll_i2c_write_read,
+    .set_address = linux_ll_i2c_set_address,
+    .get_address = linux_ll_i2c_get_address,
+    .mtu = linux_ll_i2c_mtu,
+    .wait_ready = linux_ll_wait_ready,
+    .ready_fd = linux_ll_ready_fd,
+    .gpio_init = linux_ll_gpio_init,
+    .gpio_reset_high = linux_ll_gpio_reset_high,
+    .gpio_reset_low = linux_ll_gpio_reset_low,
+    .sleep_us = linux_ll_sleep_us,
+    .time_us = linux_ll_time_us,
+};
+
+#if !defined(GRC_TRANSPORT_NO_DEFAULT) && !defined(GRC_STATIC_TRANSPORT_HEADER)
+const struct grc_transport_ops* const grc_default_transport = &grc_linux_transport;
+#endif
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _GRC_DRIVERS_I2C_LINUX_IMPL_H_
@@ -0,0 +1,120 @@
+#ifndef _GRC_DRIVERS_SERIAL_H_
+#define _GRC_DRIVERS_SERIAL_H_
+
+#include <stdint.h>
+
+#include "grc/drivers/grc_ll_driver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#define PROTOCOL_INTERFACE_SERIAL 0x32220005
+
+// frame on the serial link: sync byte, payload length (2 bytes, little endian), payload,
+// CRC-8 of the length and payload bytes
+#define GRC_SERIAL_SYNC 0xa5
+#define GRC_SERIAL_HEADER_SIZE 3
+#define GRC_SERIAL_MAX_PAYLOAD 1024
+#define GRC_SERIAL_MAX_FRAME (GRC_SERIAL_HEADER_SIZE + GRC_SERIAL_MAX_PAYLOAD + 1)
+
+// operations of a request payload, executed by the bridge in order. lengths are 2 bytes, little endian
+#define GRC_SERIAL_OP_WRITE 0x01 // address, length, data
+#define GRC_SERIAL_OP_READ 0x02 // address, length
+#define GRC_SERIAL_OP_WRITE_READ 0x03 // address, write length, data, read length. read after a repeated start
+#define GRC_SERIAL_OP_DELAY 0x04 // microseconds (4 bytes, little endian)
+
+// reply payload: one status byte per executed operation (0 or error code), then the bytes read by the operations.
+// the bridge stops at the first failed operation, the bytes are not sent then
+
+// largest I2C transaction the bridge carries
+#define GRC_SERIAL_MTU 256
+
+/*!
+ * \brief traffic of the serial transport
+ * \param exchanges request frames sent and their replies received
+ * \param transactions I2C transactions sent in the frames
+ * \param bytes_sent, bytes_received frame bytes on the serial link
+ */
+struct grc_serial_stats {
+    uint32_t exchanges;
+    uint32_t transactions;
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+};
+
+/*!
+ * \brief GRC behind an MCU bridge reached over a serial link (USB CDC, UART). the I2C transactions are tunnelled
+ *        in frames: writes and sleeps are queued and sent with the next read in one exchange, so the link latency
+ *        is paid once per reply instead of once per transaction. errors of queued writes are reported by the
+ *        transaction that sends them
+ * \param type PROTOCOL_INTERFACE_SERIAL
+ * \param tty_path serial device of the bridge, e.g. "/dev/ttyACM0"
+ * \param baud line speed, 0 - 115200. USB CDC bridges ignore it
+ * \param slave_addr GRC device address on the I2C bus of the bridge
+ * \param timeout_ms longest wait for a reply frame, 0 - 1000
+ * \param unbatched 1 - every transaction is sent in an exchange of its own
+ * \param stats link traffic, may be reset by the user
+ * \param fd opened by the driver
+ * \param frame request being queued
+ */
+struct grc_ll_serial_dev {
+    uint32_t type;
+
+    const char* tty_path;
+    uint32_t baud;
+    uint16_t slave_addr;
+    uint32_t timeout_ms;
+    uint8_t unbatched;
+
+    struct grc_serial_stats stats;
+
+    int fd;
+    struct {
+        uint8_t buf[GRC_SERIAL_MAX_FRAME];
+        uint16_t len;
+        uint8_t ops;
+        uint64_t delay_us;
+    } frame;
+};
+
+/*!
+ * \brief send a frame, the payload is at frame + GRC_SERIAL_HEADER_SIZE and the header and CRC are filled in
+ * \return Ok(=0) or I2C_ERROR
+ */
+int grc_serial_write_frame(int fd, uint8_t* frame, int payload_len);
+
+/*!
+ * \brief receive a frame into GRC_SERIAL_MAX_FRAME bytes, bytes before the sync byte are skipped
+ * \param timeout_ms longest wait for the whole frame, -1 - no limit
+ * \return payload length (payload at frame + GRC_SERIAL_HEADER_SIZE), GRC_TIMEOUT, WRONG_GRC_ANSWER if the CRC or
+ *         the length is wrong, I2C_ERROR if the link is closed
+ */
+int grc_serial_read_frame(int fd, uint8_t* frame, int timeout_ms);
+
+/*!
+ * \brief bridge side: execute the operations of a request payload on the I2C transport of the bridge
+ * \param request, len request payload
+ * \param reply reply payload
+ * \param max size of reply, GRC_SERIAL_MAX_PAYLOAD holds the reply of any request
+ * \param i2c, i2c_dev initialised transport of the bridge and its device
+ * \return reply payload length or ARGUMENT_ERROR if the request is malformed
+ */
+int grc_serial_bridge_execute(const uint8_t* request, int len, uint8_t* reply, int max,
+    const struct grc_transport_ops* i2c, void* i2c_dev);
+
+/*!
+ * \brief bridge side: answer request frames read from the file descriptor until it is closed. frames with a bad
+ *        CRC are answered with an empty reply. used by Linux bridges and to test the transport over a pty pair
+ * \param fd serial link, e.g. the master of a pty whose slave is opened by the transport
+ * \param i2c, i2c_dev initialised transport of the bridge and its device
+ * \param reply_delay_us added before every reply, models the link latency (USB polling interval). 0 - none
+ * \return Ok(=0) when the link is closed or I2C_ERROR
+ */
+int grc_serial_bridge_serve(int fd, const struct grc_transport_ops* i2c, void* i2c_dev, uint32_t reply_delay_us);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _GRC_DRIVERS_SERIAL_H_
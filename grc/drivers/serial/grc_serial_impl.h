@@ -0,0 +1,325 @@
+#ifndef _GRC_DRIVERS_SERIAL_IMPL_H_
+#define _GRC_DRIVERS_SERIAL_IMPL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include "grc/drivers/grc_ll_driver.h"
+#include "grc/grc_error_codes.h"
+#include "grc_serial.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define GRC_SERIAL_DEFAULT_BAUD 115200
+#define GRC_SERIAL_DEFAULT_TIMEOUT_MS 1000
+// operation header: code, address, length
+#define GRC_SERIAL_OP_HEADER_SIZE 4
+
+#define CHECK_SERIAL_DEVICE(ll_dev)                   \
+    if ((ll_dev)->type != PROTOCOL_INTERFACE_SERIAL) \
+        return ARGUMENT_ERROR;
+
+static speed_t serial_baud_speed(uint32_t baud)
+{
+    switch (baud) {
+    case 9600:
+        return B9600;
+    case 19200:
+        return B19200;
+    case 38400:
+        return B38400;
+    case 57600:
+        return B57600;
+    case 115200:
+        return B115200;
+    case 230400:
+        return B230400;
+    case 460800:
+        return B460800;
+    case 921600:
+        return B921600;
+    default:
+        return B0;
+    }
+}
+
+static void serial_put_u16(uint8_t* p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void serial_put_u32(uint8_t* p, uint32_t v)
+{
+    serial_put_u16(p, v);
+    serial_put_u16(p + 2, v >> 16);
+}
+
+// queued operations are sent in one request and their statuses checked, rdata gets the bytes of the last one
+static int serial_ll_flush_read(struct grc_ll_serial_dev* ll_dev, void* rdata, int rlen)
+{
+    if (ll_dev->frame.ops == 0) {
+        return GRC_OK;
+    }
+    int ops = ll_dev->frame.ops;
+    ll_dev->stats.exchanges++;
+    ll_dev->stats.bytes_sent += GRC_SERIAL_HEADER_SIZE + ll_dev->frame.len + 1;
+    ll_dev->frame.ops = 0;
+    ll_dev->frame.delay_us = 0;
+    // bytes of an earlier reply given up on are dropped, they would be taken for this one
+    tcflush(ll_dev->fd, TCIFLUSH);
+    int res = grc_serial_write_frame(ll_dev->fd, ll_dev->frame.buf, ll_dev->frame.len);
+    ll_dev->frame.len = 0;
+    if (res < 0) {
+        return res;
+    }
+    uint8_t* reply = ll_dev->frame.buf;
+    int timeout_ms = ll_dev->timeout_ms ? (int)ll_dev->timeout_ms : GRC_SERIAL_DEFAULT_TIMEOUT_MS;
+    int len = grc_serial_read_frame(ll_dev->fd, reply, timeout_ms);
+    if (len < 0) {
+        return I2C_ERROR;
+    }
+    ll_dev->stats.bytes_received += GRC_SERIAL_HEADER_SIZE + len + 1;
+    reply += GRC_SERIAL_HEADER_SIZE;
+    // the bridge stops at the first failed operation
+    for (int i = 0; i < ops; i++) {
+        if ((i >= len) || ((int8_t)reply[i] < 0)) {
+            return i < len ? (int8_t)reply[i] : I2C_ERROR;
+        }
+    }
+    if (len != ops + rlen) {
+        return I2C_ERROR;
+    }
+    if (rlen > 0) {
+        memcpy(rdata, reply + ops, rlen);
+    }
+    return GRC_OK;
+}
+
+// room for an operation of size bytes, queued ones are sent if it does not fit
+static uint8_t* serial_ll_queue(struct grc_ll_serial_dev* ll_dev, int size)
+{
+    if (ll_dev->frame.len + size > GRC_SERIAL_MAX_PAYLOAD) {
+        if (serial_ll_flush_read(ll_dev, NULL, 0) < 0) {
+            return NULL;
+        }
+    }
+    uint8_t* op = &ll_dev->frame.buf[GRC_SERIAL_HEADER_SIZE + ll_dev->frame.len];
+    ll_dev->frame.len += size;
+    ll_dev->frame.ops++;
+    return op;
+}
+
+static void serial_ll_sleep_us(void* dev, uint32_t us)
+{
+    struct grc_ll_serial_dev* ll_dev = (struct grc_ll_serial_dev*)dev;
+    // a sleep between queued transactions is made by the bridge
+    if ((ll_dev->frame.ops > 0) && !ll_dev->unbatched) {
+        uint8_t* op = serial_ll_queue(ll_dev, 5);
+        if (op != NULL) {
+            op[0] = GRC_SERIAL_OP_DELAY;
+            serial_put_u32(op + 1, us);
+            ll_dev->frame.delay_us += us;
+            return;
+        }
+    }
+    struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (long)(us % 1000000) * 1000 };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
+}
+
+// the sleeps queued for the bridge count as passed, the protocol layer times the replies with them
+static uint64_t serial_ll_time_us(void* dev)
+{
+    struct grc_ll_serial_dev* ll_dev = (struct grc_ll_serial_dev*)dev;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000 + ll_dev->frame.delay_us;
+}
+
+static int serial_ll_init(void* dev)
+{
+    struct grc_ll_serial_dev* ll_dev = (struct grc_ll_serial_dev*)dev;
+    CHECK_SERIAL_DEVICE(ll_dev)
+
+    speed_t speed = serial_baud_speed(ll_dev->baud ? ll_dev->baud : GRC_SERIAL_DEFAULT_BAUD);
+    if (speed == B0) {
+        return ARGUMENT_ERROR;
+    }
+    ll_dev->fd = open(ll_dev->tty_path, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (ll_dev->fd < 0) {
+        return I2C_ERROR;
+    }
+    // frames are binary: no echo, no line editing, no flow control or character translation
+    struct termios tio;
+    if (tcgetattr(ll_dev->fd, &tio) < 0) {
+        close(ll_dev->fd);
+        return I2C_ERROR;
+    }
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    if (tcsetattr(ll_dev->fd, TCSANOW, &tio) < 0) {
+        close(ll_dev->fd);
+        return I2C_ERROR;
+    }
+    ll_dev->frame.len = 0;
+    ll_dev->frame.ops = 0;
+    ll_dev->frame.delay_us = 0;
+    return GRC_OK;
+}
+
+static int serial_ll_flush(void* dev)
+{
+    return serial_ll_flush_read((struct grc_ll_serial_dev*)dev, NULL, 0);
+}
+
+static int serial_ll_release(void* dev)
+{
+    struct grc_ll_serial_dev* ll_dev = (struct grc_ll_serial_dev*)dev;
+    int res = serial_ll_flush(dev);
+    close(ll_dev->fd);
+    return res;
+}
+
+// queue a write of the fragments, the unbatched transport sends it at once
+static int serial_ll_queue_write(struct grc_ll_serial_dev* ll_dev, const struct grc_ll_iovec* iov, int cnt)
+{
+    int len = 0;
+    for (int i = 0; i < cnt; i++) {
+        len += iov[i].len > 0 ? iov[i].len : 0;
+    }
+    if ((len < 1) || (len > GRC_SERIAL_MTU)) {
+        return ARGUMENT_ERROR;
+    }
+    uint8_t* op = serial_ll_queue(ll_dev, GRC_SERIAL_OP_HEADER_SIZE + len);
+    if (op == NULL) {
+        return I2C_ERROR;
+    }
+    op[0] = GRC_SERIAL_OP_WRITE;
+    op[1] = (uint8_t)ll_dev->slave_addr;
+    ll_dev->stats.transactions++;
+    serial_put_u16(op + 2, len);
+    uint8_t* p = op + GRC_SERIAL_OP_HEADER_SIZE;
+    for (int i = 0; i < cnt; i++) {
+        if (iov[i].len > 0) {
+            memcpy(p, iov[i].data, iov[i].len);
+            p += iov[i].len;
+        }
+    }
+    if (ll_dev->unbatched) {
+        int res = serial_ll_flush_read(ll_dev, NULL, 0);
+        if (res < 0) {
+            return res;
+        }
+    }
+    return len;
+}
+
+static int serial_ll_write(void* dev, const void* data, int len)
+{
+    struct grc_ll_iovec iov = { .data = data, .len = len };
+    return serial_ll_queue_write((struct grc_ll_serial_dev*)dev, &iov, 1);
+}
+
+static int serial_ll_writev(void* dev, const struct grc_ll_iovec* iov, int cnt)
+{
+    return serial_ll_queue_write((struct grc_ll_serial_dev*)dev, iov, cnt);
+}
+
+static int serial_ll_read(void* dev, void* data, int len)
+{
+    struct grc_ll_serial_dev* ll_dev = (struct grc_ll_serial_dev*)dev;
+    if ((len < 1) || (len > GRC_SERIAL_MTU)) {
+        return ARGUMENT_ERROR;
+    }
+    uint8_t* op = serial_ll_queue(ll_dev, GRC_SERIAL_OP_HEADER_SIZE);
+    if (op == NULL) {
+        return I2C_ERROR;
+    }
+    op[0] = GRC_SERIAL_OP_READ;
+    op[1] = (uint8_t)ll_dev->slave_addr;
+    ll_dev->stats.transactions++;
+    serial_put_u16(op + 2, len);
+    int res = serial_ll_flush_read(ll_dev, data, len);
+    return res < 0 ? res : len;
+}
+
+static int serial_ll_write_read(void* dev, const void* wdata, int wlen, void* rdata, int rlen)
+{
+    struct grc_ll_serial_dev* ll_dev = (struct grc_ll_serial_dev*)dev;
+    if ((wlen < 1) || (rlen < 1) || (wlen > GRC_SERIAL_MTU) || (rlen > GRC_SERIAL_MTU)) {
+        return ARGUMENT_ERROR;
+    }
+    uint8_t* op = serial_ll_queue(ll_dev, GRC_SERIAL_OP_HEADER_SIZE + wlen + 2);
+    if (op == NULL) {
+        return I2C_ERROR;
+    }
+    op[0] = GRC_SERIAL_OP_WRITE_READ;
+    op[1] = (uint8_t)ll_dev->slave_addr;
+    ll_dev->stats.transactions++;
+    serial_put_u16(op + 2, wlen);
+    memcpy(op + GRC_SERIAL_OP_HEADER_SIZE, wdata, wlen);
+    serial_put_u16(op + GRC_SERIAL_OP_HEADER_SIZE + wlen, rlen);
+    int res = serial_ll_flush_read(ll_dev, rdata, rlen);
+    return res < 0 ? res : rlen;
+}
+
+// every operation carries its address, queued ones keep theirs
+static int serial_ll_set_address(void* dev, uint16_t addr)
+{
+    struct grc_ll_serial_dev* ll_dev = (struct grc_ll_serial_dev*)dev;
+    ll_dev->slave_addr = addr;
+    return GRC_OK;
+}
+
+static int serial_ll_get_address(void* dev)
+{
+    struct grc_ll_serial_dev* ll_dev = (struct grc_ll_serial_dev*)dev;
+    return ll_dev->slave_addr;
+}
+
+static int serial_ll_mtu(void* dev)
+{
+    return GRC_SERIAL_MTU;
+}
+
+// transport of grc_ll_serial_dev devices. the data ready and reset lines stay at the bridge
+static const struct grc_transport_ops grc_serial_transport = {
+    .init = serial_ll_init,
+    .release = serial_ll_release,
+    .write = serial_ll_write,
+    .writev = serial_ll_writev,
+    .read = serial_ll_read,
+    .write_read = serial_ll_write_read,
+    .set_address = serial_ll_set_address,
+    .get_address = serial_ll_get_address,
+    .mtu = serial_ll_mtu,
+    .wait_ready = NULL,
+    .ready_fd = NULL,
+    .gpio_init = NULL,
+    .gpio_reset_high = NULL,
+    .gpio_reset_low = NULL,
+    .sleep_us = serial_ll_sleep_us,
+    .time_us = serial_ll_time_us,
+    .flush = serial_ll_flush,
+};
+
+#if !defined(GRC_TRANSPORT_NO_DEFAULT) && !defined(GRC_STATIC_TRANSPORT_HEADER)
+const struct grc_transport_ops* const grc_default_transport = &grc_serial_transport;
+#endif
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _GRC_DRIVERS_SERIAL_IMPL_H_
@@ -0,0 +1,247 @@
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "grc/grc_error_codes.h"
+#include "grc/i2c/crc_calculation.h"
+#include "grc_serial.h"
+
+static uint64_t serial_time_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + ts.tv_nsec / 1000000;
+}
+
+static uint16_t serial_get_u16(const uint8_t* p)
+{
+    return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t serial_get_u32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// CRC-8 of the length and payload bytes, Crc8Update takes up to 255 bytes at once
+static uint8_t serial_frame_crc(const uint8_t* frame, int payload_len)
+{
+    const uint8_t* p = frame + 1;
+    int len = payload_len + 2;
+    uint8_t crc = CRC8_INIT;
+    while (len > 0) {
+        uint8_t part = len > 255 ? 255 : (uint8_t)len;
+        crc = Crc8Update(crc, p, part);
+        p += part;
+        len -= part;
+    }
+    return crc;
+}
+
+int grc_serial_write_frame(int fd, uint8_t* frame, int payload_len)
+{
+    frame[0] = GRC_SERIAL_SYNC;
+    frame[1] = (uint8_t)payload_len;
+    frame[2] = (uint8_t)(payload_len >> 8);
+    frame[GRC_SERIAL_HEADER_SIZE + payload_len] = serial_frame_crc(frame, payload_len);
+    int len = GRC_SERIAL_HEADER_SIZE + payload_len + 1;
+    int sent = 0;
+    while (sent < len) {
+        ssize_t res = write(fd, frame + sent, len - sent);
+        if (res < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return I2C_ERROR;
+        }
+        sent += (int)res;
+    }
+    return GRC_OK;
+}
+
+// read exactly len bytes before the deadline, deadline 0 - no limit
+static int serial_read_all(int fd, uint8_t* data, int len, uint64_t deadline_ms)
+{
+    int got = 0;
+    while (got < len) {
+        int timeout = -1;
+        if (deadline_ms != 0) {
+            uint64_t now = serial_time_ms();
+            if (now >= deadline_ms) {
+                return GRC_TIMEOUT;
+            }
+            timeout = (int)(deadline_ms - now);
+        }
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        int res = poll(&pfd, 1, timeout);
+        if (res < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return I2C_ERROR;
+        }
+        if (res == 0) {
+            return GRC_TIMEOUT;
+        }
+        ssize_t cnt = read(fd, data + got, len - got);
+        if (cnt < 0 && (errno == EINTR || errno == EAGAIN)) {
+            continue;
+        }
+        // EIO: the other side of a pty is closed
+        if (cnt <= 0) {
+            return I2C_ERROR;
+        }
+        got += (int)cnt;
+    }
+    return GRC_OK;
+}
+
+int grc_serial_read_frame(int fd, uint8_t* frame, int timeout_ms)
+{
+    uint64_t deadline = timeout_ms < 0 ? 0 : serial_time_ms() + (uint64_t)timeout_ms;
+    // a frame starts with the sync byte, the rest of a broken frame is skipped
+    do {
+        int res = serial_read_all(fd, frame, 1, deadline);
+        if (res < 0) {
+            return res;
+        }
+    } while (frame[0] != GRC_SERIAL_SYNC);
+    int res = serial_read_all(fd, frame + 1, 2, deadline);
+    if (res < 0) {
+        return res;
+    }
+    int payload_len = serial_get_u16(frame + 1);
+    if (payload_len > GRC_SERIAL_MAX_PAYLOAD) {
+        return WRONG_GRC_ANSWER;
+    }
+    res = serial_read_all(fd, frame + GRC_SERIAL_HEADER_SIZE, payload_len + 1, deadline);
+    if (res < 0) {
+        return res;
+    }
+    if (frame[GRC_SERIAL_HEADER_SIZE + payload_len] != serial_frame_crc(frame, payload_len)) {
+        return WRONG_GRC_ANSWER;
+    }
+    return payload_len;
+}
+
+// ================ BRIDGE ====================
+
+// runs one operation, returns its size in the request or ARGUMENT_ERROR. *status gets its result
+static int bridge_operation(const uint8_t* op, int len, uint8_t* data, int max, int* read_len, int* status,
+    const struct grc_transport_ops* i2c, void* i2c_dev, uint16_t* addr)
+{
+    *read_len = 0;
+    if ((op[0] == GRC_SERIAL_OP_DELAY) && (len >= 5)) {
+        i2c->sleep_us(i2c_dev, serial_get_u32(op + 1));
+        *status = GRC_OK;
+        return 5;
+    }
+    if (len < 4) {
+        return ARGUMENT_ERROR;
+    }
+    int size = 4;
+    int wlen = 0;
+    int rlen = 0;
+    switch (op[0]) {
+    case GRC_SERIAL_OP_WRITE:
+        wlen = serial_get_u16(op + 2);
+        size += wlen;
+        break;
+    case GRC_SERIAL_OP_READ:
+        rlen = serial_get_u16(op + 2);
+        break;
+    case GRC_SERIAL_OP_WRITE_READ:
+        wlen = serial_get_u16(op + 2);
+        size += wlen + 2;
+        if (size <= len) {
+            rlen = serial_get_u16(op + 4 + wlen);
+        }
+        break;
+    default:
+        return ARGUMENT_ERROR;
+    }
+    if ((size > len) || (rlen > max) || (wlen > GRC_SERIAL_MTU) || (rlen > GRC_SERIAL_MTU)) {
+        return ARGUMENT_ERROR;
+    }
+    // the transport follows the address of the operations, links with one module ignore it
+    if ((op[1] != *addr) && (i2c->set_address != NULL)) {
+        int res = i2c->set_address(i2c_dev, op[1]);
+        if ((res < 0) && (res != NOT_IMPLEMENTED)) {
+            *status = res;
+            return size;
+        }
+        *addr = op[1];
+    }
+    int res;
+    if ((wlen > 0) && (rlen > 0)) {
+        if (i2c->write_read != NULL) {
+            res = i2c->write_read(i2c_dev, op + 4, wlen, data, rlen);
+        } else {
+            res = i2c->write(i2c_dev, op + 4, wlen);
+            res = res < 0 ? res : i2c->read(i2c_dev, data, rlen);
+        }
+    } else if (wlen > 0) {
+        res = i2c->write(i2c_dev, op + 4, wlen);
+    } else {
+        res = i2c->read(i2c_dev, data, rlen);
+    }
+    *status = res < 0 ? res : GRC_OK;
+    *read_len = res < 0 ? 0 : rlen;
+    return size;
+}
+
+int grc_serial_bridge_execute(const uint8_t* request, int len, uint8_t* reply, int max,
+    const struct grc_transport_ops* i2c, void* i2c_dev)
+{
+    // statuses go first, the read bytes are collected after the request is run
+    uint8_t data[GRC_SERIAL_MAX_PAYLOAD];
+    int data_len = 0;
+    int ops = 0;
+    uint16_t addr = 0;
+    int pos = 0;
+    while (pos < len) {
+        int read_len;
+        int status;
+        int size = bridge_operation(request + pos, len - pos, data + data_len, max - data_len - ops - 1, &read_len,
+            &status, i2c, i2c_dev, &addr);
+        if (size < 0) {
+            return size;
+        }
+        reply[ops++] = (uint8_t)(int8_t)status;
+        if (status < 0) {
+            return ops;
+        }
+        data_len += read_len;
+        pos += size;
+    }
+    memcpy(reply + ops, data, data_len);
+    return ops + data_len;
+}
+
+int grc_serial_bridge_serve(int fd, const struct grc_transport_ops* i2c, void* i2c_dev, uint32_t reply_delay_us)
+{
+    uint8_t request[GRC_SERIAL_MAX_FRAME];
+    uint8_t reply[GRC_SERIAL_MAX_FRAME];
+    while (1) {
+        int len = grc_serial_read_frame(fd, request, -1);
+        if (len == I2C_ERROR) {
+            // the host closed the link
+            return GRC_OK;
+        }
+        int reply_len = 0;
+        if (len >= 0) {
+            reply_len = grc_serial_bridge_execute(request + GRC_SERIAL_HEADER_SIZE, len,
+                reply + GRC_SERIAL_HEADER_SIZE, GRC_SERIAL_MAX_PAYLOAD, i2c, i2c_dev);
+            // a malformed request gets no statuses, as a broken one
+            reply_len = reply_len < 0 ? 0 : reply_len;
+        }
+        if (reply_delay_us > 0) {
+            i2c->sleep_us(i2c_dev, reply_delay_us);
+        }
+        if (grc_serial_write_frame(fd, reply, reply_len) < 0) {
+            return I2C_ERROR;
+        }
+    }
+}
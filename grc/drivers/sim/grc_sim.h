@@ -0,0 +1,233 @@
+#ifndef _GRC_DRIVERS_SIM_H_
+#define _GRC_DRIVERS_SIM_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#define PROTOCOL_INTERFACE_SIM 0x32220003
+
+/*!
+ * \brief behaviour of the simulated GRC module
+ * \param sdk_version version reported for GET_SDK_VERSION_CMD
+ * \param response_us time after a command write before the reply can be read. earlier reads return 0xff
+ * \param function_us execution time of a remote function
+ * \param train_us execution time of the stop training function
+ * \param bus_hz modelled I2C clock, a transaction takes its start, address, data, acknowledge and stop bits.
+ *        0 - transfers take no time
+ * \param state_floats_per_class size of one class in the downloaded model
+ * \param ready_line 1 - module signals function completion on the data ready line (see grc_sim_module_ready_fd)
+ * \param block_error_period every Nth stream block received or sent by the module fails CRC check. 0 - no errors
+ * \param max_block_size largest stream block the module sends on bulk read. 0 - 255
+ * \param queue_depth number of submitted functions the module keeps (SDK version 3). 0 - 4
+ * \param mtu largest transaction of the simulated link, longer ones fail. 0 - 4096
+ * \param stall_period every Nth called function runs stall_us longer, as a stalled module. 0 - no stalls
+ * \param stall_us extra execution time of a stalled function
+ * \param transaction_us fixed latency of every transaction on top of its transfer time, as the adapter and the
+ *        driver of a real bus add
+ * \param nak_period every Nth transaction is not acknowledged: the module takes no command and sends no reply,
+ *        the master gets I2C_NACK. 0 - no errors
+ * \param not_ready_period every Nth read gets the idle bus (0xff bytes) as if the reply were not ready. 0 - never
+ * \param bit_flip_period every Nth read has one bit flipped, a different one each time. replies without a CRC
+ *        reach the SDK as they are. 0 - never
+ */
+struct grc_sim_config {
+    uint32_t sdk_version;
+    uint32_t response_us;
+    uint32_t function_us;
+    uint32_t train_us;
+    uint32_t bus_hz;
+    uint32_t state_floats_per_class;
+    uint32_t ready_line;
+    uint32_t block_error_period;
+    uint32_t max_block_size;
+    uint32_t queue_depth;
+    uint32_t mtu;
+    uint32_t stall_period;
+    uint32_t stall_us;
+    uint32_t transaction_us;
+    uint32_t nak_period;
+    uint32_t not_ready_period;
+    uint32_t bit_flip_period;
+};
+
+// every field is named so C++ takes it without missing initializer warnings
+#define GRC_SIM_DEFAULT_CONFIG                                                   \
+    {                                                                            \
+        .sdk_version = 1, .response_us = 50,                                     \
+        .function_us = 200, .train_us = 2000,                                    \
+        .bus_hz = 400000, .state_floats_per_class = 500,                         \
+        .ready_line = 0, .block_error_period = 0, .max_block_size = 0,           \
+        .queue_depth = 0, .mtu = 0, .stall_period = 0, .stall_us = 0,            \
+        .transaction_us = 0, .nak_period = 0, .not_ready_period = 0,             \
+        .bit_flip_period = 0                                                     \
+    }
+
+/*!
+ * \brief bus traffic seen by the simulated module
+ * \param writes number of master write transactions
+ * \param reads number of master read transactions
+ * \param combined number of write transactions followed by a read with a repeated start
+ * \param faults injected faults: transactions not acknowledged, idle or flipped replies, stream blocks failing CRC
+ * \param bytes_written payload bytes of the write transactions
+ * \param bytes_read payload bytes of the read transactions
+ */
+struct grc_sim_stats {
+    uint32_t writes;
+    uint32_t reads;
+    uint32_t combined;
+    uint32_t faults;
+    uint64_t bytes_written;
+    uint64_t bytes_read;
+};
+
+struct grc_sim_module;
+
+struct grc_sim_bus;
+
+/*!
+ * \brief simulated transport device
+ * \param type PROTOCOL_INTERFACE_SIM
+ * \param config behaviour of the simulated module
+ * \param module simulated module state. created on the first init of the transport, release with grc_sim_module_destroy.
+ *        on a shared bus it is the module attached at addr (see grc_sim_bus_attach), owned by the bus
+ * \param bus shared simulated bus, NULL - the device has a bus and a module of its own
+ * \param addr address the device talks to on bus, the attached modules keep the config they were created with
+ */
+struct grc_ll_sim_dev {
+    uint32_t type;
+    struct grc_sim_config config;
+    struct grc_sim_module* module;
+    struct grc_sim_bus* bus;
+    uint16_t addr;
+};
+
+/*!
+ * \brief create simulated module (slave side of the GRC I2C protocol)
+ * \return module or NULL if out of memory
+ */
+struct grc_sim_module* grc_sim_module_create(const struct grc_sim_config* cfg);
+void grc_sim_module_destroy(struct grc_sim_module* module);
+
+/*!
+ * \brief restore power-on state of the module (as after reset line toggle)
+ */
+void grc_sim_module_reset(struct grc_sim_module* module);
+
+/*!
+ * \brief change the injected faults of a running module, e.g. once the SDK has initialised it. takes
+ *        block_error_period, stall_period, stall_us, nak_period, not_ready_period and bit_flip_period from cfg and
+ *        starts their periods over
+ */
+void grc_sim_module_set_faults(struct grc_sim_module* module, const struct grc_sim_config* cfg);
+
+/*!
+ * \brief I2C master write to the module
+ * \return len or error code (<0)
+ */
+int grc_sim_module_write(struct grc_sim_module* module, const uint8_t* data, int len);
+
+/*!
+ * \brief I2C master read from the module
+ * \return len or error code (<0)
+ */
+int grc_sim_module_read(struct grc_sim_module* module, uint8_t* data, int len);
+
+/*!
+ * \brief I2C master write followed by a read in the same transaction (repeated start)
+ * \return rlen or error code (<0)
+ */
+int grc_sim_module_write_read(struct grc_sim_module* module, const uint8_t* wdata, int wlen, uint8_t* rdata, int rlen);
+
+/*!
+ * \brief bus traffic since module creation or the last reset of the counters
+ * \param reset 1 - set the counters to zero after reading
+ */
+void grc_sim_module_get_stats(struct grc_sim_module* module, struct grc_sim_stats* stats, int reset);
+
+/*!
+ * \brief data ready line of the module
+ * \return fd readable (8 byte counter like eventfd) after each function completion, or -1 if ready_line is off
+ */
+int grc_sim_module_ready_fd(struct grc_sim_module* module);
+
+// modules on one simulated bus
+#define GRC_SIM_BUS_MAX_MODULES 16
+
+/*!
+ * \brief traffic of a simulated bus
+ * \param transactions transactions acknowledged by a module
+ * \param naks transactions to addresses without a module
+ * \param busy_us time the bus carried transactions
+ * \param utilisation busy_us part of the time since the bus creation or the last reset, 0..1
+ */
+struct grc_sim_bus_stats {
+    uint64_t transactions;
+    uint64_t naks;
+    uint64_t busy_us;
+    float utilisation;
+};
+
+/*!
+ * \brief I2C bus shared by several simulated modules. a transaction holds the bus for its transfer time
+ *        at bus_hz and the others wait for it, as bus arbitration does. transactions to addresses without
+ *        a module are not acknowledged
+ * \param bus_hz modelled I2C clock, replaces bus_hz of the attached modules. 0 - transfers take no time
+ * \return bus or NULL if out of memory
+ */
+struct grc_sim_bus* grc_sim_bus_create(uint32_t bus_hz);
+
+/*!
+ * \brief destroy the bus and the modules attached to it
+ */
+void grc_sim_bus_destroy(struct grc_sim_bus* bus);
+
+/*!
+ * \brief connect the module to the bus at the address, the bus owns it from now on
+ * \return Ok(=0) or ARGUMENT_ERROR if the address is taken or the bus has GRC_SIM_BUS_MAX_MODULES modules
+ */
+int grc_sim_bus_attach(struct grc_sim_bus* bus, uint16_t addr, struct grc_sim_module* module);
+
+/*!
+ * \return module at the address or NULL
+ */
+struct grc_sim_module* grc_sim_bus_module(struct grc_sim_bus* bus, uint16_t addr);
+
+/*!
+ * \brief I2C master write to the address
+ * \return len, I2C_ERROR if no module acknowledges the address, or error code (<0)
+ */
+int grc_sim_bus_write(struct grc_sim_bus* bus, uint16_t addr, const uint8_t* data, int len);
+
+/*!
+ * \brief I2C master read from the address
+ * \return len, I2C_ERROR if no module acknowledges the address, or error code (<0)
+ */
+int grc_sim_bus_read(struct grc_sim_bus* bus, uint16_t addr, uint8_t* data, int len);
+
+/*!
+ * \brief I2C master write followed by a read from the address with a repeated start, the bus is not released
+ *        between them
+ * \return rlen, I2C_ERROR if no module acknowledges the address, or error code (<0)
+ */
+int grc_sim_bus_write_read(struct grc_sim_bus* bus, uint16_t addr, const uint8_t* wdata, int wlen, uint8_t* rdata, int rlen);
+
+/*!
+ * \brief bus traffic since the bus creation or the last reset of the counters
+ * \param reset 1 - set the counters to zero after reading
+ */
+void grc_sim_bus_get_stats(struct grc_sim_bus* bus, struct grc_sim_bus_stats* stats, int reset);
+
+/*!
+ * \brief monotonic time used by the simulation
+ */
+uint64_t grc_sim_time_us(void);
+void grc_sim_sleep_us(uint64_t us);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _GRC_DRIVERS_SIM_H_
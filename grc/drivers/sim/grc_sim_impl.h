@@ -0,0 +1,227 @@
+#ifndef _GRC_DRIVERS_SIM_IMPL_H_
+#define _GRC_DRIVERS_SIM_IMPL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#include <errno.h>
+#include <poll.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "grc/drivers/grc_ll_driver.h"
+#include "grc/grc_error_codes.h"
+#include "grc_sim.h"
+
+// the simulated module receives a write as one buffer
+#define GRC_SIM_MAX_WRITE 4096
+
+#define CHECK_SIM_DEVICE(ll_dev)                  \
+    if ((ll_dev)->type != PROTOCOL_INTERFACE_SIM) \
+        return ARGUMENT_ERROR;
+
+static void sim_ll_sleep_us(void* dev, uint32_t us)
+{
+    grc_sim_sleep_us(us);
+}
+
+static uint64_t sim_ll_time_us(void* dev)
+{
+    return grc_sim_time_us();
+}
+
+static int sim_ll_i2c_init(void* dev)
+{
+    struct grc_ll_sim_dev* ll_dev = (struct grc_ll_sim_dev*)dev;
+    CHECK_SIM_DEVICE(ll_dev)
+
+    // modules are attached to a shared bus beforehand, an address without one is not acknowledged
+    if (ll_dev->bus != NULL) {
+        ll_dev->module = grc_sim_bus_module(ll_dev->bus, ll_dev->addr);
+        return GRC_OK;
+    }
+    // module keeps its state across driver re-initialization like the real chip
+    if (ll_dev->module == NULL) {
+        ll_dev->module = grc_sim_module_create(&ll_dev->config);
+        if (ll_dev->module == NULL) {
+            return GRC_NO_MEMORY;
+        }
+    }
+    return GRC_OK;
+}
+
+static int sim_ll_i2c_release(void* dev)
+{
+    return GRC_OK;
+}
+
+static int sim_ll_i2c_mtu(void* dev)
+{
+    struct grc_ll_sim_dev* ll_dev = (struct grc_ll_sim_dev*)dev;
+    uint32_t mtu = ll_dev->config.mtu;
+    return (mtu > 0 && mtu < GRC_SIM_MAX_WRITE) ? (int)mtu : GRC_SIM_MAX_WRITE;
+}
+
+static int sim_ll_i2c_write(void* dev, const void* data, int len)
+{
+    struct grc_ll_sim_dev* ll_dev = (struct grc_ll_sim_dev*)dev;
+    if ((ll_dev->module == NULL) && (ll_dev->bus == NULL)) {
+        return I2C_ERROR;
+    }
+    if (len > sim_ll_i2c_mtu(dev)) {
+        return I2C_ERROR;
+    }
+    if (ll_dev->bus != NULL) {
+        return grc_sim_bus_write(ll_dev->bus, ll_dev->addr, (const uint8_t*)data, len);
+    }
+    return grc_sim_module_write(ll_dev->module, (const uint8_t*)data, len);
+}
+
+static int sim_ll_i2c_writev(void* dev, const struct grc_ll_iovec* iov, int cnt)
+{
+    struct grc_ll_sim_dev* ll_dev = (struct grc_ll_sim_dev*)dev;
+    if ((ll_dev->module == NULL) && (ll_dev->bus == NULL)) {
+        return I2C_ERROR;
+    }
+    uint8_t buf[GRC_SIM_MAX_WRITE];
+    int len = 0;
+    for (int i = 0; i < cnt; i++) {
+        if (iov[i].len < 0 || len + iov[i].len > GRC_SIM_MAX_WRITE) {
+            return ARGUMENT_ERROR;
+        }
+        if (len + iov[i].len > sim_ll_i2c_mtu(dev)) {
+            return I2C_ERROR;
+        }
+        memcpy(&buf[len], iov[i].data, iov[i].len);
+        len += iov[i].len;
+    }
+    if (ll_dev->bus != NULL) {
+        return grc_sim_bus_write(ll_dev->bus, ll_dev->addr, buf, len);
+    }
+    return grc_sim_module_write(ll_dev->module, buf, len);
+}
+
+static int sim_ll_i2c_read(void* dev, void* data, int len)
+{
+    struct grc_ll_sim_dev* ll_dev = (struct grc_ll_sim_dev*)dev;
+    if ((ll_dev->module == NULL) && (ll_dev->bus == NULL)) {
+        return I2C_ERROR;
+    }
+    if (len > sim_ll_i2c_mtu(dev)) {
+        return I2C_ERROR;
+    }
+    if (ll_dev->bus != NULL) {
+        return grc_sim_bus_read(ll_dev->bus, ll_dev->addr, (uint8_t*)data, len);
+    }
+    return grc_sim_module_read(ll_dev->module, (uint8_t*)data, len);
+}
+
+static int sim_ll_i2c_write_read(void* dev, const void* wdata, int wlen, void* rdata, int rlen)
+{
+    struct grc_ll_sim_dev* ll_dev = (struct grc_ll_sim_dev*)dev;
+    if ((ll_dev->module == NULL) && (ll_dev->bus == NULL)) {
+        return I2C_ERROR;
+    }
+    if ((wlen > sim_ll_i2c_mtu(dev)) || (rlen > sim_ll_i2c_mtu(dev))) {
+        return I2C_ERROR;
+    }
+    if (ll_dev->bus != NULL) {
+        return grc_sim_bus_write_read(ll_dev->bus, ll_dev->addr, (const uint8_t*)wdata, wlen, (uint8_t*)rdata, rlen);
+    }
+    return grc_sim_module_write_read(ll_dev->module, (const uint8_t*)wdata, wlen, (uint8_t*)rdata, rlen);
+}
+
+static int sim_ll_i2c_set_address(void* dev, uint16_t addr)
+{
+    struct grc_ll_sim_dev* ll_dev = (struct grc_ll_sim_dev*)dev;
+    if (ll_dev->bus == NULL) {
+        return NOT_IMPLEMENTED;
+    }
+    ll_dev->addr = addr;
+    ll_dev->module = grc_sim_bus_module(ll_dev->bus, addr);
+    return GRC_OK;
+}
+
+static int sim_ll_i2c_get_address(void* dev)
+{
+    struct grc_ll_sim_dev* ll_dev = (struct grc_ll_sim_dev*)dev;
+    return ll_dev->bus != NULL ? ll_dev->addr : NOT_IMPLEMENTED;
+}
+
+static int sim_ll_wait_ready(void* dev, int timeout_ms)
+{
+    struct grc_ll_sim_dev* ll_dev = (struct grc_ll_sim_dev*)dev;
+    int fd = ll_dev->module ? grc_sim_module_ready_fd(ll_dev->module) : -1;
+    if (fd < 0) {
+        return NOT_IMPLEMENTED;
+    }
+    struct pollfd pfd = { .fd = fd, .events = POLLIN, .revents = 0 };
+    int res;
+    do {
+        res = poll(&pfd, 1, timeout_ms);
+    } while (res < 0 && errno == EINTR);
+    if (res <= 0) {
+        return res == 0 ? GRC_TIMEOUT : GRC_GPIO_ERROR;
+    }
+    uint64_t edges;
+    return read(fd, &edges, sizeof(edges)) == sizeof(edges) ? GRC_OK : GRC_GPIO_ERROR;
+}
+
+static int sim_ll_ready_fd(void* dev)
+{
+    struct grc_ll_sim_dev* ll_dev = (struct grc_ll_sim_dev*)dev;
+    int fd = ll_dev->module ? grc_sim_module_ready_fd(ll_dev->module) : -1;
+    return fd >= 0 ? fd : NOT_IMPLEMENTED;
+}
+
+static int sim_ll_gpio_init(void* dev)
+{
+    return GRC_OK;
+}
+
+static int sim_ll_gpio_reset_high(void* dev)
+{
+    struct grc_ll_sim_dev* ll_dev = (struct grc_ll_sim_dev*)dev;
+    if (ll_dev->module != NULL) {
+        grc_sim_module_reset(ll_dev->module);
+    }
+    return GRC_OK;
+}
+
+static int sim_ll_gpio_reset_low(void* dev)
+{
+    return GRC_OK;
+}
+
+// transport of grc_ll_sim_dev devices
+static const struct grc_transport_ops grc_sim_transport = {
+    .init = sim_ll_i2c_init,
+    .release = sim_ll_i2c_release,
+    .write = sim_ll_i2c_write,
+    .writev = sim_ll_i2c_writev,
+    .read = sim_ll_i2c_read,
+    .write_read = sim_ll_i2c_write_read,
+    .set_address = sim_ll_i2c_set_address,
+    .get_address = sim_ll_i2c_get_address,
+    .mtu = sim_ll_i2c_mtu,
+    .wait_ready = sim_ll_wait_ready,
+    .ready_fd = sim_ll_ready_fd,
+    .gpio_init = sim_ll_gpio_init,
+    .gpio_reset_high = sim_ll_gpio_reset_high,
+    .gpio_reset_low = sim_ll_gpio_reset_low,
+    .sleep_us = sim_ll_sleep_us,
+    .time_us = sim_ll_time_us,
+    .flush = NULL,
+};
+
+#if !defined(GRC_TRANSPORT_NO_DEFAULT) && !defined(GRC_STATIC_TRANSPORT_HEADER)
+const struct grc_transport_ops* const grc_default_transport = &grc_sim_transport;
+#endif
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _GRC_DRIVERS_SIM_IMPL_H_
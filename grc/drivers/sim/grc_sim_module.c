@@ -0,0 +1,1222 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "grc/grc_error_codes.h"
+#include "grc/drivers/sim/grc_sim.h"
+#include "grc/i2c/crc_calculation.h"
+#include "grc/i2c/protocol_structures.h"
+
+// ===== slave side of the GRC I2C protocol ===========
+#define GET_CUR_FUNCTION_CMD 0x01
+#define ACTIVATE_STREAMING_CMD 0x02
+#define GET_STREAMING_RESULT_CMD 0x03
+#define CALL_FUNCTION_CMD 0x04
+#define GET_FUNCTION_STATUS_CMD 0x05
+#define GET_FUNCTION_RESULT_CMD 0x06
+#define GET_SDK_VERSION_CMD 0x07
+#define GET_CAPABILITIES_CMD 0x08 // SDK version 2
+#define READ_STREAMING_CMD 0x09 // SDK version 2
+#define SUBMIT_FUNCTION_CMD 0x0a // SDK version 3
+#define GET_SUBMITTED_RESULT_CMD 0x0b // SDK version 3
+
+#define FUNCTION_START_TRAINING_CMD 0x07
+#define FUNCTION_STOP_TRAINING_CMD 0x08
+#define FUNCTION_START_INFERENCE_CMD 0x09
+#define FUNCTION_STOP_INFERENCE_CMD 0x0a
+#define FUNCTION_FEED_DATA_FLOAT_CMD 0x0b
+#define FUNCTION_FEED_DATA_FLOAT_ARRAY_CMD 0x0c
+#define FUNCTION_GET_STATUS_CMD 0x0d
+#define FUNCTION_CLEAR_CMD 0x0e
+#define FUNCTION_SET_NEEDED_PARAMS_CMD 0x0f
+#define FUNCTION_SET_PARAMS_BATCH_CMD 0x10 // SDK version 2
+#define FUNCTION_INFER_WINDOW_CMD 0x11 // SDK version 2
+#define FUNCTION_SET_WINDOW_CMD 0x12 // SDK version 4
+#define FUNCTION_INFER_HOP_CMD 0x13 // SDK version 4
+#define FUNCTION_CNT 0x14
+
+#define STATUS_IS_CALLED 0x80
+#define STATUS_IS_RUNNING 0x40
+
+#define BLOCK_HEADER_SIZE 3 // 0xff 0xfe <block number>
+#define MAX_BLOCK_CNT 255
+#define MAX_BLOCK_SIZE 255
+#define REPLY_SIZE (MAX_BLOCK_SIZE + 1)
+#define CAPABILITIES_MIN_SDK_VERSION 2
+#define PIPELINE_MIN_SDK_VERSION 3
+#define SLIDING_WINDOW_MIN_SDK_VERSION 4
+#define DEFAULT_QUEUE_DEPTH 4
+#define MAX_SLIDING_WINDOW 16384
+#define MAX_CLASS_CNT 16
+#define I2C_BITS_PER_BYTE 9 // 8 data bits and ack
+#define I2C_START_BITS 1 // start or repeated start condition
+#define I2C_STOP_BITS 1
+//==================================================
+
+typedef enum {
+    SIM_IDLE,
+    SIM_TRAINING,
+    SIM_INFERENCE
+} sim_mode;
+
+// streamed function arguments
+struct sim_stream {
+    uint8_t block_size;
+    uint8_t block_cnt;
+    uint8_t delivered[STREAMING_STATUS_SIZE];
+    uint8_t data[MAX_BLOCK_CNT * MAX_BLOCK_SIZE];
+};
+
+typedef enum {
+    JOB_FREE,
+    JOB_RECEIVING, // arguments are being written
+    JOB_QUEUED, // runs or has run after the previously queued jobs
+    JOB_READ // its result was read, the slot is reused by the next submission
+} sim_job_state;
+
+// function submitted with a sequence number
+struct sim_job {
+    sim_job_state state;
+    uint8_t seq;
+    uint8_t func;
+    uint8_t blocks_received; // including corrupted ones
+    uint32_t submitted; // submission order
+    uint64_t done_us;
+    uint8_t retcode;
+    int32_t result;
+    struct sim_stream args;
+};
+
+struct grc_sim_module {
+    struct grc_sim_config cfg;
+    struct grc_sim_stats stats;
+
+    // reply to the last command, valid after reply_ready_us
+    uint8_t reply[REPLY_SIZE];
+    uint64_t reply_ready_us;
+
+    // arguments of CALL_FUNCTION_CMD
+    struct sim_stream stream;
+    // arguments of the executed function
+    struct sim_stream* args;
+    // stream receiving the written blocks, NULL if they are dropped
+    struct sim_stream* write_target;
+    struct sim_job* write_job;
+    uint32_t blocks_received;
+    uint32_t blocks_sent;
+    uint32_t functions_called;
+    // counters of the injected faults
+    uint32_t transactions;
+    uint32_t replies_sent;
+
+    // remote functions
+    uint8_t cur_function;
+    uint64_t function_done_us;
+    uint8_t retcode[FUNCTION_CNT];
+    int32_t result[FUNCTION_CNT];
+    int ready_fd; // timerfd expiring at function completion
+
+    // submitted functions
+    struct sim_job jobs[MAX_QUEUE_DEPTH];
+    uint32_t submissions;
+    uint64_t queue_done_us;
+    uint8_t queue_function;
+
+    // AI SW model
+    sim_mode mode;
+    int arch;
+    int category;
+    int req_category;
+    int ext_req;
+    uint32_t next_elm;
+    int cats;
+    float class_mean[MAX_CLASS_CNT];
+    double train_sum;
+    uint32_t train_cnt;
+    // floats fed since the inference started, a window may come in several arrays
+    double infer_sum;
+    uint32_t infer_cnt;
+    float window_mean;
+    float* feeds;
+    uint32_t feeds_len;
+    uint32_t feeds_cap;
+    // last samples of the sliding window inference, ring of window_len
+    float* window;
+    uint32_t window_len;
+    uint32_t window_pos;
+    uint32_t window_fill;
+};
+
+uint64_t grc_sim_time_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000;
+}
+
+void grc_sim_sleep_us(uint64_t us)
+{
+    struct timespec ts = { .tv_sec = us / 1000000u, .tv_nsec = (us % 1000000u) * 1000 };
+    while (nanosleep(&ts, &ts) != 0) {
+    }
+}
+
+static uint64_t sim_bits_us(struct grc_sim_module* m, uint64_t bits)
+{
+    return m->cfg.bus_hz == 0 ? 0 : bits * 1000000u / m->cfg.bus_hz;
+}
+
+// start, address byte and len bytes, without the stop
+static uint64_t sim_phase_bits(int len)
+{
+    return I2C_START_BITS + (uint64_t)(len + 1) * I2C_BITS_PER_BYTE;
+}
+
+static void sim_bus_transfer(struct grc_sim_module* m, uint64_t bits)
+{
+    uint64_t us = sim_bits_us(m, bits) + m->cfg.transaction_us;
+    if (us > 0) {
+        grc_sim_sleep_us(us);
+    }
+}
+
+// the address byte of the transaction is not acknowledged, the master stops after it
+static int sim_inject_nak(struct grc_sim_module* m)
+{
+    m->transactions++;
+    if (m->cfg.nak_period && (m->transactions % m->cfg.nak_period) == 0) {
+        sim_bus_transfer(m, sim_phase_bits(0) + I2C_STOP_BITS);
+        m->stats.faults++;
+        return 1;
+    }
+    return 0;
+}
+
+static void sim_inject_reply_faults(struct grc_sim_module* m, uint8_t* data, int len)
+{
+    m->replies_sent++;
+    if (m->cfg.not_ready_period && (m->replies_sent % m->cfg.not_ready_period) == 0) {
+        memset(data, 0xff, len);
+        m->stats.faults++;
+    } else if (m->cfg.bit_flip_period && (m->replies_sent % m->cfg.bit_flip_period) == 0) {
+        uint32_t bit = (m->replies_sent / m->cfg.bit_flip_period) % ((uint32_t)len * 8);
+        data[bit / 8] ^= (uint8_t)(1 << (bit % 8));
+        m->stats.faults++;
+    }
+}
+
+static uint32_t sim_get_u32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static void sim_put_u32(uint8_t* p, uint32_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = (v >> 24) & 0xff;
+}
+
+static float sim_get_float(const uint8_t* p)
+{
+    uint32_t v = sim_get_u32(p);
+    float f;
+    memcpy(&f, &v, sizeof(f));
+    return f;
+}
+
+// filler for the model elements other than the class mean
+static float sim_state_value(int cat, uint32_t idx)
+{
+    return (float)cat + (float)(idx % 97) / 97.0f;
+}
+
+static void sim_set_reply(struct grc_sim_module* m, const uint8_t* data, int len)
+{
+    memset(m->reply, 0xff, sizeof(m->reply));
+    memcpy(m->reply, data, len);
+    m->reply_ready_us = grc_sim_time_us() + m->cfg.response_us;
+}
+
+static int sim_is_running(struct grc_sim_module* m)
+{
+    return m->cur_function != 0 && grc_sim_time_us() < m->function_done_us;
+}
+
+// function the module is busy with, including the submitted ones. 0 if idle
+static uint8_t sim_cur_function(struct grc_sim_module* m)
+{
+    if (sim_is_running(m)) {
+        return m->cur_function;
+    }
+    return grc_sim_time_us() < m->queue_done_us ? m->queue_function : 0;
+}
+
+static void sim_arm_ready_line(struct grc_sim_module* m, uint64_t duration_us)
+{
+    if (m->ready_fd >= 0) {
+        // zero it_value disarms the timer, fire at least 1 us later
+        duration_us = duration_us ? duration_us : 1;
+        struct itimerspec its = { .it_value = { .tv_sec = duration_us / 1000000u, .tv_nsec = (duration_us % 1000000u) * 1000 } };
+        timerfd_settime(m->ready_fd, 0, &its, NULL);
+    }
+}
+
+static const uint8_t* sim_stream_payload(struct grc_sim_module* m)
+{
+    return m->args->data;
+}
+
+static int sim_stream_complete(struct grc_sim_module* m)
+{
+    for (int i = 0; i < m->args->block_cnt; i++) {
+        if (!(m->args->delivered[STREAMING_STATUS_SIZE - i / 8 - 1] & (1 << (i % 8)))) {
+            return 0;
+        }
+    }
+    return m->args->block_cnt > 0;
+}
+
+static void sim_feed_append(struct grc_sim_module* m, float val)
+{
+    if (m->feeds_len == m->feeds_cap) {
+        uint32_t cap = m->feeds_cap ? m->feeds_cap * 2 : 1024;
+        float* feeds = (float*)realloc(m->feeds, cap * sizeof(float));
+        if (feeds == NULL) {
+            return;
+        }
+        m->feeds = feeds;
+        m->feeds_cap = cap;
+    }
+    m->feeds[m->feeds_len++] = val;
+}
+
+static uint8_t sim_feed_array(struct grc_sim_module* m)
+{
+    const uint8_t* p = sim_stream_payload(m);
+    uint32_t len = sim_get_u32(p);
+    uint32_t capacity = (uint32_t)m->args->block_cnt * (m->args->block_size - 4) / 4 - 1;
+    if (len == 0 || len > capacity) {
+        return InvalDataLen;
+    }
+    double sum = 0;
+    for (uint32_t i = 0; i < len; i++) {
+        sum += sim_get_float(p + 4 * (i + 1));
+    }
+    switch (m->mode) {
+    case SIM_TRAINING:
+        m->train_sum += sum;
+        m->train_cnt += len;
+        return Ok;
+    case SIM_INFERENCE:
+        m->infer_sum += sum;
+        m->infer_cnt += len;
+        m->window_mean = (float)(m->infer_sum / m->infer_cnt);
+        return Ok;
+    case SIM_IDLE:
+        if (m->cfg.sdk_version < CAPABILITIES_MIN_SDK_VERSION) {
+            return InvalState;
+        }
+        for (uint32_t i = 0; i < len; i++) {
+            sim_feed_append(m, sim_get_float(p + 4 * (i + 1)));
+        }
+        return Ok;
+    default:
+        return InvalState;
+    }
+}
+
+static int sim_classify(struct grc_sim_module* m, float value)
+{
+    int best = NOT_CLASSIFIED;
+    float best_dist = 0;
+    for (int i = 0; i < m->cats; i++) {
+        float dist = fabsf(m->class_mean[i] - value);
+        if (best < 0 || dist < best_dist) {
+            best = i;
+            best_dist = dist;
+        }
+    }
+    return best;
+}
+
+static uint8_t sim_set_param(struct grc_sim_module* m, uint8_t kind, int32_t ival)
+{
+    switch (kind) {
+    case PredictSignal:
+    case SeparateInaccuracies:
+    case Noise:
+    case InputScaling:
+    case FeedbackScaling:
+    case ThresholdFactor:
+        return Ok;
+    case ArchType:
+        if (ival < 1 || ival > 9) {
+            return InvalParm;
+        }
+        m->arch = ival;
+        return Ok;
+    case AskExtStatus:
+        if (ival < CatsQty || ival > NextDataElm) {
+            return InvalParm;
+        }
+        m->ext_req = ival;
+        m->next_elm = 0;
+        return Ok;
+    case LoadTrainData:
+        if (ival < 0 || ival > MAX_CLASS_CNT || m->feeds_len != (uint32_t)ival * m->cfg.state_floats_per_class) {
+            m->feeds_len = 0;
+            return InvalDataLen;
+        }
+        m->cats = ival;
+        for (int i = 0; i < ival; i++) {
+            m->class_mean[i] = m->feeds[i * m->cfg.state_floats_per_class];
+        }
+        m->feeds_len = 0;
+        return Ok;
+    case ReqCategory:
+        if (ival < 0 || ival >= m->cats) {
+            return InvalParm;
+        }
+        m->req_category = ival;
+        return Ok;
+    default:
+        return InvalParm;
+    }
+}
+
+static float sim_state_element(struct grc_sim_module* m, uint32_t idx)
+{
+    uint32_t fpc = m->cfg.state_floats_per_class;
+    int cat = idx / fpc;
+    return (idx % fpc == 0) ? m->class_mean[cat] : sim_state_value(cat, idx % fpc);
+}
+
+// entry count, then kind and value of each entry. applying stops at the first failed entry
+static uint8_t sim_set_params_batch(struct grc_sim_module* m)
+{
+    const uint8_t* p = sim_stream_payload(m);
+    uint32_t capacity = (uint32_t)m->args->block_cnt * (m->args->block_size - 4);
+    uint8_t cnt = p[0];
+    if (cnt == 0 || 1 + cnt * 5u > capacity) {
+        m->result[FUNCTION_SET_PARAMS_BATCH_CMD] = 0;
+        return InvalDataLen;
+    }
+    for (uint8_t i = 0; i < cnt; i++) {
+        const uint8_t* entry = p + 1 + i * 5;
+        uint8_t retcode = sim_set_param(m, entry[0], (int32_t)sim_get_u32(entry + 1));
+        if (retcode != Ok) {
+            m->result[FUNCTION_SET_PARAMS_BATCH_CMD] = i;
+            return retcode;
+        }
+    }
+    m->result[FUNCTION_SET_PARAMS_BATCH_CMD] = cnt;
+    return Ok;
+}
+
+static int32_t sim_get_status(struct grc_sim_module* m)
+{
+    switch (m->ext_req) {
+    case CatsQty:
+        return m->cats;
+    case SaveDataLen:
+        return m->cats * m->cfg.state_floats_per_class;
+    case NextDataElm: {
+        float val = sim_state_element(m, m->next_elm++);
+        int32_t bits;
+        memcpy(&bits, &val, sizeof(bits));
+        return bits;
+    }
+    default:
+        return m->result[FUNCTION_STOP_INFERENCE_CMD];
+    }
+}
+
+static uint8_t sim_stop_inference(struct grc_sim_module* m)
+{
+    if (m->mode != SIM_INFERENCE) {
+        return InvalState;
+    }
+    int cat = sim_classify(m, m->window_mean);
+    if (m->req_category >= 0) {
+        cat = (cat == m->req_category) ? cat : NOT_CLASSIFIED;
+        m->req_category = -1;
+    }
+    m->result[FUNCTION_STOP_INFERENCE_CMD] = cat;
+    m->mode = SIM_IDLE;
+    return Ok;
+}
+
+// start inference, feed float array, stop inference
+static uint8_t sim_infer_window(struct grc_sim_module* m)
+{
+    if (m->mode != SIM_IDLE) {
+        return InvalState;
+    }
+    m->mode = SIM_INFERENCE;
+    m->ext_req = None;
+    m->infer_sum = 0;
+    m->infer_cnt = 0;
+    uint8_t retcode = sim_feed_array(m);
+    if (retcode != Ok) {
+        m->mode = SIM_IDLE;
+        return retcode;
+    }
+    retcode = sim_stop_inference(m);
+    m->result[FUNCTION_INFER_WINDOW_CMD] = m->result[FUNCTION_STOP_INFERENCE_CMD];
+    return retcode;
+}
+
+static uint8_t sim_set_window(struct grc_sim_module* m, int32_t len)
+{
+    if (len < 1 || len > MAX_SLIDING_WINDOW) {
+        return InvalParm;
+    }
+    if ((uint32_t)len > m->window_len) {
+        float* window = (float*)realloc(m->window, len * sizeof(float));
+        if (window == NULL) {
+            return Error;
+        }
+        m->window = window;
+    }
+    m->window_len = len;
+    m->window_pos = 0;
+    m->window_fill = 0;
+    return Ok;
+}
+
+// append the new samples to the kept window and classify it
+static uint8_t sim_infer_hop(struct grc_sim_module* m)
+{
+    m->result[FUNCTION_INFER_HOP_CMD] = NOT_CLASSIFIED;
+    if (m->mode != SIM_IDLE || m->window_len == 0) {
+        return InvalState;
+    }
+    const uint8_t* p = sim_stream_payload(m);
+    uint32_t len = sim_get_u32(p);
+    uint32_t capacity = (uint32_t)m->args->block_cnt * (m->args->block_size - 4) / 4 - 1;
+    if (len == 0 || len > capacity || len > m->window_len) {
+        return InvalDataLen;
+    }
+    for (uint32_t i = 0; i < len; i++) {
+        m->window[m->window_pos] = sim_get_float(p + 4 * (i + 1));
+        m->window_pos = (m->window_pos + 1) % m->window_len;
+    }
+    m->window_fill = (m->window_fill + len < m->window_len) ? m->window_fill + len : m->window_len;
+    if (m->window_fill < m->window_len) {
+        return InvalDataLen;
+    }
+    double sum = 0;
+    for (uint32_t i = 0; i < m->window_len; i++) {
+        sum += m->window[i];
+    }
+    m->mode = SIM_INFERENCE;
+    m->window_mean = (float)(sum / m->window_len);
+    uint8_t retcode = sim_stop_inference(m);
+    m->result[FUNCTION_INFER_HOP_CMD] = m->result[FUNCTION_STOP_INFERENCE_CMD];
+    return retcode;
+}
+
+static uint8_t sim_execute(struct grc_sim_module* m, uint8_t func)
+{
+    switch (func) {
+    case FUNCTION_START_TRAINING_CMD:
+        if (!sim_stream_complete(m)) {
+            return InvalParm;
+        }
+        m->category = (int32_t)sim_get_u32(sim_stream_payload(m));
+        if (m->category >= MAX_CLASS_CNT || (m->category < 0 && m->cats >= MAX_CLASS_CNT)) {
+            return InvalParm;
+        }
+        m->mode = SIM_TRAINING;
+        m->ext_req = None;
+        m->train_sum = 0;
+        m->train_cnt = 0;
+        return Ok;
+    case FUNCTION_STOP_TRAINING_CMD: {
+        if (m->mode != SIM_TRAINING || m->train_cnt == 0) {
+            m->mode = SIM_IDLE;
+            return InvalState;
+        }
+        int idx = m->category >= 0 ? m->category : m->cats;
+        if (idx >= m->cats) {
+            m->cats = idx + 1;
+        }
+        m->class_mean[idx] = (float)(m->train_sum / m->train_cnt);
+        m->mode = SIM_IDLE;
+        return Ok;
+    }
+    case FUNCTION_START_INFERENCE_CMD:
+        // GRC refuses an inference until the training it started is stopped
+        if (m->mode == SIM_TRAINING) {
+            return InvalState;
+        }
+        m->mode = SIM_INFERENCE;
+        m->ext_req = None;
+        m->infer_sum = 0;
+        m->infer_cnt = 0;
+        return Ok;
+    case FUNCTION_STOP_INFERENCE_CMD:
+        return sim_stop_inference(m);
+    case FUNCTION_FEED_DATA_FLOAT_CMD:
+        if (!sim_stream_complete(m)) {
+            return InvalParm;
+        }
+        sim_feed_append(m, sim_get_float(sim_stream_payload(m)));
+        return Ok;
+    case FUNCTION_FEED_DATA_FLOAT_ARRAY_CMD:
+        if (!sim_stream_complete(m)) {
+            return InvalParm;
+        }
+        return sim_feed_array(m);
+    case FUNCTION_GET_STATUS_CMD:
+        m->result[FUNCTION_GET_STATUS_CMD] = sim_get_status(m);
+        return Ok;
+    case FUNCTION_CLEAR_CMD:
+        m->cats = 0;
+        m->feeds_len = 0;
+        m->mode = SIM_IDLE;
+        return Ok;
+    case FUNCTION_SET_NEEDED_PARAMS_CMD: {
+        if (!sim_stream_complete(m)) {
+            return InvalParm;
+        }
+        const uint8_t* p = sim_stream_payload(m);
+        return sim_set_param(m, p[0], (int32_t)sim_get_u32(p + 1));
+    }
+    case FUNCTION_SET_PARAMS_BATCH_CMD:
+        if (m->cfg.sdk_version < CAPABILITIES_MIN_SDK_VERSION) {
+            return NotImplemented;
+        }
+        if (!sim_stream_complete(m)) {
+            return InvalParm;
+        }
+        return sim_set_params_batch(m);
+    case FUNCTION_INFER_WINDOW_CMD:
+        if (m->cfg.sdk_version < CAPABILITIES_MIN_SDK_VERSION) {
+            return NotImplemented;
+        }
+        if (!sim_stream_complete(m)) {
+            return InvalParm;
+        }
+        return sim_infer_window(m);
+    case FUNCTION_SET_WINDOW_CMD:
+        if (m->cfg.sdk_version < SLIDING_WINDOW_MIN_SDK_VERSION) {
+            return NotImplemented;
+        }
+        if (!sim_stream_complete(m)) {
+            return InvalParm;
+        }
+        return sim_set_window(m, (int32_t)sim_get_u32(sim_stream_payload(m)));
+    case FUNCTION_INFER_HOP_CMD:
+        if (m->cfg.sdk_version < SLIDING_WINDOW_MIN_SDK_VERSION) {
+            return NotImplemented;
+        }
+        if (!sim_stream_complete(m)) {
+            return InvalParm;
+        }
+        return sim_infer_hop(m);
+    default:
+        return NotImplemented;
+    }
+}
+
+static int sim_is_faulty_block(struct grc_sim_module* m, uint32_t* counter)
+{
+    (*counter)++;
+    if (m->cfg.block_error_period && (*counter % m->cfg.block_error_period) == 0) {
+        m->stats.faults++;
+        return 1;
+    }
+    return 0;
+}
+
+// execution time of the next called function
+static uint64_t sim_function_duration(struct grc_sim_module* m, uint8_t func)
+{
+    uint64_t duration_us = (func == FUNCTION_STOP_TRAINING_CMD) ? m->cfg.train_us : m->cfg.function_us;
+    m->functions_called++;
+    if (m->cfg.stall_period && (m->functions_called % m->cfg.stall_period) == 0) {
+        duration_us += m->cfg.stall_us;
+    }
+    return duration_us;
+}
+
+static void sim_call_function(struct grc_sim_module* m, uint8_t func)
+{
+    if (func >= FUNCTION_CNT || sim_cur_function(m)) {
+        return;
+    }
+    m->retcode[func] = sim_execute(m, func);
+    m->cur_function = func;
+    uint64_t duration_us = sim_function_duration(m, func);
+    m->function_done_us = grc_sim_time_us() + duration_us;
+    sim_arm_ready_line(m, duration_us);
+    // arguments are consumed by the call
+    m->stream.block_cnt = 0;
+    memset(m->stream.delivered, 0, sizeof(m->stream.delivered));
+}
+
+static void sim_enqueue_job(struct grc_sim_module* m, struct sim_job* job);
+
+static int sim_receive_blocks(struct grc_sim_module* m, const uint8_t* data, int len)
+{
+    struct sim_stream* target = m->write_target;
+    int pos = 0;
+    while (pos < len) {
+        if (target == NULL || target->block_size == 0 || pos + target->block_size > len || data[pos] != 0xff
+            || data[pos + 1] != 0xfe) {
+            // garbage on the bus, drop the rest of the write
+            return len;
+        }
+        uint8_t number = data[pos + 2];
+        int payload = target->block_size - 4;
+        uint8_t crc = Crc8((uint8_t*)&data[pos + 2], payload + 1);
+        if (sim_is_faulty_block(m, &m->blocks_received)) {
+            crc = ~data[pos + target->block_size - 1];
+        }
+        if (number >= 1 && number <= target->block_cnt && crc == data[pos + target->block_size - 1]) {
+            int idx = number - 1;
+            memcpy(&target->data[idx * payload], &data[pos + BLOCK_HEADER_SIZE], payload);
+            target->delivered[STREAMING_STATUS_SIZE - idx / 8 - 1] |= 1 << (idx % 8);
+        }
+        pos += target->block_size;
+        // submitted function is queued after its last block
+        if (m->write_job && ++m->write_job->blocks_received == target->block_cnt) {
+            sim_enqueue_job(m, m->write_job);
+            m->write_job = NULL;
+            m->write_target = NULL;
+            return len;
+        }
+    }
+    return len;
+}
+
+// job runs after the previously queued ones, its effect is applied at once
+static void sim_enqueue_job(struct grc_sim_module* m, struct sim_job* job)
+{
+    uint64_t now = grc_sim_time_us();
+    uint64_t start = m->queue_done_us > now ? m->queue_done_us : now;
+    m->args = &job->args;
+    if (sim_stream_complete(m)) {
+        job->retcode = sim_execute(m, job->func);
+        job->result = job->func < FUNCTION_CNT ? m->result[job->func] : 0;
+        job->done_us = start + sim_function_duration(m, job->func);
+    } else {
+        job->retcode = NotDelivered;
+        job->result = 0;
+        job->done_us = start;
+    }
+    m->args = &m->stream;
+    job->state = JOB_QUEUED;
+    m->queue_done_us = job->done_us;
+    m->queue_function = job->func;
+    sim_arm_ready_line(m, job->done_us - now);
+}
+
+// job slot for the sequence number: the job with the same number, a free one or the oldest one whose result
+// was read. a result that was not read is kept, the master may poll it any time. the master keeps at most
+// queue_depth jobs unread, so a submission finding every slot unread takes the slot of the first submitted one,
+// which the master has given up on
+static struct sim_job* sim_job_slot(struct grc_sim_module* m, uint8_t seq)
+{
+    struct sim_job* slot = NULL;
+    struct sim_job* abandoned = NULL;
+    for (uint32_t i = 0; i < m->cfg.queue_depth; i++) {
+        struct sim_job* job = &m->jobs[i];
+        if (job->state != JOB_FREE && job->seq == seq) {
+            return job;
+        }
+        if (job->state == JOB_FREE) {
+            slot = (slot && slot->state == JOB_FREE) ? slot : job;
+        } else if (job->state == JOB_READ
+            && (slot == NULL || (slot->state == JOB_READ && job->submitted < slot->submitted))) {
+            slot = job;
+        } else if ((job->state == JOB_QUEUED) && (abandoned == NULL || job->submitted < abandoned->submitted)) {
+            abandoned = job;
+        }
+    }
+    return slot != NULL ? slot : abandoned;
+}
+
+static void sim_submit(struct grc_sim_module* m, const uint8_t* data, int len)
+{
+    m->write_target = NULL;
+    m->write_job = NULL;
+    struct sim_job* job = sim_job_slot(m, data[1]);
+    if (job == NULL || data[4] == 0) {
+        // queue is full, the submitted function is dropped
+        return;
+    }
+    job->state = JOB_RECEIVING;
+    job->submitted = m->submissions++;
+    job->seq = data[1];
+    job->func = data[2];
+    job->blocks_received = 0;
+    job->args.block_size = data[3];
+    job->args.block_cnt = data[4];
+    memset(job->args.delivered, 0, sizeof(job->args.delivered));
+    m->write_target = &job->args;
+    m->write_job = job;
+    if (len > 5) {
+        sim_receive_blocks(m, data + 5, len - 5);
+    }
+}
+
+static void sim_submitted_result(struct grc_sim_module* m, uint8_t seq)
+{
+    uint8_t reply[6];
+    reply[0] = seq;
+    reply[1] = NotCalled;
+    sim_put_u32(&reply[2], 0);
+    for (uint32_t i = 0; i < m->cfg.queue_depth; i++) {
+        struct sim_job* job = &m->jobs[i];
+        if (job->state == JOB_FREE || job->seq != seq) {
+            continue;
+        }
+        if (job->state == JOB_RECEIVING || grc_sim_time_us() < job->done_us) {
+            reply[1] = STATUS_IS_RUNNING;
+        } else {
+            reply[1] = job->retcode;
+            sim_put_u32(&reply[2], (uint32_t)job->result);
+            job->state = JOB_READ;
+        }
+    }
+    sim_set_reply(m, reply, sizeof(reply));
+}
+
+static void sim_read_stream(struct grc_sim_module* m, uint8_t block_size, uint32_t offset)
+{
+    uint8_t block[MAX_BLOCK_SIZE];
+    int values_in_block = (block_size - 4) / 4;
+    uint32_t state_len = m->cats * m->cfg.state_floats_per_class;
+    block[0] = 0xff;
+    block[1] = 0xfe;
+    block[2] = (uint8_t)(offset / values_in_block + 1);
+    memset(&block[BLOCK_HEADER_SIZE], 0, block_size - 4);
+    for (int i = 0; i < values_in_block && offset + i < state_len; i++) {
+        float val = sim_state_element(m, offset + i);
+        memcpy(&block[BLOCK_HEADER_SIZE + 4 * i], &val, sizeof(val));
+    }
+    block[block_size - 1] = Crc8(&block[2], block_size - 3);
+    if (sim_is_faulty_block(m, &m->blocks_sent)) {
+        block[block_size - 1] = ~block[block_size - 1];
+    }
+    sim_set_reply(m, block, block_size);
+}
+
+static void sim_init_state(struct grc_sim_module* m)
+{
+    memset(m->reply, 0xff, sizeof(m->reply));
+    m->reply_ready_us = 0;
+    m->stream.block_size = 0;
+    m->stream.block_cnt = 0;
+    memset(m->stream.delivered, 0, sizeof(m->stream.delivered));
+    m->args = &m->stream;
+    m->write_target = NULL;
+    m->write_job = NULL;
+    for (int i = 0; i < MAX_QUEUE_DEPTH; i++) {
+        m->jobs[i].state = JOB_FREE;
+    }
+    m->submissions = 0;
+    m->queue_done_us = 0;
+    m->cur_function = 0;
+    m->function_done_us = 0;
+    for (int i = 0; i < FUNCTION_CNT; i++) {
+        m->retcode[i] = NotCalled;
+        m->result[i] = 0;
+    }
+    m->result[FUNCTION_STOP_INFERENCE_CMD] = NOT_CLASSIFIED;
+    m->mode = SIM_IDLE;
+    m->arch = 0;
+    m->category = -1;
+    m->req_category = -1;
+    m->ext_req = None;
+    m->next_elm = 0;
+    m->cats = 0;
+    m->feeds_len = 0;
+    m->window_len = 0;
+    m->window_pos = 0;
+    m->window_fill = 0;
+}
+
+struct grc_sim_module* grc_sim_module_create(const struct grc_sim_config* cfg)
+{
+    struct grc_sim_module* m = (struct grc_sim_module*)calloc(1, sizeof(struct grc_sim_module));
+    if (m == NULL) {
+        return NULL;
+    }
+    m->cfg = *cfg;
+    if (m->cfg.state_floats_per_class == 0) {
+        m->cfg.state_floats_per_class = 1;
+    }
+    if (m->cfg.max_block_size == 0 || m->cfg.max_block_size > MAX_BLOCK_SIZE) {
+        m->cfg.max_block_size = MAX_BLOCK_SIZE;
+    }
+    if (m->cfg.queue_depth == 0 || m->cfg.queue_depth > MAX_QUEUE_DEPTH) {
+        m->cfg.queue_depth = m->cfg.queue_depth ? MAX_QUEUE_DEPTH : DEFAULT_QUEUE_DEPTH;
+    }
+    m->ready_fd = -1;
+    if (m->cfg.ready_line) {
+        m->ready_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+        if (m->ready_fd < 0) {
+            free(m);
+            return NULL;
+        }
+    }
+    sim_init_state(m);
+    return m;
+}
+
+void grc_sim_module_set_faults(struct grc_sim_module* m, const struct grc_sim_config* cfg)
+{
+    m->cfg.block_error_period = cfg->block_error_period;
+    m->cfg.stall_period = cfg->stall_period;
+    m->cfg.stall_us = cfg->stall_us;
+    m->cfg.nak_period = cfg->nak_period;
+    m->cfg.not_ready_period = cfg->not_ready_period;
+    m->cfg.bit_flip_period = cfg->bit_flip_period;
+    m->transactions = 0;
+    m->replies_sent = 0;
+    m->blocks_received = 0;
+    m->blocks_sent = 0;
+    m->functions_called = 0;
+}
+
+void grc_sim_module_destroy(struct grc_sim_module* m)
+{
+    if (m == NULL) {
+        return;
+    }
+    if (m->ready_fd >= 0) {
+        close(m->ready_fd);
+    }
+    free(m->feeds);
+    free(m->window);
+    free(m);
+}
+
+int grc_sim_module_ready_fd(struct grc_sim_module* m)
+{
+    return m->ready_fd;
+}
+
+void grc_sim_module_get_stats(struct grc_sim_module* m, struct grc_sim_stats* stats, int reset)
+{
+    *stats = m->stats;
+    if (reset) {
+        memset(&m->stats, 0, sizeof(m->stats));
+    }
+}
+
+void grc_sim_module_reset(struct grc_sim_module* m)
+{
+    sim_init_state(m);
+}
+
+// command or data written by the master
+static int sim_receive(struct grc_sim_module* m, const uint8_t* data, int len)
+{
+    if (len >= 2 && data[0] == 0xff && data[1] == 0xfe) {
+        return sim_receive_blocks(m, data, len);
+    }
+    uint8_t reply[REPLY_SIZE];
+    uint8_t func = len > 1 ? data[1] : 0;
+    switch (data[0]) {
+    case GET_CUR_FUNCTION_CMD:
+        reply[0] = sim_cur_function(m);
+        sim_set_reply(m, reply, 1);
+        break;
+    case ACTIVATE_STREAMING_CMD:
+        if (len < 3) {
+            return len;
+        }
+        m->stream.block_size = data[1];
+        m->stream.block_cnt = data[2];
+        memset(m->stream.delivered, 0, sizeof(m->stream.delivered));
+        m->write_target = &m->stream;
+        m->write_job = NULL;
+        if (len > 3) {
+            sim_receive_blocks(m, data + 3, len - 3);
+        }
+        break;
+    case GET_STREAMING_RESULT_CMD:
+        sim_set_reply(m, m->stream.delivered, STREAMING_STATUS_SIZE);
+        break;
+    case CALL_FUNCTION_CMD:
+        sim_call_function(m, func);
+        break;
+    case GET_FUNCTION_STATUS_CMD:
+        if (func >= FUNCTION_CNT) {
+            reply[0] = NotImplemented;
+        } else if (sim_is_running(m) && m->cur_function == func) {
+            reply[0] = STATUS_IS_RUNNING;
+        } else {
+            reply[0] = m->retcode[func];
+        }
+        // fused and sliding window inference report the class index with the status
+        if (func == FUNCTION_INFER_WINDOW_CMD || func == FUNCTION_INFER_HOP_CMD) {
+            reply[1] = (uint8_t)m->result[func];
+            sim_set_reply(m, reply, 2);
+        } else {
+            sim_set_reply(m, reply, 1);
+        }
+        break;
+    case GET_FUNCTION_RESULT_CMD:
+        sim_put_u32(reply, func < FUNCTION_CNT ? (uint32_t)m->result[func] : 0);
+        sim_set_reply(m, reply, 4);
+        break;
+    case GET_SDK_VERSION_CMD:
+        sim_put_u32(reply, m->cfg.sdk_version);
+        sim_set_reply(m, reply, 4);
+        break;
+    case GET_CAPABILITIES_CMD:
+        if (m->cfg.sdk_version < CAPABILITIES_MIN_SDK_VERSION) {
+            memset(m->reply, 0xff, sizeof(m->reply));
+            break;
+        }
+        sim_put_u32(reply, 0);
+        reply[0] = CAPABILITY_BULK_READ | CAPABILITY_BULK_WRITE | CAPABILITY_BATCH_PARAMS | CAPABILITY_FUSED_INFERENCE;
+        reply[1] = m->cfg.max_block_size;
+        reply[2] = MAX_BLOCK_CNT;
+        reply[3] = (m->cfg.sdk_version >= PIPELINE_MIN_SDK_VERSION) ? m->cfg.queue_depth : 0;
+        if (reply[3]) {
+            reply[0] |= CAPABILITY_PIPELINE;
+        }
+        if (m->cfg.sdk_version >= SLIDING_WINDOW_MIN_SDK_VERSION) {
+            reply[0] |= CAPABILITY_SLIDING_WINDOW;
+        }
+        sim_set_reply(m, reply, 4);
+        break;
+    case SUBMIT_FUNCTION_CMD:
+        if (m->cfg.sdk_version < PIPELINE_MIN_SDK_VERSION || len < 5) {
+            m->write_target = NULL;
+            m->write_job = NULL;
+            break;
+        }
+        sim_submit(m, data, len);
+        break;
+    case GET_SUBMITTED_RESULT_CMD:
+        if (m->cfg.sdk_version < PIPELINE_MIN_SDK_VERSION || len < 2) {
+            memset(m->reply, 0xff, sizeof(m->reply));
+            break;
+        }
+        sim_submitted_result(m, data[1]);
+        break;
+    case READ_STREAMING_CMD:
+        if (m->cfg.sdk_version < CAPABILITIES_MIN_SDK_VERSION || len < 6 || data[1] < 8
+            || data[1] > m->cfg.max_block_size) {
+            memset(m->reply, 0xff, sizeof(m->reply));
+            break;
+        }
+        sim_read_stream(m, data[1], sim_get_u32(&data[2]));
+        break;
+    default:
+        memset(m->reply, 0xff, sizeof(m->reply));
+        break;
+    }
+    return len;
+}
+
+// reply sent to the master
+static int sim_send(struct grc_sim_module* m, uint8_t* data, int len)
+{
+    if (grc_sim_time_us() < m->reply_ready_us) {
+        // slave has not prepared the reply yet
+        memset(data, 0xff, len);
+        return len;
+    }
+    for (int i = 0; i < len; i++) {
+        data[i] = i < REPLY_SIZE ? m->reply[i] : 0xff;
+    }
+    sim_inject_reply_faults(m, data, len);
+    return len;
+}
+
+int grc_sim_module_write(struct grc_sim_module* m, const uint8_t* data, int len)
+{
+    if (len < 1) {
+        return ARGUMENT_ERROR;
+    }
+    if (sim_inject_nak(m)) {
+        return I2C_NACK;
+    }
+    sim_bus_transfer(m, sim_phase_bits(len) + I2C_STOP_BITS);
+    m->stats.writes++;
+    m->stats.bytes_written += len;
+    return sim_receive(m, data, len);
+}
+
+int grc_sim_module_read(struct grc_sim_module* m, uint8_t* data, int len)
+{
+    if (len < 1) {
+        return ARGUMENT_ERROR;
+    }
+    if (sim_inject_nak(m)) {
+        return I2C_NACK;
+    }
+    sim_bus_transfer(m, sim_phase_bits(len) + I2C_STOP_BITS);
+    m->stats.reads++;
+    m->stats.bytes_read += len;
+    return sim_send(m, data, len);
+}
+
+int grc_sim_module_write_read(struct grc_sim_module* m, const uint8_t* wdata, int wlen, uint8_t* rdata, int rlen)
+{
+    if ((wlen < 1) || (rlen < 1)) {
+        return ARGUMENT_ERROR;
+    }
+    if (sim_inject_nak(m)) {
+        return I2C_NACK;
+    }
+    // the command is taken when its last byte is clocked in, the read phase repeats the address byte after the
+    // repeated start. the whole transaction is one transfer time
+    uint64_t write_us = sim_bits_us(m, sim_phase_bits(wlen));
+    int res = sim_receive(m, wdata, wlen);
+    if (res < 0) {
+        return res;
+    }
+    m->reply_ready_us += write_us;
+    sim_bus_transfer(m, sim_phase_bits(wlen) + sim_phase_bits(rlen) + I2C_STOP_BITS);
+    m->stats.combined++;
+    m->stats.bytes_written += wlen;
+    m->stats.bytes_read += rlen;
+    return sim_send(m, rdata, rlen);
+}
+
+// ===== shared bus ===================================
+
+struct sim_bus_slave {
+    uint16_t addr;
+    struct grc_sim_module* module;
+};
+
+struct grc_sim_bus {
+    // held for the whole transfer time of a transaction
+    pthread_mutex_t lock;
+    uint32_t bus_hz;
+    struct sim_bus_slave slaves[GRC_SIM_BUS_MAX_MODULES];
+    uint32_t cnt;
+    struct grc_sim_bus_stats stats;
+    uint64_t since_us;
+};
+
+struct grc_sim_bus* grc_sim_bus_create(uint32_t bus_hz)
+{
+    struct grc_sim_bus* bus = (struct grc_sim_bus*)calloc(1, sizeof(struct grc_sim_bus));
+    if (bus == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&bus->lock, NULL);
+    bus->bus_hz = bus_hz;
+    bus->since_us = grc_sim_time_us();
+    return bus;
+}
+
+void grc_sim_bus_destroy(struct grc_sim_bus* bus)
+{
+    if (bus == NULL) {
+        return;
+    }
+    for (uint32_t i = 0; i < bus->cnt; i++) {
+        grc_sim_module_destroy(bus->slaves[i].module);
+    }
+    pthread_mutex_destroy(&bus->lock);
+    free(bus);
+}
+
+// called with the bus lock
+static struct grc_sim_module* sim_bus_find(struct grc_sim_bus* bus, uint16_t addr)
+{
+    for (uint32_t i = 0; i < bus->cnt; i++) {
+        if (bus->slaves[i].addr == addr) {
+            return bus->slaves[i].module;
+        }
+    }
+    return NULL;
+}
+
+int grc_sim_bus_attach(struct grc_sim_bus* bus, uint16_t addr, struct grc_sim_module* module)
+{
+    pthread_mutex_lock(&bus->lock);
+    int res = ARGUMENT_ERROR;
+    if ((bus->cnt < GRC_SIM_BUS_MAX_MODULES) && (sim_bus_find(bus, addr) == NULL)) {
+        module->cfg.bus_hz = bus->bus_hz;
+        bus->slaves[bus->cnt].addr = addr;
+        bus->slaves[bus->cnt].module = module;
+        bus->cnt++;
+        res = GRC_OK;
+    }
+    pthread_mutex_unlock(&bus->lock);
+    return res;
+}
+
+struct grc_sim_module* grc_sim_bus_module(struct grc_sim_bus* bus, uint16_t addr)
+{
+    pthread_mutex_lock(&bus->lock);
+    struct grc_sim_module* module = sim_bus_find(bus, addr);
+    pthread_mutex_unlock(&bus->lock);
+    return module;
+}
+
+// write, read or both with a repeated start between them
+static int sim_bus_transaction(struct grc_sim_bus* bus, uint16_t addr, const uint8_t* wdata, int wlen, uint8_t* rdata, int rlen)
+{
+    pthread_mutex_lock(&bus->lock);
+    uint64_t start = grc_sim_time_us();
+    struct grc_sim_module* module = sim_bus_find(bus, addr);
+    int res;
+    if (module == NULL) {
+        // the address byte is not acknowledged
+        if (bus->bus_hz != 0) {
+            grc_sim_sleep_us((I2C_START_BITS + I2C_BITS_PER_BYTE + I2C_STOP_BITS) * 1000000u / bus->bus_hz);
+        }
+        bus->stats.naks++;
+        res = I2C_NACK;
+    } else {
+        if ((wlen > 0) && (rlen > 0)) {
+            res = grc_sim_module_write_read(module, wdata, wlen, rdata, rlen);
+        } else if (rlen > 0) {
+            res = grc_sim_module_read(module, rdata, rlen);
+        } else {
+            res = grc_sim_module_write(module, wdata, wlen);
+        }
+        bus->stats.transactions++;
+    }
+    bus->stats.busy_us += grc_sim_time_us() - start;
+    pthread_mutex_unlock(&bus->lock);
+    return res;
+}
+
+int grc_sim_bus_write(struct grc_sim_bus* bus, uint16_t addr, const uint8_t* data, int len)
+{
+    return sim_bus_transaction(bus, addr, data, len, NULL, 0);
+}
+
+int grc_sim_bus_read(struct grc_sim_bus* bus, uint16_t addr, uint8_t* data, int len)
+{
+    return sim_bus_transaction(bus, addr, NULL, 0, data, len);
+}
+
+int grc_sim_bus_write_read(struct grc_sim_bus* bus, uint16_t addr, const uint8_t* wdata, int wlen, uint8_t* rdata, int rlen)
+{
+    return sim_bus_transaction(bus, addr, wdata, wlen, rdata, rlen);
+}
+
+void grc_sim_bus_get_stats(struct grc_sim_bus* bus, struct grc_sim_bus_stats* stats, int reset)
+{
+    pthread_mutex_lock(&bus->lock);
+    uint64_t now = grc_sim_time_us();
+    *stats = bus->stats;
+    stats->utilisation = now > bus->since_us ? (float)bus->stats.busy_us / (float)(now - bus->since_us) : 0.0f;
+    if (reset) {
+        memset(&bus->stats, 0, sizeof(bus->stats));
+        bus->since_us = now;
+    }
+    pthread_mutex_unlock(&bus->lock);
+}
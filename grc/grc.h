@@ -98,6 +98,37 @@ struct grc_inference_params {
     void* user_data;
 };
 
+// results of a streaming inference kept for grc_stream_read
+#define GRC_STREAM_QUEUE_LEN 32
+
+/*!
+ * \brief result of one window of a streaming inference
+ * \param sample number of samples pushed up to the end of the window
+ * \param result class tag or NOT_CLASSIFIED
+ */
+struct grc_stream_result {
+    uint64_t sample;
+    int result;
+};
+
+typedef void (*grc_stream_callback_t)(const struct grc_stream_result* result, void* user_data);
+
+/*!
+ * \brief structure for streaming inference parameters.
+ * \param window_len number of samples in a classified window
+ * \param hop_len number of samples between the ends of two windows, 1 to window_len
+ * \param inference parameters of each window inference. GRC_PARAMS_ASYNC is not supported
+ * \param callback called with the result of each window. NULL - results are queued for grc_stream_read
+ * \param user_data callback arguments
+ */
+struct grc_stream_params {
+    uint32_t window_len;
+    uint32_t hop_len;
+    struct grc_inference_params inference;
+    grc_stream_callback_t callback;
+    void* user_data;
+};
+
 /*!
  * \brief info for trained class.
  * \param tag Name of class.
@@ -122,24 +153,57 @@ struct grc_internal_state {
     float* values;
 };
 
+/*!
+ * \brief SDK counters of the device
+ * \param blocks_resent stream blocks sent again after GRC reported them as not delivered
+ * \param resend_rounds number of resend attempts
+ * \param blocks_reread blocks read again from GRC after CRC mismatch
+ */
+struct grc_stats {
+    uint32_t blocks_resent;
+    uint32_t resend_rounds;
+    uint32_t blocks_reread;
+};
+
+struct grc_context;
+
+struct grc_transport_ops;
+
 /*!
  * \brief structure for grc device setup
  * \param ll_dev structure with specified transport layer parameters
  * \param version  GRC SDK version
+ * \param ctx per-device SDK state. allocated by grc_init and freed by grc_release
+ * \param transport driver functions for ll_dev (e.g. &grc_linux_transport), NULL - grc_default_transport
  */
 struct grc_device {
     void* ll_dev;
     uint32_t version;
+    struct grc_context* ctx;
+    const struct grc_transport_ops* transport;
 };
 
 /*!
  * \brief interface and grc initialising
  * \param dev structure for grc device setup
  * \param cfg  configuration of GRC architecture
- * \return Ok(=0) or error code (<0)
+ * \return Ok(=0) or error code (<0). if the interface, the SDK version or the architecture fails, the interface is
+ *         released again and dev needs no grc_release
  */
 int grc_init(struct grc_device* dev, struct grc_config* cfg);
 
+/*!
+ * \brief interface and grc initialising with GRC AI parameters setup.
+ *        GRC firmware of SDK version 2 and later gets the architecture and parameters in one remote call
+ * \param dev structure for grc device setup
+ * \param cfg  configuration of GRC architecture
+ * \param hp array of parameter types and values
+ * \param len length of hp array
+ * \param results array of len result codes as in grc_set_config_results. NULL if not needed
+ * \return Ok(=0) or error code (<0)
+ */
+int grc_init_config(struct grc_device* dev, struct grc_config* cfg, struct hp_setup* hp, int len, int* results);
+
 /*!
  * \brief release interface
  * \param dev structure for grc device
@@ -147,6 +211,20 @@ int grc_init(struct grc_device* dev, struct grc_config* cfg);
  */
 int grc_release(struct grc_device* dev);
 
+/*!
+ * \brief find GRC modules on the bus of the transport device. each address of the range is asked for
+ *        the SDK version, the addresses replying with a version the SDK supports are reported.
+ *        the transport device is opened by the caller (init of its transport) and stays open at its address;
+ *        a found module gets a transport device of its own with its address
+ * \param bus transport device of the bus and its transport, the device is not initialised with grc_init
+ * \param first, last address range, e.g. 0x08..0x77
+ * \param addrs found addresses
+ * \param max size of addrs, the scan stops when it is full
+ * \return number of found modules (>=0) or error code (<0): a transport error other than a not acknowledged
+ *         address ends the scan, NOT_IMPLEMENTED if the link has one module only
+ */
+int grc_scan(const struct grc_device* bus, uint16_t first, uint16_t last, uint16_t* addrs, uint32_t max);
+
 /*!
  * \brief setup GRC AI parameters
  * \param dev structure for grc device
@@ -156,6 +234,18 @@ int grc_release(struct grc_device* dev);
  */
 int grc_set_config(struct grc_device* dev, struct hp_setup* hp, int len);
 
+/*!
+ * \brief setup GRC AI parameters and get result of each of them.
+ *        parameters are applied in order until the first failed one
+ * \param dev structure for grc device
+ * \param hp array of parameter types and values
+ * \param len length of hp array
+ * \param results array of len result codes: Ok(=0), error code (<0) of the failed parameter
+ *        or REMOTE_FUNCTION_NOT_CALLED for parameters after it
+ * \return Ok(=0) or error code (<0) of the failed parameter
+ */
+int grc_set_config_results(struct grc_device* dev, struct hp_setup* hp, int len, int* results);
+
 /*!
  * \brief clear GRC trained state
  * \param dev structure for grc device
@@ -168,8 +258,10 @@ int grc_clear_state(struct grc_device* dev);
  * \param dev structure for grc device
  * \param params train parameters
  * \param vals Pointer to train data
- * \param len Train data len
- * \return trained class id(>= 0) or error code (<0)
+ * \param len Train data len. series longer than one stream are split by the SDK
+ * \return trained class id(>= 0) or error code (<0).
+ *         with GRC_PARAMS_ASYNC the data is copied and Ok(=0) is returned once the training is queued, the class id is
+ *         given to the callback and grc_wait. GRC_IS_BUSY - GRC_ASYNC_QUEUE_LEN functions are queued
  */
 int grc_train(
     struct grc_device* dev,
@@ -177,13 +269,50 @@ int grc_train(
     const float* vals,
     uint32_t len);
 
+/*!
+ * \brief start training on a series fed in chunks with grc_train_feed, e.g. as it is acquired
+ * \param dev structure for grc device
+ * \param params train parameters as in grc_train. GRC_PARAMS_ASYNC is not supported
+ * \return Ok(=0) or error code (<0)
+ */
+int grc_train_begin(struct grc_device* dev, struct grc_training_params* params);
+
+/*!
+ * \brief feed the next chunk of the series started with grc_train_begin.
+ *        chunks shorter than 1024 floats are collected before they are sent, longer ones are split into streams
+ *        GRC accepts. an error ends the training as grc_train_cancel does
+ * \param dev structure for grc device
+ * \param vals Pointer to the chunk
+ * \param len chunk len
+ * \return Ok(=0) or error code (<0)
+ */
+int grc_train_feed(struct grc_device* dev, const float* vals, uint32_t len);
+
+/*!
+ * \brief finish the training started with grc_train_begin
+ * \param dev structure for grc device
+ * \return trained class id(>= 0) or error code (<0)
+ */
+int grc_train_end(struct grc_device* dev);
+
+/*!
+ * \brief end the training started with grc_train_begin before the series is complete. chunks the SDK still collects
+ *        are dropped and GRC is stopped. GRC can not drop a series it has started: if it got floats already, the class
+ *        is trained on them and kept, otherwise no class is added
+ * \param dev structure for grc device
+ * \return id of the class kept (>= 0), NOT_CLASSIFIED(-1) if no class was added or error code (< -1) if GRC could
+ *         not be stopped
+ */
+int grc_train_cancel(struct grc_device* dev);
+
 /*!
  * \brief Inference on raw data.
  * \param dev structure for grc device
  * \param params inference parameters
  * \param vals Pointer to inference data.
  * \param len Inference data len.
- * \return trained class id(>= 0) or error code (<0). error_code -1 for NOT_CLASSIFIED
+ * \return trained class id(>= 0) or error code (<0). error_code -1 for NOT_CLASSIFIED.
+ *         GRC_PARAMS_ASYNC as in grc_train
  */
 int grc_inference(
     struct grc_device* dev,
@@ -192,12 +321,95 @@ int grc_inference(
     uint32_t len);
 
 /*!
- * \brief (NOT IMPLEMENTED) wait for train or inference execution end
+ * \brief inference on several windows.
+ *        GRC firmware of SDK version 3 and later queues the windows, so data of the next windows is sent while GRC computes
+ *        the previous ones
+ * \param dev structure for grc device
+ * \param params inference parameters, as in grc_inference
+ * \param windows cnt pointers to windows of len floats
+ * \param len length of each window
+ * \param cnt number of windows
+ * \param results cnt class tags or NOT_CLASSIFIED
+ * \return number of classified windows (cnt) or error code (<0), GRC_TIMEOUT if the oldest queued window
+ *         has no result within the function timeout
+ */
+int grc_inference_batch(
+    struct grc_device* dev,
+    struct grc_inference_params* params,
+    const float* const* windows,
+    uint32_t len,
+    uint32_t cnt,
+    int* results);
+
+/*!
+ * \brief start inference on overlapping windows of a continuous stream of samples.
+ *        GRC firmware of SDK version 4 and later keeps the last window, so only the new samples of each hop are sent
  * \param dev structure for grc device
+ * \param params streaming parameters
  * \return Ok(=0) or error code (<0)
  */
+int grc_stream_begin(struct grc_device* dev, const struct grc_stream_params* params);
+
+/*!
+ * \brief push samples of the stream, a window is classified each hop_len samples once window_len samples are pushed
+ * \param dev structure for grc device
+ * \param vals Pointer to the samples
+ * \param len number of samples
+ * \return number of windows classified or error code (<0). samples after the failed window are not pushed
+ */
+int grc_stream_push(struct grc_device* dev, const float* vals, uint32_t len);
+
+/*!
+ * \brief take queued results of a stream without callback. the oldest result is dropped when
+ *        GRC_STREAM_QUEUE_LEN results are queued
+ * \param dev structure for grc device
+ * \param results buffer for up to cnt results, oldest first
+ * \param cnt buffer length
+ * \return number of results taken or error code (<0)
+ */
+int grc_stream_read(struct grc_device* dev, struct grc_stream_result* results, uint32_t cnt);
+
+/*!
+ * \brief end the streaming inference, queued results are dropped
+ * \param dev structure for grc device
+ * \return Ok(=0) or error code (<0)
+ */
+int grc_stream_end(struct grc_device* dev);
+
+/*!
+ * \brief function run on the device worker thread, see grc_submit
+ * \return result given to the callback
+ */
+typedef int (*grc_function_t)(struct grc_device* dev, void* arg);
+
+/*!
+ * \brief run the function on the device worker thread, in order with the functions called with GRC_PARAMS_ASYNC.
+ *        the function calls the other functions of grc.h on the device
+ * \param dev structure for grc device
+ * \param run function to run
+ * \param arg argument of run, kept valid by the caller until the callback
+ * \param callback called on the worker thread with the result of run, may be NULL. calls on the device from it
+ *        return GRC_IS_BUSY, it may queue further functions
+ * \param user_data callback arguments
+ * \return Ok(=0), GRC_IS_BUSY if 8 functions are queued, NOT_IMPLEMENTED without worker threads, or error code (<0)
+ */
+int grc_submit(struct grc_device* dev, grc_function_t run, void* arg, grc_callback_t callback, void* user_data);
+
+/*!
+ * \brief wait for the end of train and inference functions called with GRC_PARAMS_ASYNC
+ * \param dev structure for grc device
+ * \return result of the last finished function, Ok(=0) if none was called, or error code (<0)
+ */
 int grc_wait(struct grc_device* dev);
 
+/*!
+ * \brief grc_wait with time limit
+ * \param dev structure for grc device
+ * \param timeout_ms maximum wait time, <0 - no limit
+ * \return result of the last finished function, Ok(=0) if none was called, GRC_TIMEOUT or error code (<0)
+ */
+int grc_wait_timeout(struct grc_device* dev, int timeout_ms);
+
 /*!
  * \brief get number of trained classes
  * \return number of trained classes (>= 0) or error code (<0).
@@ -270,6 +482,30 @@ int grc_store(struct grc_device* dev);
  */
 int grc_restore(struct grc_device* dev);
 
+/*!
+ * \brief get SDK counters of the device
+ * \param dev structure for grc device
+ * \param stats where to put counters
+ * \return Ok(=0) or error code (<0).
+ */
+int grc_get_stats(struct grc_device* dev, struct grc_stats* stats);
+
+/*!
+ * \brief set SDK counters of the device to zero
+ * \param dev structure for grc device
+ * \return Ok(=0) or error code (<0).
+ */
+int grc_reset_stats(struct grc_device* dev);
+
+/*!
+ * \brief set the longest wait for a remote function, 10 s after grc_init. a stalled module makes
+ *        the waiting function return GRC_TIMEOUT, GRC may still run the function after it
+ * \param dev structure for grc device
+ * \param timeout_ms time limit, 0 - wait without a limit
+ * \return Ok(=0) or error code (<0).
+ */
+int grc_set_function_timeout(struct grc_device* dev, uint32_t timeout_ms);
+
 /*!
  * \brief reset GRC device
  * \param dev structure for grc device
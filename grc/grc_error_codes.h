@@ -12,6 +12,9 @@
 #define NOT_IMPLEMENTED -7
 #define SDK_VERSION_MISMATCH -8
 #define GRC_GPIO_ERROR -9
+#define GRC_NO_MEMORY -10
+#define GRC_TIMEOUT -11
+#define I2C_NACK -12
 
 #define REMOTE_FUNCTION_ERROR -20
 #define REMOTE_FUNCTION_INVAL_STATE -21
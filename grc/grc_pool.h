@@ -0,0 +1,105 @@
+#ifndef _GRC_POOL_H_
+#define _GRC_POOL_H_
+
+#include <stdint.h>
+
+#include "grc/grc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// inferences queued per device of a pool
+#define GRC_POOL_QUEUE_LEN 16
+
+/*!
+ * \brief devices holding identical models, each driven by its own worker thread (POSIX threads).
+ *        an inference is queued to an idle device or the shortest queue, an idle device takes queued
+ *        inferences of the others (work stealing). with hedging on, an idle device also runs a window that
+ *        takes longer than the 95th percentile of the inference times on another device, the first answer wins
+ */
+struct grc_pool;
+
+/*!
+ * \brief work of a pool device
+ * \param inferences inferences finished by the device
+ * \param stolen inferences the device took from queues of the other devices
+ * \param hedged windows the device ran as a hedge of a window running longer on another device
+ * \param hedges_won hedged windows answered by this device first
+ * \param busy_us time the device spent on inferences
+ * \param utilisation busy_us part of the time since the pool creation or the last reset, 0..1
+ */
+struct grc_pool_stats {
+    uint64_t inferences;
+    uint64_t stolen;
+    uint64_t hedged;
+    uint64_t hedges_won;
+    uint64_t busy_us;
+    float utilisation;
+};
+
+/*!
+ * \brief create pool of the devices, initialised with grc_init before.
+ *        the devices are not used with the other functions of grc.h until the pool is destroyed
+ * \param devs devices
+ * \param cnt number of devices
+ * \return pool or NULL if out of memory, cnt is 0 or POSIX threads are not available
+ */
+struct grc_pool* grc_pool_create(struct grc_device* const* devs, uint32_t cnt);
+
+/*!
+ * \brief finish the queued inferences and release the pool, the devices stay initialised
+ */
+void grc_pool_destroy(struct grc_pool* pool);
+
+/*!
+ * \brief copy the model trained on one device, with its class tags, to the other devices of the pool.
+ *        waits for the queued inferences, no inferences are queued until it returns
+ * \param src index of the trained device
+ * \return number of classes (>=0) or error code (<0)
+ */
+int grc_pool_replicate(struct grc_pool* pool, uint32_t src);
+
+/*!
+ * \brief run slow windows on a second device: a window running longer than the hedging delay is run again
+ *        by an idle device, the callback gets the first class and the other result is ignored.
+ *        the stalled device is not interrupted, it takes the next window when its function finishes or
+ *        times out (see grc_set_function_timeout)
+ * \param enable 1 - hedging on, 0 - off (default)
+ * \return Ok(=0) or error code (<0)
+ */
+int grc_pool_set_hedging(struct grc_pool* pool, int enable);
+
+/*!
+ * \brief hedging delay: 95th percentile of the last 128 inference times of the pool, updated as they finish
+ * \return delay in microseconds, 0 until 32 inferences are timed
+ */
+uint32_t grc_pool_hedge_delay_us(struct grc_pool* pool);
+
+/*!
+ * \brief queue classification of the window on the pool, all classes are considered. the window is copied
+ * \param callback called on a worker thread with the class tag, NOT_CLASSIFIED or error code (<0)
+ * \param user_data callback arguments
+ * \return Ok(=0), GRC_IS_BUSY if all queues are full, GRC_NO_MEMORY
+ */
+int grc_pool_inference(struct grc_pool* pool, const float* vals, uint32_t len, grc_callback_t callback, void* user_data);
+
+/*!
+ * \brief wait until the queued inferences are finished, including the ignored runs of hedged windows
+ * \return Ok(=0) or error code (<0)
+ */
+int grc_pool_wait(struct grc_pool* pool);
+
+/*!
+ * \brief work of the device since the pool creation or the last reset
+ * \param idx device index
+ * \param reset 1 - start counting again
+ * \return Ok(=0) or ARGUMENT_ERROR
+ */
+int grc_pool_get_stats(struct grc_pool* pool, uint32_t idx, struct grc_pool_stats* stats, int reset);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _GRC_POOL_H_
@@ -0,0 +1,85 @@
+#ifndef _GRC_REACTOR_H_
+#define _GRC_REACTOR_H_
+
+#include <stdint.h>
+
+#include "grc/grc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// inferences queued and not finished yet, per device
+#define GRC_REACTOR_QUEUE_LEN 8
+
+/*!
+ * \brief single-threaded event loop driving remote calls of many devices concurrently (Linux, epoll).
+ *        while one device computes, the reactor talks to the others instead of sleeping.
+ *        bus transactions are still made with blocking driver calls, the waits for GRC are not
+ */
+struct grc_reactor;
+
+/*!
+ * \brief create reactor
+ * \return reactor or NULL if out of memory or file descriptors
+ */
+struct grc_reactor* grc_reactor_create(void);
+
+/*!
+ * \brief release the reactor. inferences not finished are dropped without callback
+ */
+void grc_reactor_destroy(struct grc_reactor* reactor);
+
+/*!
+ * \brief drive the device with the reactor. the device is initialised with grc_init before,
+ *        it is not used with the other functions of grc.h while inferences are queued. may be called from the
+ *        callbacks of the reactor
+ * \return Ok(=0), ARGUMENT_ERROR if the device is not initialised, or GRC_NO_MEMORY
+ */
+int grc_reactor_add(struct grc_reactor* reactor, struct grc_device* dev);
+
+/*!
+ * \brief stop driving the device, inferences not finished are dropped without callback.
+ *        not called from the callbacks of the device
+ * \return Ok(=0) or ARGUMENT_ERROR if the device is not added
+ */
+int grc_reactor_remove(struct grc_reactor* reactor, struct grc_device* dev);
+
+/*!
+ * \brief queue classification of the window on the device, all classes are considered
+ * \param vals window data, stays valid until the callback
+ * \param callback called from grc_reactor_run with the class tag, NOT_CLASSIFIED or error code (<0)
+ * \param user_data callback arguments
+ * \return Ok(=0), GRC_IS_BUSY if GRC_REACTOR_QUEUE_LEN inferences are queued on the device,
+ *         ARGUMENT_ERROR if the device is not added or len is 0
+ */
+int grc_reactor_inference(
+    struct grc_reactor* reactor,
+    struct grc_device* dev,
+    const float* vals,
+    uint32_t len,
+    grc_callback_t callback,
+    void* user_data);
+
+/*!
+ * \brief wait for events of the devices once and make the bus transactions they are ready for
+ * \param timeout_ms maximum wait time, <0 - no limit, 0 - do not wait
+ * \return number of inferences finished (callbacks called) or error code (<0)
+ */
+int grc_reactor_run(struct grc_reactor* reactor, int timeout_ms);
+
+/*!
+ * \brief file descriptor readable when grc_reactor_run has work, to nest the reactor in another event loop
+ */
+int grc_reactor_fd(struct grc_reactor* reactor);
+
+/*!
+ * \brief number of inferences queued on all devices
+ */
+uint32_t grc_reactor_pending(struct grc_reactor* reactor);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _GRC_REACTOR_H_
@@ -1,5 +1,18 @@
 #include "grc/i2c/crc_calculation.h"
 
+// slicing by 8 needs 1792 more bytes of tables, small MCUs keep the bytewise loop
+#ifndef CRC8_SLICES
+#if defined(__AVR__)
+#define CRC8_SLICES 1
+#else
+#define CRC8_SLICES 8
+#endif
+#endif
+
+#if (CRC8_SLICES != 1) && (CRC8_SLICES != 8)
+#error "CRC8_SLICES must be 1 or 8"
+#endif
+
 /*
   Name  : CRC-8
   Poly  : 0x31    x^8 + x^5 + x^4 + 1
@@ -44,12 +57,268 @@ static const uint8_t Crc8Table[256] = {
     0x3B, 0x0A, 0x59, 0x68, 0xFF, 0xCE, 0x9D, 0xAC
 };
 
+#if CRC8_SLICES > 1
+// Crc8SliceTable[k][x] - crc of x followed by k + 1 zero bytes, so 8 bytes are folded with independent lookups
+static const uint8_t Crc8SliceTable[CRC8_SLICES - 1][256] = {
+    {
+        0x00, 0xF4, 0xD9, 0x2D, 0x83, 0x77, 0x5A, 0xAE,
+        0x37, 0xC3, 0xEE, 0x1A, 0xB4, 0x40, 0x6D, 0x99,
+        0x6E, 0x9A, 0xB7, 0x43, 0xED, 0x19, 0x34, 0xC0,
+        0x59, 0xAD, 0x80, 0x74, 0xDA, 0x2E, 0x03, 0xF7,
+        0xDC, 0x28, 0x05, 0xF1, 0x5F, 0xAB, 0x86, 0x72,
+        0xEB, 0x1F, 0x32, 0xC6, 0x68, 0x9C, 0xB1, 0x45,
+        0xB2, 0x46, 0x6B, 0x9F, 0x31, 0xC5, 0xE8, 0x1C,
+        0x85, 0x71, 0x5C, 0xA8, 0x06, 0xF2, 0xDF, 0x2B,
+        0x89, 0x7D, 0x50, 0xA4, 0x0A, 0xFE, 0xD3, 0x27,
+        0xBE, 0x4A, 0x67, 0x93, 0x3D, 0xC9, 0xE4, 0x10,
+        0xE7, 0x13, 0x3E, 0xCA, 0x64, 0x90, 0xBD, 0x49,
+        0xD0, 0x24, 0x09, 0xFD, 0x53, 0xA7, 0x8A, 0x7E,
+        0x55, 0xA1, 0x8C, 0x78, 0xD6, 0x22, 0x0F, 0xFB,
+        0x62, 0x96, 0xBB, 0x4F, 0xE1, 0x15, 0x38, 0xCC,
+        0x3B, 0xCF, 0xE2, 0x16, 0xB8, 0x4C, 0x61, 0x95,
+        0x0C, 0xF8, 0xD5, 0x21, 0x8F, 0x7B, 0x56, 0xA2,
+        0x23, 0xD7, 0xFA, 0x0E, 0xA0, 0x54, 0x79, 0x8D,
+        0x14, 0xE0, 0xCD, 0x39, 0x97, 0x63, 0x4E, 0xBA,
+        0x4D, 0xB9, 0x94, 0x60, 0xCE, 0x3A, 0x17, 0xE3,
+        0x7A, 0x8E, 0xA3, 0x57, 0xF9, 0x0D, 0x20, 0xD4,
+        0xFF, 0x0B, 0x26, 0xD2, 0x7C, 0x88, 0xA5, 0x51,
+        0xC8, 0x3C, 0x11, 0xE5, 0x4B, 0xBF, 0x92, 0x66,
+        0x91, 0x65, 0x48, 0xBC, 0x12, 0xE6, 0xCB, 0x3F,
+        0xA6, 0x52, 0x7F, 0x8B, 0x25, 0xD1, 0xFC, 0x08,
+        0xAA, 0x5E, 0x73, 0x87, 0x29, 0xDD, 0xF0, 0x04,
+        0x9D, 0x69, 0x44, 0xB0, 0x1E, 0xEA, 0xC7, 0x33,
+        0xC4, 0x30, 0x1D, 0xE9, 0x47, 0xB3, 0x9E, 0x6A,
+        0xF3, 0x07, 0x2A, 0xDE, 0x70, 0x84, 0xA9, 0x5D,
+        0x76, 0x82, 0xAF, 0x5B, 0xF5, 0x01, 0x2C, 0xD8,
+        0x41, 0xB5, 0x98, 0x6C, 0xC2, 0x36, 0x1B, 0xEF,
+        0x18, 0xEC, 0xC1, 0x35, 0x9B, 0x6F, 0x42, 0xB6,
+        0x2F, 0xDB, 0xF6, 0x02, 0xAC, 0x58, 0x75, 0x81
+    },
+    {
+        0x00, 0x46, 0x8C, 0xCA, 0x29, 0x6F, 0xA5, 0xE3,
+        0x52, 0x14, 0xDE, 0x98, 0x7B, 0x3D, 0xF7, 0xB1,
+        0xA4, 0xE2, 0x28, 0x6E, 0x8D, 0xCB, 0x01, 0x47,
+        0xF6, 0xB0, 0x7A, 0x3C, 0xDF, 0x99, 0x53, 0x15,
+        0x79, 0x3F, 0xF5, 0xB3, 0x50, 0x16, 0xDC, 0x9A,
+        0x2B, 0x6D, 0xA7, 0xE1, 0x02, 0x44, 0x8E, 0xC8,
+        0xDD, 0x9B, 0x51, 0x17, 0xF4, 0xB2, 0x78, 0x3E,
+        0x8F, 0xC9, 0x03, 0x45, 0xA6, 0xE0, 0x2A, 0x6C,
+        0xF2, 0xB4, 0x7E, 0x38, 0xDB, 0x9D, 0x57, 0x11,
+        0xA0, 0xE6, 0x2C, 0x6A, 0x89, 0xCF, 0x05, 0x43,
+        0x56, 0x10, 0xDA, 0x9C, 0x7F, 0x39, 0xF3, 0xB5,
+        0x04, 0x42, 0x88, 0xCE, 0x2D, 0x6B, 0xA1, 0xE7,
+        0x8B, 0xCD, 0x07, 0x41, 0xA2, 0xE4, 0x2E, 0x68,
+        0xD9, 0x9F, 0x55, 0x13, 0xF0, 0xB6, 0x7C, 0x3A,
+        0x2F, 0x69, 0xA3, 0xE5, 0x06, 0x40, 0x8A, 0xCC,
+        0x7D, 0x3B, 0xF1, 0xB7, 0x54, 0x12, 0xD8, 0x9E,
+        0xD5, 0x93, 0x59, 0x1F, 0xFC, 0xBA, 0x70, 0x36,
+        0x87, 0xC1, 0x0B, 0x4D, 0xAE, 0xE8, 0x22, 0x64,
+        0x71, 0x37, 0xFD, 0xBB, 0x58, 0x1E, 0xD4, 0x92,
+        0x23, 0x65, 0xAF, 0xE9, 0x0A, 0x4C, 0x86, 0xC0,
+        0xAC, 0xEA, 0x20, 0x66, 0x85, 0xC3, 0x09, 0x4F,
+        0xFE, 0xB8, 0x72, 0x34, 0xD7, 0x91, 0x5B, 0x1D,
+        0x08, 0x4E, 0x84, 0xC2, 0x21, 0x67, 0xAD, 0xEB,
+        0x5A, 0x1C, 0xD6, 0x90, 0x73, 0x35, 0xFF, 0xB9,
+        0x27, 0x61, 0xAB, 0xED, 0x0E, 0x48, 0x82, 0xC4,
+        0x75, 0x33, 0xF9, 0xBF, 0x5C, 0x1A, 0xD0, 0x96,
+        0x83, 0xC5, 0x0F, 0x49, 0xAA, 0xEC, 0x26, 0x60,
+        0xD1, 0x97, 0x5D, 0x1B, 0xF8, 0xBE, 0x74, 0x32,
+        0x5E, 0x18, 0xD2, 0x94, 0x77, 0x31, 0xFB, 0xBD,
+        0x0C, 0x4A, 0x80, 0xC6, 0x25, 0x63, 0xA9, 0xEF,
+        0xFA, 0xBC, 0x76, 0x30, 0xD3, 0x95, 0x5F, 0x19,
+        0xA8, 0xEE, 0x24, 0x62, 0x81, 0xC7, 0x0D, 0x4B
+    },
+    {
+        0x00, 0x9B, 0x07, 0x9C, 0x0E, 0x95, 0x09, 0x92,
+        0x1C, 0x87, 0x1B, 0x80, 0x12, 0x89, 0x15, 0x8E,
+        0x38, 0xA3, 0x3F, 0xA4, 0x36, 0xAD, 0x31, 0xAA,
+        0x24, 0xBF, 0x23, 0xB8, 0x2A, 0xB1, 0x2D, 0xB6,
+        0x70, 0xEB, 0x77, 0xEC, 0x7E, 0xE5, 0x79, 0xE2,
+        0x6C, 0xF7, 0x6B, 0xF0, 0x62, 0xF9, 0x65, 0xFE,
+        0x48, 0xD3, 0x4F, 0xD4, 0x46, 0xDD, 0x41, 0xDA,
+        0x54, 0xCF, 0x53, 0xC8, 0x5A, 0xC1, 0x5D, 0xC6,
+        0xE0, 0x7B, 0xE7, 0x7C, 0xEE, 0x75, 0xE9, 0x72,
+        0xFC, 0x67, 0xFB, 0x60, 0xF2, 0x69, 0xF5, 0x6E,
+        0xD8, 0x43, 0xDF, 0x44, 0xD6, 0x4D, 0xD1, 0x4A,
+        0xC4, 0x5F, 0xC3, 0x58, 0xCA, 0x51, 0xCD, 0x56,
+        0x90, 0x0B, 0x97, 0x0C, 0x9E, 0x05, 0x99, 0x02,
+        0x8C, 0x17, 0x8B, 0x10, 0x82, 0x19, 0x85, 0x1E,
+        0xA8, 0x33, 0xAF, 0x34, 0xA6, 0x3D, 0xA1, 0x3A,
+        0xB4, 0x2F, 0xB3, 0x28, 0xBA, 0x21, 0xBD, 0x26,
+        0xF1, 0x6A, 0xF6, 0x6D, 0xFF, 0x64, 0xF8, 0x63,
+        0xED, 0x76, 0xEA, 0x71, 0xE3, 0x78, 0xE4, 0x7F,
+        0xC9, 0x52, 0xCE, 0x55, 0xC7, 0x5C, 0xC0, 0x5B,
+        0xD5, 0x4E, 0xD2, 0x49, 0xDB, 0x40, 0xDC, 0x47,
+        0x81, 0x1A, 0x86, 0x1D, 0x8F, 0x14, 0x88, 0x13,
+        0x9D, 0x06, 0x9A, 0x01, 0x93, 0x08, 0x94, 0x0F,
+        0xB9, 0x22, 0xBE, 0x25, 0xB7, 0x2C, 0xB0, 0x2B,
+        0xA5, 0x3E, 0xA2, 0x39, 0xAB, 0x30, 0xAC, 0x37,
+        0x11, 0x8A, 0x16, 0x8D, 0x1F, 0x84, 0x18, 0x83,
+        0x0D, 0x96, 0x0A, 0x91, 0x03, 0x98, 0x04, 0x9F,
+        0x29, 0xB2, 0x2E, 0xB5, 0x27, 0xBC, 0x20, 0xBB,
+        0x35, 0xAE, 0x32, 0xA9, 0x3B, 0xA0, 0x3C, 0xA7,
+        0x61, 0xFA, 0x66, 0xFD, 0x6F, 0xF4, 0x68, 0xF3,
+        0x7D, 0xE6, 0x7A, 0xE1, 0x73, 0xE8, 0x74, 0xEF,
+        0x59, 0xC2, 0x5E, 0xC5, 0x57, 0xCC, 0x50, 0xCB,
+        0x45, 0xDE, 0x42, 0xD9, 0x4B, 0xD0, 0x4C, 0xD7
+    },
+    {
+        0x00, 0xD3, 0x97, 0x44, 0x1F, 0xCC, 0x88, 0x5B,
+        0x3E, 0xED, 0xA9, 0x7A, 0x21, 0xF2, 0xB6, 0x65,
+        0x7C, 0xAF, 0xEB, 0x38, 0x63, 0xB0, 0xF4, 0x27,
+        0x42, 0x91, 0xD5, 0x06, 0x5D, 0x8E, 0xCA, 0x19,
+        0xF8, 0x2B, 0x6F, 0xBC, 0xE7, 0x34, 0x70, 0xA3,
+        0xC6, 0x15, 0x51, 0x82, 0xD9, 0x0A, 0x4E, 0x9D,
+        0x84, 0x57, 0x13, 0xC0, 0x9B, 0x48, 0x0C, 0xDF,
+        0xBA, 0x69, 0x2D, 0xFE, 0xA5, 0x76, 0x32, 0xE1,
+        0xC1, 0x12, 0x56, 0x85, 0xDE, 0x0D, 0x49, 0x9A,
+        0xFF, 0x2C, 0x68, 0xBB, 0xE0, 0x33, 0x77, 0xA4,
+        0xBD, 0x6E, 0x2A, 0xF9, 0xA2, 0x71, 0x35, 0xE6,
+        0x83, 0x50, 0x14, 0xC7, 0x9C, 0x4F, 0x0B, 0xD8,
+        0x39, 0xEA, 0xAE, 0x7D, 0x26, 0xF5, 0xB1, 0x62,
+        0x07, 0xD4, 0x90, 0x43, 0x18, 0xCB, 0x8F, 0x5C,
+        0x45, 0x96, 0xD2, 0x01, 0x5A, 0x89, 0xCD, 0x1E,
+        0x7B, 0xA8, 0xEC, 0x3F, 0x64, 0xB7, 0xF3, 0x20,
+        0xB3, 0x60, 0x24, 0xF7, 0xAC, 0x7F, 0x3B, 0xE8,
+        0x8D, 0x5E, 0x1A, 0xC9, 0x92, 0x41, 0x05, 0xD6,
+        0xCF, 0x1C, 0x58, 0x8B, 0xD0, 0x03, 0x47, 0x94,
+        0xF1, 0x22, 0x66, 0xB5, 0xEE, 0x3D, 0x79, 0xAA,
+        0x4B, 0x98, 0xDC, 0x0F, 0x54, 0x87, 0xC3, 0x10,
+        0x75, 0xA6, 0xE2, 0x31, 0x6A, 0xB9, 0xFD, 0x2E,
+        0x37, 0xE4, 0xA0, 0x73, 0x28, 0xFB, 0xBF, 0x6C,
+        0x09, 0xDA, 0x9E, 0x4D, 0x16, 0xC5, 0x81, 0x52,
+        0x72, 0xA1, 0xE5, 0x36, 0x6D, 0xBE, 0xFA, 0x29,
+        0x4C, 0x9F, 0xDB, 0x08, 0x53, 0x80, 0xC4, 0x17,
+        0x0E, 0xDD, 0x99, 0x4A, 0x11, 0xC2, 0x86, 0x55,
+        0x30, 0xE3, 0xA7, 0x74, 0x2F, 0xFC, 0xB8, 0x6B,
+        0x8A, 0x59, 0x1D, 0xCE, 0x95, 0x46, 0x02, 0xD1,
+        0xB4, 0x67, 0x23, 0xF0, 0xAB, 0x78, 0x3C, 0xEF,
+        0xF6, 0x25, 0x61, 0xB2, 0xE9, 0x3A, 0x7E, 0xAD,
+        0xC8, 0x1B, 0x5F, 0x8C, 0xD7, 0x04, 0x40, 0x93
+    },
+    {
+        0x00, 0x57, 0xAE, 0xF9, 0x6D, 0x3A, 0xC3, 0x94,
+        0xDA, 0x8D, 0x74, 0x23, 0xB7, 0xE0, 0x19, 0x4E,
+        0x85, 0xD2, 0x2B, 0x7C, 0xE8, 0xBF, 0x46, 0x11,
+        0x5F, 0x08, 0xF1, 0xA6, 0x32, 0x65, 0x9C, 0xCB,
+        0x3B, 0x6C, 0x95, 0xC2, 0x56, 0x01, 0xF8, 0xAF,
+        0xE1, 0xB6, 0x4F, 0x18, 0x8C, 0xDB, 0x22, 0x75,
+        0xBE, 0xE9, 0x10, 0x47, 0xD3, 0x84, 0x7D, 0x2A,
+        0x64, 0x33, 0xCA, 0x9D, 0x09, 0x5E, 0xA7, 0xF0,
+        0x76, 0x21, 0xD8, 0x8F, 0x1B, 0x4C, 0xB5, 0xE2,
+        0xAC, 0xFB, 0x02, 0x55, 0xC1, 0x96, 0x6F, 0x38,
+        0xF3, 0xA4, 0x5D, 0x0A, 0x9E, 0xC9, 0x30, 0x67,
+        0x29, 0x7E, 0x87, 0xD0, 0x44, 0x13, 0xEA, 0xBD,
+        0x4D, 0x1A, 0xE3, 0xB4, 0x20, 0x77, 0x8E, 0xD9,
+        0x97, 0xC0, 0x39, 0x6E, 0xFA, 0xAD, 0x54, 0x03,
+        0xC8, 0x9F, 0x66, 0x31, 0xA5, 0xF2, 0x0B, 0x5C,
+        0x12, 0x45, 0xBC, 0xEB, 0x7F, 0x28, 0xD1, 0x86,
+        0xEC, 0xBB, 0x42, 0x15, 0x81, 0xD6, 0x2F, 0x78,
+        0x36, 0x61, 0x98, 0xCF, 0x5B, 0x0C, 0xF5, 0xA2,
+        0x69, 0x3E, 0xC7, 0x90, 0x04, 0x53, 0xAA, 0xFD,
+        0xB3, 0xE4, 0x1D, 0x4A, 0xDE, 0x89, 0x70, 0x27,
+        0xD7, 0x80, 0x79, 0x2E, 0xBA, 0xED, 0x14, 0x43,
+        0x0D, 0x5A, 0xA3, 0xF4, 0x60, 0x37, 0xCE, 0x99,
+        0x52, 0x05, 0xFC, 0xAB, 0x3F, 0x68, 0x91, 0xC6,
+        0x88, 0xDF, 0x26, 0x71, 0xE5, 0xB2, 0x4B, 0x1C,
+        0x9A, 0xCD, 0x34, 0x63, 0xF7, 0xA0, 0x59, 0x0E,
+        0x40, 0x17, 0xEE, 0xB9, 0x2D, 0x7A, 0x83, 0xD4,
+        0x1F, 0x48, 0xB1, 0xE6, 0x72, 0x25, 0xDC, 0x8B,
+        0xC5, 0x92, 0x6B, 0x3C, 0xA8, 0xFF, 0x06, 0x51,
+        0xA1, 0xF6, 0x0F, 0x58, 0xCC, 0x9B, 0x62, 0x35,
+        0x7B, 0x2C, 0xD5, 0x82, 0x16, 0x41, 0xB8, 0xEF,
+        0x24, 0x73, 0x8A, 0xDD, 0x49, 0x1E, 0xE7, 0xB0,
+        0xFE, 0xA9, 0x50, 0x07, 0x93, 0xC4, 0x3D, 0x6A
+    },
+    {
+        0x00, 0xE9, 0xE3, 0x0A, 0xF7, 0x1E, 0x14, 0xFD,
+        0xDF, 0x36, 0x3C, 0xD5, 0x28, 0xC1, 0xCB, 0x22,
+        0x8F, 0x66, 0x6C, 0x85, 0x78, 0x91, 0x9B, 0x72,
+        0x50, 0xB9, 0xB3, 0x5A, 0xA7, 0x4E, 0x44, 0xAD,
+        0x2F, 0xC6, 0xCC, 0x25, 0xD8, 0x31, 0x3B, 0xD2,
+        0xF0, 0x19, 0x13, 0xFA, 0x07, 0xEE, 0xE4, 0x0D,
+        0xA0, 0x49, 0x43, 0xAA, 0x57, 0xBE, 0xB4, 0x5D,
+        0x7F, 0x96, 0x9C, 0x75, 0x88, 0x61, 0x6B, 0x82,
+        0x5E, 0xB7, 0xBD, 0x54, 0xA9, 0x40, 0x4A, 0xA3,
+        0x81, 0x68, 0x62, 0x8B, 0x76, 0x9F, 0x95, 0x7C,
+        0xD1, 0x38, 0x32, 0xDB, 0x26, 0xCF, 0xC5, 0x2C,
+        0x0E, 0xE7, 0xED, 0x04, 0xF9, 0x10, 0x1A, 0xF3,
+        0x71, 0x98, 0x92, 0x7B, 0x86, 0x6F, 0x65, 0x8C,
+        0xAE, 0x47, 0x4D, 0xA4, 0x59, 0xB0, 0xBA, 0x53,
+        0xFE, 0x17, 0x1D, 0xF4, 0x09, 0xE0, 0xEA, 0x03,
+        0x21, 0xC8, 0xC2, 0x2B, 0xD6, 0x3F, 0x35, 0xDC,
+        0xBC, 0x55, 0x5F, 0xB6, 0x4B, 0xA2, 0xA8, 0x41,
+        0x63, 0x8A, 0x80, 0x69, 0x94, 0x7D, 0x77, 0x9E,
+        0x33, 0xDA, 0xD0, 0x39, 0xC4, 0x2D, 0x27, 0xCE,
+        0xEC, 0x05, 0x0F, 0xE6, 0x1B, 0xF2, 0xF8, 0x11,
+        0x93, 0x7A, 0x70, 0x99, 0x64, 0x8D, 0x87, 0x6E,
+        0x4C, 0xA5, 0xAF, 0x46, 0xBB, 0x52, 0x58, 0xB1,
+        0x1C, 0xF5, 0xFF, 0x16, 0xEB, 0x02, 0x08, 0xE1,
+        0xC3, 0x2A, 0x20, 0xC9, 0x34, 0xDD, 0xD7, 0x3E,
+        0xE2, 0x0B, 0x01, 0xE8, 0x15, 0xFC, 0xF6, 0x1F,
+        0x3D, 0xD4, 0xDE, 0x37, 0xCA, 0x23, 0x29, 0xC0,
+        0x6D, 0x84, 0x8E, 0x67, 0x9A, 0x73, 0x79, 0x90,
+        0xB2, 0x5B, 0x51, 0xB8, 0x45, 0xAC, 0xA6, 0x4F,
+        0xCD, 0x24, 0x2E, 0xC7, 0x3A, 0xD3, 0xD9, 0x30,
+        0x12, 0xFB, 0xF1, 0x18, 0xE5, 0x0C, 0x06, 0xEF,
+        0x42, 0xAB, 0xA1, 0x48, 0xB5, 0x5C, 0x56, 0xBF,
+        0x9D, 0x74, 0x7E, 0x97, 0x6A, 0x83, 0x89, 0x60
+    },
+    {
+        0x00, 0x49, 0x92, 0xDB, 0x15, 0x5C, 0x87, 0xCE,
+        0x2A, 0x63, 0xB8, 0xF1, 0x3F, 0x76, 0xAD, 0xE4,
+        0x54, 0x1D, 0xC6, 0x8F, 0x41, 0x08, 0xD3, 0x9A,
+        0x7E, 0x37, 0xEC, 0xA5, 0x6B, 0x22, 0xF9, 0xB0,
+        0xA8, 0xE1, 0x3A, 0x73, 0xBD, 0xF4, 0x2F, 0x66,
+        0x82, 0xCB, 0x10, 0x59, 0x97, 0xDE, 0x05, 0x4C,
+        0xFC, 0xB5, 0x6E, 0x27, 0xE9, 0xA0, 0x7B, 0x32,
+        0xD6, 0x9F, 0x44, 0x0D, 0xC3, 0x8A, 0x51, 0x18,
+        0x61, 0x28, 0xF3, 0xBA, 0x74, 0x3D, 0xE6, 0xAF,
+        0x4B, 0x02, 0xD9, 0x90, 0x5E, 0x17, 0xCC, 0x85,
+        0x35, 0x7C, 0xA7, 0xEE, 0x20, 0x69, 0xB2, 0xFB,
+        0x1F, 0x56, 0x8D, 0xC4, 0x0A, 0x43, 0x98, 0xD1,
+        0xC9, 0x80, 0x5B, 0x12, 0xDC, 0x95, 0x4E, 0x07,
+        0xE3, 0xAA, 0x71, 0x38, 0xF6, 0xBF, 0x64, 0x2D,
+        0x9D, 0xD4, 0x0F, 0x46, 0x88, 0xC1, 0x1A, 0x53,
+        0xB7, 0xFE, 0x25, 0x6C, 0xA2, 0xEB, 0x30, 0x79,
+        0xC2, 0x8B, 0x50, 0x19, 0xD7, 0x9E, 0x45, 0x0C,
+        0xE8, 0xA1, 0x7A, 0x33, 0xFD, 0xB4, 0x6F, 0x26,
+        0x96, 0xDF, 0x04, 0x4D, 0x83, 0xCA, 0x11, 0x58,
+        0xBC, 0xF5, 0x2E, 0x67, 0xA9, 0xE0, 0x3B, 0x72,
+        0x6A, 0x23, 0xF8, 0xB1, 0x7F, 0x36, 0xED, 0xA4,
+        0x40, 0x09, 0xD2, 0x9B, 0x55, 0x1C, 0xC7, 0x8E,
+        0x3E, 0x77, 0xAC, 0xE5, 0x2B, 0x62, 0xB9, 0xF0,
+        0x14, 0x5D, 0x86, 0xCF, 0x01, 0x48, 0x93, 0xDA,
+        0xA3, 0xEA, 0x31, 0x78, 0xB6, 0xFF, 0x24, 0x6D,
+        0x89, 0xC0, 0x1B, 0x52, 0x9C, 0xD5, 0x0E, 0x47,
+        0xF7, 0xBE, 0x65, 0x2C, 0xE2, 0xAB, 0x70, 0x39,
+        0xDD, 0x94, 0x4F, 0x06, 0xC8, 0x81, 0x5A, 0x13,
+        0x0B, 0x42, 0x99, 0xD0, 0x1E, 0x57, 0x8C, 0xC5,
+        0x21, 0x68, 0xB3, 0xFA, 0x34, 0x7D, 0xA6, 0xEF,
+        0x5F, 0x16, 0xCD, 0x84, 0x4A, 0x03, 0xD8, 0x91,
+        0x75, 0x3C, 0xE7, 0xAE, 0x60, 0x29, 0xF2, 0xBB
+    }
+};
+#endif
+
 uint8_t Crc8(uint8_t* pcBlock, uint8_t len)
 {
-    uint8_t crc = 0xFF;
+    return Crc8Update(CRC8_INIT, pcBlock, len);
+}
 
+uint8_t Crc8Update(uint8_t crc, const uint8_t* data, uint8_t len)
+{
+#if CRC8_SLICES > 1
+    while (len >= CRC8_SLICES) {
+        crc = Crc8SliceTable[6][crc ^ data[0]] ^ Crc8SliceTable[5][data[1]] ^ Crc8SliceTable[4][data[2]]
+            ^ Crc8SliceTable[3][data[3]] ^ Crc8SliceTable[2][data[4]] ^ Crc8SliceTable[1][data[5]]
+            ^ Crc8SliceTable[0][data[6]] ^ Crc8Table[data[7]];
+        data += CRC8_SLICES;
+        len -= CRC8_SLICES;
+    }
+#endif
     while (len--)
-        crc = Crc8Table[crc ^ *pcBlock++];
+        crc = Crc8Table[crc ^ *data++];
 
     return crc;
 }
@@ -18,6 +18,14 @@ extern "C" {
 */
 uint8_t Crc8(uint8_t* pcBlock, uint8_t len);
 
+#define CRC8_INIT 0xFF
+
+/*
+  Continues CRC-8 of the preceding bytes with len more bytes,
+  Crc8Update(CRC8_INIT, data, len) == Crc8(data, len)
+*/
+uint8_t Crc8Update(uint8_t crc, const uint8_t* data, uint8_t len);
+
 #ifdef __cplusplus
 }
 #endif // __cplusplus
@@ -0,0 +1,192 @@
+#include <stdlib.h>
+#include <time.h>
+
+#include "grc/grc_error_codes.h"
+#include "grc/i2c/grc_async.h"
+
+static void release_arg(const struct grc_async_job* job)
+{
+    if (job->release) {
+        job->release(job->arg);
+    }
+}
+
+#if GRC_ASYNC
+
+struct worker_args {
+    struct grc_async_engine* engine;
+    struct grc_device* dev;
+};
+
+static void* async_worker(void* arg)
+{
+    struct worker_args args = *(struct worker_args*)arg;
+    struct grc_async_engine* engine = args.engine;
+    free(arg);
+    pthread_mutex_lock(&engine->lock);
+    while (1) {
+        while ((engine->len == 0) && !engine->stop) {
+            pthread_cond_wait(&engine->submitted, &engine->lock);
+        }
+        if (engine->len == 0) {
+            break;
+        }
+        struct grc_async_job job = engine->jobs[engine->head];
+        pthread_mutex_unlock(&engine->lock);
+
+        // the device is used by this thread only until the queue is empty
+        int result = job.run(args.dev, job.arg);
+        if (job.release) {
+            job.release(job.arg);
+        }
+        if (job.callback) {
+            engine->in_callback = 1;
+            job.callback(result, job.user_data);
+            engine->in_callback = 0;
+        }
+
+        pthread_mutex_lock(&engine->lock);
+        engine->head = (engine->head + 1) % GRC_ASYNC_QUEUE_LEN;
+        engine->len--;
+        engine->result = result;
+        pthread_cond_broadcast(&engine->finished);
+    }
+    pthread_mutex_unlock(&engine->lock);
+    return NULL;
+}
+
+static int start_worker(struct grc_async_engine* engine, struct grc_device* dev)
+{
+    struct worker_args* args = (struct worker_args*)malloc(sizeof(struct worker_args));
+    if (args == NULL) {
+        return GRC_NO_MEMORY;
+    }
+    args->engine = engine;
+    args->dev = dev;
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    // timeouts of grc_async_wait do not jump with the wall clock
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&engine->lock, NULL);
+    pthread_cond_init(&engine->submitted, NULL);
+    pthread_cond_init(&engine->finished, &attr);
+    pthread_condattr_destroy(&attr);
+    engine->stop = 0;
+    engine->head = 0;
+    engine->len = 0;
+    engine->result = GRC_OK;
+    engine->in_callback = 0;
+    if (pthread_create(&engine->worker, NULL, async_worker, args) != 0) {
+        free(args);
+        pthread_cond_destroy(&engine->finished);
+        pthread_cond_destroy(&engine->submitted);
+        pthread_mutex_destroy(&engine->lock);
+        return GRC_NO_MEMORY;
+    }
+    engine->started = 1;
+    return GRC_OK;
+}
+
+int grc_async_submit(struct grc_async_engine* engine, struct grc_device* dev, const struct grc_async_job* job)
+{
+    if (!engine->started) {
+        int res = start_worker(engine, dev);
+        if (res < 0) {
+            release_arg(job);
+            return res;
+        }
+    }
+    pthread_mutex_lock(&engine->lock);
+    if (engine->len == GRC_ASYNC_QUEUE_LEN) {
+        pthread_mutex_unlock(&engine->lock);
+        release_arg(job);
+        return GRC_IS_BUSY;
+    }
+    engine->jobs[(engine->head + engine->len) % GRC_ASYNC_QUEUE_LEN] = *job;
+    engine->len++;
+    pthread_cond_signal(&engine->submitted);
+    pthread_mutex_unlock(&engine->lock);
+    return GRC_OK;
+}
+
+int grc_async_wait(struct grc_async_engine* engine, int timeout_ms)
+{
+    if (!engine->started) {
+        return GRC_OK;
+    }
+    if (pthread_equal(pthread_self(), engine->worker)) {
+        return GRC_OK;
+    }
+    struct timespec deadline;
+    if (timeout_ms >= 0) {
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+    }
+    pthread_mutex_lock(&engine->lock);
+    int res = 0;
+    while ((engine->len > 0) && (res == 0)) {
+        if (timeout_ms < 0) {
+            pthread_cond_wait(&engine->finished, &engine->lock);
+        } else {
+            res = pthread_cond_timedwait(&engine->finished, &engine->lock, &deadline);
+        }
+    }
+    res = (engine->len > 0) ? GRC_TIMEOUT : engine->result;
+    pthread_mutex_unlock(&engine->lock);
+    return res;
+}
+
+int grc_async_before_call(struct grc_async_engine* engine)
+{
+    // only the worker thread sets in_callback, it is read here on that thread
+    if (engine->started && pthread_equal(pthread_self(), engine->worker) && engine->in_callback) {
+        return GRC_IS_BUSY;
+    }
+    grc_async_wait(engine, -1);
+    return GRC_OK;
+}
+
+void grc_async_stop(struct grc_async_engine* engine)
+{
+    if (!engine->started) {
+        return;
+    }
+    pthread_mutex_lock(&engine->lock);
+    engine->stop = 1;
+    pthread_cond_signal(&engine->submitted);
+    pthread_mutex_unlock(&engine->lock);
+    pthread_join(engine->worker, NULL);
+    pthread_cond_destroy(&engine->finished);
+    pthread_cond_destroy(&engine->submitted);
+    pthread_mutex_destroy(&engine->lock);
+    engine->started = 0;
+}
+
+#else
+
+int grc_async_submit(struct grc_async_engine* engine, struct grc_device* dev, const struct grc_async_job* job)
+{
+    release_arg(job);
+    return NOT_IMPLEMENTED;
+}
+
+int grc_async_wait(struct grc_async_engine* engine, int timeout_ms)
+{
+    return GRC_OK;
+}
+
+int grc_async_before_call(struct grc_async_engine* engine)
+{
+    return GRC_OK;
+}
+
+void grc_async_stop(struct grc_async_engine* engine)
+{
+}
+
+#endif // GRC_ASYNC
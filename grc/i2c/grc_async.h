@@ -0,0 +1,99 @@
+#ifndef _GRC_ASYNC_H_
+#define _GRC_ASYNC_H_
+
+#include <stdint.h>
+
+#include "grc/grc.h"
+
+// asynchronous functions (GRC_PARAMS_ASYNC) run on a worker thread of the device, it needs POSIX threads
+#ifndef GRC_ASYNC
+#if defined(__unix__) || defined(ESP_PLATFORM)
+#define GRC_ASYNC 1
+#else
+#define GRC_ASYNC 0
+#endif
+#endif
+
+#if GRC_ASYNC
+#include <pthread.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+// functions submitted and not finished yet, per device
+#define GRC_ASYNC_QUEUE_LEN 8
+
+/*!
+ * \brief function submitted with GRC_PARAMS_ASYNC
+ * \param run runs the function on the worker thread, returns its result
+ * \param arg argument of run
+ * \param release frees arg after the run, NULL - arg is kept by the submitter
+ * \param callback called on the worker thread with the result, may be NULL
+ * \param user_data callback arguments
+ */
+struct grc_async_job {
+    int (*run)(struct grc_device* dev, void* arg);
+    void* arg;
+    void (*release)(void* arg);
+    grc_callback_t callback;
+    void* user_data;
+};
+
+/*!
+ * \brief worker thread and submission queue of a device. zeroed - not started
+ * \param started 1 - the worker thread runs
+ * \param stop 1 - the worker thread exits once the queue is empty
+ * \param jobs submitted jobs from head on, the running one stays at head until it finishes
+ * \param result result of the last finished job
+ * \param in_callback 1 - the worker thread runs the callback of a job
+ */
+struct grc_async_engine {
+    int started;
+#if GRC_ASYNC
+    pthread_t worker;
+    pthread_mutex_t lock;
+    pthread_cond_t submitted;
+    pthread_cond_t finished;
+    int stop;
+    struct grc_async_job jobs[GRC_ASYNC_QUEUE_LEN];
+    uint32_t head;
+    uint32_t len;
+    int result;
+    int in_callback;
+#endif
+};
+
+/*!
+ * \brief queue the job, the worker thread is started by the first one
+ * \return Ok(=0), GRC_IS_BUSY if GRC_ASYNC_QUEUE_LEN jobs are waiting, NOT_IMPLEMENTED without GRC_ASYNC,
+ *         or error code (<0). the job arg is released on error
+ */
+int grc_async_submit(struct grc_async_engine* engine, struct grc_device* dev, const struct grc_async_job* job);
+
+/*!
+ * \brief wait until the submitted jobs are finished. returns at once on the worker thread
+ * \param timeout_ms maximum wait time, <0 - no limit
+ * \return result of the last finished job, Ok(=0) if none was submitted, or GRC_TIMEOUT
+ */
+int grc_async_wait(struct grc_async_engine* engine, int timeout_ms);
+
+/*!
+ * \brief wait until the submitted jobs are finished before a synchronous call on the device. the jobs themselves
+ *        call on the worker thread without waiting
+ * \return Ok(=0), or GRC_IS_BUSY in a callback on the worker thread: the jobs queued after the one being reported
+ *         would run after the call and can not be waited for there
+ */
+int grc_async_before_call(struct grc_async_engine* engine);
+
+/*!
+ * \brief finish the submitted jobs and stop the worker thread. must not be called on the worker thread
+ */
+void grc_async_stop(struct grc_async_engine* engine);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _GRC_ASYNC_H_
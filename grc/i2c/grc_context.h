@@ -0,0 +1,95 @@
+#ifndef _GRC_CONTEXT_H_
+#define _GRC_CONTEXT_H_
+
+#include <stdint.h>
+
+#include "grc/grc.h"
+#include "grc/i2c/grc_async.h"
+#include "grc/i2c/protocol_structures.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+#define MAX_TAG_CNT 5
+
+/*!
+ * \brief training series fed in chunks
+ * \param active 1 - between grc_train_begin and grc_train_end
+ * \param class_idx GRC class index being trained, NOT_CLASSIFIED for a new class
+ * \param flags flags of grc_train_begin
+ * \param tag tag of the trained class
+ * \param staging collected short chunks, allocated on the first one
+ * \param staging_len number of floats in staging
+ */
+struct train_session {
+    int active;
+    int class_idx;
+    uint32_t flags;
+    grc_class_tag_t tag;
+    float* staging;
+    uint32_t staging_len;
+};
+
+/*!
+ * \brief streaming inference on overlapping windows
+ * \param active 1 - between grc_stream_begin and grc_stream_end
+ * \param params parameters of grc_stream_begin
+ * \param ring last window_len samples, each kept twice so the last window is contiguous at ring[pos]
+ * \param pos ring index of the oldest sample of the last window
+ * \param filled number of samples in the ring, up to window_len
+ * \param since_window samples pushed since the last classified window
+ * \param pushed samples pushed since grc_stream_begin
+ * \param hop_transfer 1 - GRC keeps the window, only new samples are sent
+ * \param synced 1 - GRC keeps the samples of the last classified window
+ * \param queue results waiting for grc_stream_read, from queue_head on
+ */
+struct inference_stream {
+    int active;
+    struct grc_stream_params params;
+    float* ring;
+    uint32_t pos;
+    uint32_t filled;
+    uint32_t since_window;
+    uint64_t pushed;
+    int hop_transfer;
+    int synced;
+    struct grc_stream_result queue[GRC_STREAM_QUEUE_LEN];
+    uint32_t queue_head;
+    uint32_t queue_len;
+};
+
+/*!
+ * \brief per-device SDK state
+ * \param protocol protocol layer buffers of the device
+ * \param tags_trained tags of trained classes, indexed by GRC class index
+ * \param tags_trained_len number of trained classes
+ * \param train training series in progress
+ * \param stream streaming inference in progress
+ * \param async worker thread running the functions submitted with GRC_PARAMS_ASYNC
+ */
+struct grc_context {
+    struct ProtocolContext protocol;
+    grc_class_tag_t tags_trained[MAX_TAG_CNT];
+    int tags_trained_len;
+    struct train_session train;
+    struct inference_stream stream;
+    struct grc_async_engine async;
+};
+
+/*!
+ * \brief SDK result of the remote function retcode
+ */
+int retcode_to_result(const Retcode* retcode);
+
+/*!
+ * \brief tag of the class GRC reported
+ * \return tag, NOT_CLASSIFIED or WRONG_GRC_ANSWER for an unknown class index
+ */
+int class_idx_to_tag(struct grc_context* ctx, int class_idx);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif // _GRC_CONTEXT_H_
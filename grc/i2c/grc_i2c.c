@@ -1,14 +1,19 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "grc/grc.h"
 #include "grc/grc_error_codes.h"
+#include "grc/drivers/grc_transport.h"
+#include "grc/i2c/grc_context.h"
 #include "grc/i2c/grc_ll_api.h"
 #include "grc/i2c/protocol_structures.h"
 
-#define CUR_SDK_VERSION 1
+#define CUR_SDK_VERSION 4
+// oldest GRC firmware the SDK works with, newer features are negotiated at grc_init
+#define MIN_SDK_VERSION 1
 
-int retcode_to_result(Retcode* retcode)
+int retcode_to_result(const Retcode* retcode)
 {
     int res = I2C_ERROR;
     switch (*retcode) {
@@ -30,6 +35,9 @@ int retcode_to_result(Retcode* retcode)
     case NotCalled:
         res = REMOTE_FUNCTION_NOT_CALLED;
         break;
+    case NotDelivered:
+        res = DATA_NOT_DELIVERED;
+        break;
     case NotImplemented:
         res = REMOTE_FUNCTION_NOT_IMPLEMENTED;
         break;
@@ -47,18 +55,42 @@ int retcode_to_result(Retcode* retcode)
         return res;                           \
     }
 
-#define MAX_TAG_CNT 5
-static int tags_trained[MAX_TAG_CNT] = { -1 };
-static int tags_trained_len = 0;
+// functions submitted with GRC_PARAMS_ASYNC before are finished first, a callback of one of them gets GRC_IS_BUSY
+#define CHECK_DEVICE_CONTEXT(dev)                                   \
+    if ((dev)->ctx == NULL) {                                       \
+        return ARGUMENT_ERROR;                                      \
+    }                                                               \
+    if (grc_async_before_call(&(dev)->ctx->async) == GRC_IS_BUSY) { \
+        return GRC_IS_BUSY;                                         \
+    }
+
+// attempts to classify a window corrupted on the bus
+#define SUBMIT_ATTEMPTS 3
+// polling interval for the result of the oldest submitted window
+#define PIPELINE_POLL_MIN_US 100
+#define PIPELINE_POLL_MAX_US 2000
+
+// short chunks of a training series are collected up to this number of floats before a feed remote call
+#define TRAIN_STAGING_LEN 1024
+
+/*!
+ * \brief arguments of a function submitted with GRC_PARAMS_ASYNC, the data is copied
+ */
+struct async_call {
+    struct grc_training_params train;
+    struct grc_inference_params inference;
+    uint32_t len;
+    float vals[];
+};
 
-static int get_tag_idx(grc_class_tag_t tag, uint32_t flags)
+static int get_tag_idx(struct grc_context* ctx, grc_class_tag_t tag, uint32_t flags)
 {
     int class_idx = NOT_CLASSIFIED;
     if (flags & GRC_PARAMS_ADD_NEW_TAG) {
         return class_idx;
     }
-    for (int i = 0; i < tags_trained_len; i++) {
-        if (tags_trained[i] == tag) {
+    for (int i = 0; i < ctx->tags_trained_len; i++) {
+        if (ctx->tags_trained[i] == tag) {
             class_idx = i;
             break;
         }
@@ -66,6 +98,17 @@ static int get_tag_idx(grc_class_tag_t tag, uint32_t flags)
     return class_idx;
 }
 
+int class_idx_to_tag(struct grc_context* ctx, int class_idx)
+{
+    if (class_idx >= ctx->tags_trained_len) {
+        return WRONG_GRC_ANSWER;
+    }
+    if (class_idx < 0) {
+        return class_idx;
+    }
+    return (int)ctx->tags_trained[class_idx];
+}
+
 int __get_arch_type(struct grc_config* cfg)
 {
     switch (cfg->arch)
@@ -129,80 +172,433 @@ int __set_params(struct hp_setup* hp, struct Param* param)
     return res;
 }
 
-int grc_init(struct grc_device* dev, struct grc_config* cfg)
+// applies arch type (if > 0) and hp entries in order, one remote call per batch if GRC supports it.
+// results (if not NULL) gets result code of each hp entry
+static int set_params(struct grc_device* dev, int arch_type, struct hp_setup* hp, int len, int* results)
+{
+    int arch_cnt = (arch_type > 0) ? 1 : 0;
+    for (int i = 0; results && (i < len); i++) {
+        results[i] = REMOTE_FUNCTION_NOT_CALLED;
+    }
+    if (len + arch_cnt == 0) {
+        return GRC_OK;
+    }
+    struct Param* params = (struct Param*)malloc((len + arch_cnt) * sizeof(struct Param));
+    if (params == NULL) {
+        return GRC_NO_MEMORY;
+    }
+    if (arch_cnt) {
+        params[0].kind = ArchType;
+        params[0].ival = arch_type;
+    }
+    // nothing is sent if an entry can not be converted
+    for (int i = 0; i < len; i++) {
+        int res = __set_params(&hp[i], &params[arch_cnt + i]);
+        if (res < 0) {
+            if (results) {
+                results[i] = res;
+            }
+            free(params);
+            return res;
+        }
+    }
+
+    int res;
+    Retcode retcode = Ok;
+    unsigned applied = 0;
+    res = setParameters(&dev->ctx->protocol, len + arch_cnt, params, &applied, &retcode);
+    if (res == NOT_IMPLEMENTED) {
+        // old firmware applies one parameter per remote call
+        res = GRC_OK;
+        for (applied = 0; applied < (unsigned)(len + arch_cnt); applied++) {
+            res = setNeededParameters(&dev->ctx->protocol, &params[applied], &retcode);
+            if ((res < 0) || (retcode != Ok)) {
+                break;
+            }
+        }
+    }
+    free(params);
+    if (res < 0) {
+        return res;
+    }
+    int applied_hp = (int)applied - arch_cnt;
+    for (int i = 0; results && (i < applied_hp); i++) {
+        results[i] = GRC_OK;
+    }
+    res = retcode_to_result(&retcode);
+    if (results && (res < 0) && (applied_hp >= 0) && (applied_hp < len)) {
+        results[applied_hp] = res;
+    }
+    return res;
+}
+
+// the async worker has to be stopped and the transport released before
+static void free_context(struct grc_device* dev)
+{
+    free(dev->ctx->train.staging);
+    free(dev->ctx->stream.ring);
+    free(dev->ctx);
+    dev->ctx = NULL;
+}
+
+static int init_device(struct grc_device* dev, struct grc_config* cfg)
 {
-    int grc_sdk_version = initProtocolLayer(dev->ll_dev);
+    if (dev->ctx == NULL) {
+        dev->ctx = (struct grc_context*)calloc(1, sizeof(struct grc_context));
+        if (dev->ctx == NULL) {
+            return GRC_NO_MEMORY;
+        }
+    }
+    int grc_sdk_version = initProtocolLayer(&dev->ctx->protocol, grc_transport_resolve(dev->transport), dev->ll_dev);
     if (grc_sdk_version < 0) {
-        // initialization failed
+        // initialization failed, the protocol layer released the transport
+        grc_async_stop(&dev->ctx->async);
+        free_context(dev);
         return grc_sdk_version;
     }
     dev->version = grc_sdk_version;
-    if (grc_sdk_version != CUR_SDK_VERSION) {
-        return SDK_VERSION_MISMATCH;
+    int res = __get_arch_type(cfg);
+    if ((grc_sdk_version < MIN_SDK_VERSION) || (grc_sdk_version > CUR_SDK_VERSION)) {
+        res = SDK_VERSION_MISMATCH;
     }
-    int arch_type = __get_arch_type(cfg);
+    if (res < 0) {
+        grc_async_stop(&dev->ctx->async);
+        releaseProtocolLayer(&dev->ctx->protocol);
+        free_context(dev);
+    }
+    return res;
+}
+
+int grc_init(struct grc_device* dev, struct grc_config* cfg)
+{
+    int arch_type = init_device(dev, cfg);
     if (arch_type < 0) {
         return arch_type;
     }
     int res;
     Retcode retcode;
     struct Param param = { .kind = ArchType, .ival = arch_type };
-    CHECK_REMOTE_CALL(setNeededParameters(dev->ll_dev, &param, &retcode), res, retcode)
+    CHECK_REMOTE_CALL(setNeededParameters(&dev->ctx->protocol, &param, &retcode), res, retcode)
     return 0;
 }
 
+int grc_init_config(struct grc_device* dev, struct grc_config* cfg, struct hp_setup* hp, int len, int* results)
+{
+    int arch_type = init_device(dev, cfg);
+    if (arch_type < 0) {
+        return arch_type;
+    }
+    return set_params(dev, arch_type, hp, len, results);
+}
+
 int grc_release(struct grc_device* dev)
 {
-    return releaseProtocolLayer(dev->ll_dev);
+    CHECK_DEVICE_CONTEXT(dev)
+    grc_async_stop(&dev->ctx->async);
+    int res = releaseProtocolLayer(&dev->ctx->protocol);
+    free_context(dev);
+    return res;
 }
 
-int grc_set_config(struct grc_device* dev, struct hp_setup* hp, int len)
+int grc_scan(const struct grc_device* bus, uint16_t first, uint16_t last, uint16_t* addrs, uint32_t max)
 {
-    Retcode retcode;
-    struct Param param = {};
-    for (int i = 0; i < len; i++) {
-        int res = __set_params(&hp[i], &param);
-        if (res < 0) {
-            return res;
+    const struct grc_transport_ops* transport = grc_transport_resolve(bus->transport);
+    int bus_addr = grc_transport_get_address(transport, bus->ll_dev);
+    if (bus_addr < 0) {
+        return bus_addr;
+    }
+    struct ProtocolContext* protocol = (struct ProtocolContext*)calloc(1, sizeof(struct ProtocolContext));
+    if (protocol == NULL) {
+        return GRC_NO_MEMORY;
+    }
+    int res = initBusScan(protocol, transport, bus->ll_dev);
+    uint32_t found = 0;
+    for (uint32_t addr = first; (addr <= last) && (found < max) && (res >= 0); addr++) {
+        // an address without a module is not acknowledged, another chip does not give a valid version
+        int version;
+        res = probeAddress(protocol, (uint16_t)addr, &version);
+        if ((res > 0) && (version >= MIN_SDK_VERSION) && (version <= CUR_SDK_VERSION)) {
+            addrs[found++] = (uint16_t)addr;
         }
-        CHECK_REMOTE_CALL(setNeededParameters(dev->ll_dev, &param, &retcode), res, retcode)
     }
-    return 0;
+    free(protocol);
+    // the bus stays open at its address for the caller
+    int restored = grc_transport_set_address(transport, bus->ll_dev, (uint16_t)bus_addr);
+    if (res < 0) {
+        return res;
+    }
+    return restored < 0 ? restored : (int)found;
+}
+
+int grc_set_config(struct grc_device* dev, struct hp_setup* hp, int len)
+{
+    CHECK_DEVICE_CONTEXT(dev)
+    return set_params(dev, 0, hp, len, NULL);
+}
+
+int grc_set_config_results(struct grc_device* dev, struct hp_setup* hp, int len, int* results)
+{
+    CHECK_DEVICE_CONTEXT(dev)
+    return set_params(dev, 0, hp, len, results);
 }
 
 int grc_clear_state(struct grc_device* dev)
 {
+    CHECK_DEVICE_CONTEXT(dev)
     int res;
     Retcode retcode;
-    CHECK_REMOTE_CALL(clear(dev->ll_dev, &retcode), res, retcode)
-    tags_trained_len = 0;
+    CHECK_REMOTE_CALL(clear(&dev->ctx->protocol, &retcode), res, retcode)
+    dev->ctx->tags_trained_len = 0;
     return 0;
 }
 
+static void end_train_session(struct grc_context* ctx)
+{
+    free(ctx->train.staging);
+    ctx->train.staging = NULL;
+    ctx->train.staging_len = 0;
+    ctx->train.active = 0;
+}
+
+// feeds the series in streams GRC accepts
+static int feed_train_data(struct grc_context* ctx, const float* vals, uint32_t len)
+{
+    int res;
+    Retcode retcode;
+    CHECK_REMOTE_CALL(feedData(&ctx->protocol, len, vals, &retcode), res, retcode)
+    return GRC_OK;
+}
+
+static int flush_train_staging(struct grc_context* ctx)
+{
+    if (ctx->train.staging_len == 0) {
+        return GRC_OK;
+    }
+    int res = feed_train_data(ctx, ctx->train.staging, ctx->train.staging_len);
+    ctx->train.staging_len = 0;
+    return res;
+}
+
+// class trained by GRC on stop training, a new one takes the next index
+static int record_trained_class(struct grc_context* ctx)
+{
+    int class_idx = ctx->train.class_idx;
+    if (class_idx < 0) {
+        class_idx = ctx->tags_trained_len;
+        ctx->tags_trained[ctx->tags_trained_len++] = (ctx->train.flags & GRC_PARAMS_ADD_NEW_TAG) ? (grc_class_tag_t)class_idx : ctx->train.tag;
+    }
+    return class_idx;
+}
+
+static int stop_train_session(struct grc_context* ctx)
+{
+    int res;
+    Retcode retcode;
+    CHECK_REMOTE_CALL(stopTraining(&ctx->protocol, &retcode), res, retcode)
+    return record_trained_class(ctx);
+}
+
+// takes GRC out of training mode when the series is not finished and ends the session. GRC can not drop a series
+// it has started: the floats it got are trained into the class, which is recorded so the class indices stay those
+// of GRC and returned. GRC answers InvalState if it got none, no class is added then and NOT_CLASSIFIED is returned
+static int abort_train_session(struct grc_context* ctx)
+{
+    Retcode retcode;
+    int res = stopTraining(&ctx->protocol, &retcode);
+    if ((res >= 0) && (retcode == Ok)) {
+        res = record_trained_class(ctx);
+    } else if ((res >= 0) && (retcode == InvalState)) {
+        res = NOT_CLASSIFIED;
+    } else if (res >= 0) {
+        res = retcode_to_result(&retcode);
+    }
+    end_train_session(ctx);
+    return res;
+}
+
+int grc_train_begin(struct grc_device* dev, struct grc_training_params* params)
+{
+    CHECK_DEVICE_CONTEXT(dev)
+    struct grc_context* ctx = dev->ctx;
+    if (ctx->train.active) {
+        return ARGUMENT_ERROR;
+    }
+    int class_idx = get_tag_idx(ctx, params->tag, params->flags);
+    if (!(params->flags & GRC_PARAMS_OVERWRITE) && (class_idx >= 0)) {
+        return ARGUMENT_ERROR;
+    }
+    if ((class_idx < 0) && (ctx->tags_trained_len >= MAX_TAG_CNT)) {
+        return ARGUMENT_ERROR;
+    }
+    if (params->flags & GRC_PARAMS_ASYNC) {
+        return NOT_IMPLEMENTED;
+    }
+    int res;
+    Retcode retcode;
+    CHECK_REMOTE_CALL(startTraining(&ctx->protocol, class_idx, &retcode), res, retcode)
+    ctx->train.active = 1;
+    ctx->train.class_idx = class_idx;
+    ctx->train.flags = params->flags;
+    ctx->train.tag = params->tag;
+    return GRC_OK;
+}
+
+int grc_train_feed(struct grc_device* dev, const float* vals, uint32_t len)
+{
+    CHECK_DEVICE_CONTEXT(dev)
+    struct grc_context* ctx = dev->ctx;
+    if (!ctx->train.active) {
+        return ARGUMENT_ERROR;
+    }
+    int res = GRC_OK;
+    if (len >= TRAIN_STAGING_LEN) {
+        // long chunks are fed in place after the collected ones
+        res = flush_train_staging(ctx);
+        if (res >= 0) {
+            res = feed_train_data(ctx, vals, len);
+        }
+    } else if (len > 0) {
+        if (ctx->train.staging == NULL) {
+            ctx->train.staging = (float*)malloc(TRAIN_STAGING_LEN * sizeof(float));
+            res = ctx->train.staging ? GRC_OK : GRC_NO_MEMORY;
+        }
+        while ((res >= 0) && (len > 0)) {
+            uint32_t cnt = TRAIN_STAGING_LEN - ctx->train.staging_len;
+            cnt = len < cnt ? len : cnt;
+            memcpy(&ctx->train.staging[ctx->train.staging_len], vals, cnt * sizeof(float));
+            ctx->train.staging_len += cnt;
+            vals += cnt;
+            len -= cnt;
+            if (ctx->train.staging_len == TRAIN_STAGING_LEN) {
+                res = flush_train_staging(ctx);
+            }
+        }
+    }
+    if (res < 0) {
+        // the error of the feed is reported, GRC is stopped as far as the link still works
+        abort_train_session(ctx);
+    }
+    return res;
+}
+
+int grc_train_end(struct grc_device* dev)
+{
+    CHECK_DEVICE_CONTEXT(dev)
+    struct grc_context* ctx = dev->ctx;
+    if (!ctx->train.active) {
+        return ARGUMENT_ERROR;
+    }
+    int res = flush_train_staging(ctx);
+    if (res < 0) {
+        abort_train_session(ctx);
+        return res;
+    }
+    res = stop_train_session(ctx);
+    end_train_session(ctx);
+    return res;
+}
+
+int grc_train_cancel(struct grc_device* dev)
+{
+    CHECK_DEVICE_CONTEXT(dev)
+    if (!dev->ctx->train.active) {
+        return ARGUMENT_ERROR;
+    }
+    // chunks the SDK still collects are dropped
+    dev->ctx->train.staging_len = 0;
+    return abort_train_session(dev->ctx);
+}
+
+static struct async_call* new_async_call(const float* vals, uint32_t len)
+{
+    struct async_call* call = (struct async_call*)malloc(sizeof(struct async_call) + len * sizeof(float));
+    if (call != NULL) {
+        call->len = len;
+        memcpy(call->vals, vals, len * sizeof(float));
+    }
+    return call;
+}
+
+static int run_async_train(struct grc_device* dev, void* arg)
+{
+    struct async_call* call = (struct async_call*)arg;
+    return grc_train(dev, &call->train, call->vals, call->len);
+}
+
+static int submit_train(struct grc_device* dev, struct grc_training_params* params, const float* vals, uint32_t len)
+{
+    if (dev->ctx == NULL) {
+        return ARGUMENT_ERROR;
+    }
+    struct async_call* call = new_async_call(vals, len);
+    if (call == NULL) {
+        return GRC_NO_MEMORY;
+    }
+    call->train = *params;
+    call->train.flags &= ~GRC_PARAMS_ASYNC;
+    struct grc_async_job job = { .run = run_async_train, .arg = call, .release = free, .callback = params->callback, .user_data = params->user_data };
+    return grc_async_submit(&dev->ctx->async, dev, &job);
+}
+
 int grc_train(
     struct grc_device* dev,
     struct grc_training_params* params,
     const float* vals,
     uint32_t len)
 {
-    int class_idx = get_tag_idx(params->tag, params->flags);
-    if (!(params->flags & GRC_PARAMS_OVERWRITE) && (class_idx >= 0)) {
+    if (params->flags & GRC_PARAMS_ASYNC) {
+        return submit_train(dev, params, vals, len);
+    }
+    int res = grc_train_begin(dev, params);
+    if (res < 0) {
+        return res;
+    }
+    // the series is fed in place, without collecting it
+    res = feed_train_data(dev->ctx, vals, len);
+    if (res < 0) {
+        // GRC is taken out of training mode, else it would refuse the next inference
+        abort_train_session(dev->ctx);
+        return res;
+    }
+    return grc_train_end(dev);
+}
+
+// GRC checks the window against one class for GRC_PARAMS_SINGLE_CLASS, the class is reset by each inference
+static int set_required_class(struct grc_context* ctx, struct grc_inference_params* params)
+{
+    if (!(params->flags & GRC_PARAMS_SINGLE_CLASS)) {
+        return GRC_OK;
+    }
+    int class_idx = get_tag_idx(ctx, params->tag, 0);
+    if (class_idx < 0) {
         return ARGUMENT_ERROR;
     }
-    if (params->flags & GRC_PARAMS_ASYNC) {
-        return NOT_IMPLEMENTED;
-    } else {
-        int res;
-        Retcode retcode;
-        CHECK_REMOTE_CALL(startTraining(dev->ll_dev, class_idx, &retcode), res, retcode)
-        CHECK_REMOTE_CALL(feedData(dev->ll_dev, len, vals, &retcode), res, retcode)
-        CHECK_REMOTE_CALL(stopTraining(dev->ll_dev, &retcode), res, retcode)
-        if (class_idx < 0) {
-            class_idx = tags_trained_len;
-            tags_trained[tags_trained_len++] = (params->flags & GRC_PARAMS_ADD_NEW_TAG) ? class_idx : params->tag;
-        }
+    int res;
+    Retcode retcode;
+    struct Param param = { .kind = ReqCategory, .ival = class_idx };
+    CHECK_REMOTE_CALL(setNeededParameters(&ctx->protocol, &param, &retcode), res, retcode)
+    return GRC_OK;
+}
+
+static int run_async_inference(struct grc_device* dev, void* arg)
+{
+    struct async_call* call = (struct async_call*)arg;
+    return grc_inference(dev, &call->inference, call->vals, call->len);
+}
+
+static int submit_inference(struct grc_device* dev, struct grc_inference_params* params, const float* vals, uint32_t len)
+{
+    if (dev->ctx == NULL) {
+        return ARGUMENT_ERROR;
     }
-    return class_idx;
+    struct async_call* call = new_async_call(vals, len);
+    if (call == NULL) {
+        return GRC_NO_MEMORY;
+    }
+    call->inference = *params;
+    call->inference.flags &= ~GRC_PARAMS_ASYNC;
+    struct grc_async_job job = { .run = run_async_inference, .arg = call, .release = free, .callback = params->callback, .user_data = params->user_data };
+    return grc_async_submit(&dev->ctx->async, dev, &job);
 }
 
 int grc_inference(
@@ -211,44 +607,334 @@ int grc_inference(
     const float* vals,
     uint32_t len)
 {
-    int res;
+    if (params->flags & GRC_PARAMS_ASYNC) {
+        return submit_inference(dev, params, vals, len);
+    }
+    CHECK_DEVICE_CONTEXT(dev)
+    int res = set_required_class(dev->ctx, params);
+    if (res < 0) {
+        return res;
+    }
     Retcode retcode;
-    if (params->flags & GRC_PARAMS_SINGLE_CLASS) {
-        int class_idx = get_tag_idx(params->tag, 0);
-        if (class_idx < 0) {
-            return ARGUMENT_ERROR;
+    int class_idx;
+    // a window longer than one stream takes the sequence, which feeds it in parts
+    if ((dev->ctx->protocol.caps.flags & CAPABILITY_FUSED_INFERENCE) && (len <= dev->ctx->protocol.caps.maxArrayLen)) {
+        CHECK_REMOTE_CALL(inferWindow(&dev->ctx->protocol, len, vals, &class_idx, &retcode), res, retcode)
+    } else {
+        CHECK_REMOTE_CALL(startInference(&dev->ctx->protocol, &retcode), res, retcode)
+        CHECK_REMOTE_CALL(feedData(&dev->ctx->protocol, len, vals, &retcode), res, retcode)
+        CHECK_REMOTE_CALL(stopInference(&dev->ctx->protocol, &retcode), res, retcode)
+        CHECK_REMOTE_CALL(getStatus(&dev->ctx->protocol, &class_idx, &retcode), res, retcode)
+    }
+    return class_idx_to_tag(dev->ctx, class_idx);
+}
+
+// windows queued by GRC while the data of the next ones is sent. a window not delivered in SUBMIT_ATTEMPTS
+// submissions is put to deferred, grc_inference_batch classifies it after the queue is empty
+static int pipeline_inference(struct grc_device* dev, const float* const* windows, uint32_t len, uint32_t cnt,
+    int* results, uint32_t* deferred, uint32_t* deferred_cnt)
+{
+    struct ProtocolContext* protocol = &dev->ctx->protocol;
+    // submitted windows in submission order
+    struct {
+        uint8_t seq;
+        uint8_t attempts;
+        uint32_t window;
+    } queue[MAX_QUEUE_DEPTH];
+    int head = 0;
+    int queued = 0;
+    uint32_t next = 0;
+    uint32_t done = 0;
+    uint32_t poll_delay = PIPELINE_POLL_MIN_US;
+    uint64_t head_since_us = grc_transport_time_us(protocol->transport, protocol->ll_dev);
+    while (done + *deferred_cnt < cnt) {
+        // data of the next windows is sent while GRC computes the previous ones
+        while ((queued < protocol->caps.queueDepth) && (next < cnt)) {
+            int slot = (head + queued) % MAX_QUEUE_DEPTH;
+            queue[slot].window = next++;
+            queue[slot].attempts = 1;
+            int res = submitInference(protocol, len, windows[queue[slot].window], &queue[slot].seq);
+            if (res < 0) {
+                return res;
+            }
+            queued++;
+        }
+
+        int class_idx;
+        Retcode retcode;
+        int res = pollSubmitted(protocol, queue[head].seq, &class_idx, &retcode);
+        if (res < 0) {
+            return res;
+        }
+        uint64_t now_us = grc_transport_time_us(protocol->transport, protocol->ll_dev);
+        if (res == 0) {
+            // the oldest window waits for the functions queued before it only
+            if ((protocol->functionTimeoutMs != 0) && (now_us - head_since_us > (uint64_t)protocol->functionTimeoutMs * 1000)) {
+                return GRC_TIMEOUT;
+            }
+            grc_transport_sleep_us(protocol->transport, protocol->ll_dev, poll_delay);
+            poll_delay = (2 * poll_delay < PIPELINE_POLL_MAX_US) ? 2 * poll_delay : PIPELINE_POLL_MAX_US;
+            continue;
+        }
+        poll_delay = PIPELINE_POLL_MIN_US;
+        head_since_us = now_us;
+
+        if (retcode == NotDelivered) {
+            if (queue[head].attempts < SUBMIT_ATTEMPTS) {
+                // submitted again behind the other queued windows
+                protocol->stats.resendRounds++;
+                queue[head].attempts++;
+                res = submitInference(protocol, len, windows[queue[head].window], &queue[head].seq);
+                if (res < 0) {
+                    return res;
+                }
+                int tail = (head + queued) % MAX_QUEUE_DEPTH;
+                queue[tail] = queue[head];
+            } else {
+                // the per-window path resends only the blocks GRC missed
+                deferred[(*deferred_cnt)++] = queue[head].window;
+                queued--;
+            }
+            head = (head + 1) % MAX_QUEUE_DEPTH;
+            continue;
+        }
+        res = retcode_to_result(&retcode);
+        if (res < 0) {
+            return res;
+        }
+        res = class_idx_to_tag(dev->ctx, class_idx);
+        if ((res < 0) && (res != NOT_CLASSIFIED)) {
+            return res;
+        }
+        results[queue[head].window] = res;
+        head = (head + 1) % MAX_QUEUE_DEPTH;
+        queued--;
+        done++;
+    }
+    return GRC_OK;
+}
+
+int grc_inference_batch(
+    struct grc_device* dev,
+    struct grc_inference_params* params,
+    const float* const* windows,
+    uint32_t len,
+    uint32_t cnt,
+    int* results)
+{
+    CHECK_DEVICE_CONTEXT(dev)
+    struct ProtocolContext* protocol = &dev->ctx->protocol;
+    // windows longer than one stream are not queued, grc_inference feeds them in parts
+    if (!(protocol->caps.flags & CAPABILITY_PIPELINE) || (params->flags & GRC_PARAMS_SINGLE_CLASS)
+        || (len > protocol->caps.maxArrayLen)) {
+        for (uint32_t i = 0; i < cnt; i++) {
+            int res = grc_inference(dev, params, windows[i], len);
+            if ((res < 0) && (res != NOT_CLASSIFIED)) {
+                return res;
+            }
+            results[i] = res;
+        }
+        return cnt;
+    }
+
+    uint32_t* deferred = (uint32_t*)malloc(cnt * sizeof(uint32_t));
+    if ((deferred == NULL) && (cnt > 0)) {
+        return GRC_NO_MEMORY;
+    }
+    uint32_t deferred_cnt = 0;
+    int res = pipeline_inference(dev, windows, len, cnt, results, deferred, &deferred_cnt);
+    for (uint32_t i = 0; (i < deferred_cnt) && (res >= NOT_CLASSIFIED); i++) {
+        res = grc_inference(dev, params, windows[deferred[i]], len);
+        if (res >= NOT_CLASSIFIED) {
+            results[deferred[i]] = res;
         }
-        struct Param param = { .kind = ReqCategory, .ival = class_idx };
-        CHECK_REMOTE_CALL(setNeededParameters(dev->ll_dev, &param, &retcode), res, retcode)
     }
-    CHECK_REMOTE_CALL(startInference(dev->ll_dev, &retcode), res, retcode)
-    CHECK_REMOTE_CALL(feedData(dev->ll_dev, len, vals, &retcode), res, retcode)
-    CHECK_REMOTE_CALL(stopInference(dev->ll_dev, &retcode), res, retcode)
+    free(deferred);
+    return ((res < 0) && (res != NOT_CLASSIFIED)) ? res : (int)cnt;
+}
+
+int grc_stream_begin(struct grc_device* dev, const struct grc_stream_params* params)
+{
+    CHECK_DEVICE_CONTEXT(dev)
+    struct grc_context* ctx = dev->ctx;
+    struct inference_stream* stream = &ctx->stream;
+    if (stream->active || (params->window_len == 0) || (params->hop_len == 0) || (params->hop_len > params->window_len)) {
+        return ARGUMENT_ERROR;
+    }
+    if (params->inference.flags & GRC_PARAMS_ASYNC) {
+        return NOT_IMPLEMENTED;
+    }
+    float* ring = (float*)malloc(2 * params->window_len * sizeof(float));
+    if (ring == NULL) {
+        return GRC_NO_MEMORY;
+    }
+    // the first window is sent whole, so it has to fit into one stream
+    int hop_transfer = (ctx->protocol.caps.flags & CAPABILITY_SLIDING_WINDOW) && (params->window_len <= ctx->protocol.caps.maxArrayLen);
+    if (hop_transfer) {
+        Retcode retcode;
+        int res = setSlidingWindow(&ctx->protocol, params->window_len, &retcode);
+        if (res >= 0) {
+            res = retcode_to_result(&retcode);
+        }
+        if (res < 0) {
+            free(ring);
+            return res;
+        }
+    }
+    memset(stream, 0, sizeof(*stream));
+    stream->active = 1;
+    stream->params = *params;
+    stream->ring = ring;
+    stream->hop_transfer = hop_transfer;
+    return GRC_OK;
+}
+
+// every sample is written twice, window_len apart
+static void stream_append(struct inference_stream* stream, const float* vals, uint32_t len)
+{
+    uint32_t window_len = stream->params.window_len;
+    while (len > 0) {
+        uint32_t cnt = window_len - stream->pos;
+        cnt = len < cnt ? len : cnt;
+        memcpy(&stream->ring[stream->pos], vals, cnt * sizeof(float));
+        memcpy(&stream->ring[stream->pos + window_len], vals, cnt * sizeof(float));
+        stream->pos = (stream->pos + cnt) % window_len;
+        vals += cnt;
+        len -= cnt;
+    }
+}
+
+static int classify_stream_window(struct grc_device* dev)
+{
+    struct inference_stream* stream = &dev->ctx->stream;
+    uint32_t window_len = stream->params.window_len;
+    const float* window = &stream->ring[stream->pos];
+    if (!stream->hop_transfer) {
+        return grc_inference(dev, &stream->params.inference, window, window_len);
+    }
+    int res = set_required_class(dev->ctx, &stream->params.inference);
+    if (res < 0) {
+        return res;
+    }
+    // after a failed window GRC may have kept only a part of the samples, the window is sent whole
+    uint32_t len = (stream->synced && (stream->since_window < window_len)) ? stream->since_window : window_len;
+    stream->synced = 0;
     int class_idx;
-    CHECK_REMOTE_CALL(getStatus(dev->ll_dev, &class_idx, &retcode), res, retcode)
-    if (class_idx >= tags_trained_len) {
-        return WRONG_GRC_ANSWER;
+    Retcode retcode;
+    CHECK_REMOTE_CALL(inferHop(&dev->ctx->protocol, len, window + window_len - len, &class_idx, &retcode), res, retcode)
+    stream->synced = 1;
+    return class_idx_to_tag(dev->ctx, class_idx);
+}
+
+static void deliver_stream_result(struct inference_stream* stream, const struct grc_stream_result* result)
+{
+    if (stream->params.callback) {
+        stream->params.callback(result, stream->params.user_data);
+        return;
     }
-    if (class_idx < 0) {
-        return class_idx;
+    if (stream->queue_len == GRC_STREAM_QUEUE_LEN) {
+        stream->queue_head = (stream->queue_head + 1) % GRC_STREAM_QUEUE_LEN;
+        stream->queue_len--;
+    }
+    stream->queue[(stream->queue_head + stream->queue_len) % GRC_STREAM_QUEUE_LEN] = *result;
+    stream->queue_len++;
+}
+
+int grc_stream_push(struct grc_device* dev, const float* vals, uint32_t len)
+{
+    CHECK_DEVICE_CONTEXT(dev)
+    struct inference_stream* stream = &dev->ctx->stream;
+    if (!stream->active) {
+        return ARGUMENT_ERROR;
     }
-    return tags_trained[class_idx];
+    uint32_t window_len = stream->params.window_len;
+    int windows = 0;
+    while (len > 0) {
+        // samples up to the end of the next window
+        uint32_t cnt = (stream->filled < window_len) ? window_len - stream->filled : stream->params.hop_len - stream->since_window;
+        cnt = len < cnt ? len : cnt;
+        stream_append(stream, vals, cnt);
+        vals += cnt;
+        len -= cnt;
+        stream->pushed += cnt;
+        stream->since_window += cnt;
+        stream->filled = (stream->filled + cnt < window_len) ? stream->filled + cnt : window_len;
+        if ((stream->filled < window_len) || (stream->since_window < stream->params.hop_len)) {
+            continue;
+        }
+        int res = classify_stream_window(dev);
+        stream->since_window = 0;
+        if ((res < 0) && (res != NOT_CLASSIFIED)) {
+            return res;
+        }
+        struct grc_stream_result result = { .sample = stream->pushed, .result = res };
+        deliver_stream_result(stream, &result);
+        windows++;
+    }
+    return windows;
+}
+
+int grc_stream_read(struct grc_device* dev, struct grc_stream_result* results, uint32_t cnt)
+{
+    CHECK_DEVICE_CONTEXT(dev)
+    struct inference_stream* stream = &dev->ctx->stream;
+    if (!stream->active) {
+        return ARGUMENT_ERROR;
+    }
+    uint32_t taken = 0;
+    while ((taken < cnt) && (stream->queue_len > 0)) {
+        results[taken++] = stream->queue[stream->queue_head];
+        stream->queue_head = (stream->queue_head + 1) % GRC_STREAM_QUEUE_LEN;
+        stream->queue_len--;
+    }
+    return taken;
+}
+
+int grc_stream_end(struct grc_device* dev)
+{
+    CHECK_DEVICE_CONTEXT(dev)
+    struct inference_stream* stream = &dev->ctx->stream;
+    if (!stream->active) {
+        return ARGUMENT_ERROR;
+    }
+    free(stream->ring);
+    stream->ring = NULL;
+    stream->active = 0;
+    return GRC_OK;
+}
+
+int grc_submit(struct grc_device* dev, grc_function_t run, void* arg, grc_callback_t callback, void* user_data)
+{
+    if (dev->ctx == NULL) {
+        return ARGUMENT_ERROR;
+    }
+    struct grc_async_job job = { .run = run, .arg = arg, .release = NULL, .callback = callback, .user_data = user_data };
+    return grc_async_submit(&dev->ctx->async, dev, &job);
 }
 
 int grc_wait(struct grc_device* dev)
 {
-    return NOT_IMPLEMENTED;
+    return grc_wait_timeout(dev, -1);
+}
+
+int grc_wait_timeout(struct grc_device* dev, int timeout_ms)
+{
+    if (dev->ctx == NULL) {
+        return ARGUMENT_ERROR;
+    }
+    return grc_async_wait(&dev->ctx->async, timeout_ms);
 }
 
 int grc_get_classes_number(struct grc_device* dev)
 {
+    CHECK_DEVICE_CONTEXT(dev)
     int res;
     Retcode retcode;
     struct Param param = { .kind = AskExtStatus, .ival = CatsQty };
-    CHECK_REMOTE_CALL(setNeededParameters(dev->ll_dev, &param, &retcode), res, retcode)
+    CHECK_REMOTE_CALL(setNeededParameters(&dev->ctx->protocol, &param, &retcode), res, retcode)
 
     int class_numbers;
-    CHECK_REMOTE_CALL(getStatus(dev->ll_dev, &class_numbers, &retcode), res, retcode)
+    CHECK_REMOTE_CALL(getStatus(&dev->ctx->protocol, &class_numbers, &retcode), res, retcode)
     return class_numbers;
 }
 
@@ -277,29 +963,39 @@ int grc_clear_class_by_tag(
 
 int grc_download(struct grc_device* dev, struct grc_internal_state* states, uint32_t* len)
 {
+    CHECK_DEVICE_CONTEXT(dev)
     int res;
     Retcode retcode;
     int i = 0;
     struct Param param = { .kind = AskExtStatus, .ival = SaveDataLen };
 
-    CHECK_REMOTE_CALL(setNeededParameters(dev->ll_dev, &param, &retcode), res, retcode)
+    CHECK_REMOTE_CALL(setNeededParameters(&dev->ctx->protocol, &param, &retcode), res, retcode)
     int download_len = -1;
-    CHECK_REMOTE_CALL(getStatus(dev->ll_dev, &download_len, &retcode), res, retcode)
+    CHECK_REMOTE_CALL(getStatus(&dev->ctx->protocol, &download_len, &retcode), res, retcode)
     if (download_len < 0) {
         return -1;
     }
     typedef float dtype;
     states[i].len = download_len;
     states[i].values = (dtype*)malloc(states[i].len * sizeof(dtype));
+    if (states[i].values == NULL) {
+        return GRC_NO_MEMORY;
+    }
 
-    param.kind = AskExtStatus;
-    param.ival = NextDataElm;
-    CHECK_REMOTE_CALL(setNeededParameters(dev->ll_dev, &param, &retcode), res, retcode)
+    res = downloadData(&dev->ctx->protocol, download_len, states[i].values);
+    if (res == NOT_IMPLEMENTED) {
+        // old firmware gives the state one element per remote call
+        param.kind = AskExtStatus;
+        param.ival = NextDataElm;
+        CHECK_REMOTE_CALL(setNeededParameters(&dev->ctx->protocol, &param, &retcode), res, retcode)
 
-    int elm;
-    for (unsigned cnt = 0; cnt < download_len; ++cnt) {
-        CHECK_REMOTE_CALL(getStatus(dev->ll_dev, &(elm), &retcode), res, retcode)
-        memcpy(&(states[i].values[cnt]), &elm, sizeof(dtype));
+        int elm;
+        for (int cnt = 0; cnt < download_len; ++cnt) {
+            CHECK_REMOTE_CALL(getStatus(&dev->ctx->protocol, &(elm), &retcode), res, retcode)
+            memcpy(&(states[i].values[cnt]), &elm, sizeof(dtype));
+        }
+    } else if (res < 0) {
+        return res;
     }
     *len = 1;
 
@@ -308,17 +1004,26 @@ int grc_download(struct grc_device* dev, struct grc_internal_state* states, uint
 
 int grc_upload(struct grc_device* dev, struct grc_internal_state* states, uint32_t len)
 {
+    CHECK_DEVICE_CONTEXT(dev)
     int res;
     Retcode retcode;
     int j = 0;
-    for (unsigned i = 0; i < states[j].len; ++i) {
-        CHECK_REMOTE_CALL(feedDataSingle(dev->ll_dev, states[j].values[i], &retcode), res, retcode);
+    if (len > MAX_TAG_CNT) {
+        return ARGUMENT_ERROR;
+    }
+    if (dev->ctx->protocol.caps.flags & CAPABILITY_BULK_WRITE) {
+        CHECK_REMOTE_CALL(uploadData(&dev->ctx->protocol, states[j].len, states[j].values, &retcode), res, retcode)
+    } else {
+        // old firmware collects the state one element per remote call
+        for (unsigned i = 0; i < states[j].len; ++i) {
+            CHECK_REMOTE_CALL(feedDataSingle(&dev->ctx->protocol, states[j].values[i], &retcode), res, retcode);
+        }
     }
     struct Param param = { .kind = LoadTrainData, .ival = len };
-    CHECK_REMOTE_CALL(setNeededParameters(dev->ll_dev, &param, &retcode), res, retcode)
-    tags_trained_len = 0;
-    for (int i = 0; i < len; i++) {
-        tags_trained[tags_trained_len++] = i;
+    CHECK_REMOTE_CALL(setNeededParameters(&dev->ctx->protocol, &param, &retcode), res, retcode)
+    dev->ctx->tags_trained_len = 0;
+    for (uint32_t i = 0; i < len; i++) {
+        dev->ctx->tags_trained[dev->ctx->tags_trained_len++] = i;
     }
     return 0;
 }
@@ -333,22 +1038,47 @@ int grc_restore(struct grc_device* dev)
     return NOT_IMPLEMENTED;
 }
 
+int grc_get_stats(struct grc_device* dev, struct grc_stats* stats)
+{
+    CHECK_DEVICE_CONTEXT(dev)
+    struct ProtocolStats* protocol_stats = &dev->ctx->protocol.stats;
+    stats->blocks_resent = protocol_stats->blocksResent;
+    stats->resend_rounds = protocol_stats->resendRounds;
+    stats->blocks_reread = protocol_stats->blocksReread;
+    return GRC_OK;
+}
+
+int grc_reset_stats(struct grc_device* dev)
+{
+    CHECK_DEVICE_CONTEXT(dev)
+    memset(&dev->ctx->protocol.stats, 0, sizeof(dev->ctx->protocol.stats));
+    return GRC_OK;
+}
+
+int grc_set_function_timeout(struct grc_device* dev, uint32_t timeout_ms)
+{
+    CHECK_DEVICE_CONTEXT(dev)
+    dev->ctx->protocol.functionTimeoutMs = timeout_ms;
+    return GRC_OK;
+}
+
 int grc_device_reset(struct grc_device* dev)
 {
-    int res = grc_ll_gpio_init(dev->ll_dev);
+    const struct grc_transport_ops* transport = grc_transport_resolve(dev->transport);
+    int res = grc_transport_gpio_init(transport, dev->ll_dev);
     if (GRC_OK != res)
         return res;
 
-    res = grc_ll_gpio_reset_low(dev->ll_dev);
+    res = grc_transport_gpio_reset_low(transport, dev->ll_dev);
     if (GRC_OK != res)
         return res;
 
-    grc_ll_sleep(100);
+    grc_transport_sleep_us(transport, dev->ll_dev, 100 * 1000);
 
-    res = grc_ll_gpio_reset_high(dev->ll_dev);
+    res = grc_transport_gpio_reset_high(transport, dev->ll_dev);
     if (GRC_OK != res)
         return res;
 
-    grc_ll_sleep(1000);
+    grc_transport_sleep_us(transport, dev->ll_dev, 1000 * 1000);
     return res;
 }
@@ -1,5 +1,8 @@
 #include <stdio.h>
+#include <string.h>
 #include "grc/grc_error_codes.h"
+#include "grc/drivers/grc_transport.h"
+#include "grc/i2c/grc_ll_api.h"
 #include "grc/i2c/grc_ll_protocol_commands.h"
 
 #define FUNCTION_START_TRAINING_CMD 0x07
@@ -11,13 +14,34 @@
 #define FUNCTION_GET_STATUS_CMD 0x0d
 #define FUNCTION_CLEAR_CMD 0x0e
 #define FUNCTION_SET_NEEDED_PARAMS_CMD 0x0f
+#define FUNCTION_SET_PARAMS_BATCH_CMD 0x10 // CAPABILITY_BATCH_PARAMS
+#define FUNCTION_INFER_WINDOW_CMD 0x11 // CAPABILITY_FUSED_INFERENCE
+#define FUNCTION_SET_WINDOW_CMD 0x12 // CAPABILITY_SLIDING_WINDOW
+#define FUNCTION_INFER_HOP_CMD 0x13 // CAPABILITY_SLIDING_WINDOW
 
 #define FUNCTION_MIN FUNCTION_START_TRAINING_CMD
-#define FUNCTION_MAX FUNCTION_SET_NEEDED_PARAMS_CMD
+#define FUNCTION_MAX FUNCTION_INFER_HOP_CMD
 
-#define STATUS_BYTE_CNT 32
+#define STATUS_BYTE_CNT STREAMING_STATUS_SIZE
 
-static uint8_t streamingResult[STATUS_BYTE_CNT];
+// status is polled again if the data ready edge does not come in time
+#define READY_LINE_TIMEOUT_MS 100
+
+// stream resend attempts for undelivered blocks
+#define STREAM_RESEND_ATTEMPTS 3
+
+// GRC firmware reports optional protocol features since this version
+#define CAPABILITIES_MIN_SDK_VERSION 2
+// sequence numbered functions (protocol v2) since this version
+#define PIPELINE_MIN_SDK_VERSION 3
+// sliding window inference since this version
+#define SLIDING_WINDOW_MIN_SDK_VERSION 4
+
+// status polling interval without data ready line
+#define STATUS_POLL_MIN_US 100
+#define STATUS_POLL_MAX_US 2000
+// a function running longer is taken as a stalled module
+#define FUNCTION_TIMEOUT_MS 10000
 
 #define CHECK_TRANSPORT_RESULT(func, res) \
     res = func;                           \
@@ -25,10 +49,8 @@ static uint8_t streamingResult[STATUS_BYTE_CNT];
         return res;                       \
     }
 
-int __isExecutingAllowed(struct grc_ll_i2c_dev* grc)
+int __checkCurFunction(int curFunction)
 {
-    int curFunction;
-    CHECK_TRANSPORT_RESULT(getCurFunction(grc), curFunction)
     if (((curFunction > 0) && (curFunction < FUNCTION_MIN)) || (curFunction > FUNCTION_MAX)) {
         return WRONG_GRC_ANSWER;
     }
@@ -39,6 +61,13 @@ int __isExecutingAllowed(struct grc_ll_i2c_dev* grc)
     return GRC_OK;
 }
 
+int __isExecutingAllowed(struct ProtocolContext* grc)
+{
+    int curFunction;
+    CHECK_TRANSPORT_RESULT(getCurFunction(grc), curFunction)
+    return __checkCurFunction(curFunction);
+}
+
 int __checkSingleStatus(const uint8_t* status)
 {
     uint8_t packetStatus = status[31] & 1;
@@ -47,83 +76,134 @@ int __checkSingleStatus(const uint8_t* status)
 
 int __checkFloatArrayStatus(const uint8_t* status, uint8_t blockCnt)
 {
+    return countMissingBlocks(status, blockCnt) == 0 ? GRC_OK : DATA_NOT_DELIVERED;
+}
 
-    uint8_t packageNumber = 0;
-    for (uint8_t j = 0; j < STATUS_BYTE_CNT; j++) {
-        for (uint8_t i = 0; i < 8; i++) {
-
-            if (blockCnt <= packageNumber++) {
-                return GRC_OK;
-            }
-            // if block was not delivered
-            if (((status[STATUS_BYTE_CNT - j - 1] & 1 << i) >> i) == 0) {
-                return DATA_NOT_DELIVERED;
-            }
-        }
+// single block arguments are sent again as a whole stream if not delivered
+#define SEND_SINGLE_WITH_RESEND(grc, sendFunc, res)                                         \
+    CHECK_TRANSPORT_RESULT(sendFunc, res)                                                   \
+    CHECK_TRANSPORT_RESULT(getStreamResult(grc, grc->streamingResult), res)                 \
+    for (int attempt = 0; __checkSingleStatus(grc->streamingResult) != GRC_OK; attempt++) { \
+        if (attempt == STREAM_RESEND_ATTEMPTS) {                                            \
+            return DATA_NOT_DELIVERED;                                                      \
+        }                                                                                   \
+        grc->stats.resendRounds++;                                                          \
+        grc->stats.blocksResent++;                                                          \
+        CHECK_TRANSPORT_RESULT(sendFunc, res)                                               \
+        CHECK_TRANSPORT_RESULT(getStreamResult(grc, grc->streamingResult), res)             \
     }
-    return GRC_OK;
-}
 
-int __callStartTrainingFunction(struct grc_ll_i2c_dev* grc, int category)
+int __callIntArgumentFunction(struct ProtocolContext* grc, uint8_t functionCmd, int arg)
 {
     int res;
     CHECK_TRANSPORT_RESULT(__isExecutingAllowed(grc), res)
-    CHECK_TRANSPORT_RESULT(sendIntArguments(grc, category), res)
-    CHECK_TRANSPORT_RESULT(getStreamResult(grc, streamingResult), res)
-    // It was assumed that if some packages did not reach, they could be forwarded. but so far this possibility has not been realized
-    CHECK_TRANSPORT_RESULT(__checkSingleStatus(streamingResult), res)
-    return callFunction(grc, FUNCTION_START_TRAINING_CMD);
+    SEND_SINGLE_WITH_RESEND(grc, sendIntArguments(grc, arg), res)
+    return callFunction(grc, functionCmd);
 }
 
-int __callFeedDataSingleFunction(struct grc_ll_i2c_dev* grc, float arg)
+int __callFeedDataSingleFunction(struct ProtocolContext* grc, float arg)
 {
     int res;
     CHECK_TRANSPORT_RESULT(__isExecutingAllowed(grc), res)
-    CHECK_TRANSPORT_RESULT(sendFloatArguments(grc, arg), res)
-    CHECK_TRANSPORT_RESULT(getStreamResult(grc, streamingResult), res)
-    CHECK_TRANSPORT_RESULT(__checkSingleStatus(streamingResult), res)
+    SEND_SINGLE_WITH_RESEND(grc, sendFloatArguments(grc, arg), res)
     return callFunction(grc, FUNCTION_FEED_DATA_FLOAT_CMD);
 }
 
-int __callFeedDataFunction(struct grc_ll_i2c_dev* grc, unsigned len, const float* vals)
+int __callFloatArrayFunction(struct ProtocolContext* grc, uint8_t functionCmd, unsigned len, const float* vals)
 {
     int res;
     CHECK_TRANSPORT_RESULT(__isExecutingAllowed(grc), res)
 
     uint8_t blockCnt = 0;
     CHECK_TRANSPORT_RESULT(sendFloatArrayArguments(grc, len, vals, &blockCnt), res)
-    CHECK_TRANSPORT_RESULT(getStreamResult(grc, streamingResult), res)
-    CHECK_TRANSPORT_RESULT(__checkFloatArrayStatus(streamingResult, blockCnt), res)
-    return callFunction(grc, FUNCTION_FEED_DATA_FLOAT_ARRAY_CMD);
+    CHECK_TRANSPORT_RESULT(getStreamResult(grc, grc->streamingResult), res)
+    // only the blocks GRC did not receive are sent again
+    for (int attempt = 0; __checkFloatArrayStatus(grc->streamingResult, blockCnt) != GRC_OK; attempt++) {
+        if (attempt == STREAM_RESEND_ATTEMPTS) {
+            return DATA_NOT_DELIVERED;
+        }
+        grc->stats.resendRounds++;
+        CHECK_TRANSPORT_RESULT(resendFloatArrayBlocks(grc, len, vals, grc->streamingResult), res)
+        CHECK_TRANSPORT_RESULT(getStreamResult(grc, grc->streamingResult), res)
+    }
+    return callFunction(grc, functionCmd);
 }
 
-int __callFunctionWithoutArguments(struct grc_ll_i2c_dev* grc, uint8_t functionCmd)
+int __callFunctionWithoutArguments(struct ProtocolContext* grc, uint8_t functionCmd)
 {
     int res;
     CHECK_TRANSPORT_RESULT(__isExecutingAllowed(grc), res)
     return callFunction(grc, functionCmd);
 }
 
-int __callSetNeededParamsFunction(struct grc_ll_i2c_dev* grc, struct Param* param)
+int __callSetNeededParamsFunction(struct ProtocolContext* grc, struct Param* param)
 {
     int res;
     CHECK_TRANSPORT_RESULT(__isExecutingAllowed(grc), res)
-    CHECK_TRANSPORT_RESULT(sendParamArguments(grc, param), res)
-    CHECK_TRANSPORT_RESULT(getStreamResult(grc, streamingResult), res)
-    CHECK_TRANSPORT_RESULT(__checkSingleStatus(streamingResult), res)
+    SEND_SINGLE_WITH_RESEND(grc, sendParamArguments(grc, param), res)
     return callFunction(grc, FUNCTION_SET_NEEDED_PARAMS_CMD);
 }
 
-int __waitResultActive(struct grc_ll_i2c_dev* grc, uint8_t functionCmd, Retcode* retcode)
+int __callSetParamsBatchFunction(struct ProtocolContext* grc, unsigned cnt, const struct Param* params)
+{
+    int res;
+    CHECK_TRANSPORT_RESULT(__isExecutingAllowed(grc), res)
+
+    uint8_t blockCnt = 0;
+    CHECK_TRANSPORT_RESULT(sendParamArrayArguments(grc, cnt, params, &blockCnt), res)
+    CHECK_TRANSPORT_RESULT(getStreamResult(grc, grc->streamingResult), res)
+    // the stream is short, it is sent again as a whole
+    for (int attempt = 0; __checkFloatArrayStatus(grc->streamingResult, blockCnt) != GRC_OK; attempt++) {
+        if (attempt == STREAM_RESEND_ATTEMPTS) {
+            return DATA_NOT_DELIVERED;
+        }
+        grc->stats.resendRounds++;
+        grc->stats.blocksResent += blockCnt;
+        CHECK_TRANSPORT_RESULT(sendParamArrayArguments(grc, cnt, params, &blockCnt), res)
+        CHECK_TRANSPORT_RESULT(getStreamResult(grc, grc->streamingResult), res)
+    }
+    return callFunction(grc, FUNCTION_SET_PARAMS_BATCH_CMD);
+}
+
+static int __functionTimedOut(struct ProtocolContext* grc, uint64_t calledUs)
+{
+    uint64_t nowUs = grc_transport_time_us(grc->transport, grc->ll_dev);
+    return (grc->functionTimeoutMs != 0) && (nowUs - calledUs > (uint64_t)grc->functionTimeoutMs * 1000);
+}
+
+// result - one byte result reported with the status, NULL for functions without it
+int __waitResultWithStatus(struct ProtocolContext* grc, uint8_t functionCmd, Retcode* retcode, int* result)
 {
     struct FunctionExecutionStatus status;
     *retcode = NotCalled;
+    int useReadyLine = 1;
+    uint32_t pollDelay = STATUS_POLL_MIN_US;
+    uint64_t startUs = grc_transport_time_us(grc->transport, grc->ll_dev);
     while (1) {
         int res;
-        CHECK_TRANSPORT_RESULT(getFunctionStatus(grc, functionCmd, &status), res)
+        if (useReadyLine) {
+            // status is still read after the edge: the edge may be left from the previous function
+            res = grc_transport_wait_ready(grc->transport, grc->ll_dev, READY_LINE_TIMEOUT_MS);
+            if (res == NOT_IMPLEMENTED) {
+                useReadyLine = 0;
+            } else if ((res < 0) && (res != GRC_TIMEOUT)) {
+                return res;
+            }
+        }
+        if (result) {
+            CHECK_TRANSPORT_RESULT(getFunctionStatusWithResult(grc, functionCmd, &status, result), res)
+        } else {
+            CHECK_TRANSPORT_RESULT(getFunctionStatus(grc, functionCmd, &status), res)
+        }
 
         if (status.isRunning || status.isCalled) {
-            grc_ll_sleep(2);
+            if (__functionTimedOut(grc, startUs)) {
+                return GRC_TIMEOUT;
+            }
+            if (!useReadyLine) {
+                grc_transport_sleep_us(grc->transport, grc->ll_dev, pollDelay);
+                pollDelay = (2 * pollDelay < STATUS_POLL_MAX_US) ? 2 * pollDelay : STATUS_POLL_MAX_US;
+            }
         } else {
             *retcode = status.retcode;
             break;
@@ -132,17 +212,77 @@ int __waitResultActive(struct grc_ll_i2c_dev* grc, uint8_t functionCmd, Retcode*
     return GRC_OK;
 }
 
-int initProtocolLayer(struct grc_ll_i2c_dev* grc)
+int __waitResultActive(struct ProtocolContext* grc, uint8_t functionCmd, Retcode* retcode)
+{
+    return __waitResultWithStatus(grc, functionCmd, retcode, NULL);
+}
+
+// reads the version and the capabilities of the module on the opened transport
+static int __readModuleInfo(struct ProtocolContext* grc)
 {
-    int res = grc_ll_i2c_init(grc);
+    int res;
+    int version = getCurGRCVersion(grc);
+    if (version < 0) {
+        return version;
+    }
+    grc->caps.flags = 0;
+    grc->caps.readBlockSize = 0;
+    grc->caps.maxArrayLen = getMaxFloatArrayLen(grc);
+    grc->caps.queueDepth = 0;
+    grc->nextSeq = 1;
+    grc->functionTimeoutMs = FUNCTION_TIMEOUT_MS;
+    if (version >= CAPABILITIES_MIN_SDK_VERSION) {
+        CHECK_TRANSPORT_RESULT(getCapabilities(grc), res)
+    }
+    if (version < PIPELINE_MIN_SDK_VERSION) {
+        grc->caps.flags &= ~CAPABILITY_PIPELINE;
+    }
+    if (version < SLIDING_WINDOW_MIN_SDK_VERSION) {
+        grc->caps.flags &= ~CAPABILITY_SLIDING_WINDOW;
+    }
+    return version;
+}
+
+int initProtocolLayer(struct ProtocolContext* grc, const struct grc_transport_ops* transport, void* ll_dev)
+{
+    grc->transport = transport;
+    grc->ll_dev = ll_dev;
+    grc->outBuffLen = 0;
+    int res = initProtocolCommands(grc);
+    if (res < 0) {
+        return res;
+    }
+    int version = __readModuleInfo(grc);
+    if (version < 0) {
+        // the transport is not left open for a module that could not be read
+        releaseProtocolLayer(grc);
+    }
+    return version;
+}
+
+int initBusScan(struct ProtocolContext* grc, const struct grc_transport_ops* transport, void* ll_dev)
+{
+    grc->transport = transport;
+    grc->ll_dev = ll_dev;
+    grc->outBuffLen = 0;
+    return attachProtocolCommands(grc);
+}
+
+int probeAddress(struct ProtocolContext* grc, uint16_t addr, int* version)
+{
+    int res = grc_transport_set_address(grc->transport, grc->ll_dev, addr);
     if (res < 0) {
         return res;
     }
-    res = getCurGRCVersion(grc);
-    return res;
+    res = readGRCVersion(grc, version);
+    // nothing acknowledges the address, or nothing drives the bus for the reply
+    if ((res == I2C_NACK) || (res == WRONG_GRC_ANSWER)) {
+        return 0;
+    }
+    return res < 0 ? res : 1;
 }
 
-int setNeededParameters(struct grc_ll_i2c_dev* grc, struct Param* param, Retcode* retcode)
+int setNeededParameters(struct ProtocolContext* grc, struct Param* param, Retcode* retcode)
 {
     *retcode = NotCalled;
     int res;
@@ -150,15 +290,43 @@ int setNeededParameters(struct grc_ll_i2c_dev* grc, struct Param* param, Retcode
     return __waitResultActive(grc, FUNCTION_SET_NEEDED_PARAMS_CMD, retcode);
 }
 
-int startTraining(struct grc_ll_i2c_dev* grc, int category, Retcode* retcode)
+int setParameters(struct ProtocolContext* grc, unsigned cnt, const struct Param* params, unsigned* applied, Retcode* retcode)
+{
+    *retcode = NotCalled;
+    *applied = 0;
+    if (!(grc->caps.flags & CAPABILITY_BATCH_PARAMS)) {
+        return NOT_IMPLEMENTED;
+    }
+    for (unsigned offset = 0; offset < cnt; offset += MAX_PARAM_BATCH) {
+        unsigned batch = (cnt - offset < MAX_PARAM_BATCH) ? cnt - offset : MAX_PARAM_BATCH;
+        int res;
+        CHECK_TRANSPORT_RESULT(__callSetParamsBatchFunction(grc, batch, params + offset), res)
+        CHECK_TRANSPORT_RESULT(__waitResultActive(grc, FUNCTION_SET_PARAMS_BATCH_CMD, retcode), res)
+        if (*retcode == Ok) {
+            *applied += batch;
+            continue;
+        }
+        // GRC stops at the first failed entry and returns the number of applied ones
+        int batchApplied;
+        CHECK_TRANSPORT_RESULT(getFunctionResult(grc, FUNCTION_SET_PARAMS_BATCH_CMD, &batchApplied), res)
+        if ((batchApplied < 0) || ((unsigned)batchApplied >= batch)) {
+            return WRONG_GRC_ANSWER;
+        }
+        *applied += (unsigned)batchApplied;
+        break;
+    }
+    return GRC_OK;
+}
+
+int startTraining(struct ProtocolContext* grc, int category, Retcode* retcode)
 {
     *retcode = NotCalled;
     int res;
-    CHECK_TRANSPORT_RESULT(__callStartTrainingFunction(grc, category), res)
+    CHECK_TRANSPORT_RESULT(__callIntArgumentFunction(grc, FUNCTION_START_TRAINING_CMD, category), res)
     return __waitResultActive(grc, FUNCTION_START_TRAINING_CMD, retcode);
 }
 
-int stopTraining(struct grc_ll_i2c_dev* grc, Retcode* retcode)
+int stopTraining(struct ProtocolContext* grc, Retcode* retcode)
 {
     *retcode = NotCalled;
     int res;
@@ -166,7 +334,7 @@ int stopTraining(struct grc_ll_i2c_dev* grc, Retcode* retcode)
     return __waitResultActive(grc, FUNCTION_STOP_TRAINING_CMD, retcode);
 }
 
-int startInference(struct grc_ll_i2c_dev* grc, Retcode* retcode)
+int startInference(struct ProtocolContext* grc, Retcode* retcode)
 {
     *retcode = NotCalled;
     int res;
@@ -174,7 +342,7 @@ int startInference(struct grc_ll_i2c_dev* grc, Retcode* retcode)
     return __waitResultActive(grc, FUNCTION_START_INFERENCE_CMD, retcode);
 }
 
-int stopInference(struct grc_ll_i2c_dev* grc, Retcode* retcode)
+int stopInference(struct ProtocolContext* grc, Retcode* retcode)
 {
     *retcode = NotCalled;
     int res;
@@ -182,7 +350,7 @@ int stopInference(struct grc_ll_i2c_dev* grc, Retcode* retcode)
     return __waitResultActive(grc, FUNCTION_STOP_INFERENCE_CMD, retcode);
 }
 
-int feedDataSingle(struct grc_ll_i2c_dev* grc, float val, Retcode* retcode)
+int feedDataSingle(struct ProtocolContext* grc, float val, Retcode* retcode)
 {
     *retcode = NotCalled;
     int res;
@@ -190,15 +358,98 @@ int feedDataSingle(struct grc_ll_i2c_dev* grc, float val, Retcode* retcode)
     return __waitResultActive(grc, FUNCTION_FEED_DATA_FLOAT_CMD, retcode);
 }
 
-int feedData(struct grc_ll_i2c_dev* grc, unsigned len, const float* vals, Retcode* retcode)
+int feedData(struct ProtocolContext* grc, unsigned len, const float* vals, Retcode* retcode)
+{
+    *retcode = NotCalled;
+    unsigned offset = 0;
+    do {
+        unsigned cnt = (len - offset < grc->caps.maxArrayLen) ? len - offset : grc->caps.maxArrayLen;
+        int res;
+        CHECK_TRANSPORT_RESULT(__callFloatArrayFunction(grc, FUNCTION_FEED_DATA_FLOAT_ARRAY_CMD, cnt, vals + offset), res)
+        CHECK_TRANSPORT_RESULT(__waitResultActive(grc, FUNCTION_FEED_DATA_FLOAT_ARRAY_CMD, retcode), res)
+        offset += cnt;
+    } while ((offset < len) && (*retcode == Ok));
+    return GRC_OK;
+}
+
+// a window longer than one stream is fed in parts between start and stop inference
+static int __inferWindowSequence(struct ProtocolContext* grc, unsigned len, const float* vals, int* category, Retcode* retcode)
+{
+    int res = startInference(grc, retcode);
+    if ((res < 0) || (*retcode != Ok)) {
+        return res;
+    }
+    res = feedData(grc, len, vals, retcode);
+    if ((res < 0) || (*retcode != Ok)) {
+        return res;
+    }
+    res = stopInference(grc, retcode);
+    if ((res < 0) || (*retcode != Ok)) {
+        return res;
+    }
+    return getStatus(grc, category, retcode);
+}
+
+int inferWindow(struct ProtocolContext* grc, unsigned len, const float* vals, int* category, Retcode* retcode)
+{
+    *retcode = NotCalled;
+    if (!(grc->caps.flags & CAPABILITY_FUSED_INFERENCE)) {
+        return NOT_IMPLEMENTED;
+    }
+    if (len > grc->caps.maxArrayLen) {
+        return __inferWindowSequence(grc, len, vals, category, retcode);
+    }
+    int res;
+    CHECK_TRANSPORT_RESULT(__callFloatArrayFunction(grc, FUNCTION_INFER_WINDOW_CMD, len, vals), res)
+    return __waitResultWithStatus(grc, FUNCTION_INFER_WINDOW_CMD, retcode, category);
+}
+
+int setSlidingWindow(struct ProtocolContext* grc, unsigned len, Retcode* retcode)
+{
+    *retcode = NotCalled;
+    if (!(grc->caps.flags & CAPABILITY_SLIDING_WINDOW)) {
+        return NOT_IMPLEMENTED;
+    }
+    int res;
+    CHECK_TRANSPORT_RESULT(__callIntArgumentFunction(grc, FUNCTION_SET_WINDOW_CMD, len), res)
+    return __waitResultActive(grc, FUNCTION_SET_WINDOW_CMD, retcode);
+}
+
+int inferHop(struct ProtocolContext* grc, unsigned len, const float* vals, int* category, Retcode* retcode)
 {
     *retcode = NotCalled;
+    if (!(grc->caps.flags & CAPABILITY_SLIDING_WINDOW)) {
+        return NOT_IMPLEMENTED;
+    }
     int res;
-    CHECK_TRANSPORT_RESULT(__callFeedDataFunction(grc, len, vals), res)
-    return __waitResultActive(grc, FUNCTION_FEED_DATA_FLOAT_ARRAY_CMD, retcode);
+    CHECK_TRANSPORT_RESULT(__callFloatArrayFunction(grc, FUNCTION_INFER_HOP_CMD, len, vals), res)
+    return __waitResultWithStatus(grc, FUNCTION_INFER_HOP_CMD, retcode, category);
+}
+
+int submitInference(struct ProtocolContext* grc, unsigned len, const float* vals, uint8_t* seq)
+{
+    if (!(grc->caps.flags & CAPABILITY_PIPELINE)) {
+        return NOT_IMPLEMENTED;
+    }
+    // 0 is never used, a reply to it would not be told from a reset GRC
+    *seq = grc->nextSeq;
+    grc->nextSeq = (grc->nextSeq == 0xff) ? 1 : grc->nextSeq + 1;
+    return submitFloatArrayFunction(grc, *seq, FUNCTION_INFER_WINDOW_CMD, len, vals);
+}
+
+int pollSubmitted(struct ProtocolContext* grc, uint8_t seq, int* result, Retcode* retcode)
+{
+    struct FunctionExecutionStatus status;
+    int res;
+    CHECK_TRANSPORT_RESULT(getSubmittedResult(grc, seq, &status, result), res)
+    if (status.isRunning || status.isCalled) {
+        return 0;
+    }
+    *retcode = status.retcode;
+    return 1;
 }
 
-int getStatus(struct grc_ll_i2c_dev* grc, int* pstat, Retcode* retcode)
+int getStatus(struct ProtocolContext* grc, int* pstat, Retcode* retcode)
 {
     *retcode = NotCalled;
     int res;
@@ -207,7 +458,37 @@ int getStatus(struct grc_ll_i2c_dev* grc, int* pstat, Retcode* retcode)
     return getFunctionResult(grc, FUNCTION_GET_STATUS_CMD, pstat);
 }
 
-int clear(struct grc_ll_i2c_dev* grc, Retcode* retcode)
+int downloadData(struct ProtocolContext* grc, unsigned len, float* vals)
+{
+    if (!(grc->caps.flags & CAPABILITY_BULK_READ)) {
+        return NOT_IMPLEMENTED;
+    }
+    unsigned valuesInBlock = (grc->caps.readBlockSize - 4) / sizeof(float);
+    for (unsigned offset = 0; offset < len; offset += valuesInBlock) {
+        unsigned cnt = (len - offset < valuesInBlock) ? len - offset : valuesInBlock;
+        int res = readFloatArrayBlock(grc, offset, vals + offset, cnt);
+        // corrupted block is read again
+        for (int attempt = 0; (res == WRONG_GRC_ANSWER) && (attempt < STREAM_RESEND_ATTEMPTS); attempt++) {
+            grc->stats.blocksReread++;
+            res = readFloatArrayBlock(grc, offset, vals + offset, cnt);
+        }
+        if (res < 0) {
+            return res;
+        }
+    }
+    return GRC_OK;
+}
+
+int uploadData(struct ProtocolContext* grc, unsigned len, const float* vals, Retcode* retcode)
+{
+    *retcode = NotCalled;
+    if (!(grc->caps.flags & CAPABILITY_BULK_WRITE)) {
+        return NOT_IMPLEMENTED;
+    }
+    return feedData(grc, len, vals, retcode);
+}
+
+int clear(struct ProtocolContext* grc, Retcode* retcode)
 {
     *retcode = NotCalled;
     int res;
@@ -215,7 +496,187 @@ int clear(struct grc_ll_i2c_dev* grc, Retcode* retcode)
     return __waitResultActive(grc, FUNCTION_CLEAR_CMD, retcode);
 }
 
-int releaseProtocolLayer(struct grc_ll_i2c_dev* grc)
+// ================ REMOTE CALL STATE MACHINE ====================
+
+static void __prepareRemoteCall(struct RemoteCall* call, uint8_t functionCmd, RemoteArgs args)
+{
+    memset(call, 0, sizeof(*call));
+    call->functionCmd = functionCmd;
+    call->args = args;
+}
+
+int prepareInferWindow(struct ProtocolContext* grc, struct RemoteCall* call, unsigned len, const float* vals)
+{
+    if (!(grc->caps.flags & CAPABILITY_FUSED_INFERENCE)) {
+        return NOT_IMPLEMENTED;
+    }
+    if ((len == 0) || (len > grc->caps.maxArrayLen)) {
+        return ARGUMENT_ERROR;
+    }
+    __prepareRemoteCall(call, FUNCTION_INFER_WINDOW_CMD, RemoteArgsFloatArray);
+    call->len = len;
+    call->vals = vals;
+    call->withResult = 1;
+    return GRC_OK;
+}
+
+void prepareStartInference(struct RemoteCall* call)
+{
+    __prepareRemoteCall(call, FUNCTION_START_INFERENCE_CMD, RemoteArgsNone);
+}
+
+void prepareStopInference(struct RemoteCall* call)
+{
+    __prepareRemoteCall(call, FUNCTION_STOP_INFERENCE_CMD, RemoteArgsNone);
+}
+
+int prepareFeedData(struct ProtocolContext* grc, struct RemoteCall* call, unsigned len, const float* vals)
+{
+    if ((len == 0) || (len > grc->caps.maxArrayLen)) {
+        return ARGUMENT_ERROR;
+    }
+    __prepareRemoteCall(call, FUNCTION_FEED_DATA_FLOAT_ARRAY_CMD, RemoteArgsFloatArray);
+    call->len = len;
+    call->vals = vals;
+    return GRC_OK;
+}
+
+void prepareGetStatus(struct RemoteCall* call)
+{
+    __prepareRemoteCall(call, FUNCTION_GET_STATUS_CMD, RemoteArgsNone);
+    call->readResult = 1;
+}
+
+static int __requestCallReply(struct ProtocolContext* grc, struct RemoteCall* call, RemoteCallState state, ReplyKind kind, uint32_t* waitUs)
+{
+    int res;
+    CHECK_TRANSPORT_RESULT(requestReply(grc, kind, call->functionCmd), res)
+    call->state = state;
+    *waitUs = res;
+    return 0;
+}
+
+static int __requestCallStatus(struct ProtocolContext* grc, struct RemoteCall* call, uint32_t* waitUs)
+{
+    return __requestCallReply(grc, call, RemoteCallStatus,
+        call->withResult ? ReplyFunctionStatusWithResult : ReplyFunctionStatus, waitUs);
+}
+
+static int __callRemoteFunction(struct ProtocolContext* grc, struct RemoteCall* call, uint32_t* waitUs)
+{
+    int res;
+    CHECK_TRANSPORT_RESULT(callFunction(grc, call->functionCmd), res)
+    call->calledUs = grc_transport_time_us(grc->transport, grc->ll_dev);
+    if (call->readyLine) {
+        call->state = RemoteCallWaitDone;
+        *waitUs = READY_LINE_TIMEOUT_MS * 1000;
+        return 0;
+    }
+    return __requestCallStatus(grc, call, waitUs);
+}
+
+static int __sendCallArguments(struct ProtocolContext* grc, struct RemoteCall* call, uint32_t* waitUs)
+{
+    if (call->args == RemoteArgsNone) {
+        return __callRemoteFunction(grc, call, waitUs);
+    }
+    int res;
+    CHECK_TRANSPORT_RESULT(sendFloatArrayArguments(grc, call->len, call->vals, &call->blockCnt), res)
+    return __requestCallReply(grc, call, RemoteCallStreamResult, ReplyStreamResult, waitUs);
+}
+
+// stream delivery status is read: only the blocks GRC did not receive are sent again
+static int __onStreamResult(struct ProtocolContext* grc, struct RemoteCall* call, uint32_t* waitUs)
+{
+    int res;
+    memcpy(grc->streamingResult, grc->inBuff, STATUS_BYTE_CNT);
+    if (__checkFloatArrayStatus(grc->streamingResult, call->blockCnt) == GRC_OK) {
+        return __callRemoteFunction(grc, call, waitUs);
+    }
+    if (call->attempts++ == STREAM_RESEND_ATTEMPTS) {
+        return DATA_NOT_DELIVERED;
+    }
+    grc->stats.resendRounds++;
+    CHECK_TRANSPORT_RESULT(resendFloatArrayBlocks(grc, call->len, call->vals, grc->streamingResult), res)
+    return __requestCallReply(grc, call, RemoteCallStreamResult, ReplyStreamResult, waitUs);
+}
+
+static int __onFunctionStatus(struct ProtocolContext* grc, struct RemoteCall* call, uint32_t* waitUs)
+{
+    struct FunctionExecutionStatus status;
+    parseFunctionStatusReply(grc, &status, call->withResult ? &call->result : NULL);
+    if (status.isRunning || status.isCalled) {
+        if (__functionTimedOut(grc, call->calledUs)) {
+            return GRC_TIMEOUT;
+        }
+        call->state = RemoteCallWaitDone;
+        if (call->readyLine) {
+            *waitUs = READY_LINE_TIMEOUT_MS * 1000;
+        } else {
+            *waitUs = call->pollDelayUs;
+            call->pollDelayUs = (2 * call->pollDelayUs < STATUS_POLL_MAX_US) ? 2 * call->pollDelayUs : STATUS_POLL_MAX_US;
+        }
+        return 0;
+    }
+    call->retcode = status.retcode;
+    if (call->readResult) {
+        return __requestCallReply(grc, call, RemoteCallResult, ReplyFunctionResult, waitUs);
+    }
+    call->state = RemoteCallDone;
+    return 1;
+}
+
+// the caller waits next, transactions queued by the transport must be on the bus by then
+static int __flushRemoteCall(struct ProtocolContext* grc, int res)
+{
+    int flushed = grc_transport_flush(grc->transport, grc->ll_dev);
+    return (res >= 0) && (flushed < 0) ? flushed : res;
+}
+
+int startRemoteCall(struct ProtocolContext* grc, struct RemoteCall* call, uint32_t* waitUs)
+{
+    call->retcode = NotCalled;
+    call->attempts = 0;
+    call->pollDelayUs = STATUS_POLL_MIN_US;
+    return __flushRemoteCall(grc, __requestCallReply(grc, call, RemoteCallBusyCheck, ReplyCurFunction, waitUs));
+}
+
+static int __stepRemoteCall(struct ProtocolContext* grc, struct RemoteCall* call, uint32_t* waitUs)
+{
+    int res;
+    switch (call->state) {
+    case RemoteCallBusyCheck:
+        CHECK_TRANSPORT_RESULT(pollReply(grc, ReplyCurFunction, waitUs), res)
+        if (res == 0) {
+            return 0;
+        }
+        CHECK_TRANSPORT_RESULT(__checkCurFunction(grc->inBuff[0]), res)
+        return __sendCallArguments(grc, call, waitUs);
+    case RemoteCallStreamResult:
+        CHECK_TRANSPORT_RESULT(pollReply(grc, ReplyStreamResult, waitUs), res)
+        return res == 0 ? 0 : __onStreamResult(grc, call, waitUs);
+    case RemoteCallWaitDone:
+        // status is read after the edge too: the edge may be left from the previous function
+        return __requestCallStatus(grc, call, waitUs);
+    case RemoteCallStatus:
+        CHECK_TRANSPORT_RESULT(pollReply(grc, call->withResult ? ReplyFunctionStatusWithResult : ReplyFunctionStatus, waitUs), res)
+        return res == 0 ? 0 : __onFunctionStatus(grc, call, waitUs);
+    case RemoteCallResult:
+        CHECK_TRANSPORT_RESULT(pollReply(grc, ReplyFunctionResult, waitUs), res)
+        call->result = parseFunctionResultReply(grc);
+        call->state = RemoteCallDone;
+        return 1;
+    default:
+        return 1;
+    }
+}
+
+int stepRemoteCall(struct ProtocolContext* grc, struct RemoteCall* call, uint32_t* waitUs)
+{
+    return __flushRemoteCall(grc, __stepRemoteCall(grc, call, waitUs));
+}
+
+int releaseProtocolLayer(struct ProtocolContext* grc)
 {
-    return grc_ll_i2c_release(grc);
+    return grc_transport_release(grc->transport, grc->ll_dev);
 }
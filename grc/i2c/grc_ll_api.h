@@ -8,26 +8,193 @@
 extern "C" {
 #endif // __cplusplus
 
-int initProtocolLayer(struct grc_ll_i2c_dev* grc);
+/*!
+ * \brief open the transport and read the version and capabilities of the module
+ * \return SDK version of the module (>= 0) or error code (<0), the transport is released again then
+ */
+int initProtocolLayer(struct ProtocolContext* grc, const struct grc_transport_ops* transport, void* ll_dev);
 
-int setNeededParameters(struct grc_ll_i2c_dev* grc, struct Param* param, Retcode* retcode);
+/*!
+ * \brief prepare probeAddress on a transport device opened by the caller, it is neither opened nor released
+ */
+int initBusScan(struct ProtocolContext* grc, const struct grc_transport_ops* transport, void* ll_dev);
 
-int startTraining(struct grc_ll_i2c_dev* grc, int category, Retcode* retcode);
+/*!
+ * \brief switch the transport to the address and ask the device there for its SDK version
+ * \return 1 - a device replied with version, 0 - no device replies, or transport error code (<0)
+ */
+int probeAddress(struct ProtocolContext* grc, uint16_t addr, int* version);
 
-int stopTraining(struct grc_ll_i2c_dev* grc, Retcode* retcode);
+int setNeededParameters(struct ProtocolContext* grc, struct Param* param, Retcode* retcode);
 
-int startInference(struct grc_ll_i2c_dev* grc, Retcode* retcode);
+/*!
+ * \brief apply cnt parameters in order, one remote call per MAX_PARAM_BATCH entries.
+ *        GRC stops at the first failed entry, its retcode is put to retcode
+ * \param applied number of entries applied before the failed one
+ * \return Ok(=0), NOT_IMPLEMENTED if GRC firmware does not support batched parameters, or error code (<0)
+ */
+int setParameters(struct ProtocolContext* grc, unsigned cnt, const struct Param* params, unsigned* applied, Retcode* retcode);
 
-int stopInference(struct grc_ll_i2c_dev* grc, Retcode* retcode);
+int startTraining(struct ProtocolContext* grc, int category, Retcode* retcode);
 
-int feedDataSingle(struct grc_ll_i2c_dev* grc, float val, Retcode* retcode);
-int feedData(struct grc_ll_i2c_dev* grc, unsigned len, const float* vals, Retcode* retcode);
+int stopTraining(struct ProtocolContext* grc, Retcode* retcode);
 
-int getStatus(struct grc_ll_i2c_dev* grc, int* pstat, Retcode* retcode);
+int startInference(struct ProtocolContext* grc, Retcode* retcode);
 
-int clear(struct grc_ll_i2c_dev* grc, Retcode* retcode);
+int stopInference(struct ProtocolContext* grc, Retcode* retcode);
 
-int releaseProtocolLayer(struct grc_ll_i2c_dev* grc);
+int feedDataSingle(struct ProtocolContext* grc, float val, Retcode* retcode);
+/*!
+ * \brief feed len floats in streams of up to caps.maxArrayLen floats, stops at the first stream GRC rejects
+ */
+int feedData(struct ProtocolContext* grc, unsigned len, const float* vals, Retcode* retcode);
+
+int getStatus(struct ProtocolContext* grc, int* pstat, Retcode* retcode);
+
+/*!
+ * \brief classify the window with one remote call: start inference, feed data, stop inference and get status.
+ *        windows longer than caps.maxArrayLen are classified with the separate remote calls
+ * \param category class index or NOT_CLASSIFIED
+ * \return Ok(=0), NOT_IMPLEMENTED if GRC firmware does not support fused inference, or error code (<0)
+ */
+int inferWindow(struct ProtocolContext* grc, unsigned len, const float* vals, int* category, Retcode* retcode);
+
+/*!
+ * \brief set the window length of the sliding window inference, GRC drops the samples it keeps
+ * \return Ok(=0), NOT_IMPLEMENTED if GRC firmware does not support sliding window inference, or error code (<0)
+ */
+int setSlidingWindow(struct ProtocolContext* grc, unsigned len, Retcode* retcode);
+
+/*!
+ * \brief append len new samples to the window GRC keeps and classify the last window with one remote call.
+ *        GRC answers InvalDataLen until it has got a whole window after setSlidingWindow
+ * \param category class index or NOT_CLASSIFIED
+ * \return Ok(=0), NOT_IMPLEMENTED if GRC firmware does not support sliding window inference, or error code (<0)
+ */
+int inferHop(struct ProtocolContext* grc, unsigned len, const float* vals, int* category, Retcode* retcode);
+
+/*!
+ * \brief queue classification of the window without waiting for GRC to finish the previous ones.
+ *        no more than caps.queueDepth windows may be waiting for the result
+ * \param seq sequence number to get the result with pollSubmitted
+ * \return Ok(=0), NOT_IMPLEMENTED if GRC firmware does not support pipelining, or error code (<0)
+ */
+int submitInference(struct ProtocolContext* grc, unsigned len, const float* vals, uint8_t* seq);
+
+/*!
+ * \brief check the submitted function
+ * \param result class index for submitInference, valid when retcode is Ok
+ * \param retcode NotDelivered if the arguments were corrupted on the bus, the function is to be submitted again
+ * \return 1 - finished, retcode and result are set, 0 - still queued or running, or error code (<0)
+ */
+int pollSubmitted(struct ProtocolContext* grc, uint8_t seq, int* result, Retcode* retcode);
+
+/*!
+ * \brief read len floats of the AI SW state in CRC protected blocks
+ * \return Ok(=0), NOT_IMPLEMENTED if GRC firmware does not support bulk read, or error code (<0)
+ */
+int downloadData(struct ProtocolContext* grc, unsigned len, float* vals);
+
+/*!
+ * \brief feed len floats of the AI SW state as feedData does.
+ *        the state is applied by LoadTrainData after the upload
+ * \return Ok(=0), NOT_IMPLEMENTED if GRC firmware does not support bulk write, or error code (<0)
+ */
+int uploadData(struct ProtocolContext* grc, unsigned len, const float* vals, Retcode* retcode);
+
+int clear(struct ProtocolContext* grc, Retcode* retcode);
+
+/*!
+ * \brief arguments sent before the remote call
+ */
+typedef enum {
+    RemoteArgsNone,
+    RemoteArgsFloatArray
+} RemoteArgs;
+
+/*!
+ * \brief step the remote call waits for
+ */
+typedef enum {
+    RemoteCallBusyCheck, // current function reply
+    RemoteCallStreamResult, // delivery status of the arguments
+    RemoteCallWaitDone, // the function runs, the data ready edge or the poll delay is waited for
+    RemoteCallStatus, // function status reply
+    RemoteCallResult, // function result reply
+    RemoteCallDone
+} RemoteCallState;
+
+/*!
+ * \brief remote function called without blocking on GRC: the bus transactions are made by startRemoteCall
+ *        and stepRemoteCall, the waits between them are left to the caller (an event loop).
+ *        set up with one of the prepare functions
+ * \param functionCmd function called
+ * \param args, len, vals arguments sent before the call. vals stay valid until the call is finished
+ * \param withResult 1 - one byte result is read with the status
+ * \param readResult 1 - function result is read after the status
+ * \param readyLine 1 - the caller wakes stepRemoteCall on the data ready edge in RemoteCallWaitDone,
+ *        0 - the status is polled. set by the caller after the prepare function
+ * \param state step the call waits for
+ * \param blockCnt, attempts, pollDelayUs, calledUs progress of the call
+ * \param retcode GRC return code of the finished function
+ * \param result result read with the status or after it
+ */
+struct RemoteCall {
+    uint8_t functionCmd;
+    RemoteArgs args;
+    unsigned len;
+    const float* vals;
+    uint8_t withResult;
+    uint8_t readResult;
+    uint8_t readyLine;
+    RemoteCallState state;
+    uint8_t blockCnt;
+    uint8_t attempts;
+    uint32_t pollDelayUs;
+    uint64_t calledUs;
+    Retcode retcode;
+    int result;
+};
+
+/*!
+ * \brief fused inference of the window, see inferWindow. result is the class index or NOT_CLASSIFIED
+ * \return Ok(=0), NOT_IMPLEMENTED if GRC firmware does not support fused inference,
+ *         ARGUMENT_ERROR if len is 0 or more than caps.maxArrayLen
+ */
+int prepareInferWindow(struct ProtocolContext* grc, struct RemoteCall* call, unsigned len, const float* vals);
+
+void prepareStartInference(struct RemoteCall* call);
+
+void prepareStopInference(struct RemoteCall* call);
+
+/*!
+ * \brief feed a single stream of floats
+ * \return Ok(=0) or ARGUMENT_ERROR if len is 0 or more than caps.maxArrayLen
+ */
+int prepareFeedData(struct ProtocolContext* grc, struct RemoteCall* call, unsigned len, const float* vals);
+
+/*!
+ * \brief get status, result is the status of the AI SW
+ */
+void prepareGetStatus(struct RemoteCall* call);
+
+/*!
+ * \brief start the prepared call: request the current function of GRC
+ * \param waitUs time to wait before stepRemoteCall
+ * \return 0 or error code (<0)
+ */
+int startRemoteCall(struct ProtocolContext* grc, struct RemoteCall* call, uint32_t* waitUs);
+
+/*!
+ * \brief make the next bus transactions of the call
+ * \param waitUs time to wait before the next stepRemoteCall, in RemoteCallWaitDone with readyLine
+ *        it is cut short by the data ready edge
+ * \return 1 - finished, retcode and result are set, 0 - wait, GRC_IS_BUSY if GRC runs another function,
+ *         GRC_TIMEOUT if the function runs longer than functionTimeoutMs, or error code (<0)
+ */
+int stepRemoteCall(struct ProtocolContext* grc, struct RemoteCall* call, uint32_t* waitUs);
+
+int releaseProtocolLayer(struct ProtocolContext* grc);
 
 #ifdef __cplusplus
 }
@@ -1,19 +1,26 @@
-#include <math.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "grc/grc_error_codes.h"
 #include "grc/i2c/crc_calculation.h"
 #include "grc/i2c/grc_ll_protocol_commands.h"
-#include "grc/drivers/grc_ll_driver.h"
+#include "grc/drivers/grc_transport.h"
 
 
-#define BUFFER_SIZE 256
+#define BUFFER_SIZE PROTOCOL_BUFFER_SIZE
 #define SIMPLE_COMMAND_RESULT_SIZE 1
+#define STATUS_WITH_RESULT_SIZE 2
 #define STREAMING_RESULT_SIZE 32
 #define ACTIVATE_STREAMING_COMMAND_SIZE 3
+#define CAPABILITIES_RESULT_SIZE 4
+#define SUBMIT_COMMAND_SIZE 5
+#define SUBMITTED_RESULT_SIZE 6
 
 #define PACKAGE_HEADER_BYTE 3
 #define MAX_VALUE_CNT_FOR_PACKAGE 62
+#define MAX_BLOCK_SIZE 255
+// shortest link transaction the protocol works with, the streaming result is read at once
+#define MIN_MTU STREAMING_RESULT_SIZE
 
 #define NO_COMMAND 0x00
 
@@ -24,59 +31,172 @@
 #define GET_FUNCTION_STATUS_CMD 0x05
 #define GET_FUNCTION_RESULT_CMD 0x06
 #define GET_SDK_VERSION_CMD 0x07
+#define GET_CAPABILITIES_CMD 0x08
+#define READ_STREAMING_CMD 0x09
+#define SUBMIT_FUNCTION_CMD 0x0a
+#define GET_SUBMITTED_RESULT_CMD 0x0b
 
-static uint8_t inBuff[BUFFER_SIZE];
-static uint8_t outBuff[BUFFER_SIZE];
-static uint16_t outBuffLen = 0;
+// protocol features implemented by this SDK
+#define SUPPORTED_CAPABILITIES \
+    (CAPABILITY_BULK_READ | CAPABILITY_BULK_WRITE | CAPABILITY_BATCH_PARAMS | CAPABILITY_FUSED_INFERENCE | CAPABILITY_PIPELINE \
+        | CAPABILITY_SLIDING_WINDOW)
+#define MAX_BLOCK_CNT 255
+// smallest block carrying one float
+#define MIN_READ_BLOCK_SIZE 8
 
+// reply timing
+#define REPLY_INITIAL_WAIT_US 100
+#define REPLY_INITIAL_WORST_US 1000
+// replies which can not be told from the idle bus are read once, never sooner than this
+#define REPLY_UNCHECKED_MIN_US REPLY_INITIAL_WORST_US
+#define REPLY_MIN_WAIT_US 20
+#define REPLY_MAX_BACKOFF_US 1000
+#define REPLY_TIMEOUT_US 20000
+// replies expected this soon are read with their command in one transaction: a repeated start, the read address
+// and the first reply byte take about as long at 400 kHz
+#define COMBINED_READ_MAX_WAIT_US 50
+
+#if defined(__GNUC__)
+#define BIT_SCAN_FORWARD(x) __builtin_ctzll(x)
+#define POPULATION_COUNT(x) __builtin_popcountll(x)
+#else
+static int BIT_SCAN_FORWARD(uint64_t x)
+{
+    int i = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        i++;
+    }
+    return i;
+}
+static int POPULATION_COUNT(uint64_t x)
+{
+    int cnt = 0;
+    for (; x; x &= x - 1) {
+        cnt++;
+    }
+    return cnt;
+}
+#endif
+
+// byte order of the wire format
 #define IS_LITTLE_ENDIAN 1
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) && defined(__ORDER_BIG_ENDIAN__)
+#define HOST_IS_LITTLE_ENDIAN (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define HOST_IS_BIG_ENDIAN (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#elif defined(_MSC_VER)
+#define HOST_IS_LITTLE_ENDIAN 1
+#define HOST_IS_BIG_ENDIAN 0
+#else
+#define HOST_IS_LITTLE_ENDIAN 0
+#define HOST_IS_BIG_ENDIAN 0
+#endif
+// host values are copied to the wire as is or byte swapped, hosts of unknown byte order serialize byte by byte
+#define HOST_MATCHES_WIRE (IS_LITTLE_ENDIAN ? HOST_IS_LITTLE_ENDIAN : HOST_IS_BIG_ENDIAN)
+#define HOST_SWAPS_WIRE (IS_LITTLE_ENDIAN ? HOST_IS_BIG_ENDIAN : HOST_IS_LITTLE_ENDIAN)
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BYTE_SWAP_32(x) __builtin_bswap32(x)
+#elif defined(_MSC_VER)
+#include <stdlib.h>
+#define BYTE_SWAP_32(x) _byteswap_ulong(x)
+#else
+#define BYTE_SWAP_32(x) ((((x) & 0xff) << 24) | (((x) & 0xff00) << 8) | (((x) >> 8) & 0xff00) | ((x) >> 24))
+#endif
 #define INT_SIZE 4
 #define FLOAT_SIZE 4
+#define PARAM_SIZE (INT_SIZE + 1)
 
 // =============== PUT SIMPLE VALUES =====================
-void __putValue(uint32_t value)
+static void __encodeValue(uint8_t* dest, uint32_t value)
 {
-    uint32_t intTemplate = 0xff;
+#if HOST_MATCHES_WIRE
+    memcpy(dest, &value, INT_SIZE);
+#elif HOST_SWAPS_WIRE
+    value = BYTE_SWAP_32(value);
+    memcpy(dest, &value, INT_SIZE);
+#else
     for (uint8_t i = 0; i < INT_SIZE; i++) {
         uint8_t idx = IS_LITTLE_ENDIAN == 1 ? i : INT_SIZE - i - 1;
-        outBuff[outBuffLen + idx] = (value & (intTemplate << (i * 8))) >> (i * 8);
+        dest[idx] = (value >> (i * 8)) & 0xff;
     }
-    outBuffLen = outBuffLen + INT_SIZE;
+#endif
 }
-void __putByte(uint8_t value)
+
+void __putValue(struct ProtocolContext* ctx, uint32_t value)
+{
+    __encodeValue(&ctx->outBuff[ctx->outBuffLen], value);
+    ctx->outBuffLen = ctx->outBuffLen + INT_SIZE;
+}
+void __putByte(struct ProtocolContext* ctx, uint8_t value)
+{
+    ctx->outBuff[ctx->outBuffLen++] = value;
+}
+
+void __putInt(struct ProtocolContext* ctx, int value)
 {
-    outBuff[outBuffLen++] = value;
+    uint32_t val;
+    memcpy(&val, &value, INT_SIZE);
+    __putValue(ctx, val);
 }
 
-void __putInt(int value)
+void __putFloat(struct ProtocolContext* ctx, float value)
 {
-    uint32_t val = *(uint32_t*)&value;
-    __putValue(val);
+    uint32_t val;
+    memcpy(&val, &value, FLOAT_SIZE);
+    __putValue(ctx, val);
 }
 
-void __putFloat(float value)
+// puts cnt floats with one copy when the host byte order is the wire one
+void __putFloats(struct ProtocolContext* ctx, const float* vals, unsigned cnt)
 {
-    uint32_t val = *(uint32_t*)((void*)&value);
-    __putValue(val);
+#if HOST_MATCHES_WIRE
+    memcpy(&ctx->outBuff[ctx->outBuffLen], vals, cnt * FLOAT_SIZE);
+    ctx->outBuffLen = ctx->outBuffLen + cnt * FLOAT_SIZE;
+#else
+    for (unsigned i = 0; i < cnt; i++) {
+        __putFloat(ctx, vals[i]);
+    }
+#endif
 }
 
 uint32_t getValue(const uint8_t* source)
 {
     uint32_t val = 0;
+#if HOST_MATCHES_WIRE
+    memcpy(&val, source, INT_SIZE);
+#elif HOST_SWAPS_WIRE
+    memcpy(&val, source, INT_SIZE);
+    val = BYTE_SWAP_32(val);
+#else
     for (uint8_t i = 0; i < INT_SIZE; i++) {
         uint8_t idx = IS_LITTLE_ENDIAN ? i : INT_SIZE - i - 1;
-        val = (source[idx] << 8 * i) ^ val;
+        val |= (uint32_t)source[idx] << (8 * i);
     }
+#endif
     return val;
 }
 
 int getInt(uint8_t* source)
 {
     uint32_t val = getValue(source);
-    int result = *((int*)&val);
+    int result;
+    memcpy(&result, &val, INT_SIZE);
     return result;
 }
 
+void getFloats(const uint8_t* source, float* vals, unsigned cnt)
+{
+#if HOST_MATCHES_WIRE
+    memcpy(vals, source, cnt * FLOAT_SIZE);
+#else
+    for (unsigned i = 0; i < cnt; i++) {
+        uint32_t val = getValue(&source[i * FLOAT_SIZE]);
+        memcpy(&vals[i], &val, FLOAT_SIZE);
+    }
+#endif
+}
+
 // ============== PUT COMMANDS ===========================
 
 // fills the buffer to send a simple command
@@ -84,13 +204,13 @@ int getInt(uint8_t* source)
 // (all except ACTIVATE_STREAMING_CMD)
 // cmd - command code
 // func -  function code, required for CALL_FUNCTION_CMD, GET_FUNCTION_STATUS_CMD, GET_FUNCTION_RESULT_CMD. in other case should be 0
-int __putSimpleCommand(uint8_t cmd, uint8_t func)
+int __putSimpleCommand(struct ProtocolContext* ctx, uint8_t cmd, uint8_t func)
 {
-    outBuffLen = 0;
-    outBuff[outBuffLen++] = cmd;
+    ctx->outBuffLen = 0;
+    ctx->outBuff[ctx->outBuffLen++] = cmd;
     if ((cmd == CALL_FUNCTION_CMD) || (cmd == GET_FUNCTION_STATUS_CMD) || (cmd == GET_FUNCTION_RESULT_CMD)) {
         if (func > 0) {
-            outBuff[outBuffLen++] = func;
+            ctx->outBuff[ctx->outBuffLen++] = func;
         } else {
             return ARGUMENT_ERROR;
         }
@@ -102,276 +222,864 @@ int __putSimpleCommand(uint8_t cmd, uint8_t func)
     return GRC_OK;
 }
 
-void __putActivateStreamingCommand(uint8_t blockSize, uint8_t blockCnt)
+void __putActivateStreamingCommand(struct ProtocolContext* ctx, uint8_t blockSize, uint8_t blockCnt)
 {
-    outBuffLen = 0;
-    outBuff[outBuffLen++] = ACTIVATE_STREAMING_CMD; // streaming activatiin command
-    outBuff[outBuffLen++] = blockSize; // including: 0xff 0xfe <data bytes> crc8.
-    outBuff[outBuffLen++] = blockCnt;
+    ctx->outBuffLen = 0;
+    ctx->outBuff[ctx->outBuffLen++] = ACTIVATE_STREAMING_CMD; // streaming activatiin command
+    ctx->outBuff[ctx->outBuffLen++] = blockSize; // including: 0xff 0xfe <data bytes> crc8.
+    ctx->outBuff[ctx->outBuffLen++] = blockCnt;
 }
 
-int __putIntAsBlock(int arg)
+int __putIntAsBlock(struct ProtocolContext* ctx, int arg)
 {
-    if (outBuffLen + 8 < 256) {
-        outBuff[outBuffLen++] = 0xff;
-        outBuff[outBuffLen++] = 0xfe;
-        uint8_t dataStart = outBuffLen;
-        outBuff[outBuffLen++] = 1;
-        __putInt(arg);
-        outBuff[outBuffLen++] = Crc8(&outBuff[dataStart], INT_SIZE + 1);
+    if (ctx->outBuffLen + 8 < 256) {
+        ctx->outBuff[ctx->outBuffLen++] = 0xff;
+        ctx->outBuff[ctx->outBuffLen++] = 0xfe;
+        uint8_t dataStart = ctx->outBuffLen;
+        ctx->outBuff[ctx->outBuffLen++] = 1;
+        __putInt(ctx, arg);
+        ctx->outBuff[ctx->outBuffLen++] = Crc8(&ctx->outBuff[dataStart], INT_SIZE + 1);
         return GRC_OK;
     }
     return ARGUMENT_ERROR;
 }
 
-int __putParamAsBlock(struct Param* arg)
+int __putParamAsBlock(struct ProtocolContext* ctx, struct Param* arg)
 {
-    if (outBuffLen + INT_SIZE + 4 < 256) {
-        outBuff[outBuffLen++] = 0xff;
-        outBuff[outBuffLen++] = 0xfe;
-        uint8_t dataStart = outBuffLen;
-        outBuff[outBuffLen++] = 1;
-        __putByte(arg->kind);
-        __putInt(arg->ival);
-        outBuff[outBuffLen++] = Crc8(&outBuff[dataStart], INT_SIZE + 1 + 1);
+    if (ctx->outBuffLen + INT_SIZE + 4 < 256) {
+        ctx->outBuff[ctx->outBuffLen++] = 0xff;
+        ctx->outBuff[ctx->outBuffLen++] = 0xfe;
+        uint8_t dataStart = ctx->outBuffLen;
+        ctx->outBuff[ctx->outBuffLen++] = 1;
+        __putByte(ctx, arg->kind);
+        __putInt(ctx, arg->ival);
+        ctx->outBuff[ctx->outBuffLen++] = Crc8(&ctx->outBuff[dataStart], INT_SIZE + 1 + 1);
         return GRC_OK;
     }
     return ARGUMENT_ERROR;
 }
 
-int __putFloatAsBlock(float arg)
+int __putFloatAsBlock(struct ProtocolContext* ctx, float arg)
 {
-    if (outBuffLen + 8 < 256) {
-        outBuff[outBuffLen++] = 0xff;
-        outBuff[outBuffLen++] = 0xfe;
-        uint8_t dataStart = outBuffLen;
-        outBuff[outBuffLen++] = 1;
-        __putFloat(arg);
-        outBuff[outBuffLen++] = Crc8(&outBuff[dataStart], INT_SIZE + 1);
+    if (ctx->outBuffLen + 8 < 256) {
+        ctx->outBuff[ctx->outBuffLen++] = 0xff;
+        ctx->outBuff[ctx->outBuffLen++] = 0xfe;
+        uint8_t dataStart = ctx->outBuffLen;
+        ctx->outBuff[ctx->outBuffLen++] = 1;
+        __putFloat(ctx, arg);
+        ctx->outBuff[ctx->outBuffLen++] = Crc8(&ctx->outBuff[dataStart], INT_SIZE + 1);
         return GRC_OK;
     }
     return ARGUMENT_ERROR;
 }
 
-int __putFloatArrayAsBlock(unsigned len, const float* vals, uint8_t blockNumber, uint8_t blockSize)
+int __putFloatArrayAsBlock(struct ProtocolContext* ctx, unsigned len, const float* vals, uint8_t blockNumber, uint8_t blockSize)
 {
-    if (outBuffLen + blockSize >= 256) {
+    if (ctx->outBuffLen + blockSize > BUFFER_SIZE) {
         return ARGUMENT_ERROR;
     }
     uint8_t valuesSavedInBlock = 0;
     uint32_t totalValuesSaved = 0; // how many values from the array were added to the previous blocks
 
     uint8_t valuesInBlock = (blockSize - 4) / FLOAT_SIZE;
-    outBuff[outBuffLen++] = 0xff;
-    outBuff[outBuffLen++] = 0xfe;
-    uint8_t dataStart = outBuffLen;
-    outBuff[outBuffLen++] = blockNumber;
+    ctx->outBuff[ctx->outBuffLen++] = 0xff;
+    ctx->outBuff[ctx->outBuffLen++] = 0xfe;
+    uint8_t dataStart = ctx->outBuffLen;
+    ctx->outBuff[ctx->outBuffLen++] = blockNumber;
     if (blockNumber == 1) {
-        __putInt(len);
+        __putInt(ctx, len);
         valuesSavedInBlock++;
     } else {
         totalValuesSaved = (blockNumber - 1) * valuesInBlock - 1;
     }
-    // while the block is not filled and there are not added values in the array
-    while ((valuesSavedInBlock < valuesInBlock) && (totalValuesSaved < len)) {
-        __putFloat(vals[totalValuesSaved++]);
-        valuesSavedInBlock++;
+    // values of the array that fit into the block
+    if (totalValuesSaved < len) {
+        unsigned cnt = valuesInBlock - valuesSavedInBlock;
+        cnt = (len - totalValuesSaved < cnt) ? len - totalValuesSaved : cnt;
+        __putFloats(ctx, &vals[totalValuesSaved], cnt);
+        valuesSavedInBlock += cnt;
     }
     // fill remaining with zeros
-    while (valuesSavedInBlock < valuesInBlock) {
-        __putFloat(0);
-        valuesSavedInBlock++;
+    memset(&ctx->outBuff[ctx->outBuffLen], 0, (valuesInBlock - valuesSavedInBlock) * FLOAT_SIZE);
+    ctx->outBuffLen = ctx->outBuffLen + (valuesInBlock - valuesSavedInBlock) * FLOAT_SIZE;
+    valuesSavedInBlock = valuesInBlock;
+    ctx->outBuff[ctx->outBuffLen++] = Crc8(&ctx->outBuff[dataStart], FLOAT_SIZE * valuesSavedInBlock + 1);
+    return GRC_OK;
+}
+
+// puts part of data as block blockNumber, the rest of the block is filled with zeros
+int __putBytesAsBlock(struct ProtocolContext* ctx, const uint8_t* data, unsigned len, uint8_t blockNumber, uint8_t blockSize)
+{
+    if (ctx->outBuffLen + blockSize > BUFFER_SIZE) {
+        return ARGUMENT_ERROR;
+    }
+    uint8_t payloadSize = blockSize - 4;
+    unsigned start = (blockNumber - 1) * payloadSize;
+    ctx->outBuff[ctx->outBuffLen++] = 0xff;
+    ctx->outBuff[ctx->outBuffLen++] = 0xfe;
+    uint8_t dataStart = ctx->outBuffLen;
+    ctx->outBuff[ctx->outBuffLen++] = blockNumber;
+    for (uint8_t i = 0; i < payloadSize; i++) {
+        __putByte(ctx, start + i < len ? data[start + i] : 0);
+    }
+    ctx->outBuff[ctx->outBuffLen++] = Crc8(&ctx->outBuff[dataStart], payloadSize + 1);
+    return GRC_OK;
+}
+
+void __resetBuffer(struct ProtocolContext* ctx)
+{
+    ctx->outBuffLen = 0;
+    ctx->fragmentCnt = 0;
+    ctx->fragmentStart = 0;
+    ctx->fragmentsLen = 0;
+    ctx->fragmentBlocks = 0;
+}
+
+// =============== SCATTER-GATHER WRITE ===========================
+// header, payload and padding fragments of a block, the crc joins the header of the next block
+#define FRAGMENTS_PER_BLOCK 3
+
+static const float zeroPadding[MAX_VALUE_CNT_FOR_PACKAGE] = { 0 };
+
+// bytes put in outBuff since the last fragment become a fragment
+static void __closeBufferFragment(struct ProtocolContext* ctx)
+{
+    if (ctx->outBuffLen > ctx->fragmentStart) {
+        struct grc_ll_iovec* fragment = &ctx->fragments[ctx->fragmentCnt++];
+        fragment->data = &ctx->outBuff[ctx->fragmentStart];
+        fragment->len = ctx->outBuffLen - ctx->fragmentStart;
+        ctx->fragmentsLen += fragment->len;
+        ctx->fragmentStart = ctx->outBuffLen;
+    }
+}
+
+static void __putDataFragment(struct ProtocolContext* ctx, const void* data, int len)
+{
+    __closeBufferFragment(ctx);
+    struct grc_ll_iovec* fragment = &ctx->fragments[ctx->fragmentCnt++];
+    fragment->data = data;
+    fragment->len = len;
+    ctx->fragmentsLen += len;
+}
+
+static int __pendingWriteLen(struct ProtocolContext* ctx)
+{
+    return ctx->fragmentsLen + ctx->outBuffLen - ctx->fragmentStart;
+}
+
+static int __flushFragments(struct ProtocolContext* ctx)
+{
+    __closeBufferFragment(ctx);
+    int res = GRC_OK;
+    if (ctx->fragmentsLen > 0) {
+        res = grc_transport_writev(ctx->transport, ctx->ll_dev, ctx->fragments, ctx->fragmentCnt);
+    }
+    __resetBuffer(ctx);
+    return res < 0 ? res : GRC_OK;
+}
+
+// sends the pending write if the next block does not fit into it
+static int __reserveBlock(struct ProtocolContext* ctx, uint8_t blockSize)
+{
+    if ((ctx->mtu - __pendingWriteLen(ctx) < blockSize) || (ctx->fragmentBlocks == MAX_BLOCKS_PER_WRITE)) {
+        return __flushFragments(ctx);
     }
-    outBuff[outBuffLen++] = Crc8(&outBuff[dataStart], FLOAT_SIZE * valuesSavedInBlock + 1);
     return GRC_OK;
 }
 
-void __resetBuffer()
+// adds block blockNumber of the float array to the pending write, payload floats are referenced, not copied
+int __putFloatArrayBlockFragments(struct ProtocolContext* ctx, unsigned len, const float* vals, uint8_t blockNumber, uint8_t blockSize)
 {
-    outBuffLen = 0;
+    if ((__pendingWriteLen(ctx) + blockSize > ctx->mtu) || (ctx->fragmentBlocks == MAX_BLOCKS_PER_WRITE)) {
+        return ARGUMENT_ERROR;
+    }
+    ctx->fragmentBlocks++;
+#if HOST_MATCHES_WIRE
+    uint8_t valuesInBlock = (blockSize - 4) / FLOAT_SIZE;
+    uint8_t valuesSavedInBlock = 0;
+    uint32_t first = (blockNumber - 1) * valuesInBlock - 1; // first array value in the block
+    __putByte(ctx, 0xff);
+    __putByte(ctx, 0xfe);
+    uint16_t dataStart = ctx->outBuffLen;
+    __putByte(ctx, blockNumber);
+    if (blockNumber == 1) {
+        __putInt(ctx, len);
+        valuesSavedInBlock++;
+        first = 0;
+    }
+    uint8_t crc = Crc8Update(CRC8_INIT, &ctx->outBuff[dataStart], ctx->outBuffLen - dataStart);
+    uint8_t cnt = 0;
+    if (first < len) {
+        uint32_t room = (uint32_t)(valuesInBlock - valuesSavedInBlock);
+        cnt = (uint8_t)((len - first < room) ? len - first : room);
+        __putDataFragment(ctx, &vals[first], cnt * FLOAT_SIZE);
+        crc = Crc8Update(crc, (const uint8_t*)&vals[first], cnt * FLOAT_SIZE);
+        valuesSavedInBlock += cnt;
+    }
+    if (valuesSavedInBlock < valuesInBlock) {
+        uint8_t padding = (valuesInBlock - valuesSavedInBlock) * FLOAT_SIZE;
+        __putDataFragment(ctx, zeroPadding, padding);
+        crc = Crc8Update(crc, (const uint8_t*)zeroPadding, padding);
+    }
+    __putByte(ctx, crc);
+    return GRC_OK;
+#else
+    return __putFloatArrayAsBlock(ctx, len, vals, blockNumber, blockSize);
+#endif
 }
 // =============== COMMUNICATION HELPERS ===========================
-int __writeSimpleCommand(void* ll_dev, uint8_t cmd, uint8_t func)
+int __writeSimpleCommand(struct ProtocolContext* ctx, uint8_t cmd, uint8_t func)
 {
-    int res = __putSimpleCommand(cmd, func);
+    int res = __putSimpleCommand(ctx, cmd, func);
     if (res < 0) {
         return res;
     }
-    res = grc_ll_i2c_write(ll_dev, outBuff, outBuffLen);
+    res = grc_transport_write(ctx->transport, ctx->ll_dev, ctx->outBuff, ctx->outBuffLen);
     if (res < 0) {
         return res;
     }
     return GRC_OK;
 }
 
+// GRC does not drive the bus until the reply is prepared, so the master reads the idle level
+int __isBusIdle(const uint8_t* reply, int len)
+{
+    for (int i = 0; i < len; i++) {
+        if (reply[i] != 0xff) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void __calibrateResponse(struct ResponseTiming* timing, uint32_t elapsedUs, int firstAttempt)
+{
+    if (firstAttempt) {
+        // reply was ready in time, probe a shorter wait
+        timing->expectedUs -= timing->expectedUs / 8;
+        if (timing->expectedUs < REPLY_MIN_WAIT_US) {
+            timing->expectedUs = REPLY_MIN_WAIT_US;
+        }
+    } else {
+        timing->expectedUs = (3 * timing->expectedUs + elapsedUs) / 4;
+    }
+    // the worst time decays towards twice the expected one, but not below the floor of unchecked replies:
+    // a fast reply says little about a late one, which would be taken as a valid value
+    uint32_t floorUs = (2 * timing->expectedUs > REPLY_UNCHECKED_MIN_US) ? 2 * timing->expectedUs : REPLY_UNCHECKED_MIN_US;
+    if (elapsedUs > timing->worstUs) {
+        timing->worstUs = elapsedUs;
+    } else if (timing->worstUs > floorUs) {
+        timing->worstUs -= (timing->worstUs - floorUs) / 16;
+    }
+}
+
+// starts waiting for the reply to the command written last, returns the time to the first read
+// checkable - reply filled with 0xff is not valid, it is read again with exponential backoff until it is ready.
+//             otherwise the reply is read once after the worst observed reply time
+uint32_t __startReply(struct ProtocolContext* ctx, int checkable)
+{
+    struct ResponseTiming* timing = &ctx->timing;
+    ctx->pending.startUs = grc_transport_time_us(ctx->transport, ctx->ll_dev);
+    ctx->pending.attempts = 0;
+    ctx->pending.backoffUs = timing->expectedUs / 2;
+    if (ctx->pending.backoffUs < REPLY_MIN_WAIT_US) {
+        ctx->pending.backoffUs = REPLY_MIN_WAIT_US;
+    }
+    return checkable ? timing->expectedUs : timing->worstUs;
+}
+
+// reply read by the last transaction: 1 - it is valid, 0 - GRC has not prepared it, read again after retryUs
+static int __acceptReply(struct ProtocolContext* ctx, const uint8_t* reply, int len, int checkable, uint32_t elapsed, uint32_t* retryUs)
+{
+    struct PendingReply* pending = &ctx->pending;
+    if (!checkable) {
+        return 1;
+    }
+    if (!__isBusIdle(reply, len)) {
+        __calibrateResponse(&ctx->timing, elapsed, pending->attempts == 0);
+        return 1;
+    }
+    if (elapsed > REPLY_TIMEOUT_US) {
+        return WRONG_GRC_ANSWER;
+    }
+    pending->attempts++;
+    *retryUs = pending->backoffUs;
+    pending->backoffUs = (2 * pending->backoffUs < REPLY_MAX_BACKOFF_US) ? 2 * pending->backoffUs : REPLY_MAX_BACKOFF_US;
+    return 0;
+}
+
+// one read of the reply: 1 - reply is read, 0 - GRC has not prepared it, read again after retryUs
+int __readReplyOnce(struct ProtocolContext* ctx, uint8_t* reply, int len, int checkable, uint32_t* retryUs)
+{
+    uint32_t elapsed = (uint32_t)(grc_transport_time_us(ctx->transport, ctx->ll_dev) - ctx->pending.startUs);
+    int res = grc_transport_read(ctx->transport, ctx->ll_dev, reply, len);
+    if (res < 0) {
+        return res;
+    }
+    return __acceptReply(ctx, reply, len, checkable, elapsed, retryUs);
+}
+
+// polled replies told from the idle bus: current function and function status. an early reply is read again,
+// the function result can not be checked and is read once, after the worst reply time
+static int __isCombinable(uint8_t cmd)
+{
+    return (cmd == GET_CUR_FUNCTION_CMD) || (cmd == GET_FUNCTION_STATUS_CMD);
+}
+
+// writes the simple command and starts waiting for its reply, see __startReply. a polled reply GRC usually
+// prepares by the time it is read is read in the same transaction (repeated start): one transfer instead of two.
+// returns 1 - the reply is read, 0 - read it after waitUs, or error code (<0)
+int __requestSimpleReply(struct ProtocolContext* ctx, uint8_t cmd, uint8_t func, uint8_t* reply, int len, int checkable, uint32_t* waitUs)
+{
+    int res = __putSimpleCommand(ctx, cmd, func);
+    if (res < 0) {
+        return res;
+    }
+    uint32_t expectedUs = checkable ? ctx->timing.expectedUs : ctx->timing.worstUs;
+    if (ctx->combinedReads && checkable && __isCombinable(cmd) && (expectedUs <= COMBINED_READ_MAX_WAIT_US)) {
+        res = grc_transport_write_read(ctx->transport, ctx->ll_dev, ctx->outBuff, ctx->outBuffLen, reply, len);
+        if (res >= 0) {
+            // the reply time is counted from the end of the transaction, a shared bus may delay its start
+            __startReply(ctx, checkable);
+            return __acceptReply(ctx, reply, len, checkable, 0, waitUs);
+        }
+        if (res != NOT_IMPLEMENTED) {
+            return res;
+        }
+        // the link has no combined transactions
+        ctx->combinedReads = 0;
+    }
+    res = grc_transport_write(ctx->transport, ctx->ll_dev, ctx->outBuff, ctx->outBuffLen);
+    if (res < 0) {
+        return res;
+    }
+    *waitUs = __startReply(ctx, checkable);
+    return 0;
+}
+
+// writes the simple command and reads its reply, see __requestSimpleReply
+int __simpleCommandReply(struct ProtocolContext* ctx, uint8_t cmd, uint8_t func, uint8_t* reply, int len, int checkable)
+{
+    uint32_t waitUs;
+    int res = __requestSimpleReply(ctx, cmd, func, reply, len, checkable, &waitUs);
+    while (res == 0) {
+        grc_transport_sleep_us(ctx->transport, ctx->ll_dev, waitUs);
+        res = __readReplyOnce(ctx, reply, len, checkable, &waitUs);
+    }
+    return res < 0 ? res : GRC_OK;
+}
+
+// read reply to the command written last, see __startReply
+int __readReply(struct ProtocolContext* ctx, uint8_t* reply, int len, int checkable)
+{
+    grc_transport_sleep_us(ctx->transport, ctx->ll_dev, __startReply(ctx, checkable));
+    uint32_t retryUs;
+    int res;
+    while ((res = __readReplyOnce(ctx, reply, len, checkable, &retryUs)) == 0) {
+        grc_transport_sleep_us(ctx->transport, ctx->ll_dev, retryUs);
+    }
+    return res < 0 ? res : GRC_OK;
+}
+
+// =============== STREAMING STATUS ===========================
+uint64_t getMissingBlocks(const uint8_t* status, uint8_t blockCnt, int word)
+{
+    // block i is bit (i % 8) of status[STREAMING_STATUS_SIZE - i / 8 - 1]
+    uint64_t delivered = 0;
+    for (int i = 0; i < 8; i++) {
+        delivered |= (uint64_t)status[STREAMING_STATUS_SIZE - word * 8 - i - 1] << (i * 8);
+    }
+    int first = word * 64;
+    if (blockCnt <= first) {
+        return 0;
+    }
+    uint64_t expected = (blockCnt - first >= 64) ? ~(uint64_t)0 : (((uint64_t)1 << (blockCnt - first)) - 1);
+    return ~delivered & expected;
+}
+
+int countMissingBlocks(const uint8_t* status, uint8_t blockCnt)
+{
+    int missing = 0;
+    for (int word = 0; word < STREAMING_WORD_CNT; word++) {
+        missing += POPULATION_COUNT(getMissingBlocks(status, blockCnt, word));
+    }
+    return missing;
+}
+
 // =============== INTERFACE ===========================
-int initProtocolCommands(void* ll_dev)
+int initProtocolCommands(struct ProtocolContext* ctx)
 {
-    return grc_ll_i2c_init(ll_dev);
+    int res = grc_transport_init(ctx->transport, ctx->ll_dev);
+    if (res < 0) {
+        return res;
+    }
+    res = attachProtocolCommands(ctx);
+    if (res < 0) {
+        grc_transport_release(ctx->transport, ctx->ll_dev);
+    }
+    return res;
+}
+
+int attachProtocolCommands(struct ProtocolContext* ctx)
+{
+    ctx->timing.expectedUs = REPLY_INITIAL_WAIT_US;
+    ctx->timing.worstUs = REPLY_INITIAL_WORST_US;
+    __resetBuffer(ctx);
+    // the module takes up to BUFFER_SIZE bytes per write
+    int mtu = grc_transport_mtu(ctx->transport, ctx->ll_dev);
+    if (mtu < 0) {
+        return mtu;
+    }
+    if (mtu < MIN_MTU) {
+        return ARGUMENT_ERROR;
+    }
+    ctx->mtu = mtu < BUFFER_SIZE ? mtu : BUFFER_SIZE;
+    ctx->combinedReads = 1;
+    return GRC_OK;
 }
 
 /* cur executing command if > 0,
 0 -  no command executing,
 error < 0
 */
-int getCurFunction(void* ll_dev)
+int getCurFunction(struct ProtocolContext* ctx)
 {
-    int res = __writeSimpleCommand(ll_dev, GET_CUR_FUNCTION_CMD, 0);
+    // usually takes about 50 microseconds, sometimes more than 2ms
+    int res = __simpleCommandReply(ctx, GET_CUR_FUNCTION_CMD, 0, ctx->inBuff, SIMPLE_COMMAND_RESULT_SIZE, 1);
     if (res < 0) {
         return res;
     }
-    // TODO for some reason sometimes takes more than 2ms (2098 microseconds), although on average 50 microseconds
-    // TODO to deal with the delay,
-    // TODO to make a repeat request if got garbage
-    grc_ll_sleep(10);
-    res = grc_ll_i2c_read(ll_dev, inBuff, SIMPLE_COMMAND_RESULT_SIZE);
-    if (res < 0) {
-        return res;
-    }
-    return inBuff[0];
+    return ctx->inBuff[0];
 }
 
-int sendIntArguments(void* ll_dev, int arg)
+int sendIntArguments(struct ProtocolContext* ctx, int arg)
 {
     uint8_t blockCnt = 1;
     uint8_t blockSize = 8; // 4 for int arg and 4 for protocol wrap
-    __putActivateStreamingCommand(blockSize, blockCnt);
-    int res = __putIntAsBlock(arg);
+    __putActivateStreamingCommand(ctx, blockSize, blockCnt);
+    int res = __putIntAsBlock(ctx, arg);
     if (res < 0) {
         return res;
     }
-    return grc_ll_i2c_write(ll_dev, outBuff, outBuffLen);
+    return grc_transport_write(ctx->transport, ctx->ll_dev, ctx->outBuff, ctx->outBuffLen);
 }
 
-int sendFloatArguments(void* ll_dev, float arg)
+int sendFloatArguments(struct ProtocolContext* ctx, float arg)
 {
     uint8_t blockCnt = 1;
     uint8_t blockSize = 8; // 4 for int arg and 4 for protocol wrap
-    __putActivateStreamingCommand(blockSize, blockCnt);
-    int res = __putFloatAsBlock(arg);
+    __putActivateStreamingCommand(ctx, blockSize, blockCnt);
+    int res = __putFloatAsBlock(ctx, arg);
     if (res < 0) {
         return res;
     }
-    return grc_ll_i2c_write(ll_dev, outBuff, outBuffLen);
+    return grc_transport_write(ctx->transport, ctx->ll_dev, ctx->outBuff, ctx->outBuffLen);
 }
 
-int sendFloatArrayArguments(void* ll_dev, unsigned len, const float* vals, uint8_t* blockCnt)
+// most floats one block carries on this link
+uint8_t __maxValuesInBlock(struct ProtocolContext* ctx)
 {
-    *blockCnt = 252;
-    uint8_t blockSize = 255;
-    float b = (ceil((len + 1) / (float)MAX_VALUE_CNT_FOR_PACKAGE));
-    if (b <= 255) // max allowed package count 255
-    {
-        *blockCnt = (uint8_t)(b);
-        blockSize = (uint8_t)(ceil((float)(len + 1) / (float)(*blockCnt))) * FLOAT_SIZE + 4;
+    unsigned blockSize = ctx->mtu < MAX_BLOCK_SIZE ? ctx->mtu : MAX_BLOCK_SIZE;
+    return (blockSize - 4) / FLOAT_SIZE;
+}
+
+unsigned getMaxFloatArrayLen(struct ProtocolContext* ctx)
+{
+    // first block also carries the array length
+    return MAX_BLOCK_CNT * __maxValuesInBlock(ctx) - 1;
+}
+
+// writes __writeFloatArrayBlocks needs for the blocks after the streaming command
+static unsigned __countBlockWrites(struct ProtocolContext* ctx, unsigned blockSize, unsigned blockCnt)
+{
+    unsigned perWrite = ctx->mtu / blockSize;
+    perWrite = perWrite < MAX_BLOCKS_PER_WRITE ? perWrite : MAX_BLOCKS_PER_WRITE;
+    unsigned first = (ctx->mtu - ACTIVATE_STREAMING_COMMAND_SIZE) / blockSize;
+    first = first < MAX_BLOCKS_PER_WRITE ? first : MAX_BLOCKS_PER_WRITE;
+    if (first >= blockCnt) {
+        return 1;
+    }
+    // command is written alone if no block fits next to it
+    return 1 + (blockCnt - first + perWrite - 1) / perWrite;
+}
+
+// block size and count of the stream carrying the length and len floats: the fewest writes, then the least bytes
+// counting padding of the last block and block headers. a write costs its address byte, start and stop and the
+// turnaround of the driver, more than the bytes padding or an extra block header save
+int __getFloatArrayLayout(struct ProtocolContext* ctx, unsigned len, uint8_t* blockSize, uint8_t* blockCnt)
+{
+    // first block also carries the array length
+    unsigned values = len + 1;
+    unsigned maxInBlock = __maxValuesInBlock(ctx);
+    unsigned minCnt = (values + maxInBlock - 1) / maxInBlock;
+    if (minCnt > MAX_BLOCK_CNT) {
+        return ARGUMENT_ERROR;
+    }
+    unsigned bestWrites = 0;
+    unsigned bestBytes = 0;
+    for (unsigned cnt = minCnt; cnt <= MAX_BLOCK_CNT; cnt++) {
+        unsigned inBlock = (values + cnt - 1) / cnt;
+        // more blocks only add headers and writes once they can not beat the best layout without padding
+        unsigned bytesBound = (values + cnt) * FLOAT_SIZE;
+        unsigned writesBound = (bytesBound + ACTIVATE_STREAMING_COMMAND_SIZE + ctx->mtu - 1) / ctx->mtu;
+        if ((bestWrites > 0) && ((writesBound > bestWrites) || ((writesBound == bestWrites) && (bytesBound >= bestBytes)))) {
+            break;
+        }
+        // layouts where the last blocks are padding only are covered by a smaller count
+        if ((values + inBlock - 1) / inBlock != cnt) {
+            continue;
+        }
+        unsigned size = inBlock * FLOAT_SIZE + 4;
+        unsigned writes = __countBlockWrites(ctx, size, cnt);
+        unsigned bytes = cnt * size;
+        if ((bestWrites == 0) || (writes < bestWrites) || ((writes == bestWrites) && (bytes < bestBytes))) {
+            bestWrites = writes;
+            bestBytes = bytes;
+            *blockSize = size;
+            *blockCnt = cnt;
+        }
     }
-    __putActivateStreamingCommand(blockSize, *blockCnt);
-    if ((BUFFER_SIZE - blockSize) < ACTIVATE_STREAMING_COMMAND_SIZE) {
-        int res = grc_ll_i2c_write(ll_dev, outBuff, outBuffLen);
+    return GRC_OK;
+}
+
+// writes blocks of the float array after the command already put in the buffer
+int __writeFloatArrayBlocks(struct ProtocolContext* ctx, unsigned len, const float* vals, uint8_t blockSize, uint8_t blockCnt)
+{
+    for (int i = 0; i < blockCnt; i++) {
+        int res = __reserveBlock(ctx, blockSize);
         if (res < 0) {
             return res;
         }
-        __resetBuffer();
-    }
-    for (int i = 0; i < *blockCnt; i++) {
-        int res = __putFloatArrayAsBlock(len, vals, i + 1, blockSize);
+        res = __putFloatArrayBlockFragments(ctx, len, vals, i + 1, blockSize);
         if (res < 0) {
             return res;
         }
-        if ((BUFFER_SIZE - outBuffLen) < blockSize) {
-            res = grc_ll_i2c_write(ll_dev, outBuff, outBuffLen);
+    }
+    return __flushFragments(ctx);
+}
+
+int sendFloatArrayArguments(struct ProtocolContext* ctx, unsigned len, const float* vals, uint8_t* blockCnt)
+{
+    uint8_t blockSize;
+    int res = __getFloatArrayLayout(ctx, len, &blockSize, blockCnt);
+    if (res < 0) {
+        return res;
+    }
+    __putActivateStreamingCommand(ctx, blockSize, *blockCnt);
+    return __writeFloatArrayBlocks(ctx, len, vals, blockSize, *blockCnt);
+}
+
+int resendFloatArrayBlocks(struct ProtocolContext* ctx, unsigned len, const float* vals, const uint8_t* status)
+{
+    uint8_t blockSize;
+    uint8_t blockCnt;
+    int res = __getFloatArrayLayout(ctx, len, &blockSize, &blockCnt);
+    if (res < 0) {
+        return res;
+    }
+
+    int resent = 0;
+    __resetBuffer(ctx);
+    for (int word = 0; word < STREAMING_WORD_CNT; word++) {
+        uint64_t missing = getMissingBlocks(status, blockCnt, word);
+        while (missing) {
+            res = __reserveBlock(ctx, blockSize);
             if (res < 0) {
                 return res;
             }
-            __resetBuffer();
+            res = __putFloatArrayBlockFragments(ctx, len, vals, word * 64 + BIT_SCAN_FORWARD(missing) + 1, blockSize);
+            if (res < 0) {
+                return res;
+            }
+            missing &= missing - 1;
+            resent++;
         }
     }
-    if (outBuffLen > 0) {
-        int res = grc_ll_i2c_write(ll_dev, outBuff, outBuffLen);
-        if (res < 0) {
-            return res;
-        }
-        __resetBuffer();
+    res = __flushFragments(ctx);
+    if (res < 0) {
+        return res;
     }
-    return GRC_OK;
+    ctx->stats.blocksResent += resent;
+    return resent;
 }
 
-int sendParamArguments(void* ll_dev, struct Param* arg)
+int sendParamArguments(struct ProtocolContext* ctx, struct Param* arg)
 {
     uint8_t blockCnt = 1;
     uint8_t blockSize = INT_SIZE + 1 + 4; // 4 for int arg and 4 for protocol wrap
-    __putActivateStreamingCommand(blockSize, blockCnt);
-    int res = __putParamAsBlock(arg);
+    __putActivateStreamingCommand(ctx, blockSize, blockCnt);
+    int res = __putParamAsBlock(ctx, arg);
     if (res < 0) {
         return res;
     }
-    return grc_ll_i2c_write(ll_dev, outBuff, outBuffLen);
+    return grc_transport_write(ctx->transport, ctx->ll_dev, ctx->outBuff, ctx->outBuffLen);
 }
 
-int getStreamResult(void* ll_dev, uint8_t* status)
+int sendParamArrayArguments(struct ProtocolContext* ctx, unsigned cnt, const struct Param* params, uint8_t* blockCnt)
 {
+    if ((cnt == 0) || (cnt > MAX_PARAM_BATCH)) {
+        return ARGUMENT_ERROR;
+    }
+    // entry count, then kind and value of each entry as in sendParamArguments
+    uint8_t payload[1 + MAX_PARAM_BATCH * PARAM_SIZE];
+    unsigned len = 0;
+    payload[len++] = cnt;
+    for (unsigned i = 0; i < cnt; i++) {
+        payload[len++] = params[i].kind;
+        uint32_t value;
+        memcpy(&value, &params[i].ival, INT_SIZE);
+        __encodeValue(&payload[len], value);
+        len += INT_SIZE;
+    }
+    unsigned maxPayload = (ctx->mtu < MAX_BLOCK_SIZE ? ctx->mtu : MAX_BLOCK_SIZE) - 4;
+    *blockCnt = (len + maxPayload - 1) / maxPayload;
+    uint8_t blockSize = (len + *blockCnt - 1) / *blockCnt + 4;
 
-    int res = __writeSimpleCommand(ll_dev, GET_STREAMING_RESULT_CMD, 0);
+    __putActivateStreamingCommand(ctx, blockSize, *blockCnt);
+    for (int i = 0; i < *blockCnt; i++) {
+        if ((ctx->mtu - ctx->outBuffLen) < blockSize) {
+            int res = grc_transport_write(ctx->transport, ctx->ll_dev, ctx->outBuff, ctx->outBuffLen);
+            if (res < 0) {
+                return res;
+            }
+            __resetBuffer(ctx);
+        }
+        int res = __putBytesAsBlock(ctx, payload, len, i + 1, blockSize);
+        if (res < 0) {
+            return res;
+        }
+    }
+    int res = grc_transport_write(ctx->transport, ctx->ll_dev, ctx->outBuff, ctx->outBuffLen);
+    __resetBuffer(ctx);
+    return res;
+}
+
+int getStreamResult(struct ProtocolContext* ctx, uint8_t* status)
+{
+
+    int res = __writeSimpleCommand(ctx, GET_STREAMING_RESULT_CMD, 0);
     if (res < 0) {
         return res;
     }
-    grc_ll_sleep(1);
-    res = grc_ll_i2c_read(ll_dev, status, STREAMING_RESULT_SIZE);
+    // all blocks set is not a valid result: block count is limited to 255
+    res = __readReply(ctx, status, STREAMING_RESULT_SIZE, 1);
     if (res < 0) {
         return res;
     }
     return GRC_OK;
 }
 
-int callFunction(void* ll_dev, uint8_t functionCmd)
+int callFunction(struct ProtocolContext* ctx, uint8_t functionCmd)
 {
-    int res = __writeSimpleCommand(ll_dev, CALL_FUNCTION_CMD, functionCmd);
+    int res = __writeSimpleCommand(ctx, CALL_FUNCTION_CMD, functionCmd);
     return res;
 }
 
-int getFunctionStatus(void* ll_dev, uint8_t functionCmd, struct FunctionExecutionStatus* status)
+void __parseFunctionStatus(uint8_t reply, struct FunctionExecutionStatus* status)
+{
+    status->isRunning = ((reply >> 6) & 0x01);
+    status->isCalled = ((reply >> 7) & 0x01);
+    status->retcode = reply & 0x3f;
+}
+
+int getFunctionStatus(struct ProtocolContext* ctx, uint8_t functionCmd, struct FunctionExecutionStatus* status)
 {
-    int res = __writeSimpleCommand(ll_dev, GET_FUNCTION_STATUS_CMD, functionCmd);
+    // 0xff has all status bits set with invalid retcode
+    int res = __simpleCommandReply(ctx, GET_FUNCTION_STATUS_CMD, functionCmd, ctx->inBuff, SIMPLE_COMMAND_RESULT_SIZE, 1);
     if (res < 0) {
         return res;
     }
-    grc_ll_sleep(1);
-    res = grc_ll_i2c_read(ll_dev, inBuff, SIMPLE_COMMAND_RESULT_SIZE);
+    __parseFunctionStatus(ctx->inBuff[0], status);
+    return GRC_OK;
+}
+
+int getFunctionStatusWithResult(struct ProtocolContext* ctx, uint8_t functionCmd, struct FunctionExecutionStatus* status, int* result)
+{
+    // status byte is never 0xff, so the reply is told from the idle bus
+    int res = __simpleCommandReply(ctx, GET_FUNCTION_STATUS_CMD, functionCmd, ctx->inBuff, STATUS_WITH_RESULT_SIZE, 1);
     if (res < 0) {
         return res;
     }
-    status->isRunning = ((inBuff[0] >> 6) & 0x01);
-    status->isCalled = ((inBuff[0] >> 7) & 0x01);
-    status->retcode = inBuff[0] & 0x3f;
+    __parseFunctionStatus(ctx->inBuff[0], status);
+    *result = (int8_t)ctx->inBuff[1];
+    return GRC_OK;
+}
+
+// command and reply length of each ReplyKind
+static const uint8_t replyCommands[] = { GET_CUR_FUNCTION_CMD, GET_STREAMING_RESULT_CMD, GET_FUNCTION_STATUS_CMD,
+    GET_FUNCTION_STATUS_CMD, GET_FUNCTION_RESULT_CMD };
+static const uint8_t replySizes[] = { SIMPLE_COMMAND_RESULT_SIZE, STREAMING_RESULT_SIZE, SIMPLE_COMMAND_RESULT_SIZE,
+    STATUS_WITH_RESULT_SIZE, INT_SIZE };
+
+int requestReply(struct ProtocolContext* ctx, ReplyKind kind, uint8_t functionCmd)
+{
+    uint8_t cmd = replyCommands[kind];
+    int withFunction = (cmd == GET_FUNCTION_STATUS_CMD) || (cmd == GET_FUNCTION_RESULT_CMD);
+    uint32_t waitUs;
+    // function result can not be told from the idle bus
+    int res = __requestSimpleReply(ctx, cmd, withFunction ? functionCmd : 0, ctx->inBuff, replySizes[kind],
+        kind != ReplyFunctionResult, &waitUs);
+    if (res < 0) {
+        return res;
+    }
+    ctx->pending.replied = res;
+    return res ? 0 : (int)waitUs;
+}
+
+int pollReply(struct ProtocolContext* ctx, ReplyKind kind, uint32_t* retryUs)
+{
+    if (ctx->pending.replied) {
+        ctx->pending.replied = 0;
+        return 1;
+    }
+    return __readReplyOnce(ctx, ctx->inBuff, replySizes[kind], kind != ReplyFunctionResult, retryUs);
+}
+
+void parseFunctionStatusReply(struct ProtocolContext* ctx, struct FunctionExecutionStatus* status, int* result)
+{
+    __parseFunctionStatus(ctx->inBuff[0], status);
+    if (result) {
+        *result = (int8_t)ctx->inBuff[1];
+    }
+}
 
+int parseFunctionResultReply(struct ProtocolContext* ctx)
+{
+    return getInt(ctx->inBuff);
+}
+
+int getFunctionResult(struct ProtocolContext* ctx, uint8_t functionCmd, int* result)
+{
+    // any value is a valid result
+    int res = __simpleCommandReply(ctx, GET_FUNCTION_RESULT_CMD, functionCmd, ctx->inBuff, INT_SIZE, 0);
+    if (res < 0) {
+        return res;
+    }
+    *result = getInt(ctx->inBuff);
     return GRC_OK;
 }
 
-int getFunctionResult(void* ll_dev, uint8_t functionCmd, int* result)
+int getCapabilities(struct ProtocolContext* ctx)
 {
-    int res = __writeSimpleCommand(ll_dev, GET_FUNCTION_RESULT_CMD, functionCmd);
+    int res = __writeSimpleCommand(ctx, GET_CAPABILITIES_CMD, 0);
     if (res < 0) {
         return res;
     }
-    grc_ll_sleep(1);
-    res = grc_ll_i2c_read(ll_dev, inBuff, GET_FUNCTION_RESULT_CMD);
+    // flags, read block size, stream block count (0 - no limit), queue depth for submitted functions
+    res = __readReply(ctx, ctx->inBuff, CAPABILITIES_RESULT_SIZE, 1);
     if (res < 0) {
         return res;
     }
-    *result = getInt(inBuff);
+    // block is read into inBuff, use the largest size both sides can handle holding whole floats
+    unsigned linkBlockSize = ctx->mtu < MAX_BLOCK_SIZE ? ctx->mtu : MAX_BLOCK_SIZE;
+    uint8_t blockSize = ctx->inBuff[1] < linkBlockSize ? ctx->inBuff[1] : linkBlockSize;
+    if (blockSize >= MIN_READ_BLOCK_SIZE) {
+        blockSize -= (blockSize - 4) % FLOAT_SIZE;
+    }
+    ctx->caps.flags = ctx->inBuff[0] & SUPPORTED_CAPABILITIES;
+    ctx->caps.readBlockSize = blockSize;
+    // first block also carries the array length
+    uint8_t blockCnt = ctx->inBuff[2] > 0 ? ctx->inBuff[2] : MAX_BLOCK_CNT;
+    ctx->caps.maxArrayLen = blockCnt * __maxValuesInBlock(ctx) - 1;
+    ctx->caps.queueDepth = ctx->inBuff[3] < MAX_QUEUE_DEPTH ? ctx->inBuff[3] : MAX_QUEUE_DEPTH;
+    if (ctx->caps.queueDepth == 0) {
+        ctx->caps.flags &= ~CAPABILITY_PIPELINE;
+    }
+    if (blockSize < MIN_READ_BLOCK_SIZE) {
+        ctx->caps.flags &= ~CAPABILITY_BULK_READ;
+    }
     return GRC_OK;
 }
 
-int getCurGRCVersion(void* ll_dev)
+int readFloatArrayBlock(struct ProtocolContext* ctx, uint32_t offset, float* vals, unsigned cnt)
 {
-    int res = __writeSimpleCommand(ll_dev, GET_SDK_VERSION_CMD, 0);
+    uint8_t blockSize = ctx->caps.readBlockSize;
+    uint8_t valuesInBlock = (blockSize - 4) / FLOAT_SIZE;
+    if (cnt > valuesInBlock) {
+        return ARGUMENT_ERROR;
+    }
+    __resetBuffer(ctx);
+    __putByte(ctx, READ_STREAMING_CMD);
+    __putByte(ctx, blockSize);
+    __putValue(ctx, offset);
+    int res = grc_transport_write(ctx->transport, ctx->ll_dev, ctx->outBuff, ctx->outBuffLen);
+    __resetBuffer(ctx);
     if (res < 0) {
         return res;
     }
-    grc_ll_sleep(10);
-    res = grc_ll_i2c_read(ll_dev, inBuff, INT_SIZE);
+    // block starts with 0xff 0xfe, so it is told from the idle bus
+    res = __readReply(ctx, ctx->inBuff, blockSize, 1);
+    if (res < 0) {
+        return res;
+    }
+    // block number is checked to drop a stale reply to the previous read
+    uint8_t blockNumber = (uint8_t)(offset / valuesInBlock + 1);
+    if ((ctx->inBuff[0] != 0xff) || (ctx->inBuff[1] != 0xfe) || (ctx->inBuff[2] != blockNumber)
+        || (Crc8(&ctx->inBuff[2], blockSize - 3) != ctx->inBuff[blockSize - 1])) {
+        return WRONG_GRC_ANSWER;
+    }
+    getFloats(&ctx->inBuff[PACKAGE_HEADER_BYTE], vals, cnt);
+    return GRC_OK;
+}
+
+int submitFloatArrayFunction(struct ProtocolContext* ctx, uint8_t seq, uint8_t functionCmd, unsigned len, const float* vals)
+{
+    uint8_t blockSize;
+    uint8_t blockCnt;
+    int res = __getFloatArrayLayout(ctx, len, &blockSize, &blockCnt);
     if (res < 0) {
         return res;
     }
-    return getInt(inBuff);
+    // the blocks following the command are the arguments of the submitted function
+    __resetBuffer(ctx);
+    __putByte(ctx, SUBMIT_FUNCTION_CMD);
+    __putByte(ctx, seq);
+    __putByte(ctx, functionCmd);
+    __putByte(ctx, blockSize);
+    __putByte(ctx, blockCnt);
+    return __writeFloatArrayBlocks(ctx, len, vals, blockSize, blockCnt);
+}
+
+int getSubmittedResult(struct ProtocolContext* ctx, uint8_t seq, struct FunctionExecutionStatus* status, int* result)
+{
+    __resetBuffer(ctx);
+    __putByte(ctx, GET_SUBMITTED_RESULT_CMD);
+    __putByte(ctx, seq);
+    int res = grc_transport_write(ctx->transport, ctx->ll_dev, ctx->outBuff, ctx->outBuffLen);
+    __resetBuffer(ctx);
+    if (res < 0) {
+        return res;
+    }
+    // sequence number, status byte as in getFunctionStatus, result
+    res = __readReply(ctx, ctx->inBuff, SUBMITTED_RESULT_SIZE, 1);
+    if (res < 0) {
+        return res;
+    }
+    if (ctx->inBuff[0] != seq) {
+        return WRONG_GRC_ANSWER;
+    }
+    __parseFunctionStatus(ctx->inBuff[1], status);
+    *result = getInt(&ctx->inBuff[2]);
+    return GRC_OK;
+}
+
+int getCurGRCVersion(struct ProtocolContext* ctx)
+{
+    int version;
+    int res = readGRCVersion(ctx, &version);
+    return res < 0 ? res : version;
+}
+
+int readGRCVersion(struct ProtocolContext* ctx, int* version)
+{
+    int res = __writeSimpleCommand(ctx, GET_SDK_VERSION_CMD, 0);
+    if (res < 0) {
+        return res;
+    }
+    res = __readReply(ctx, ctx->inBuff, INT_SIZE, 1);
+    if (res < 0) {
+        return res;
+    }
+    *version = getInt(ctx->inBuff);
+    return GRC_OK;
 }
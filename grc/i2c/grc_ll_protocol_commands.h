@@ -9,44 +9,156 @@ extern "C" {
 #endif // __cplusplus
 
 /*!
- * \brief init protocol
+ * \brief open the transport and init protocol. the transport is released again if init fails
  */
-int initProtocolCommands(void* ll_dev);
+int initProtocolCommands(struct ProtocolContext* ctx);
+
+/*!
+ * \brief init protocol on a transport device opened by the caller
+ */
+int attachProtocolCommands(struct ProtocolContext* ctx);
 
 /*!
  * \brief get the function currently running on the device
  */
-int getCurFunction(void* ll_dev);
+int getCurFunction(struct ProtocolContext* ctx);
 
 /*!
  * \brief send function argument of different types
  */
-int sendIntArguments(void* ll_dev, int arg);
-int sendFloatArguments(void* ll_dev, float arg);
-int sendFloatArrayArguments(void* ll_dev, unsigned len, const float* vals, uint8_t* blockCnt);
-int sendParamArguments(void* ll_dev, struct Param* arg);
+int sendIntArguments(struct ProtocolContext* ctx, int arg);
+int sendFloatArguments(struct ProtocolContext* ctx, float arg);
+/*!
+ * \brief longest float array one stream carries on the link of the context
+ */
+unsigned getMaxFloatArrayLen(struct ProtocolContext* ctx);
+int sendFloatArrayArguments(struct ProtocolContext* ctx, unsigned len, const float* vals, uint8_t* blockCnt);
+int sendParamArguments(struct ProtocolContext* ctx, struct Param* arg);
+
+// longest Param array sent in one stream
+#define MAX_PARAM_BATCH 32
+
+/*!
+ * \brief send up to MAX_PARAM_BATCH parameters as one stream
+ * \note GRC firmware applies them with one remote call if it reports CAPABILITY_BATCH_PARAMS
+ */
+int sendParamArrayArguments(struct ProtocolContext* ctx, unsigned cnt, const struct Param* params, uint8_t* blockCnt);
+
+/*!
+ * \brief resend float array blocks which are not marked as delivered in status
+ * \return number of resent blocks or error code (<0)
+ */
+int resendFloatArrayBlocks(struct ProtocolContext* ctx, unsigned len, const float* vals, const uint8_t* status);
 
 /*!
  * \brief get status of send arguments
  */
-int getStreamResult(void* ll_dev, uint8_t* status);
+int getStreamResult(struct ProtocolContext* ctx, uint8_t* status);
+
+#define STREAMING_WORD_CNT (STREAMING_STATUS_SIZE / 8)
+
+/*!
+ * \brief undelivered blocks in streaming status
+ * \param word index of 64 block group
+ * \return bitmask of undelivered blocks word * 64 .. word * 64 + 63
+ */
+uint64_t getMissingBlocks(const uint8_t* status, uint8_t blockCnt, int word);
+int countMissingBlocks(const uint8_t* status, uint8_t blockCnt);
 
 /*!
  * \brief call remote function
  */
-int callFunction(void* ll_dev, uint8_t functionCmd);
+int callFunction(struct ProtocolContext* ctx, uint8_t functionCmd);
 
 /*!
  * \brief get function executing status and retcode
  */
-int getFunctionStatus(void* ll_dev, uint8_t functionCmd, struct FunctionExecutionStatus* status);
+int getFunctionStatus(struct ProtocolContext* ctx, uint8_t functionCmd, struct FunctionExecutionStatus* status);
+
+/*!
+ * \brief get function executing status with one byte signed result
+ * \note only for functions which report the result with the status (FUNCTION_INFER_WINDOW_CMD)
+ */
+int getFunctionStatusWithResult(struct ProtocolContext* ctx, uint8_t functionCmd, struct FunctionExecutionStatus* status, int* result);
 
 /*!
  * \brief get function result values
  */
-int getFunctionResult(void* ll_dev, uint8_t functionCmd, int* result);
+int getFunctionResult(struct ProtocolContext* ctx, uint8_t functionCmd, int* result);
 
-int getCurGRCVersion(void* ll_dev);
+int getCurGRCVersion(struct ProtocolContext* ctx);
+
+/*!
+ * \brief get the SDK version apart from the error code: another chip may reply with any value
+ * \return Ok(=0) or error code (<0)
+ */
+int readGRCVersion(struct ProtocolContext* ctx, int* version);
+
+/*!
+ * \brief replies read without blocking with requestReply and pollReply
+ */
+typedef enum {
+    ReplyCurFunction, // current function in inBuff[0]
+    ReplyStreamResult, // streaming status in inBuff
+    ReplyFunctionStatus, // see parseFunctionStatusReply
+    ReplyFunctionStatusWithResult, // see parseFunctionStatusReply
+    ReplyFunctionResult // see parseFunctionResultReply
+} ReplyKind;
+
+/*!
+ * \brief write the command of the reply
+ * \param functionCmd function of the status and result replies
+ * \return time to wait before pollReply in microseconds or error code (<0). a reply read with the command
+ *         (see write_read of grc_transport_ops) has no wait, pollReply returns it without a transaction
+ */
+int requestReply(struct ProtocolContext* ctx, ReplyKind kind, uint8_t functionCmd);
+
+/*!
+ * \brief read the reply requested last into ctx->inBuff
+ * \param retryUs time to wait before the next pollReply if the reply is not ready
+ * \return 1 - the reply is read, 0 - GRC has not prepared it yet, or error code (<0)
+ */
+int pollReply(struct ProtocolContext* ctx, ReplyKind kind, uint32_t* retryUs);
+
+/*!
+ * \brief status, and one byte signed result for ReplyFunctionStatusWithResult, of the reply read with pollReply
+ * \param result NULL for ReplyFunctionStatus
+ */
+void parseFunctionStatusReply(struct ProtocolContext* ctx, struct FunctionExecutionStatus* status, int* result);
+
+/*!
+ * \brief function result of the ReplyFunctionResult reply read with pollReply
+ */
+int parseFunctionResultReply(struct ProtocolContext* ctx);
+
+/*!
+ * \brief submit function with float array arguments to the GRC queue. GRC runs it after the previously submitted ones.
+ *        GRC keeps the result until getSubmittedResult has read it, only then the slot takes a new submission.
+ *        the master keeps at most queueDepth results unread: a submission finding every slot unread releases
+ *        the first submitted one, which the master has given up on (e.g. a batch ended by an error)
+ * \param seq sequence number to get the result with
+ * \note requires CAPABILITY_PIPELINE
+ */
+int submitFloatArrayFunction(struct ProtocolContext* ctx, uint8_t seq, uint8_t functionCmd, unsigned len, const float* vals);
+
+/*!
+ * \brief get status and result of the submitted function
+ * \return Ok(=0) or error code (<0). WRONG_GRC_ANSWER if the reply is for another sequence number
+ */
+int getSubmittedResult(struct ProtocolContext* ctx, uint8_t seq, struct FunctionExecutionStatus* status, int* result);
+
+/*!
+ * \brief negotiate optional protocol features, result is put to ctx->caps
+ * \note GRC firmware supports the request since SDK version 2
+ */
+int getCapabilities(struct ProtocolContext* ctx);
+
+/*!
+ * \brief read cnt floats of the AI SW state starting from offset in one CRC protected block
+ * \note requires CAPABILITY_BULK_READ, cnt is limited by ctx->caps.readBlockSize
+ * \return Ok(=0) or error code (<0). WRONG_GRC_ANSWER if the block is corrupted
+ */
+int readFloatArrayBlock(struct ProtocolContext* ctx, uint32_t offset, float* vals, unsigned cnt);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,456 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "grc/grc_error_codes.h"
+#include "grc/grc_pool.h"
+#include "grc/i2c/grc_async.h"
+
+#if GRC_ASYNC
+
+#include "grc/i2c/grc_context.h"
+
+// inference times kept for the hedging delay
+#define LATENCY_SAMPLES 128
+// inferences timed before windows are hedged
+#define LATENCY_MIN_SAMPLES 32
+// the hedging delay is updated after this many inferences
+#define LATENCY_UPDATE_PERIOD 16
+
+/*!
+ * \brief window queued on the pool
+ * \param runs devices the window is queued on or runs on, the window is freed by the last one
+ * \param hedged 1 - the window runs on a second device too
+ * \param answered 1 - the callback got the result, later results are ignored
+ */
+struct pool_window {
+    grc_callback_t callback;
+    void* user_data;
+    uint32_t runs;
+    int hedged;
+    int answered;
+    uint32_t len;
+    float vals[];
+};
+
+/*!
+ * \brief device of the pool
+ * \param queue windows from head on, the owner takes the oldest, the others steal the newest
+ * \param current window the device runs, NULL if it is idle
+ * \param started_us start of the current window
+ * \param hedge 1 - the current window is a hedge of a window running on another device
+ * \param stats work counted since since_us
+ */
+struct pool_device {
+    struct grc_pool* pool;
+    struct grc_device* dev;
+    pthread_t worker;
+    struct pool_window* queue[GRC_POOL_QUEUE_LEN];
+    uint32_t head;
+    uint32_t len;
+    struct pool_window* current;
+    uint64_t started_us;
+    int hedge;
+    struct grc_pool_stats stats;
+    uint64_t since_us;
+};
+
+/*!
+ * \brief one lock guards all queues: it is held for a few operations, an inference takes milliseconds
+ * \param queued windows in all queues
+ * \param running inferences being run
+ * \param next device tried first by grc_pool_inference, spreads the windows among equal queues
+ * \param latencies last inference times, ring of LATENCY_SAMPLES from latency_cnt on
+ * \param hedge_delay_us 95th percentile of latencies, 0 until LATENCY_MIN_SAMPLES are timed
+ */
+struct grc_pool {
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t idle;
+    int stop;
+    int hedging;
+    uint32_t queued;
+    uint32_t running;
+    uint32_t next;
+    uint32_t latencies[LATENCY_SAMPLES];
+    uint32_t latency_cnt;
+    uint32_t hedge_delay_us;
+    uint32_t cnt;
+    struct pool_device devices[];
+};
+
+// times of the devices are compared for hedging and waited for in wait_work, both on CLOCK_MONOTONIC:
+// a transport clock may run apart from it, the serial one counts queued sleeps
+static uint64_t pool_time_us(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000u + (uint64_t)now.tv_nsec / 1000u;
+}
+
+static struct pool_window* take_window(struct pool_device* pd, int newest)
+{
+    uint32_t idx = (pd->head + (newest ? pd->len - 1 : 0)) % GRC_POOL_QUEUE_LEN;
+    if (!newest) {
+        pd->head = (pd->head + 1) % GRC_POOL_QUEUE_LEN;
+    }
+    pd->len--;
+    return pd->queue[idx];
+}
+
+// own window or one stolen from the longest queue, called with the pool lock. returns NULL if there is none
+static struct pool_window* next_window(struct pool_device* pd)
+{
+    struct grc_pool* pool = pd->pool;
+    if (pd->len > 0) {
+        return take_window(pd, 0);
+    }
+    struct pool_device* victim = NULL;
+    for (uint32_t i = 0; i < pool->cnt; i++) {
+        if ((victim == NULL) || (pool->devices[i].len > victim->len)) {
+            victim = &pool->devices[i];
+        }
+    }
+    if ((victim == NULL) || (victim->len == 0)) {
+        return NULL;
+    }
+    pd->stats.stolen++;
+    return take_window(victim, 1);
+}
+
+// window running longer than the hedging delay on another device, called with the pool lock.
+// returns NULL if there is none, wait_us is then the time until the next one is due, 0 if none runs
+static struct pool_window* window_to_hedge(struct pool_device* pd, uint64_t* wait_us)
+{
+    struct grc_pool* pool = pd->pool;
+    *wait_us = 0;
+    if (!pool->hedging || (pool->hedge_delay_us == 0)) {
+        return NULL;
+    }
+    uint64_t now = pool_time_us();
+    for (uint32_t i = 0; i < pool->cnt; i++) {
+        struct pool_device* other = &pool->devices[i];
+        struct pool_window* win = other->current;
+        if ((win == NULL) || win->hedged || win->answered) {
+            continue;
+        }
+        uint64_t due = other->started_us + pool->hedge_delay_us;
+        if (due <= now) {
+            return win;
+        }
+        if ((*wait_us == 0) || (due - now < *wait_us)) {
+            *wait_us = due - now;
+        }
+    }
+    return NULL;
+}
+
+static int compare_latencies(const void* a, const void* b)
+{
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+// called with the pool lock
+static void add_latency(struct grc_pool* pool, uint64_t busy_us)
+{
+    pool->latencies[pool->latency_cnt % LATENCY_SAMPLES] = busy_us > UINT32_MAX ? UINT32_MAX : (uint32_t)busy_us;
+    pool->latency_cnt++;
+    if ((pool->latency_cnt < LATENCY_MIN_SAMPLES) || (pool->latency_cnt % LATENCY_UPDATE_PERIOD != 0)) {
+        return;
+    }
+    uint32_t cnt = pool->latency_cnt < LATENCY_SAMPLES ? pool->latency_cnt : LATENCY_SAMPLES;
+    uint32_t sorted[LATENCY_SAMPLES];
+    memcpy(sorted, pool->latencies, cnt * sizeof(uint32_t));
+    qsort(sorted, cnt, sizeof(uint32_t), compare_latencies);
+    pool->hedge_delay_us = sorted[(cnt * 95) / 100];
+}
+
+// wait for work, until wait_us passes if it is not 0
+static void wait_work(struct grc_pool* pool, uint64_t wait_us)
+{
+    if (wait_us == 0) {
+        pthread_cond_wait(&pool->work, &pool->lock);
+        return;
+    }
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += wait_us / 1000000;
+    deadline.tv_nsec += (long)(wait_us % 1000000) * 1000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+    pthread_cond_timedwait(&pool->work, &pool->lock, &deadline);
+}
+
+static void* pool_worker(void* arg)
+{
+    struct pool_device* pd = (struct pool_device*)arg;
+    struct grc_pool* pool = pd->pool;
+    struct grc_inference_params params = { 0 };
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        uint64_t wait_us;
+        struct pool_window* win = next_window(pd);
+        if (win != NULL) {
+            pool->queued--;
+            pd->hedge = 0;
+        } else if ((win = window_to_hedge(pd, &wait_us)) != NULL) {
+            win->hedged = 1;
+            win->runs++;
+            pd->hedge = 1;
+            pd->stats.hedged++;
+        } else if (pool->stop) {
+            break;
+        } else {
+            wait_work(pool, wait_us);
+            continue;
+        }
+        pool->running++;
+        pd->current = win;
+        pd->started_us = pool_time_us();
+        if (pool->hedging) {
+            // an idle device takes over waiting for the hedging delays
+            pthread_cond_signal(&pool->work);
+        }
+        pthread_mutex_unlock(&pool->lock);
+
+        int result = grc_inference(pd->dev, &params, win->vals, win->len);
+
+        pthread_mutex_lock(&pool->lock);
+        uint64_t busy = pool_time_us() - pd->started_us;
+        pd->current = NULL;
+        pd->stats.inferences++;
+        pd->stats.busy_us += busy;
+        add_latency(pool, busy);
+        // the first class is the answer, an error only if no other device runs the window
+        int answer = !win->answered && ((result >= NOT_CLASSIFIED) || (win->runs == 1));
+        if (answer) {
+            win->answered = 1;
+            pd->stats.hedges_won += pd->hedge;
+        }
+        int last = (--win->runs == 0);
+        pthread_mutex_unlock(&pool->lock);
+
+        if (answer && win->callback) {
+            win->callback(result, win->user_data);
+        }
+        if (last) {
+            free(win);
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        pool->running--;
+        if ((pool->queued == 0) && (pool->running == 0)) {
+            pthread_cond_broadcast(&pool->idle);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+struct grc_pool* grc_pool_create(struct grc_device* const* devs, uint32_t cnt)
+{
+    if (cnt == 0) {
+        return NULL;
+    }
+    struct grc_pool* pool = (struct grc_pool*)calloc(1, sizeof(struct grc_pool) + cnt * sizeof(struct pool_device));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    // hedging delays do not jump with the wall clock
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, &attr);
+    pthread_cond_init(&pool->idle, NULL);
+    pthread_condattr_destroy(&attr);
+    uint64_t now = pool_time_us();
+    for (uint32_t i = 0; i < cnt; i++) {
+        struct pool_device* pd = &pool->devices[i];
+        pd->pool = pool;
+        pd->dev = devs[i];
+        pd->since_us = now;
+        if ((devs[i]->ctx == NULL) || (pthread_create(&pd->worker, NULL, pool_worker, pd) != 0)) {
+            grc_pool_destroy(pool);
+            return NULL;
+        }
+        pool->cnt++;
+    }
+    return pool;
+}
+
+void grc_pool_destroy(struct grc_pool* pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = 1;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+    for (uint32_t i = 0; i < pool->cnt; i++) {
+        pthread_join(pool->devices[i].worker, NULL);
+    }
+    pthread_cond_destroy(&pool->idle);
+    pthread_cond_destroy(&pool->work);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+int grc_pool_set_hedging(struct grc_pool* pool, int enable)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->hedging = enable;
+    pthread_mutex_unlock(&pool->lock);
+    return GRC_OK;
+}
+
+uint32_t grc_pool_hedge_delay_us(struct grc_pool* pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    uint32_t delay = pool->hedge_delay_us;
+    pthread_mutex_unlock(&pool->lock);
+    return delay;
+}
+
+int grc_pool_inference(struct grc_pool* pool, const float* vals, uint32_t len, grc_callback_t callback, void* user_data)
+{
+    struct pool_window* win = (struct pool_window*)malloc(sizeof(struct pool_window) + len * sizeof(float));
+    if (win == NULL) {
+        return GRC_NO_MEMORY;
+    }
+    win->callback = callback;
+    win->user_data = user_data;
+    win->runs = 1;
+    win->hedged = 0;
+    win->answered = 0;
+    win->len = len;
+    memcpy(win->vals, vals, len * sizeof(float));
+
+    pthread_mutex_lock(&pool->lock);
+    // an idle device with an empty queue, otherwise the shortest queue
+    struct pool_device* target = NULL;
+    for (uint32_t i = 0; i < pool->cnt; i++) {
+        struct pool_device* pd = &pool->devices[(pool->next + i) % pool->cnt];
+        if ((pd->len == 0) && (pd->current == NULL)) {
+            target = pd;
+            break;
+        }
+        if ((target == NULL) || (pd->len < target->len)) {
+            target = pd;
+        }
+    }
+    if (target->len == GRC_POOL_QUEUE_LEN) {
+        pthread_mutex_unlock(&pool->lock);
+        free(win);
+        return GRC_IS_BUSY;
+    }
+    pool->next = (pool->next + 1) % pool->cnt;
+    target->queue[(target->head + target->len) % GRC_POOL_QUEUE_LEN] = win;
+    target->len++;
+    pool->queued++;
+    // any idle worker takes it, from its own queue or by stealing
+    pthread_cond_signal(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+    return GRC_OK;
+}
+
+int grc_pool_wait(struct grc_pool* pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    while ((pool->queued > 0) || (pool->running > 0)) {
+        pthread_cond_wait(&pool->idle, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return GRC_OK;
+}
+
+int grc_pool_replicate(struct grc_pool* pool, uint32_t src)
+{
+    if (src >= pool->cnt) {
+        return ARGUMENT_ERROR;
+    }
+    grc_pool_wait(pool);
+    struct grc_device* src_dev = pool->devices[src].dev;
+    struct grc_internal_state state = { 0 };
+    uint32_t state_len = 0;
+    int classes = grc_download(src_dev, &state, &state_len);
+    for (uint32_t i = 0; (i < pool->cnt) && (classes >= 0); i++) {
+        struct grc_device* dev = pool->devices[i].dev;
+        if (i == src) {
+            continue;
+        }
+        int res = grc_upload(dev, &state, classes);
+        if (res < 0) {
+            classes = res;
+            break;
+        }
+        // the classes keep the tags of the trained device
+        memcpy(dev->ctx->tags_trained, src_dev->ctx->tags_trained, sizeof(dev->ctx->tags_trained));
+        dev->ctx->tags_trained_len = src_dev->ctx->tags_trained_len;
+    }
+    free(state.values);
+    return classes;
+}
+
+int grc_pool_get_stats(struct grc_pool* pool, uint32_t idx, struct grc_pool_stats* stats, int reset)
+{
+    if (idx >= pool->cnt) {
+        return ARGUMENT_ERROR;
+    }
+    struct pool_device* pd = &pool->devices[idx];
+    pthread_mutex_lock(&pool->lock);
+    uint64_t now = pool_time_us();
+    *stats = pd->stats;
+    stats->utilisation = now > pd->since_us ? (float)pd->stats.busy_us / (float)(now - pd->since_us) : 0.0f;
+    if (reset) {
+        memset(&pd->stats, 0, sizeof(pd->stats));
+        pd->since_us = now;
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return GRC_OK;
+}
+
+#else
+
+struct grc_pool* grc_pool_create(struct grc_device* const* devs, uint32_t cnt)
+{
+    return NULL;
+}
+
+void grc_pool_destroy(struct grc_pool* pool)
+{
+}
+
+int grc_pool_replicate(struct grc_pool* pool, uint32_t src)
+{
+    return NOT_IMPLEMENTED;
+}
+
+int grc_pool_set_hedging(struct grc_pool* pool, int enable)
+{
+    return NOT_IMPLEMENTED;
+}
+
+uint32_t grc_pool_hedge_delay_us(struct grc_pool* pool)
+{
+    return 0;
+}
+
+int grc_pool_inference(struct grc_pool* pool, const float* vals, uint32_t len, grc_callback_t callback, void* user_data)
+{
+    return NOT_IMPLEMENTED;
+}
+
+int grc_pool_wait(struct grc_pool* pool)
+{
+    return NOT_IMPLEMENTED;
+}
+
+int grc_pool_get_stats(struct grc_pool* pool, uint32_t idx, struct grc_pool_stats* stats, int reset)
+{
+    return NOT_IMPLEMENTED;
+}
+
+#endif // GRC_ASYNC
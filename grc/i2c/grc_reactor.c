@@ -0,0 +1,459 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "grc/grc_error_codes.h"
+#include "grc/grc_reactor.h"
+
+#ifdef __linux__
+
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "grc/drivers/grc_transport.h"
+#include "grc/i2c/grc_context.h"
+#include "grc/i2c/grc_ll_api.h"
+
+// events handled by one grc_reactor_run
+#define MAX_EVENTS 32
+
+// remote calls of one inference
+typedef enum {
+    StageInferWindow, // fused inference, SDK version 2 and later
+    StageStartInference,
+    StageFeedData,
+    StageStopInference,
+    StageGetStatus
+} InferenceStage;
+
+struct reactor_op {
+    const float* vals;
+    uint32_t len;
+    grc_callback_t callback;
+    void* user_data;
+};
+
+/*!
+ * \brief device driven by the reactor
+ * \param timer_fd wakes the device when the wait returned by the remote call is over
+ * \param ready_fd data ready line of the device, -1 if not wired
+ * \param ops queued inferences from head on, the running one stays at head until it finishes
+ * \param running 1 - the inference at head is started
+ * \param stage, offset, call progress of the running inference
+ * \param edge_pending the data ready edge came while the function status was read
+ */
+struct reactor_device {
+    struct grc_device* dev;
+    int timer_fd;
+    int ready_fd;
+    struct reactor_op ops[GRC_REACTOR_QUEUE_LEN];
+    uint32_t head;
+    uint32_t len;
+    int running;
+    InferenceStage stage;
+    uint32_t offset;
+    struct RemoteCall call;
+    int edge_pending;
+};
+
+struct grc_reactor {
+    int epoll_fd;
+    struct reactor_device* devices;
+    uint32_t cnt;
+};
+
+// epoll data of the device fds
+#define EVENT_DATA(idx, is_ready) (((uint64_t)(idx) << 1) | (is_ready))
+
+struct grc_reactor* grc_reactor_create(void)
+{
+    struct grc_reactor* reactor = (struct grc_reactor*)calloc(1, sizeof(struct grc_reactor));
+    if (reactor == NULL) {
+        return NULL;
+    }
+    reactor->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (reactor->epoll_fd < 0) {
+        free(reactor);
+        return NULL;
+    }
+    return reactor;
+}
+
+void grc_reactor_destroy(struct grc_reactor* reactor)
+{
+    for (uint32_t i = 0; i < reactor->cnt; i++) {
+        close(reactor->devices[i].timer_fd);
+    }
+    close(reactor->epoll_fd);
+    free(reactor->devices);
+    free(reactor);
+}
+
+static int watch_fd(struct grc_reactor* reactor, int fd, uint64_t data)
+{
+    struct epoll_event event = { .events = EPOLLIN, .data.u64 = data };
+    return epoll_ctl(reactor->epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0 ? GRC_OK : GRC_NO_MEMORY;
+}
+
+int grc_reactor_add(struct grc_reactor* reactor, struct grc_device* dev)
+{
+    if (dev->ctx == NULL) {
+        return ARGUMENT_ERROR;
+    }
+    // functions submitted with GRC_PARAMS_ASYNC are finished before the reactor takes the device
+    grc_async_wait(&dev->ctx->async, -1);
+    struct reactor_device* devices = (struct reactor_device*)realloc(reactor->devices,
+        (reactor->cnt + 1) * sizeof(struct reactor_device));
+    if (devices == NULL) {
+        return GRC_NO_MEMORY;
+    }
+    reactor->devices = devices;
+    struct reactor_device* rd = &devices[reactor->cnt];
+    memset(rd, 0, sizeof(*rd));
+    rd->dev = dev;
+    rd->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (rd->timer_fd < 0) {
+        return GRC_NO_MEMORY;
+    }
+    int res = watch_fd(reactor, rd->timer_fd, EVENT_DATA(reactor->cnt, 0));
+    const struct grc_transport_ops* transport = grc_transport_resolve(dev->transport);
+    rd->ready_fd = grc_transport_ready_fd(transport, dev->ll_dev);
+    if ((res == GRC_OK) && (rd->ready_fd >= 0)) {
+        // the edges left from the blocking API are dropped
+        while (grc_transport_wait_ready(transport, dev->ll_dev, 0) == GRC_OK) {
+        }
+        res = watch_fd(reactor, rd->ready_fd, EVENT_DATA(reactor->cnt, 1));
+    } else {
+        rd->ready_fd = -1;
+    }
+    if (res < 0) {
+        epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, rd->timer_fd, NULL);
+        close(rd->timer_fd);
+        return res;
+    }
+    reactor->cnt++;
+    return GRC_OK;
+}
+
+static struct reactor_device* find_device(struct grc_reactor* reactor, struct grc_device* dev)
+{
+    for (uint32_t i = 0; i < reactor->cnt; i++) {
+        if (reactor->devices[i].dev == dev) {
+            return &reactor->devices[i];
+        }
+    }
+    return NULL;
+}
+
+int grc_reactor_remove(struct grc_reactor* reactor, struct grc_device* dev)
+{
+    struct reactor_device* rd = find_device(reactor, dev);
+    if (rd == NULL) {
+        return ARGUMENT_ERROR;
+    }
+    if (rd->ready_fd >= 0) {
+        epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, rd->ready_fd, NULL);
+    }
+    epoll_ctl(reactor->epoll_fd, EPOLL_CTL_DEL, rd->timer_fd, NULL);
+    close(rd->timer_fd);
+    // the last device takes the place of the removed one
+    uint32_t idx = rd - reactor->devices;
+    reactor->cnt--;
+    if (idx < reactor->cnt) {
+        *rd = reactor->devices[reactor->cnt];
+        struct epoll_event event = { .events = EPOLLIN, .data.u64 = EVENT_DATA(idx, 0) };
+        epoll_ctl(reactor->epoll_fd, EPOLL_CTL_MOD, rd->timer_fd, &event);
+        if (rd->ready_fd >= 0) {
+            event.data.u64 = EVENT_DATA(idx, 1);
+            epoll_ctl(reactor->epoll_fd, EPOLL_CTL_MOD, rd->ready_fd, &event);
+        }
+    }
+    return GRC_OK;
+}
+
+static void arm_timer(struct reactor_device* rd, uint32_t wait_us)
+{
+    // zero would disarm the timer
+    if (wait_us == 0) {
+        wait_us = 1;
+    }
+    struct itimerspec spec = { 0 };
+    spec.it_value.tv_sec = wait_us / 1000000;
+    spec.it_value.tv_nsec = (long)(wait_us % 1000000) * 1000;
+    timerfd_settime(rd->timer_fd, 0, &spec, NULL);
+}
+
+// the remote call waits for wait_us, or for the data ready edge
+static void wait_call(struct reactor_device* rd, uint32_t wait_us)
+{
+    if ((rd->call.state == RemoteCallWaitDone) && rd->edge_pending) {
+        wait_us = 0;
+    }
+    rd->edge_pending = 0;
+    arm_timer(rd, wait_us);
+}
+
+static int start_stage(struct reactor_device* rd, InferenceStage stage)
+{
+    struct ProtocolContext* protocol = &rd->dev->ctx->protocol;
+    const struct reactor_op* op = &rd->ops[rd->head];
+    int res = GRC_OK;
+    rd->stage = stage;
+    switch (stage) {
+    case StageInferWindow:
+        res = prepareInferWindow(protocol, &rd->call, op->len, op->vals);
+        break;
+    case StageStartInference:
+        prepareStartInference(&rd->call);
+        break;
+    case StageFeedData: {
+        uint32_t cnt = op->len - rd->offset;
+        if (cnt > protocol->caps.maxArrayLen) {
+            cnt = protocol->caps.maxArrayLen;
+        }
+        res = prepareFeedData(protocol, &rd->call, cnt, op->vals + rd->offset);
+        break;
+    }
+    case StageStopInference:
+        prepareStopInference(&rd->call);
+        break;
+    case StageGetStatus:
+        prepareGetStatus(&rd->call);
+        break;
+    }
+    if (res < 0) {
+        return res;
+    }
+    rd->call.readyLine = rd->ready_fd >= 0;
+    rd->edge_pending = 0;
+    uint32_t wait_us;
+    res = startRemoteCall(protocol, &rd->call, &wait_us);
+    if (res < 0) {
+        return res;
+    }
+    wait_call(rd, wait_us);
+    return GRC_OK;
+}
+
+static int start_op(struct reactor_device* rd)
+{
+    rd->running = 1;
+    rd->offset = 0;
+    int fused = rd->dev->ctx->protocol.caps.flags & CAPABILITY_FUSED_INFERENCE;
+    // a window longer than one stream is fed in parts
+    if (fused && (rd->ops[rd->head].len <= rd->dev->ctx->protocol.caps.maxArrayLen)) {
+        return start_stage(rd, StageInferWindow);
+    }
+    return start_stage(rd, StageStartInference);
+}
+
+// finish the running inference and start the next queued one, returns the number of callbacks called
+static int finish_op(struct grc_reactor* reactor, struct reactor_device* rd, int result)
+{
+    struct grc_device* dev = rd->dev;
+    int finished = 0;
+    while (1) {
+        struct reactor_op op = rd->ops[rd->head];
+        rd->head = (rd->head + 1) % GRC_REACTOR_QUEUE_LEN;
+        rd->len--;
+        rd->running = 0;
+        // the callback may queue the next inference
+        if (op.callback) {
+            op.callback(result, op.user_data);
+            // it may also add or remove other devices, which moves the device table
+            rd = find_device(reactor, dev);
+        }
+        finished++;
+        if (rd == NULL) {
+            return finished;
+        }
+        if ((rd->len == 0) || rd->running) {
+            return finished;
+        }
+        result = start_op(rd);
+        if (result >= 0) {
+            return finished;
+        }
+    }
+}
+
+// the remote call of the stage is finished, returns the next stage or the inference result
+static int next_stage(struct reactor_device* rd, int* done)
+{
+    struct grc_context* ctx = rd->dev->ctx;
+    *done = 0;
+    int res = retcode_to_result(&rd->call.retcode);
+    if (res < 0) {
+        *done = 1;
+        return res;
+    }
+    switch (rd->stage) {
+    case StageStartInference:
+        return StageFeedData;
+    case StageFeedData:
+        rd->offset += rd->call.len;
+        return rd->offset < rd->ops[rd->head].len ? StageFeedData : StageStopInference;
+    case StageStopInference:
+        return StageGetStatus;
+    default:
+        *done = 1;
+        return class_idx_to_tag(ctx, rd->call.result);
+    }
+}
+
+// the device timer expired or the data ready edge came, returns the number of callbacks called
+static int advance(struct grc_reactor* reactor, struct reactor_device* rd)
+{
+    if (!rd->running) {
+        return 0;
+    }
+    uint32_t wait_us;
+    int res = stepRemoteCall(&rd->dev->ctx->protocol, &rd->call, &wait_us);
+    if (res == 0) {
+        wait_call(rd, wait_us);
+        return 0;
+    }
+    if (res > 0) {
+        int done;
+        res = next_stage(rd, &done);
+        if (!done) {
+            res = start_stage(rd, (InferenceStage)res);
+            if (res >= 0) {
+                return 0;
+            }
+        }
+    }
+    return finish_op(reactor, rd, res);
+}
+
+int grc_reactor_inference(
+    struct grc_reactor* reactor,
+    struct grc_device* dev,
+    const float* vals,
+    uint32_t len,
+    grc_callback_t callback,
+    void* user_data)
+{
+    struct reactor_device* rd = find_device(reactor, dev);
+    if ((rd == NULL) || (len == 0)) {
+        return ARGUMENT_ERROR;
+    }
+    if (rd->len == GRC_REACTOR_QUEUE_LEN) {
+        return GRC_IS_BUSY;
+    }
+    struct reactor_op* op = &rd->ops[(rd->head + rd->len) % GRC_REACTOR_QUEUE_LEN];
+    op->vals = vals;
+    op->len = len;
+    op->callback = callback;
+    op->user_data = user_data;
+    rd->len++;
+    // inside a callback of the device the next inference is started after the callback
+    if (rd->running || (rd->len > 1)) {
+        return GRC_OK;
+    }
+    // the first remote call is started at once, its error is returned without the callback
+    int res = start_op(rd);
+    if (res < 0) {
+        rd->len = 0;
+        rd->running = 0;
+        return res;
+    }
+    return GRC_OK;
+}
+
+int grc_reactor_run(struct grc_reactor* reactor, int timeout_ms)
+{
+    struct epoll_event events[MAX_EVENTS];
+    int cnt = epoll_wait(reactor->epoll_fd, events, MAX_EVENTS, timeout_ms);
+    if (cnt < 0) {
+        return errno == EINTR ? 0 : I2C_ERROR;
+    }
+    int finished = 0;
+    for (int i = 0; i < cnt; i++) {
+        // a device removed by a callback of this run is skipped
+        if ((events[i].data.u64 >> 1) >= reactor->cnt) {
+            continue;
+        }
+        struct reactor_device* rd = &reactor->devices[events[i].data.u64 >> 1];
+        if (events[i].data.u64 & 1) {
+            grc_transport_wait_ready(grc_transport_resolve(rd->dev->transport), rd->dev->ll_dev, 0);
+            if (!rd->running || (rd->call.state != RemoteCallWaitDone)) {
+                // the status being read may still be the running one, the edge ends the next wait
+                rd->edge_pending = rd->running && (rd->call.state == RemoteCallStatus);
+                continue;
+            }
+        } else {
+            uint64_t expirations;
+            if (read(rd->timer_fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+                // the timer was set again after the event
+                continue;
+            }
+        }
+        finished += advance(reactor, rd);
+    }
+    return finished;
+}
+
+int grc_reactor_fd(struct grc_reactor* reactor)
+{
+    return reactor->epoll_fd;
+}
+
+uint32_t grc_reactor_pending(struct grc_reactor* reactor)
+{
+    uint32_t pending = 0;
+    for (uint32_t i = 0; i < reactor->cnt; i++) {
+        pending += reactor->devices[i].len;
+    }
+    return pending;
+}
+
+#else
+
+struct grc_reactor* grc_reactor_create(void)
+{
+    return NULL;
+}
+
+void grc_reactor_destroy(struct grc_reactor* reactor)
+{
+}
+
+int grc_reactor_add(struct grc_reactor* reactor, struct grc_device* dev)
+{
+    return NOT_IMPLEMENTED;
+}
+
+int grc_reactor_remove(struct grc_reactor* reactor, struct grc_device* dev)
+{
+    return NOT_IMPLEMENTED;
+}
+
+int grc_reactor_inference(
+    struct grc_reactor* reactor,
+    struct grc_device* dev,
+    const float* vals,
+    uint32_t len,
+    grc_callback_t callback,
+    void* user_data)
+{
+    return NOT_IMPLEMENTED;
+}
+
+int grc_reactor_run(struct grc_reactor* reactor, int timeout_ms)
+{
+    return NOT_IMPLEMENTED;
+}
+
+int grc_reactor_fd(struct grc_reactor* reactor)
+{
+    return NOT_IMPLEMENTED;
+}
+
+uint32_t grc_reactor_pending(struct grc_reactor* reactor)
+{
+    return 0;
+}
+
+#endif // __linux__
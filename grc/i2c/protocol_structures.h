@@ -3,6 +3,8 @@
 
 #include <stdint.h>
 
+#include "grc/drivers/grc_ll_driver.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif // __cplusplus
@@ -22,6 +24,7 @@ typedef enum {
     InvalDataLen,
 
     NotCalled = 20,
+    NotDelivered, // submitted arguments failed CRC check
 
     NotImplemented = 30
 } Retcode;
@@ -56,6 +59,119 @@ struct Param {
     };
 };
 
+/*!
+ * \brief protocol counters of the device
+ * \param blocksResent stream blocks sent again after GRC reported them as not delivered
+ * \param resendRounds number of resend attempts
+ * \param blocksReread blocks read again from GRC after CRC mismatch
+ */
+struct ProtocolStats {
+    uint32_t blocksResent;
+    uint32_t resendRounds;
+    uint32_t blocksReread;
+};
+
+#define PROTOCOL_BUFFER_SIZE 256
+#define STREAMING_STATUS_SIZE 32
+// blocks of one write transaction
+#define MAX_BLOCKS_PER_WRITE 8
+// fragments of one scatter-gather write: command, then header, payload and padding of each block, last crc
+#define MAX_WRITE_FRAGMENTS (MAX_BLOCKS_PER_WRITE * 3 + 2)
+
+/*!
+ * \brief calibrated time GRC needs to prepare a reply to a command
+ * \param expectedUs typical reply time, replies are first read after it
+ * \param worstUs recently observed worst reply time, used for replies which can not be told from garbage.
+ *        it does not drop below the initial worst time
+ */
+struct ResponseTiming {
+    uint32_t expectedUs;
+    uint32_t worstUs;
+};
+
+/*!
+ * \brief reply to the command written last, not read yet
+ * \param startUs time the command was written
+ * \param backoffUs wait before the next read if the reply is not ready
+ * \param attempts reads of the reply so far
+ * \param replied 1 - the reply was read with its command in one transaction
+ */
+struct PendingReply {
+    uint64_t startUs;
+    uint32_t backoffUs;
+    uint8_t attempts;
+    uint8_t replied;
+};
+
+// optional protocol features reported by GRC firmware (SDK version 2 and later)
+#define CAPABILITY_BULK_READ 0x01
+// float arrays fed outside training and inference are collected for LoadTrainData
+#define CAPABILITY_BULK_WRITE 0x02
+// several Param entries are applied by one remote call
+#define CAPABILITY_BATCH_PARAMS 0x04
+// window is classified by one remote call, class index comes with the function status
+#define CAPABILITY_FUSED_INFERENCE 0x08
+// functions are submitted with sequence numbers and queued by GRC (SDK version 3 and later)
+#define CAPABILITY_PIPELINE 0x10
+// GRC keeps the last window of a sliding window inference, only new samples are sent (SDK version 4 and later)
+#define CAPABILITY_SLIDING_WINDOW 0x20
+// submitted functions tracked by the SDK at once
+#define MAX_QUEUE_DEPTH 8
+
+/*!
+ * \brief protocol features negotiated with GRC
+ * \param flags CAPABILITY_* supported by both sides
+ * \param readBlockSize size of the blocks read with bulk read, including protocol wrap
+ * \param maxArrayLen longest float array GRC accepts in one stream
+ * \param queueDepth number of submitted functions GRC keeps at once
+ */
+struct ProtocolCapabilities {
+    uint8_t flags;
+    uint8_t readBlockSize;
+    uint16_t maxArrayLen;
+    uint8_t queueDepth;
+};
+
+/*!
+ * \brief per-device protocol state
+ * \param transport functions of the transport driver of ll_dev
+ * \param ll_dev transport layer device
+ * \param inBuff buffer for data read from GRC
+ * \param outBuff buffer for data to be written to GRC
+ * \param outBuffLen number of bytes prepared in outBuff
+ * \param streamingResult delivery status of the last streamed arguments
+ * \param timing reply time calibration of the device
+ * \param pending reply being waited for
+ * \param stats protocol counters
+ * \param caps negotiated protocol features
+ * \param nextSeq sequence number of the next submitted function
+ */
+struct ProtocolContext {
+    const struct grc_transport_ops* transport;
+    void* ll_dev;
+    uint8_t inBuff[PROTOCOL_BUFFER_SIZE];
+    uint8_t outBuff[PROTOCOL_BUFFER_SIZE];
+    uint16_t outBuffLen;
+    // write under construction: outBuff bytes from fragmentStart on are its last fragment
+    struct grc_ll_iovec fragments[MAX_WRITE_FRAGMENTS];
+    uint8_t fragmentCnt;
+    uint16_t fragmentStart;
+    uint16_t fragmentsLen;
+    uint8_t fragmentBlocks;
+    // largest transaction of the link and the module
+    uint16_t mtu;
+    // 1 - the link writes a command and reads its reply in one transaction
+    uint8_t combinedReads;
+    uint8_t streamingResult[STREAMING_STATUS_SIZE];
+    struct ResponseTiming timing;
+    struct PendingReply pending;
+    struct ProtocolStats stats;
+    struct ProtocolCapabilities caps;
+    uint8_t nextSeq;
+    // longest wait for a called function to finish, 0 - no limit
+    uint32_t functionTimeoutMs;
+};
+
 #ifdef __cplusplus
 }
 #endif // __cplusplus